@@ -0,0 +1,17 @@
+// Per-frame camera and lighting (Renderer::setFrameUniforms), shared by the
+// node and MapV instance shaders. Renderer::loadShaders inserts this after
+// their #version line; the std140 layout must match struct FrameUniforms in
+// Renderer.h. The glow/rim terms default to 0 (Classic theme, no visual
+// change).
+layout(std140) uniform FrameUniforms {
+    mat4 uView;
+    mat4 uProjection;
+    vec3 uLightPos;
+    float uBaseGlow;
+    vec3 uAmbient;
+    float uRimIntensity;
+    vec3 uDiffuse;
+    float uRimPower;
+    vec3 uViewPos;
+    vec3 uGlowColor;
+};
@@ -0,0 +1,42 @@
+#version 330 core
+// One MapV block per instance (see MapVLayout::buildNodeMesh): the unit
+// box's corners are placed from the block's footprint, height and slant.
+layout(location = 0) in vec3 aPosition;  // corner: at c1.x, at c1.y, on top
+layout(location = 1) in vec3 aNormal;    // face direction
+
+layout(location = 4) in vec4 aCorners;   // c0.x, c0.y, c1.x, c1.y
+layout(location = 5) in vec4 aShape;     // z base, z scale, height, slant ratio
+layout(location = 6) in vec4 aColor;
+layout(location = 7) in float aGlow;
+
+// FrameUniforms block: prepended from frame_uniforms.glsl (Renderer::loadShaders)
+
+out vec3 vWorldPos;
+out vec3 vNormal;
+out vec3 vColor;
+out vec2 vTexCoord;
+out float vGlow;
+
+void main() {
+    vec2 c0 = aCorners.xy;
+    vec2 c1 = aCorners.zw;
+    float height = aShape.z;
+
+    // Top face inset by the slant
+    vec2 offset = min(vec2(height), aShape.w * (c1 - c0));
+    vec2 xy = mix(c0, c1, aPosition.xy) + aPosition.z * offset * (1.0 - 2.0 * aPosition.xy);
+    float z = aPosition.z * height;
+
+    // Slanted side normals
+    vec2 len = sqrt(offset * offset + height * height);
+    len = mix(len, vec2(1.0), vec2(lessThan(len, vec2(1.0e-6))));
+    vec3 normal = vec3(aNormal.xy * height / len,
+                       aNormal.z + dot(abs(aNormal.xy), offset / len));
+
+    vWorldPos = vec3(xy, aShape.x + aShape.y * z);
+    vNormal = vec3(normal.xy, normal.z / max(aShape.y, 1.0e-4));
+    vColor = aColor.rgb;
+    vTexCoord = vec2(0.0);
+    vGlow = aGlow;
+    gl_Position = uProjection * uView * vec4(vWorldPos, 1.0);
+}
@@ -0,0 +1,61 @@
+#version 330 core
+// Folder outline of one collapsed MapV directory per instance (see
+// MapVLayout::buildFolderMesh): each segment of the outline is a thin quad.
+layout(location = 0) in vec3 aPosition;  // segment, at its end, side (+1 or -1)
+layout(location = 1) in vec3 aNormal;
+
+layout(location = 4) in vec4 aCorners;   // c0.x, c0.y, c1.x, c1.y
+layout(location = 5) in vec4 aShape;     // z base, z scale, height, slant ratio
+layout(location = 6) in vec4 aColor;
+layout(location = 7) in float aGlow;
+
+// FrameUniforms block: prepended from frame_uniforms.glsl (Renderer::loadShaders)
+
+out vec3 vWorldPos;
+out vec3 vNormal;
+out vec3 vColor;
+out vec2 vTexCoord;
+out float vGlow;
+
+const float MAGIC_NUMBER = 1.61803398874989484820;
+
+vec2 outlinePoint(int i, vec2 fc0, vec2 fc1, vec2 tab, float border) {
+    if (i == 1) return vec2(fc0.x, tab.y);
+    if (i == 2) return vec2(fc0.x + border, fc1.y);
+    if (i == 3) return vec2(tab.x - border, fc1.y);
+    if (i == 4) return tab;
+    if (i == 5) return vec2(fc1.x, tab.y);
+    if (i == 6) return vec2(fc1.x, fc0.y);
+    return fc0;
+}
+
+void main() {
+    vec2 c0 = aCorners.xy;
+    vec2 c1 = aCorners.zw;
+    float height = aShape.z;
+
+    // Folder inside the top face
+    vec2 offset = min(vec2(height), aShape.w * (c1 - c0));
+    vec2 dims = c1 - c0 - 2.0 * offset;
+    float border = 0.0625 * min(dims.x, dims.y);
+    vec2 fc0 = c0 + offset + border;
+    vec2 fc1 = c1 - offset - border;
+    vec2 tab = vec2(fc1.x - (MAGIC_NUMBER - 1.0) * (fc1.x - fc0.x), fc1.y - border);
+
+    int segment = int(aPosition.x);
+    vec2 a = outlinePoint(segment, fc0, fc1, tab, border);
+    vec2 b = outlinePoint(segment + 1, fc0, fc1, tab, border);
+    vec2 d = b - a;
+    float len = length(d);
+    vec2 halfWidth = len < 1.0e-6 ? vec2(0.0)
+                                  : vec2(-d.y, d.x) / len * (0.125 * border);
+    vec2 xy = mix(a, b, aPosition.y) + aPosition.z * halfWidth;
+    float z = height + 0.1;
+
+    vWorldPos = vec3(xy, aShape.x + aShape.y * z);
+    vNormal = vec3(aNormal.xy, aNormal.z / max(aShape.y, 1.0e-4));
+    vColor = aColor.rgb;
+    vTexCoord = vec2(0.0);
+    vGlow = aGlow;
+    gl_Position = uProjection * uView * vec4(vWorldPos, 1.0);
+}
@@ -3,18 +3,13 @@ in vec3 vWorldPos;
 in vec3 vNormal;
 in vec3 vColor;
 in vec2 vTexCoord;
+in float vGlow;  // per-instance pulse glow
 
-uniform vec3 uLightPos;
-uniform vec3 uAmbient;
-uniform vec3 uDiffuse;
-uniform vec3 uViewPos;
-uniform float uHighlight;
+// FrameUniforms block: prepended from frame_uniforms.glsl (Renderer::loadShaders)
 
-// Glow/rim uniforms (default 0 = Classic theme, no visual change)
-uniform vec3 uGlowColor;
-uniform float uGlowIntensity;
-uniform float uRimIntensity;
-uniform float uRimPower;
+// Per-draw
+uniform float uHighlight;
+uniform float uGlowIntensity;  // the directory's pulse glow
 
 out vec4 FragColor;
 
@@ -39,7 +34,7 @@ void main() {
     vec3 rimGlow = uGlowColor * rim * uRimIntensity;
 
     // Emissive glow (base + pulse)
-    vec3 emissive = uGlowColor * uGlowIntensity;
+    vec3 emissive = uGlowColor * (uBaseGlow + uGlowIntensity + vGlow);
 
     color += rimGlow + emissive;
 
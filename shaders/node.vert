@@ -4,20 +4,24 @@ layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec3 aColor;
 layout(location = 3) in vec2 aTexCoord;
 
+// FrameUniforms block: prepended from frame_uniforms.glsl (Renderer::loadShaders)
+
+// Per-draw
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
+uniform mat3 uNormalMatrix;  // of uModel, computed on the CPU
 
 out vec3 vWorldPos;
 out vec3 vNormal;
 out vec3 vColor;
 out vec2 vTexCoord;
+out float vGlow;
 
 void main() {
     vec4 worldPos = uModel * vec4(aPosition, 1.0);
     vWorldPos = worldPos.xyz;
-    vNormal = mat3(transpose(inverse(uModel))) * aNormal;
+    vNormal = uNormalMatrix * aNormal;
     vColor = aColor;
     vTexCoord = aTexCoord;
+    vGlow = 0.0;
     gl_Position = uProjection * uView * worldPos;
 }
@@ -12,6 +12,8 @@
 #include "core/FsScanner.h"
 #include "animation/Animation.h"
 #include "renderer/Renderer.h"
+#include "geometry/GeometryManager.h"
+#include "geometry/MapVLayout.h"
 #include "color/ColorSystem.h"
 #include "app/Config.h"
 #include "ui/ThemeManager.h"
@@ -33,9 +35,21 @@ App& App::instance() {
 }
 
 bool App::init(int argc, char* argv[]) {
-    // Parse command-line arguments
-    if (argc > 1) {
-        initialPath_ = argv[1];
+    // Parse command-line arguments:
+    //   [-x|--one-file-system] [--exclude PATTERN]... [path]
+    bool oneFileSystem = false;
+    std::vector<std::string> exclude;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-x" || arg == "--one-file-system") {
+            oneFileSystem = true;
+        } else if (arg == "--exclude" && i + 1 < argc) {
+            exclude.push_back(argv[++i]);
+        } else if (arg.rfind("--exclude=", 0) == 0) {
+            exclude.push_back(arg.substr(10));
+        } else {
+            initialPath_ = arg;
+        }
     }
 
     // Initialize SDL
@@ -84,6 +98,7 @@ bool App::init(int argc, char* argv[]) {
 
     // Load config
     Config::instance().load();
+    MapVLayout::instance().setSizeByAllocation(Config::instance().mapvSizeByAllocation);
 
     // Initialize ImGui
     ImGuiBackend::init(window_, glContext_);
@@ -111,6 +126,8 @@ bool App::init(int argc, char* argv[]) {
         }
     }
     MainWindow::instance().setInitialPath(initialPath_);
+    MainWindow::instance().setOneFileSystem(oneFileSystem);
+    MainWindow::instance().setScanExclude(exclude);
 
     running_ = true;
     return true;
@@ -134,6 +151,7 @@ void App::run() {
 void App::shutdown() {
     Config::instance().themeName = ThemeManager::instance().currentTheme().id;
     Config::instance().save();
+    GeometryManager::instance().freeAll();
     Renderer::instance().shutdown();
     ImGuiBackend::shutdown();
 
@@ -166,6 +166,16 @@ nlohmann::json Config::toJson() const {
     j["lastMode"] = static_cast<int>(lastMode);
     j["themeName"] = themeName;
 
+    // Scan settings
+    j["scan"]["threads"] = scanThreads;
+    j["scan"]["watch"] = scanWatch;
+    j["scan"]["depth"] = scanDepth;
+    j["scan"]["oneFileSystem"] = scanOneFileSystem;
+    j["scan"]["exclude"] = scanExclude;
+
+    // Layout settings
+    j["mapv"]["sizeByAllocation"] = mapvSizeByAllocation;
+
     // Window settings
     j["window"]["width"] = windowWidth;
     j["window"]["height"] = windowHeight;
@@ -231,6 +241,39 @@ void Config::fromJson(const nlohmann::json& j) {
         themeName = j["themeName"].get<std::string>();
     }
 
+    // Scan settings
+    if (j.contains("scan") && j["scan"].is_object()) {
+        const auto& js = j["scan"];
+        if (js.contains("threads") && js["threads"].is_number_unsigned()) {
+            scanThreads = js["threads"].get<unsigned int>();
+        }
+        if (js.contains("watch") && js["watch"].is_boolean()) {
+            scanWatch = js["watch"].get<bool>();
+        }
+        if (js.contains("depth") && js["depth"].is_number_unsigned()) {
+            scanDepth = js["depth"].get<unsigned int>();
+        }
+        if (js.contains("oneFileSystem") && js["oneFileSystem"].is_boolean()) {
+            scanOneFileSystem = js["oneFileSystem"].get<bool>();
+        }
+        if (js.contains("exclude") && js["exclude"].is_array()) {
+            scanExclude.clear();
+            for (const auto& jp : js["exclude"]) {
+                if (jp.is_string()) {
+                    scanExclude.push_back(jp.get<std::string>());
+                }
+            }
+        }
+    }
+
+    // Layout settings
+    if (j.contains("mapv") && j["mapv"].is_object()) {
+        const auto& jm = j["mapv"];
+        if (jm.contains("sizeByAllocation") && jm["sizeByAllocation"].is_boolean()) {
+            mapvSizeByAllocation = jm["sizeByAllocation"].get<bool>();
+        }
+    }
+
     // Window settings
     if (j.contains("window") && j["window"].is_object()) {
         const auto& jw = j["window"];
@@ -250,7 +293,10 @@ void Config::fromJson(const nlohmann::json& j) {
 
     if (jc.contains("mode") && jc["mode"].is_number_integer()) {
         int m = jc["mode"].get<int>();
-        if (m >= COLOR_BY_NODETYPE && m <= COLOR_NONE) {
+        // Duplicate and diff results don't outlive the session, so neither
+        // do those modes
+        if (m >= COLOR_BY_NODETYPE && m <= COLOR_NONE && m != COLOR_BY_DUPLICATE &&
+            m != COLOR_BY_GROWTH) {
             colorMode = static_cast<ColorMode>(m);
         }
     }
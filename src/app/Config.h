@@ -3,6 +3,7 @@
 #include "core/Types.h"
 #include "color/ColorSystem.h"
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 namespace fsvng {
@@ -19,6 +20,16 @@ public:
     std::string defaultPath;   // Cached default scan path
     FsvMode lastMode = FSV_MAPV;
 
+    // Scan settings
+    unsigned int scanThreads = 0;  // 0 = one per hardware thread
+    bool scanWatch = false;        // Follow filesystem changes after a scan
+    unsigned int scanDepth = 0;    // Lazy scan: levels read up front; 0 = all
+    bool scanOneFileSystem = false;  // Don't read other mounts below the root
+    std::vector<std::string> scanExclude;  // Names/paths pruned while scanning
+
+    // Layout settings
+    bool mapvSizeByAllocation = false;  // MapV blocks sized by disk usage
+
     // Window settings
     int windowWidth = 1280;
     int windowHeight = 800;
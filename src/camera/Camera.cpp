@@ -71,7 +71,7 @@ void Camera::init(FsvMode mode, bool initialView) {
             double rootHeight = 100.0;
             if (rootDir) {
                 rootWidth = rootDir->mapvWidth();
-                rootHeight = rootDir->mapvGeom.height;
+                rootHeight = rootDir->mapvGeom().height;
                 if (rootWidth < EPSILON) rootWidth = 1000.0;
                 if (rootHeight < EPSILON) rootHeight = 100.0;
             }
@@ -93,7 +93,7 @@ void Camera::init(FsvMode mode, bool initialView) {
         case FSV_TREEV: {
             double extRadius = 1000.0;
             if (rootDir) {
-                extRadius = rootDir->treevGeom.platform.depth;
+                extRadius = rootDir->treevGeom().platform.depth;
                 if (extRadius < EPSILON) extRadius = 1000.0;
                 // Include a generous view of the tree
                 extRadius += 8192.0; // core radius
@@ -207,7 +207,7 @@ double Camera::mapvLookAt(FsNode* node, MorphType mtype, double panTimeOverride)
     double nodeDepth = node->mapvDepth();
     double nodeCenterX = node->mapvCenterX();
     double nodeCenterY = node->mapvCenterY();
-    double nodeHeight = node->mapvGeom.height;
+    double nodeHeight = node->mapvGeom().height;
 
     // Target point
     XYZvec newTarget;
@@ -229,7 +229,7 @@ double Camera::mapvLookAt(FsNode* node, MorphType mtype, double panTimeOverride)
         newPhi = 52.5;
     } else if (node->parent) {
         double parentDepth = node->parent->mapvDepth();
-        double parentC0y = node->parent->mapvGeom.c0.y;
+        double parentC0y = node->parent->mapvGeom().c0.y;
         if (parentDepth > EPSILON) {
             newPhi = 45.0 + 15.0 * (newTarget.y - parentC0y) / parentDepth;
         } else {
@@ -375,28 +375,28 @@ double Camera::treevLookAt(FsNode* node, MorphType mtype, double panTimeOverride
         double platformR0 = gm.treevPlatformR0(parent);
         double platformTheta = gm.treevPlatformTheta(parent);
 
-        newTargetR = platformR0 + node->treevGeom.leaf.distance;
-        newTargetTheta = platformTheta + node->treevGeom.leaf.theta;
-        newTargetZ = parent->treevGeom.platform.height +
-                     (MAGIC_NUMBER - 1.0) * node->treevGeom.leaf.height;
+        newTargetR = platformR0 + node->treevGeom().leaf.distance;
+        newTargetTheta = platformTheta + node->treevGeom().leaf.theta;
+        newTargetZ = parent->treevGeom().platform.height +
+                     (MAGIC_NUMBER - 1.0) * node->treevGeom().leaf.height;
 
         double topDist = 2.5 * fieldDistance(cam.fov, SQRT_2 * TREEV_LEAF_NODE_EDGE);
-        newDistance = topDist + (2.0 - MAGIC_NUMBER) * node->treevGeom.leaf.height;
+        newDistance = topDist + (2.0 - MAGIC_NUMBER) * node->treevGeom().leaf.height;
 
         newNearClip = NEAR_TO_DISTANCE_RATIO * topDist;
         newFarClip = FAR_TO_NEAR_RATIO * newNearClip;
 
         // Viewing angles - relTheta is just the leaf's local theta
-        double arcWidth = parent->treevGeom.platform.arc_width;
+        double arcWidth = parent->treevGeom().platform.arc_width;
         if (std::abs(arcWidth) > EPSILON) {
-            newTheta = -15.0 * node->treevGeom.leaf.theta / arcWidth;
+            newTheta = -15.0 * node->treevGeom().leaf.theta / arcWidth;
         } else {
             newTheta = 0.0;
         }
         newPhi = 45.0;
 
         // Ensure camera is pitched high enough to see top and bottom
-        double leafHeight = node->treevGeom.leaf.height;
+        double leafHeight = node->treevGeom().leaf.height;
         if (leafHeight > EPSILON) {
             double k = newDistance * std::sin(rad(0.25 * cam.fov)) /
                        ((2.0 - MAGIC_NUMBER) * leafHeight);
@@ -410,15 +410,15 @@ double Camera::treevLookAt(FsNode* node, MorphType mtype, double panTimeOverride
         auto& gm = GeometryManager::instance();
         double platformR0 = gm.treevPlatformR0(node);
         double platformTheta = gm.treevPlatformTheta(node);
-        double platformDepth = node->treevGeom.platform.depth;
+        double platformDepth = node->treevGeom().platform.depth;
 
         newTargetR = platformR0 + 0.3 * platformDepth - 0.2 * TREEV_PLATFORM_SPACING_DEPTH;
         newTargetTheta = platformTheta;
-        newTargetZ = node->treevGeom.platform.height;
+        newTargetZ = node->treevGeom().platform.height;
 
         // Distance from target point
         double diameter = std::max(platformDepth + 0.5 * TREEV_PLATFORM_SPACING_DEPTH,
-                                   0.25 * node->treevGeom.platform.height);
+                                   0.25 * node->treevGeom().platform.height);
         newDistance = fieldDistance(cam.fov, diameter);
 
         newNearClip = NEAR_TO_DISTANCE_RATIO * newDistance;
@@ -553,6 +553,14 @@ void Camera::lookAtPrevious() {
     lookAt(prevNode);
 }
 
+void Camera::forgetSubtree(const FsNode* node) {
+    history_.erase(std::remove_if(history_.begin(), history_.end(),
+                                  [node](FsNode* n) { return n && n->isWithin(node); }),
+                   history_.end());
+    if (currentNode_ && currentNode_->isWithin(node))
+        currentNode_ = node->parent;
+}
+
 // ============================================================================
 // TreeV L-pan
 // ============================================================================
@@ -574,18 +582,18 @@ void Camera::treevLpanLookAt(FsNode* node, double panTimeOverride) {
     if (isLeaf && node->parent) {
         FsNode* parent = node->parent;
         auto& gm = GeometryManager::instance();
-        double arcWidth = parent->treevGeom.platform.arc_width;
-        double leafTheta = node->treevGeom.leaf.theta;
+        double arcWidth = parent->treevGeom().platform.arc_width;
+        double leafTheta = node->treevGeom().leaf.theta;
         if (std::abs(arcWidth) > EPSILON) {
             newTheta = -15.0 * leafTheta / arcWidth;
         } else {
             newTheta = 0.0;
         }
-        newTargetR = gm.treevPlatformR0(parent) + node->treevGeom.leaf.distance;
+        newTargetR = gm.treevPlatformR0(parent) + node->treevGeom().leaf.distance;
         newTargetTheta = gm.treevPlatformTheta(parent) + leafTheta;
     } else {
         auto& gm = GeometryManager::instance();
-        newTargetR = gm.treevPlatformR0(node) + (2.0 - MAGIC_NUMBER) * node->treevGeom.platform.depth;
+        newTargetR = gm.treevPlatformR0(node) + (2.0 - MAGIC_NUMBER) * node->treevGeom().platform.depth;
         newTargetTheta = gm.treevPlatformTheta(node);
         newTheta = -0.125 * (newTargetTheta - 90.0);
     }
@@ -82,6 +82,10 @@ public:
     // Get current node of interest
     FsNode* currentNode() const { return currentNode_; }
 
+    // Drop history entries for node and everything below it (called before
+    // the subtree is deleted from the tree)
+    void forgetSubtree(const FsNode* node);
+
 private:
     Camera() = default;
 
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+
+namespace fsvng {
+
+// ============================================================================
+// Aabb - axis-aligned box, empty until a point is added
+// ============================================================================
+
+struct Aabb {
+    glm::vec3 min{FLT_MAX, FLT_MAX, FLT_MAX};
+    glm::vec3 max{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    bool empty() const { return min.x > max.x; }
+
+    void add(const glm::vec3& p) {
+        min = glm::vec3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+        max = glm::vec3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+    }
+
+    void add(const Aabb& box) {
+        if (!box.empty()) {
+            add(box.min);
+            add(box.max);
+        }
+    }
+
+    // Smallest box holding this one transformed by an affine matrix
+    Aabb transformed(const glm::mat4& m) const {
+        if (empty())
+            return *this;
+        Aabb out;
+        for (int i = 0; i < 3; ++i) {
+            out.min[i] = out.max[i] = m[3][i];
+            for (int j = 0; j < 3; ++j) {
+                float a = m[j][i] * min[j];
+                float b = m[j][i] * max[j];
+                out.min[i] += std::min(a, b);
+                out.max[i] += std::max(a, b);
+            }
+        }
+        return out;
+    }
+};
+
+// ============================================================================
+// Frustum - the six clip planes of a view-projection matrix
+//
+// intersects() is conservative: a box it rejects is wholly outside, but one
+// it accepts may still be outside near a corner of the frustum. A default
+// Frustum accepts every non-empty box.
+// ============================================================================
+
+class Frustum {
+public:
+    Frustum() = default;
+
+    explicit Frustum(const glm::mat4& viewProj) {
+        // Rows of the matrix (glm is column-major); plane = row3 +/- rowN
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i)
+            rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+        for (int i = 0; i < 3; ++i) {
+            planes_[2 * i] = rows[3] + rows[i];
+            planes_[2 * i + 1] = rows[3] - rows[i];
+        }
+    }
+
+    bool intersects(const Aabb& box) const {
+        if (box.empty())
+            return false;
+        for (const glm::vec4& p : planes_) {
+            // The box corner furthest along the plane's normal
+            float x = p.x >= 0.0f ? box.max.x : box.min.x;
+            float y = p.y >= 0.0f ? box.max.y : box.min.y;
+            float z = p.z >= 0.0f ? box.max.z : box.min.z;
+            if (p.x * x + p.y * y + p.z * z + p.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    glm::vec4 planes_[6]{};
+};
+
+} // namespace fsvng
@@ -1,14 +1,26 @@
 #include "color/ColorSystem.h"
+#include "core/FsDiff.h"
 #include "core/FsNode.h"
 #include "core/FsTree.h"
 #include "core/PlatformUtils.h"
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <ctime>
 
 namespace fsvng {
 
+namespace {
+
+// Growth shades per direction, spread over changes of 2^10 .. 2^40 bytes on a
+// log scale; anything outside that range gets the first or last shade.
+constexpr int GROWTH_SHADES = 32;
+constexpr double GROWTH_LOG2_MIN = 10.0;
+constexpr double GROWTH_LOG2_MAX = 40.0;
+
+} // namespace
+
 // ----------------------------------------------------------------------------
 // Default node type colors (from original color.c)
 // ----------------------------------------------------------------------------
@@ -38,6 +50,7 @@ ColorSystem& ColorSystem::instance() {
 void ColorSystem::init() {
     loadDefaults();
     generateSpectrum();
+    generateGrowthShades();
 }
 
 // ----------------------------------------------------------------------------
@@ -87,6 +100,15 @@ void ColorSystem::loadDefaults() {
     // Default color for unmatched files
     config_.byWpattern.defaultColor = PlatformUtils::hex2rgb("#FFFFA0");
 
+    // Duplicates stand out against everything else
+    config_.byDuplicate.duplicateColor = PlatformUtils::hex2rgb("#FF3333");
+    config_.byDuplicate.uniqueColor    = PlatformUtils::hex2rgb("#666666");
+
+    // Growth: warm for bigger, cool for smaller, grey for the same
+    config_.byGrowth.growColor      = PlatformUtils::hex2rgb("#FF3300");
+    config_.byGrowth.shrinkColor    = PlatformUtils::hex2rgb("#3366FF");
+    config_.byGrowth.unchangedColor = PlatformUtils::hex2rgb("#666666");
+
     // Default mode
     mode_ = COLOR_BY_NODETYPE;
 }
@@ -100,6 +122,25 @@ void ColorSystem::generateSpectrum() {
                        config_.byTimestamp.newColor);
 }
 
+// ----------------------------------------------------------------------------
+// generateGrowthShades - ramps from the unchanged color towards the grow and
+// shrink colors; even the smallest shade is clearly tinted
+// ----------------------------------------------------------------------------
+void ColorSystem::generateGrowthShades() {
+    auto ramp = [this](const RGBcolor& to, std::vector<RGBcolor>& shades) {
+        const RGBcolor& from = config_.byGrowth.unchangedColor;
+        shades.resize(GROWTH_SHADES);
+        for (int i = 0; i < GROWTH_SHADES; ++i) {
+            float t = 0.25f + 0.75f * static_cast<float>(i) / (GROWTH_SHADES - 1);
+            shades[i] = {from.r + (to.r - from.r) * t,
+                         from.g + (to.g - from.g) * t,
+                         from.b + (to.b - from.b) * t};
+        }
+    };
+    ramp(config_.byGrowth.growColor, growShades_);
+    ramp(config_.byGrowth.shrinkColor, shrinkShades_);
+}
+
 // ----------------------------------------------------------------------------
 // setMode - change current coloring mode and recolor the entire tree
 // ----------------------------------------------------------------------------
@@ -119,6 +160,7 @@ void ColorSystem::setMode(ColorMode mode) {
 void ColorSystem::setConfig(const ColorConfig& config, ColorMode mode) {
     config_ = config;
     generateSpectrum();
+    generateGrowthShades();
 
     if (mode != COLOR_NONE) {
         setMode(mode);
@@ -138,6 +180,10 @@ void ColorSystem::assignRecursive(FsNode* dnode) {
         return;
     }
 
+    // Colors are baked into the directory's cached meshes
+    dnode->aDlistStale = true;
+    dnode->cDlistStale = true;
+
     for (auto& childPtr : dnode->children) {
         FsNode* node = childPtr.get();
         const RGBcolor* color = nullptr;
@@ -152,6 +198,12 @@ void ColorSystem::assignRecursive(FsNode* dnode) {
             case COLOR_BY_WPATTERN:
                 color = wpatternColor(node);
                 break;
+            case COLOR_BY_DUPLICATE:
+                color = duplicateColor(node);
+                break;
+            case COLOR_BY_GROWTH:
+                color = growthColor(node);
+                break;
             default:
                 color = nodeTypeColor(node);
                 break;
@@ -165,6 +217,26 @@ void ColorSystem::assignRecursive(FsNode* dnode) {
     }
 }
 
+// ----------------------------------------------------------------------------
+// setDuplicates - remember which node IDs DuplicateFinder reported
+// ----------------------------------------------------------------------------
+void ColorSystem::setDuplicates(const std::vector<unsigned int>& ids) {
+    duplicates_.clear();
+    for (unsigned int id : ids) {
+        if (id >= duplicates_.size()) {
+            duplicates_.resize(id + 1);
+        }
+        duplicates_[id] = true;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// setGrowth - remember the comparison COLOR_BY_GROWTH shows
+// ----------------------------------------------------------------------------
+void ColorSystem::setGrowth(std::shared_ptr<const FsDiff> diff) {
+    growth_ = std::move(diff);
+}
+
 // ----------------------------------------------------------------------------
 // getSpectrumColor - look up a color in the precomputed spectrum
 // ----------------------------------------------------------------------------
@@ -268,4 +340,44 @@ const RGBcolor* ColorSystem::wpatternColor(FsNode* node) const {
     return &config_.byWpattern.defaultColor;
 }
 
+// ----------------------------------------------------------------------------
+// duplicateColor - files with a duplicate elsewhere in the tree stand out;
+// directories are colored by node type.
+// ----------------------------------------------------------------------------
+const RGBcolor* ColorSystem::duplicateColor(FsNode* node) const {
+    if (!node) {
+        return &config_.byDuplicate.uniqueColor;
+    }
+    if (node->isDir()) {
+        return nodeTypeColor(node);
+    }
+    if (node->id < duplicates_.size() && duplicates_[node->id]) {
+        return &config_.byDuplicate.duplicateColor;
+    }
+    return &config_.byDuplicate.uniqueColor;
+}
+
+// ----------------------------------------------------------------------------
+// growthColor - files are shaded by how much they grew or shrank, on a log
+// scale; new files count as grown by their whole size.  Directories are
+// colored by node type.
+// ----------------------------------------------------------------------------
+const RGBcolor* ColorSystem::growthColor(FsNode* node) const {
+    if (!node) {
+        return &config_.byGrowth.unchangedColor;
+    }
+    if (node->isDir()) {
+        return nodeTypeColor(node);
+    }
+    int64_t delta = growth_ ? growth_->deltaOf(node) : 0;
+    if (delta == 0 || growShades_.empty()) {
+        return &config_.byGrowth.unchangedColor;
+    }
+
+    double x = (std::log2(static_cast<double>(std::llabs(delta))) - GROWTH_LOG2_MIN) /
+               (GROWTH_LOG2_MAX - GROWTH_LOG2_MIN);
+    int shade = static_cast<int>(std::clamp(x, 0.0, 1.0) * (GROWTH_SHADES - 1) + 0.5);
+    return delta > 0 ? &growShades_[shade] : &shrinkShades_[shade];
+}
+
 } // namespace fsvng
@@ -2,12 +2,14 @@
 
 #include "core/Types.h"
 #include "color/Spectrum.h"
+#include <memory>
 #include <vector>
 #include <string>
 
 namespace fsvng {
 
 class FsNode;
+struct FsDiff;
 
 struct WPatternGroup {
     RGBcolor color;
@@ -35,6 +37,19 @@ struct ColorConfig {
         std::vector<WPatternGroup> groups;
         RGBcolor defaultColor{1.0f, 1.0f, 0.625f};
     } byWpattern;
+
+    // Color by duplicate contents (DuplicateFinder results)
+    struct {
+        RGBcolor duplicateColor{1.0f, 0.2f, 0.2f};
+        RGBcolor uniqueColor{0.4f, 0.4f, 0.4f};
+    } byDuplicate;
+
+    // Color by growth since a snapshot (FsDiff results)
+    struct {
+        RGBcolor growColor{1.0f, 0.2f, 0.0f};
+        RGBcolor shrinkColor{0.2f, 0.4f, 1.0f};
+        RGBcolor unchangedColor{0.4f, 0.4f, 0.4f};
+    } byGrowth;
 };
 
 class ColorSystem {
@@ -52,6 +67,14 @@ public:
     // Assign colors to all nodes in subtree
     void assignRecursive(FsNode* dnode);
 
+    // Files shown in duplicateColor under COLOR_BY_DUPLICATE, by node ID.
+    // Takes effect on the next assignRecursive().
+    void setDuplicates(const std::vector<unsigned int>& ids);
+
+    // Size deltas shown under COLOR_BY_GROWTH, or nullptr for none.
+    // Takes effect on the next assignRecursive().
+    void setGrowth(std::shared_ptr<const FsDiff> diff);
+
     // Get color for spectrum visualization
     const RGBcolor& getSpectrumColor(double x) const;
 
@@ -64,13 +87,20 @@ private:
     const RGBcolor* nodeTypeColor(FsNode* node) const;
     const RGBcolor* timeColor(FsNode* node) const;
     const RGBcolor* wpatternColor(FsNode* node) const;
+    const RGBcolor* duplicateColor(FsNode* node) const;
+    const RGBcolor* growthColor(FsNode* node) const;
 
     void generateSpectrum();
+    void generateGrowthShades();
     void loadDefaults();
 
     ColorMode mode_ = COLOR_BY_NODETYPE;
     ColorConfig config_;
     Spectrum spectrum_;
+    std::vector<bool> duplicates_;  // by node ID
+    std::shared_ptr<const FsDiff> growth_;
+    std::vector<RGBcolor> growShades_;    // smallest change first
+    std::vector<RGBcolor> shrinkShades_;
 };
 
 } // namespace fsvng
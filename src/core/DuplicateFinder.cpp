@@ -0,0 +1,524 @@
+#include "DuplicateFinder.h"
+#include "FsNode.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fsvng {
+
+namespace {
+
+// Bytes hashed at each end of a file in the edge stage.
+constexpr size_t EDGE_BYTES = 4096;
+
+// Read size of the content stage.
+constexpr size_t CHUNK_BYTES = 1024 * 1024;
+
+// ============================================================================
+// Hasher - streaming 64-bit hash (XXH64 structure: four multiply-rotate
+// lanes over 32-byte stripes, then an avalanche)
+// ============================================================================
+
+class Hasher {
+public:
+    void update(const char* data, size_t len) {
+        total_ += len;
+        if (bufferLen_ + len < sizeof(buffer_)) {
+            std::memcpy(buffer_ + bufferLen_, data, len);
+            bufferLen_ += len;
+            return;
+        }
+        if (bufferLen_ > 0) {
+            size_t fill = sizeof(buffer_) - bufferLen_;
+            std::memcpy(buffer_ + bufferLen_, data, fill);
+            stripe(buffer_);
+            data += fill;
+            len -= fill;
+            bufferLen_ = 0;
+        }
+        while (len >= sizeof(buffer_)) {
+            stripe(data);
+            data += sizeof(buffer_);
+            len -= sizeof(buffer_);
+        }
+        std::memcpy(buffer_, data, len);
+        bufferLen_ = len;
+    }
+
+    uint64_t digest() const {
+        uint64_t h;
+        if (total_ >= sizeof(buffer_)) {
+            h = rotl(v_[0], 1) + rotl(v_[1], 7) + rotl(v_[2], 12) + rotl(v_[3], 18);
+            for (uint64_t v : v_) {
+                h = (h ^ round(0, v)) * P1 + P4;
+            }
+        } else {
+            h = P5;
+        }
+        h += total_;
+
+        const char* p = buffer_;
+        size_t len = bufferLen_;
+        for (; len >= 8; p += 8, len -= 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * P1 + P4;
+        }
+        if (len >= 4) {
+            uint32_t k;
+            std::memcpy(&k, p, 4);
+            h ^= uint64_t(k) * P1;
+            h = rotl(h, 23) * P2 + P3;
+            p += 4;
+            len -= 4;
+        }
+        for (; len > 0; ++p, --len) {
+            h ^= uint64_t(static_cast<unsigned char>(*p)) * P5;
+            h = rotl(h, 11) * P1;
+        }
+
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr uint64_t P1 = 11400714785074694791ull;
+    static constexpr uint64_t P2 = 14029467366897019727ull;
+    static constexpr uint64_t P3 = 1609587929392839161ull;
+    static constexpr uint64_t P4 = 9650029242287828579ull;
+    static constexpr uint64_t P5 = 2870177450012600261ull;
+
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static uint64_t read64(const char* p) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        return v;
+    }
+
+    static uint64_t round(uint64_t acc, uint64_t input) {
+        return rotl(acc + input * P2, 31) * P1;
+    }
+
+    void stripe(const char* p) {
+        for (int i = 0; i < 4; ++i) {
+            v_[i] = round(v_[i], read64(p + 8 * i));
+        }
+    }
+
+    uint64_t v_[4] = {P1 + P2, P2, 0, 0 - P1};
+    char buffer_[32];
+    size_t bufferLen_ = 0;
+    uint64_t total_ = 0;
+};
+
+// ============================================================================
+// InputFile - positioned reads from one file
+// ============================================================================
+
+class InputFile {
+public:
+    ~InputFile() { close(); }
+
+    bool open(const std::string& path, bool sequential) {
+#ifdef _WIN32
+        DWORD flags = sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            nullptr, OPEN_EXISTING, flags, nullptr);
+        return file_ != INVALID_HANDLE_VALUE;
+#else
+        int flags = O_RDONLY | O_CLOEXEC;
+#ifdef __linux__
+        // Leave access times alone: COLOR_BY_TIMESTAMP may be showing them.
+        // Only allowed on files we own.
+        fd_ = ::open(path.c_str(), flags | O_NOATIME);
+        if (fd_ < 0 && errno == EPERM) {
+            fd_ = ::open(path.c_str(), flags);
+        }
+        if (fd_ >= 0 && sequential) {
+            posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+#else
+        (void)sequential;
+        fd_ = ::open(path.c_str(), flags);
+#endif
+        return fd_ >= 0;
+#endif
+    }
+
+    // Read exactly len bytes at offset; false on error or end of file.
+    bool readAt(char* buf, size_t len, int64_t offset) {
+        while (len > 0) {
+#ifdef _WIN32
+            OVERLAPPED ov = {};
+            ov.Offset = static_cast<DWORD>(offset);
+            ov.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+            DWORD got = 0;
+            DWORD want = static_cast<DWORD>(std::min<size_t>(len, 1u << 30));
+            if (!ReadFile(file_, buf, want, &got, &ov) || got == 0) {
+                return false;
+            }
+#else
+            ssize_t got = pread(fd_, buf, len, offset);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                return false;
+            }
+#endif
+            buf += got;
+            len -= static_cast<size_t>(got);
+            offset += got;
+        }
+        return true;
+    }
+
+private:
+    void close() {
+#ifdef _WIN32
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+    }
+
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+#else
+    int fd_ = -1;
+#endif
+};
+
+// Hash of the first and last EDGE_BYTES, or of the whole file if that is
+// no longer. false if the file can't be read as large as the scan saw it.
+bool hashEdges(const DuplicateCandidate& file, std::vector<char>& buf, uint64_t* hash,
+               uint64_t* bytesRead) {
+    InputFile in;
+    if (!in.open(file.path, false)) {
+        return false;
+    }
+    size_t size = static_cast<size_t>(file.size);
+    Hasher hasher;
+    if (size <= 2 * EDGE_BYTES) {
+        if (!in.readAt(buf.data(), size, 0)) return false;
+        hasher.update(buf.data(), size);
+        *bytesRead += size;
+    } else {
+        if (!in.readAt(buf.data(), EDGE_BYTES, 0) ||
+            !in.readAt(buf.data() + EDGE_BYTES, EDGE_BYTES, file.size - EDGE_BYTES)) {
+            return false;
+        }
+        hasher.update(buf.data(), 2 * EDGE_BYTES);
+        *bytesRead += 2 * EDGE_BYTES;
+    }
+    *hash = hasher.digest();
+    return true;
+}
+
+bool hashContents(const DuplicateCandidate& file, std::vector<char>& buf,
+                  const std::atomic<bool>* cancel, uint64_t* hash, uint64_t* bytesRead) {
+    InputFile in;
+    if (!in.open(file.path, true)) {
+        return false;
+    }
+    Hasher hasher;
+    for (int64_t offset = 0; offset < file.size; offset += CHUNK_BYTES) {
+        if (cancel && cancel->load()) {
+            return false;
+        }
+        size_t len = static_cast<size_t>(std::min<int64_t>(CHUNK_BYTES, file.size - offset));
+        if (!in.readAt(buf.data(), len, offset)) {
+            return false;
+        }
+        hasher.update(buf.data(), len);
+        *bytesRead += len;
+    }
+    *hash = hasher.digest();
+    return true;
+}
+
+// Run work(i, buffer) for every i in [0, count) on up to threadCount
+// threads, each with its own buffer of bufferSize bytes.
+template <typename Work>
+void runParallel(size_t count, unsigned int threadCount, size_t bufferSize,
+                 const std::atomic<bool>* cancel, Work work) {
+    std::atomic<size_t> next{0};
+    auto loop = [&] {
+        std::vector<char> buf(bufferSize);
+        for (size_t i = next++; i < count; i = next++) {
+            if (cancel && cancel->load()) {
+                return;
+            }
+            work(i, buf);
+        }
+    };
+    threadCount = static_cast<unsigned int>(std::clamp<size_t>(count, 1, std::max(1u, threadCount)));
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned int t = 1; t < threadCount; ++t) {
+        threads.emplace_back(loop);
+    }
+    loop();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+struct Hashed {
+    size_t index;  // into candidates
+    uint64_t hash;
+};
+
+// Runs of files with equal size and hash, at least two long, in
+// candidates' order (largest size first).
+std::vector<std::vector<size_t>> sameHashGroups(const std::vector<DuplicateCandidate>& candidates,
+                                                std::vector<Hashed> hashed) {
+    std::sort(hashed.begin(), hashed.end(), [&](const Hashed& a, const Hashed& b) {
+        const DuplicateCandidate& ca = candidates[a.index];
+        const DuplicateCandidate& cb = candidates[b.index];
+        if (ca.size != cb.size) return ca.size > cb.size;
+        if (a.hash != b.hash) return a.hash < b.hash;
+        return ca.id < cb.id;
+    });
+    std::vector<std::vector<size_t>> groups;
+    for (size_t i = 0; i < hashed.size();) {
+        size_t j = i + 1;
+        while (j < hashed.size() && hashed[j].hash == hashed[i].hash &&
+               candidates[hashed[j].index].size == candidates[hashed[i].index].size) {
+            ++j;
+        }
+        if (j - i >= 2) {
+            std::vector<size_t> group;
+            for (size_t k = i; k < j; ++k) {
+                group.push_back(hashed[k].index);
+            }
+            groups.push_back(std::move(group));
+        }
+        i = j;
+    }
+    return groups;
+}
+
+void collectFiles(const FsNode* dir, std::string& path,
+                  const std::unordered_map<int64_t, uint32_t>& sizeCounts, int64_t minSize,
+                  std::vector<DuplicateCandidate>& out) {
+    for (const auto& child : dir->children) {
+        const FsNode* node = child.get();
+        bool candidate = node->type == NODE_REGFILE && !(node->flags & NODE_FLAG_DUPLICATE) &&
+                         node->size >= minSize && sizeCounts.at(node->size) >= 2;
+        if (!candidate && !node->isDir()) {
+            continue;
+        }
+        size_t len = path.size();
+        if (!path.empty() && path.back() != '/' && path.back() != '\\') {
+            path += '/';
+        }
+        path += node->name;
+        if (candidate) {
+            out.push_back({node->id, node->size, path});
+        } else {
+            collectFiles(node, path, sizeCounts, minSize, out);
+        }
+        path.resize(len);
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// DuplicateFinder stages
+// ============================================================================
+
+std::vector<DuplicateCandidate> DuplicateFinder::collect(const FsNode* metanode, int64_t minSize) {
+    std::vector<DuplicateCandidate> candidates;
+    if (!metanode) {
+        return candidates;
+    }
+
+    std::unordered_map<int64_t, uint32_t> sizeCounts;
+    std::vector<const FsNode*> stack{metanode};
+    while (!stack.empty()) {
+        const FsNode* node = stack.back();
+        stack.pop_back();
+        if (node->type == NODE_REGFILE && !(node->flags & NODE_FLAG_DUPLICATE) &&
+            node->size >= minSize) {
+            sizeCounts[node->size]++;
+        }
+        for (const auto& child : node->children) {
+            stack.push_back(child.get());
+        }
+    }
+
+    std::string path = metanode->name;
+    collectFiles(metanode, path, sizeCounts, minSize, candidates);
+    std::sort(candidates.begin(), candidates.end(),
+              [](const DuplicateCandidate& a, const DuplicateCandidate& b) {
+                  return a.size != b.size ? a.size > b.size : a.id < b.id;
+              });
+    return candidates;
+}
+
+DuplicateResult DuplicateFinder::find(std::vector<DuplicateCandidate> candidates,
+                                      unsigned int ioThreads, const std::atomic<bool>* cancel,
+                                      Progress* progress, std::mutex* progressMutex) {
+    DuplicateResult result;
+    auto report = [&](Stage stage, uint64_t done, uint64_t total, uint64_t bytes) {
+        if (!progress) return;
+        std::unique_lock<std::mutex> lock;
+        if (progressMutex) lock = std::unique_lock<std::mutex>(*progressMutex);
+        progress->stage = stage;
+        progress->filesDone = done;
+        progress->filesTotal = total;
+        progress->bytesRead += bytes;
+    };
+    std::mutex statsMutex;
+    uint64_t done = 0;
+    uint64_t unreadable = 0;
+
+    // Stage 2: edges of every candidate
+    std::vector<Hashed> edges;
+    edges.reserve(candidates.size());
+    report(Stage::Edges, 0, candidates.size(), 0);
+    runParallel(candidates.size(), ioThreads, 2 * EDGE_BYTES, cancel,
+                [&](size_t i, std::vector<char>& buf) {
+        uint64_t hash = 0, bytes = 0;
+        bool ok = hashEdges(candidates[i], buf, &hash, &bytes);
+        std::lock_guard<std::mutex> lock(statsMutex);
+        if (ok) {
+            edges.push_back({i, hash});
+        } else {
+            unreadable++;
+        }
+        report(Stage::Edges, ++done, candidates.size(), bytes);
+    });
+    if (cancel && cancel->load()) {
+        return {};
+    }
+
+    // Small files were read whole and are settled; the rest go on to
+    // stage 3 if their edges matched another file's.
+    std::vector<std::vector<size_t>> sets;
+    std::vector<size_t> remaining;
+    for (std::vector<size_t>& group : sameHashGroups(candidates, std::move(edges))) {
+        if (candidates[group[0]].size <= static_cast<int64_t>(2 * EDGE_BYTES)) {
+            sets.push_back(std::move(group));
+        } else {
+            remaining.insert(remaining.end(), group.begin(), group.end());
+        }
+    }
+
+    // Stage 3: whole contents, largest files first
+    std::vector<Hashed> contents;
+    contents.reserve(remaining.size());
+    done = 0;
+    report(Stage::Contents, 0, remaining.size(), 0);
+    runParallel(remaining.size(), ioThreads, CHUNK_BYTES, cancel,
+                [&](size_t i, std::vector<char>& buf) {
+        uint64_t hash = 0, bytes = 0;
+        bool ok = hashContents(candidates[remaining[i]], buf, cancel, &hash, &bytes);
+        std::lock_guard<std::mutex> lock(statsMutex);
+        if (ok) {
+            contents.push_back({remaining[i], hash});
+        } else {
+            unreadable++;
+        }
+        report(Stage::Contents, ++done, remaining.size(), bytes);
+    });
+    if (cancel && cancel->load()) {
+        return {};
+    }
+    for (std::vector<size_t>& group : sameHashGroups(candidates, std::move(contents))) {
+        sets.push_back(std::move(group));
+    }
+
+    for (const std::vector<size_t>& group : sets) {
+        DuplicateSet set;
+        set.size = candidates[group[0]].size;
+        for (size_t i : group) {
+            set.ids.push_back(candidates[i].id);
+        }
+        result.wastedBytes += set.wasted();
+        result.duplicateFiles += set.ids.size();
+        result.sets.push_back(std::move(set));
+    }
+    std::sort(result.sets.begin(), result.sets.end(),
+              [](const DuplicateSet& a, const DuplicateSet& b) {
+                  if (a.wasted() != b.wasted()) return a.wasted() > b.wasted();
+                  return a.ids[0] < b.ids[0];
+              });
+    result.unreadableFiles = unreadable;
+    report(Stage::Done, done, remaining.size(), 0);
+    return result;
+}
+
+// ============================================================================
+// DuplicateFinder background search
+// ============================================================================
+
+DuplicateFinder::~DuplicateFinder() {
+    cancel();
+}
+
+void DuplicateFinder::start(const FsNode* metanode, const Options& options) {
+    cancel();
+    std::vector<DuplicateCandidate> candidates = collect(metanode, options.minSize);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        progress_ = Progress();
+    }
+    cancel_ = false;
+    running_ = true;
+    thread_ = std::thread([this, options, candidates = std::move(candidates)]() mutable {
+        auto result = std::make_shared<const DuplicateResult>(
+            find(std::move(candidates), options.ioThreads, &cancel_, &progress_, &mutex_));
+        if (!cancel_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            result_ = std::move(result);
+        }
+        running_ = false;
+    });
+}
+
+void DuplicateFinder::cancel() {
+    cancel_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void DuplicateFinder::clear() {
+    cancel();
+    std::lock_guard<std::mutex> lock(mutex_);
+    progress_ = Progress();
+    result_.reset();
+}
+
+DuplicateFinder::Progress DuplicateFinder::progress() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return progress_;
+}
+
+std::shared_ptr<const DuplicateResult> DuplicateFinder::result() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return result_;
+}
+
+} // namespace fsvng
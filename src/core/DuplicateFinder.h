@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fsvng {
+
+class FsNode;
+
+// ============================================================================
+// DuplicateFinder - finds regular files with identical contents
+//
+// Runs in stages, each reading only what the previous one could not rule
+// out:
+//   1. group files by size (from the tree, no I/O); unique sizes drop out
+//   2. hash the first and last 4 KiB of each remaining file; files no larger
+//      than that are hashed whole here and are final
+//   3. hash the whole of each file still sharing a size and edge hash
+// Hashing runs on a fixed number of I/O threads with pread(). Hard links to
+// one inode (NODE_FLAG_DUPLICATE) are one file, not duplicates. Results are
+// node IDs, to be resolved with FsTree::nodeById().
+// ============================================================================
+
+struct DuplicateSet {
+    int64_t size = 0;               // of each copy
+    std::vector<unsigned int> ids;  // at least two, by ID
+
+    int64_t wasted() const { return size * static_cast<int64_t>(ids.size() - 1); }
+};
+
+struct DuplicateResult {
+    std::vector<DuplicateSet> sets;  // most wasted bytes first
+    int64_t wastedBytes = 0;         // sum over sets
+    uint64_t duplicateFiles = 0;     // files in some set
+    uint64_t unreadableFiles = 0;    // candidates that could not be read
+};
+
+// A regular file the search considers; the path is copied so the tree can
+// change while files are read.
+struct DuplicateCandidate {
+    unsigned int id = 0;
+    int64_t size = 0;
+    std::string path;
+};
+
+class DuplicateFinder {
+public:
+    enum class Stage { Idle, Edges, Contents, Done };
+
+    struct Options {
+        unsigned int ioThreads = 4;  // files read at once
+        int64_t minSize = 1;         // smaller files are ignored
+    };
+
+    struct Progress {
+        Stage stage = Stage::Idle;
+        uint64_t filesDone = 0;   // in the current stage
+        uint64_t filesTotal = 0;
+        uint64_t bytesRead = 0;   // over all stages
+    };
+
+    DuplicateFinder() = default;
+    ~DuplicateFinder();
+    DuplicateFinder(const DuplicateFinder&) = delete;
+    DuplicateFinder& operator=(const DuplicateFinder&) = delete;
+
+    // Stage 1: regular files under metanode that share their size with
+    // another, by size. Call on the thread that owns the tree.
+    static std::vector<DuplicateCandidate> collect(const FsNode* metanode, int64_t minSize = 1);
+
+    // Stages 2 and 3 on candidates from collect(), on the calling thread.
+    // Returns an empty result if *cancel becomes true.
+    static DuplicateResult find(std::vector<DuplicateCandidate> candidates,
+                                unsigned int ioThreads,
+                                const std::atomic<bool>* cancel = nullptr,
+                                Progress* progress = nullptr,
+                                std::mutex* progressMutex = nullptr);
+
+    // Collect from the tree under metanode and run the rest in the
+    // background, replacing any search in progress.
+    void start(const FsNode* metanode, const Options& options);
+
+    // Stop a running search and wait for it.
+    void cancel();
+
+    // cancel() and forget the last result (the tree is being replaced).
+    void clear();
+
+    bool isRunning() const { return running_.load(); }
+    Progress progress() const;
+
+    // The last finished result, or nullptr.
+    std::shared_ptr<const DuplicateResult> result() const;
+
+private:
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> cancel_{false};
+
+    mutable std::mutex mutex_;  // guards progress_ and result_
+    Progress progress_;
+    std::shared_ptr<const DuplicateResult> result_;
+};
+
+} // namespace fsvng
@@ -0,0 +1,370 @@
+#include "FsDiff.h"
+#include "FsNode.h"
+#include "FsSnapshot.h"
+#include "FsTree.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace fsvng {
+
+namespace {
+
+// Stop splitting the walk once there are this many tasks per thread, or at
+// this depth.
+constexpr size_t TASKS_PER_THREAD = 8;
+constexpr int MAX_PLAN_DEPTH = 4;
+
+struct Pair {
+    FsNode* base;         // nullptr if added
+    const FsNode* cur;
+};
+
+// Totals one walker thread collects.
+struct Tally {
+    std::vector<FsDiff::Removed> removed;
+    int64_t addedBytes = 0;
+    int64_t removedBytes = 0;
+    uint64_t addedNodes = 0;
+    uint64_t removedNodes = 0;
+};
+
+template <typename Node>
+std::vector<Node*> byName(Node* dir) {
+    std::vector<Node*> children;
+    children.reserve(dir->children.size());
+    for (const auto& child : dir->children) {
+        children.push_back(child.get());
+    }
+    std::sort(children.begin(), children.end(), [](Node* a, Node* b) {
+        return a->name < b->name;
+    });
+    return children;
+}
+
+class Walker {
+public:
+    Walker(FsDiff& diff, const std::atomic<bool>* cancel) : diff_(diff), cancel_(cancel) {}
+
+    // Match the children of a directory pair. Matching subdirectories are
+    // diffed right away, or appended to *deferred if given; the caller then
+    // owes finishDir(base, cur) once they are done.
+    void matchChildren(FsNode* base, const FsNode* cur, Tally& tally,
+                       std::vector<Pair>* deferred) {
+        std::vector<FsNode*> baseKids = byName(base);
+        std::vector<const FsNode*> curKids = byName(cur);
+        size_t i = 0, j = 0;
+        while (i < baseKids.size() || j < curKids.size()) {
+            int order;
+            if (i == baseKids.size()) {
+                order = 1;
+            } else if (j == curKids.size()) {
+                order = -1;
+            } else {
+                order = baseKids[i]->name.compare(curKids[j]->name);
+            }
+
+            // A name that changed between file and directory is one entry
+            // gone and another new.
+            if (order == 0 && baseKids[i]->isDir() != curKids[j]->isDir()) {
+                removeEntry(baseKids[i++], cur, tally);
+                addEntry(curKids[j++], tally, deferred);
+            } else if (order == 0) {
+                FsNode* b = baseKids[i++];
+                const FsNode* c = curKids[j++];
+                if (c->isDir()) {
+                    if (deferred) {
+                        deferred->push_back({b, c});
+                    } else {
+                        diffDir(b, c, tally);
+                    }
+                } else {
+                    setDelta(c, ownSize(c) - ownSize(b), 0);
+                }
+            } else if (order < 0) {
+                removeEntry(baseKids[i++], cur, tally);
+            } else {
+                addEntry(curKids[j++], tally, deferred);
+            }
+        }
+    }
+
+    void diffDir(FsNode* base, const FsNode* cur, Tally& tally) {
+        if (cancel_ && cancel_->load()) {
+            return;
+        }
+        matchChildren(base, cur, tally, nullptr);
+        finishDir(base, cur);
+    }
+
+    // With the base side of every child known, total base up and set cur's
+    // delta.
+    void finishDir(FsNode* base, const FsNode* cur) {
+        sumChildren(base);
+        setDelta(cur, subtreeSize(cur) - subtreeSize(base), 0);
+    }
+
+    void markAdded(const FsNode* node, Tally& tally) {
+        tally.addedNodes++;
+        if (node->isDir()) {
+            setDelta(node, subtreeSize(node), FsDiff::ADDED);
+            for (const auto& child : node->children) {
+                markAdded(child.get(), tally);
+            }
+        } else {
+            setDelta(node, ownSize(node), FsDiff::ADDED);
+            tally.addedBytes += countedSize(node);
+        }
+    }
+
+private:
+    int64_t ownSize(const FsNode* node) const {
+        return diff_.allocated ? node->sizeAlloc : node->size;
+    }
+
+    // What the node adds to its parent's subtree total
+    int64_t countedSize(const FsNode* node) const {
+        return (node->flags & NODE_FLAG_DUPLICATE) ? 0 : ownSize(node);
+    }
+
+    int64_t subtreeSize(const FsNode* node) const {
+        return diff_.allocated ? node->subtree.sizeAlloc : node->subtree.size;
+    }
+
+    void setDelta(const FsNode* node, int64_t delta, uint8_t flags) {
+        if (node->id >= diff_.delta.size()) {
+            return;
+        }
+        diff_.delta[node->id] = delta;
+        diff_.flags[node->id] = flags | (delta != 0 ? FsDiff::CHANGED : 0);
+    }
+
+    void sumChildren(FsNode* base) {
+        base->subtree.size = 0;
+        base->subtree.sizeAlloc = 0;
+        for (const auto& child : base->children) {
+            const FsNode* c = child.get();
+            if (!(c->flags & NODE_FLAG_DUPLICATE)) {
+                base->subtree.size += c->size;
+                base->subtree.sizeAlloc += c->sizeAlloc;
+            }
+            if (c->isDir()) {
+                base->subtree.size += c->subtree.size;
+                base->subtree.sizeAlloc += c->subtree.sizeAlloc;
+            }
+        }
+    }
+
+    // Total a removed subtree, counting its nodes and file bytes.
+    void sumRemoved(FsNode* node, Tally& tally) {
+        tally.removedNodes++;
+        if (!node->isDir()) {
+            tally.removedBytes += countedSize(node);
+            return;
+        }
+        for (const auto& child : node->children) {
+            if (child->isDir()) {
+                sumRemoved(child.get(), tally);
+            } else {
+                tally.removedNodes++;
+                tally.removedBytes += countedSize(child.get());
+            }
+        }
+        sumChildren(node);
+    }
+
+    void removeEntry(FsNode* node, const FsNode* curParent, Tally& tally) {
+        sumRemoved(node, tally);
+        int64_t size = countedSize(node) + (node->isDir() ? subtreeSize(node) : 0);
+        tally.removed.push_back({curParent->id, node->name, size, node->isDir()});
+    }
+
+    void addEntry(const FsNode* node, Tally& tally, std::vector<Pair>* deferred) {
+        if (deferred && node->isDir()) {
+            deferred->push_back({nullptr, node});
+        } else {
+            markAdded(node, tally);
+        }
+    }
+
+    FsDiff& diff_;
+    const std::atomic<bool>* cancel_;
+};
+
+} // namespace
+
+// ============================================================================
+// FsDiff
+// ============================================================================
+
+int64_t FsDiff::deltaOf(const FsNode* node) const {
+    return node->id < delta.size() ? delta[node->id] : 0;
+}
+
+uint8_t FsDiff::flagsOf(const FsNode* node) const {
+    return node->id < flags.size() ? flags[node->id] : 0;
+}
+
+FsDiff FsDiff::compare(FsNode* baseMetanode, const FsNode* currentMetanode,
+                       unsigned int currentNodeCount, bool allocated,
+                       unsigned int threadCount, const std::atomic<bool>* cancel) {
+    FsDiff diff;
+    diff.allocated = allocated;
+    if (!baseMetanode || !currentMetanode || baseMetanode->children.empty() ||
+        currentMetanode->children.empty()) {
+        return diff;
+    }
+    diff.delta.assign(currentNodeCount, 0);
+    diff.flags.assign(currentNodeCount, 0);
+
+    // The root directories are compared whatever their paths.
+    FsNode* baseRoot = baseMetanode->children[0].get();
+    const FsNode* curRoot = currentMetanode->children[0].get();
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    Walker walker(diff, cancel);
+    std::vector<Tally> tallies(threadCount);
+
+    // Walk the top levels here until there are enough subtrees to share out.
+    std::vector<Pair> shallow;  // finished bottom-up after the tasks
+    std::vector<Pair> frontier{{baseRoot, curRoot}};
+    std::vector<Pair> tasks;
+    for (int depth = 0; depth < MAX_PLAN_DEPTH && !frontier.empty() &&
+                        frontier.size() + tasks.size() < TASKS_PER_THREAD * threadCount &&
+                        threadCount > 1;
+         ++depth) {
+        std::vector<Pair> next;
+        for (const Pair& pair : frontier) {
+            if (pair.base) {
+                shallow.push_back(pair);
+                walker.matchChildren(pair.base, pair.cur, tallies[0], &next);
+            } else {
+                tasks.push_back(pair);
+            }
+        }
+        frontier = std::move(next);
+    }
+    tasks.insert(tasks.end(), frontier.begin(), frontier.end());
+
+    // Biggest first, so no thread is left with a large subtree at the end.
+    std::sort(tasks.begin(), tasks.end(), [](const Pair& a, const Pair& b) {
+        return a.cur->subtree.size > b.cur->subtree.size;
+    });
+    std::atomic<size_t> next{0};
+    auto run = [&](Tally& tally) {
+        for (size_t i = next++; i < tasks.size(); i = next++) {
+            if (tasks[i].base) {
+                walker.diffDir(tasks[i].base, tasks[i].cur, tally);
+            } else {
+                walker.markAdded(tasks[i].cur, tally);
+            }
+        }
+    };
+    threadCount = static_cast<unsigned int>(std::clamp<size_t>(tasks.size(), 1, threadCount));
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned int t = 1; t < threadCount; ++t) {
+        threads.emplace_back(run, std::ref(tallies[t]));
+    }
+    run(tallies[0]);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    if (cancel && cancel->load()) {
+        return FsDiff();
+    }
+
+    for (auto it = shallow.rbegin(); it != shallow.rend(); ++it) {
+        walker.finishDir(it->base, it->cur);
+    }
+
+    for (Tally& tally : tallies) {
+        diff.addedBytes += tally.addedBytes;
+        diff.removedBytes += tally.removedBytes;
+        diff.addedNodes += tally.addedNodes;
+        diff.removedNodes += tally.removedNodes;
+        diff.removed.insert(diff.removed.end(), std::make_move_iterator(tally.removed.begin()),
+                            std::make_move_iterator(tally.removed.end()));
+    }
+    std::sort(diff.removed.begin(), diff.removed.end(), [](const Removed& a, const Removed& b) {
+        if (a.size != b.size) return a.size > b.size;
+        if (a.parentId != b.parentId) return a.parentId < b.parentId;
+        return a.name < b.name;
+    });
+    diff.totalDelta = diff.deltaOf(curRoot);
+    return diff;
+}
+
+// ============================================================================
+// SnapshotDiff
+// ============================================================================
+
+SnapshotDiff::~SnapshotDiff() {
+    cancel();
+}
+
+void SnapshotDiff::start(const std::string& path, bool allocated) {
+    cancel();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_.clear();
+    }
+    cancel_ = false;
+    running_ = true;
+    thread_ = std::thread([this, path, allocated] {
+        std::string error;
+        std::unique_ptr<FsNode> baseline = FsSnapshot::load(path, &error);
+        std::shared_ptr<const FsDiff> result;
+        if (baseline && !cancel_.load()) {
+            FsTree& tree = FsTree::instance();
+            result = std::make_shared<const FsDiff>(FsDiff::compare(
+                baseline.get(), tree.root(), tree.nodeCount(), allocated, 0, &cancel_));
+        }
+        baseline.reset();
+
+        if (!cancel_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (result) {
+                result_ = std::move(result);
+                baselinePath_ = path;
+            } else {
+                error_ = error;
+            }
+        }
+        running_ = false;
+    });
+}
+
+std::shared_ptr<const FsDiff> SnapshotDiff::result() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return result_;
+}
+
+std::string SnapshotDiff::error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+}
+
+std::string SnapshotDiff::baselinePath() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return baselinePath_;
+}
+
+void SnapshotDiff::cancel() {
+    cancel_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SnapshotDiff::clear() {
+    cancel();
+    std::lock_guard<std::mutex> lock(mutex_);
+    result_.reset();
+    error_.clear();
+    baselinePath_.clear();
+}
+
+} // namespace fsvng
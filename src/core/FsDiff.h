@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fsvng {
+
+class FsNode;
+
+// ============================================================================
+// FsDiff - what changed between an earlier scan (a loaded snapshot) and the
+// current tree
+//
+// The two trees are aligned by path: each pair of matching directories has
+// its children sorted by name on both sides and merge-walked. The walk is
+// split into subtree tasks run in parallel, as in FsTree::setupTree().
+// Every node of the current tree gets a size delta (for directories, the
+// change in subtree size) and an ADDED/CHANGED flag; entries that are gone
+// are listed by the current directory that lost them.
+// ============================================================================
+
+struct FsDiff {
+    enum : uint8_t {
+        ADDED = 1 << 0,    // not in the baseline
+        CHANGED = 1 << 1   // size (subtree size for directories) differs
+    };
+
+    // A file or directory gone since the baseline; only the topmost of a
+    // removed subtree is listed.
+    struct Removed {
+        unsigned int parentId;  // in the current tree
+        std::string name;
+        int64_t size;           // with everything below it
+        bool dir;
+    };
+
+    bool allocated = false;          // deltas of sizeAlloc instead of size
+    std::vector<int64_t> delta;      // by current node ID
+    std::vector<uint8_t> flags;      // by current node ID
+    std::vector<Removed> removed;    // largest first
+    int64_t totalDelta = 0;          // of the root directory
+    int64_t addedBytes = 0;          // in files that are new
+    int64_t removedBytes = 0;        // in files that are gone
+    uint64_t addedNodes = 0;
+    uint64_t removedNodes = 0;
+
+    // 0 for nodes created after the comparison
+    int64_t deltaOf(const FsNode* node) const;
+    uint8_t flagsOf(const FsNode* node) const;
+
+    // Compare the tree under baseMetanode (e.g. from FsSnapshot::load();
+    // its subtree totals are filled in) with currentMetanode, which must be
+    // set up and have IDs below currentNodeCount. Returns an empty diff if
+    // *cancel becomes true.
+    static FsDiff compare(FsNode* baseMetanode, const FsNode* currentMetanode,
+                          unsigned int currentNodeCount, bool allocated = false,
+                          unsigned int threadCount = 0,
+                          const std::atomic<bool>* cancel = nullptr);
+};
+
+// ============================================================================
+// SnapshotDiff - loads a snapshot and compares FsTree's tree with it on a
+// worker thread
+//
+// While isRunning() the worker may read the tree, so its owner must hold
+// back any change to it (or cancel() first).
+// ============================================================================
+
+class SnapshotDiff {
+public:
+    SnapshotDiff() = default;
+    ~SnapshotDiff();
+    SnapshotDiff(const SnapshotDiff&) = delete;
+    SnapshotDiff& operator=(const SnapshotDiff&) = delete;
+
+    // Compare with the snapshot at path, replacing any comparison running.
+    void start(const std::string& path, bool allocated);
+
+    bool isRunning() const { return running_.load(); }
+
+    // The last finished comparison, or nullptr.
+    std::shared_ptr<const FsDiff> result() const;
+
+    // Why the last comparison failed, or empty.
+    std::string error() const;
+
+    // Snapshot the last result was compared with.
+    std::string baselinePath() const;
+
+    void cancel();
+
+    // cancel() and forget the last result (the tree is being replaced).
+    void clear();
+
+private:
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> cancel_{false};
+
+    mutable std::mutex mutex_;  // guards everything below
+    std::shared_ptr<const FsDiff> result_;
+    std::string error_;
+    std::string baselinePath_;
+};
+
+} // namespace fsvng
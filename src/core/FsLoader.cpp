@@ -0,0 +1,203 @@
+#include "FsLoader.h"
+#include "FsTree.h"
+
+#include <algorithm>
+
+namespace fsvng {
+
+namespace {
+
+void assignIds(FsNode* node, FsTree& tree) {
+    node->id = tree.allocateId();
+    for (auto& child : node->children) {
+        assignIds(child.get(), tree);
+    }
+}
+
+} // namespace
+
+FsLoader::~FsLoader() {
+    stop();
+}
+
+// ============================================================================
+// Start / stop
+// ============================================================================
+
+void FsLoader::start() {
+    stop();
+    scanner_.options = options;
+    running_ = true;
+    thread_ = std::thread(&FsLoader::workerLoop, this);
+}
+
+void FsLoader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        scanner_.cancelRequested.store(true);
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.clear();
+    queued_.clear();
+    results_.clear();
+    currentPath_.clear();
+}
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+void FsLoader::request(const FsNode* dir, bool urgent) {
+    if (!dir || !(dir->flags & NODE_FLAG_UNSCANNED)) {
+        return;
+    }
+    enqueue(dir->absName(), urgent);
+}
+
+void FsLoader::requestPlaceholders(const FsNode* node) {
+    // Breadth-first, so shallow placeholders (the ones most likely to be
+    // looked at next) are filled first.
+    std::deque<const FsNode*> queue{node};
+    while (!queue.empty()) {
+        const FsNode* n = queue.front();
+        queue.pop_front();
+        if (n->flags & NODE_FLAG_UNSCANNED) {
+            enqueue(n->absName(), false);
+        }
+        for (const auto& child : n->children) {
+            if (child->isDir()) {
+                queue.push_back(child.get());
+            }
+        }
+    }
+}
+
+void FsLoader::enqueue(const std::string& path, bool urgent) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (path == currentPath_) {
+            currentUrgent_ = currentUrgent_ || urgent;
+            return;
+        }
+        if (queued_.count(path)) {
+            if (!urgent) {
+                return;
+            }
+            auto it = std::find_if(jobs_.begin(), jobs_.end(),
+                                   [&](const Job& job) { return job.path == path; });
+            if (it != jobs_.end()) {
+                jobs_.erase(it);
+            }
+        }
+        queued_.insert(path);
+        if (urgent) {
+            jobs_.push_front({path, true});
+            // Don't make the user wait for a background job to finish.
+            if (!currentPath_.empty() && !currentUrgent_) {
+                scanner_.cancelRequested.store(true);
+            }
+        } else {
+            jobs_.push_back({path, false});
+        }
+    }
+    cv_.notify_one();
+}
+
+// ============================================================================
+// Worker thread - scans detached trees, never touches FsTree
+// ============================================================================
+
+void FsLoader::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_.load()) {
+        cv_.wait(lock, [this] { return !running_.load() || !jobs_.empty(); });
+        if (!running_.load()) {
+            break;
+        }
+
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        queued_.erase(job.path);
+        currentPath_ = job.path;
+        currentUrgent_ = job.urgent;
+        scanner_.cancelRequested.store(false);
+
+        lock.unlock();
+        std::unique_ptr<FsNode> tree = scanner_.scan(job.path);
+        lock.lock();
+
+        if (!running_.load()) {
+            break;
+        }
+        if (scanner_.cancelRequested.load()) {
+            // Preempted: resume right after the urgent jobs.
+            auto it = std::find_if(jobs_.begin(), jobs_.end(),
+                                   [](const Job& j) { return !j.urgent; });
+            jobs_.insert(it, std::move(job));
+            queued_.insert(currentPath_);
+        } else {
+            results_.push_back({job.path, currentUrgent_, std::move(tree)});
+        }
+        currentPath_.clear();
+    }
+}
+
+// ============================================================================
+// Applying results
+// ============================================================================
+
+size_t FsLoader::completedCount(bool* urgent) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (urgent) {
+        *urgent = std::any_of(results_.begin(), results_.end(),
+                              [](const Result& r) { return r.urgent; });
+    }
+    return results_.size();
+}
+
+bool FsLoader::isIdle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.empty() && currentPath_.empty() && results_.empty();
+}
+
+std::vector<FsNode*> FsLoader::applyCompleted() {
+    std::vector<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        results.swap(results_);
+    }
+
+    FsTree& tree = FsTree::instance();
+    std::vector<FsNode*> filled;
+    for (Result& result : results) {
+        // The placeholder may have been removed or filled in meanwhile.
+        FsNode* dir = tree.nodeByPath(result.path);
+        if (!dir || !dir->isDir() || !(dir->flags & NODE_FLAG_UNSCANNED) ||
+            !result.tree || result.tree->children.empty()) {
+            continue;
+        }
+
+        FsNode* scanned = result.tree->children[0].get();
+        dir->children = std::move(scanned->children);
+        for (auto& child : dir->children) {
+            child->parent = dir;
+            assignIds(child.get(), tree);
+        }
+        dir->flags &= static_cast<uint16_t>(~NODE_FLAG_UNSCANNED);
+        dir->markDirty();
+        filled.push_back(dir);
+    }
+
+    for (FsNode* dir : filled) {
+        requestPlaceholders(dir);
+    }
+    return filled;
+}
+
+} // namespace fsvng
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "FsNode.h"
+#include "FsScanner.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace fsvng {
+
+// ============================================================================
+// FsLoader - fills in placeholder directories left by a depth-limited scan
+//
+// A worker thread scans one placeholder at a time into a detached tree,
+// itself limited to options.maxDepth, so even a huge subtree arrives in
+// bounded steps. applyCompleted() grafts the results into FsTree on the
+// thread that owns it and queues the new placeholders they contain as
+// background work. Urgent requests (the user expanded a placeholder) go
+// ahead of background work and preempt a running background job.
+// ============================================================================
+
+class FsLoader {
+public:
+    FsLoader() = default;
+    ~FsLoader();
+    FsLoader(const FsLoader&) = delete;
+    FsLoader& operator=(const FsLoader&) = delete;
+
+    // Set before start(). maxDepth bounds each job (0 scans whole subtrees).
+    ScanOptions options;
+
+    void start();
+    // Cancel the running job and drop everything queued or completed.
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // Queue a placeholder directory (NODE_FLAG_UNSCANNED) for loading.
+    void request(const FsNode* dir, bool urgent);
+
+    // Queue every placeholder at or below node as background work,
+    // shallowest first.
+    void requestPlaceholders(const FsNode* node);
+
+    // Finished jobs waiting for applyCompleted(); *urgent is set if any of
+    // them was requested urgently.
+    size_t completedCount(bool* urgent = nullptr) const;
+
+    // True when nothing is queued, running or waiting to be applied.
+    bool isIdle() const;
+
+    // Graft finished subtrees into FsTree. Returns the directories that
+    // were filled; their spines are flagged for FsTree::updateTree(), which
+    // must run before the next call so new placeholders can be looked up.
+    std::vector<FsNode*> applyCompleted();
+
+private:
+    struct Job {
+        std::string path;
+        bool urgent = false;
+    };
+    struct Result {
+        std::string path;
+        bool urgent = false;
+        std::unique_ptr<FsNode> tree;
+    };
+
+    void workerLoop();
+    void enqueue(const std::string& path, bool urgent);
+
+    FsScanner scanner_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // Guards everything below; shared with the worker thread.
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Job> jobs_;                 // urgent jobs first
+    std::unordered_set<std::string> queued_;
+    std::vector<Result> results_;
+    std::string currentPath_;              // job being scanned, if any
+    bool currentUrgent_ = false;
+};
+
+} // namespace fsvng
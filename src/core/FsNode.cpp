@@ -11,9 +11,11 @@ namespace fsvng {
 std::string FsNode::absName() const {
     // Collect names from this node up to the root (including metanode).
     std::vector<const FsNode*> ancestors;
+    size_t length = 0;
     const FsNode* cur = this;
     while (cur != nullptr) {
         ancestors.push_back(cur);
+        length += cur->name.size() + 1;
         cur = cur->parent;
     }
 
@@ -22,6 +24,7 @@ std::string FsNode::absName() const {
 
     // Build the path.
     std::string path;
+    path.reserve(length);
     for (size_t i = 0; i < ancestors.size(); ++i) {
         const std::string& n = ancestors[i]->name;
         if (i == 0) {
@@ -46,4 +49,35 @@ FsNode* FsNode::addChild(std::unique_ptr<FsNode> child) {
     return raw;
 }
 
+void FsNode::markDirty() {
+    for (FsNode* node = this; node != nullptr; node = node->parent) {
+        node->flags |= NODE_FLAG_SUBTREE_DIRTY;
+    }
+}
+
+bool FsNode::isWithin(const FsNode* ancestor) const {
+    for (const FsNode* node = this; node != nullptr; node = node->parent) {
+        if (node == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FsNode::copyStat(const FsNode& src) {
+    type = src.type;
+    size = src.size;
+    sizeAlloc = src.sizeAlloc;
+    userId = src.userId;
+    groupId = src.groupId;
+    perms = src.perms;
+    atime = src.atime;
+    mtime = src.mtime;
+    ctime = src.ctime;
+    inode = src.inode;
+    device = src.device;
+    flags = static_cast<uint16_t>((flags & ~NODE_FLAG_MULTILINK) |
+                                  (src.flags & NODE_FLAG_MULTILINK));
+}
+
 } // namespace fsvng
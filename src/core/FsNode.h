@@ -1,8 +1,11 @@
 #pragma once
 
+#include "NodePool.h"
+#include "GeometryStore.h"
 #include "Types.h"
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -10,61 +13,77 @@
 namespace fsvng {
 
 // ============================================================================
-// Geometry parameter structs - one per visualization mode
+// FsNode - unified filesystem node
 // ============================================================================
 
-struct DiscVGeomParams {
-    double radius = 0.0;
-    double theta = 0.0;
-    XYvec pos{};
-};
+// Core bits for FsNode::flags. The low bits belong to the layouts
+// (e.g. TreeVLayout::NEED_REARRANGE).
+enum NodeFlags : uint16_t {
+    // Subtree totals and child order are out of date; FsTree::updateTree()
+    // re-aggregates every node carrying this flag. New nodes start dirty.
+    NODE_FLAG_SUBTREE_DIRTY = 0x8000,
+
+    // Directory left unread by a depth-limited scan (ScanOptions::maxDepth);
+    // it has no children until FsLoader fills it in.
+    NODE_FLAG_UNSCANNED = 0x4000,
+
+    // Non-directory with more than one hard link (st_nlink > 1).
+    NODE_FLAG_MULTILINK = 0x2000,
 
-struct MapVGeomParams {
-    XYvec c0{};   // lower-left corner
-    XYvec c1{};   // upper-right corner
-    double height = 0.0;
+    // Same (device, inode) as another node in the tree: a further hard link
+    // to a file, or a directory seen again through a bind mount. Its bytes
+    // are not counted in subtree totals and a duplicate directory is not read.
+    NODE_FLAG_DUPLICATE = 0x1000
 };
 
-struct TreeVGeomParams {
-    struct {
-        double distance = 0.0;
-        double theta = 0.0;
-        double height = 0.0;
-    } leaf;
-    struct {
-        double theta = 0.0;
-        double depth = 0.0;
-        double arc_width = 0.0;
-        double height = 0.0;
-        double subtree_arc_width = 0.0;
-    } platform;
+// Identifies a file across every filesystem a scan may cross.
+struct FileKey {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+
+    bool operator==(const FileKey& other) const {
+        return device == other.device && inode == other.inode;
+    }
 };
 
-// ============================================================================
-// FsNode - unified filesystem node
-// ============================================================================
+struct FileKeyHash {
+    size_t operator()(const FileKey& key) const {
+        return std::hash<uint64_t>()(key.inode * 0x9E3779B97F4A7C15ULL ^ key.device);
+    }
+};
 
 class FsNode {
 public:
+    // Heap-allocated nodes come from NodePool blocks, not individual mallocs.
+    static void* operator new(size_t size) { return NodePool::allocate(size); }
+    static void operator delete(void* p) { NodePool::release(p); }
+
     // Base fields (from NodeDesc)
     NodeType type = NODE_UNKNOWN;
-    unsigned int id = 0;
+    unsigned int id = INVALID_NODE_ID;
     std::string name;
     int64_t size = 0;
     int64_t sizeAlloc = 0;
     uint32_t userId = 0;
     uint32_t groupId = 0;
     uint16_t perms = 0;
-    uint16_t flags = 0;
+    uint16_t flags = NODE_FLAG_SUBTREE_DIRTY;
     time_t atime = 0;
     time_t mtime = 0;
     time_t ctime = 0;
+    uint64_t inode = 0;       // 0 where the platform has no inode numbers
+    uint64_t device = 0;      // st_dev of the containing filesystem, or 0
     const RGBcolor* color = nullptr;
 
-    // Geometry params - one struct per visualization mode
-    DiscVGeomParams discvGeom{};
-    MapVGeomParams mapvGeom{};
-    TreeVGeomParams treevGeom{};
+    // Geometry params - one struct per visualization mode, held in
+    // GeometryStore side arrays keyed by id rather than on the node. The
+    // const forms only read, seeing zeroed geometry where none is stored.
+    DiscVGeomParams& discvGeom() { return GeometryStore::instance().discv[id]; }
+    MapVGeomParams& mapvGeom() { return GeometryStore::instance().mapv[id]; }
+    TreeVGeomParams& treevGeom() { return GeometryStore::instance().treev[id]; }
+    const DiscVGeomParams& discvGeom() const { return GeometryStore::instance().discv.get(id); }
+    const MapVGeomParams& mapvGeom() const { return GeometryStore::instance().mapv.get(id); }
+    const TreeVGeomParams& treevGeom() const { return GeometryStore::instance().treev.get(id); }
 
     // Transient glow intensity (set by PulseEffect each frame, not persisted)
     float glowIntensity = 0.0f;
@@ -74,6 +93,7 @@ public:
 
     struct {
         int64_t size = 0;
+        int64_t sizeAlloc = 0;  // allocated (on-disk) bytes
         unsigned int counts[NUM_NODE_TYPES] = {};
     } subtree;
 
@@ -92,22 +112,33 @@ public:
     bool isMetanode() const { return type == NODE_METANODE; }
     bool isCollapsed() const { return deployment < EPSILON; }
     bool isExpanded() const { return deployment > (1.0 - EPSILON); }
+    FileKey fileKey() const { return {device, inode}; }
 
     size_t childCount() const { return children.size(); }
 
     // MapV helper methods (replacing macros from original)
-    double mapvWidth() const { return mapvGeom.c1.x - mapvGeom.c0.x; }
-    double mapvDepth() const { return mapvGeom.c1.y - mapvGeom.c0.y; }
-    double mapvCenterX() const { return 0.5 * (mapvGeom.c0.x + mapvGeom.c1.x); }
-    double mapvCenterY() const { return 0.5 * (mapvGeom.c0.y + mapvGeom.c1.y); }
+    double mapvWidth() const { const auto& g = mapvGeom(); return g.c1.x - g.c0.x; }
+    double mapvDepth() const { const auto& g = mapvGeom(); return g.c1.y - g.c0.y; }
+    double mapvCenterX() const { const auto& g = mapvGeom(); return 0.5 * (g.c0.x + g.c1.x); }
+    double mapvCenterY() const { const auto& g = mapvGeom(); return 0.5 * (g.c0.y + g.c1.y); }
 
     // --- Methods implemented in .cpp ---
 
-    // Build absolute path by traversing parent pointers
+    // Build absolute path by traversing parent pointers (not cached)
     std::string absName() const;
 
     // Add a child node; sets child's parent pointer. Returns raw pointer.
     FsNode* addChild(std::unique_ptr<FsNode> child);
+
+    // Flag this node and all its ancestors for FsTree::updateTree().
+    void markDirty();
+
+    // True if this node is ancestor or lies somewhere below it.
+    bool isWithin(const FsNode* ancestor) const;
+
+    // Copy type, sizes, ownership, permissions, timestamps, inode, device
+    // and the multilink flag from src.
+    void copyStat(const FsNode& src);
 };
 
 } // namespace fsvng
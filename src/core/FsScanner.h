@@ -1,13 +1,19 @@
 #pragma once
 
 #include "FsNode.h"
+#include "ScanFilter.h"
 #include "Types.h"
 
+#include <array>
 #include <atomic>
 #include <filesystem>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace fsvng {
 
@@ -19,11 +25,51 @@ struct ScanStats {
     int nodeCounts[NUM_NODE_TYPES] = {};
     int64_t sizeCounts[NUM_NODE_TYPES] = {};
     int statCount = 0;
+
+    // Accumulate another set of counters into this one.
+    void merge(const ScanStats& other);
 };
 
 // Callback invoked periodically during scanning to report progress.
+// With more than one scan thread, it may be called from any worker (calls
+// are serialized, never concurrent).
 using ScanProgressCallback = std::function<void(const std::string& currentDir, const ScanStats& stats)>;
 
+// ============================================================================
+// Scan options
+// ============================================================================
+
+enum class ScanBackend {
+    Auto,       // Fastest backend available on this platform
+    Portable,   // std::filesystem directory_iterator + status queries
+    Getdents,   // Linux only: bulk getdents64 + one statx per entry
+    IoUring     // Linux only: getdents64 + each directory's statx calls
+                // submitted as one io_uring batch; falls back to Getdents
+                // when io_uring is unavailable
+};
+
+struct ScanOptions {
+    // Number of worker threads. 1 scans serially on the calling thread;
+    // 0 uses one worker per hardware thread.
+    unsigned int threadCount = 1;
+
+    // How directories are enumerated and stat'ed.
+    ScanBackend backend = ScanBackend::Auto;
+
+    // Read directories only this many levels below the root (1 reads just
+    // the root's entries). Deeper directories are kept as childless
+    // placeholders flagged NODE_FLAG_UNSCANNED. 0 reads the whole tree.
+    unsigned int maxDepth = 0;
+
+    // Stay on the root's filesystem (like du -x): directories on another
+    // device, i.e. mount points, are kept but not read.
+    bool oneFileSystem = false;
+
+    // Entries to leave out, pruned before they are stat'ed or opened: names
+    // (".git", "*.o") or absolute paths ("/proc"); see ScanFilter.
+    std::vector<std::string> exclude;
+};
+
 // ============================================================================
 // FsScanner - filesystem scanner using std::filesystem
 // ============================================================================
@@ -32,28 +78,146 @@ class FsScanner {
 public:
     // Scan a directory tree rooted at rootPath.
     // Returns a metanode whose first child is the scanned root directory.
+    // The metanode's mtime records when the scan started. Nodes are not
+    // numbered yet; FsTree::setupTree() does that.
     // The caller takes ownership of the returned tree.
     std::unique_ptr<FsNode> scan(const std::string& rootPath,
                                   ScanProgressCallback progressCb = nullptr);
 
+    // Bring a tree returned by scan() (or loaded from a snapshot) up to date
+    // in place. Directories whose inode and mtime are unchanged keep their
+    // children untouched; changed directories are re-enumerated, reusing
+    // the existing node (ID, geometry) of every entry still present, and new
+    // directories are scanned in full. Changes are flagged for
+    // FsTree::updateTree(); a tree taken out with FsTree::releaseRoot() goes
+    // back with restoreRoot(), which keeps that geometry. Always runs on the
+    // calling thread.
+    //
+    // A directory's mtime only moves when entries are added, removed or
+    // renamed, so a file rewritten in place inside an otherwise unchanged
+    // directory keeps its old size until the next full scan.
+    // Returns false if the root directory can no longer be stat'ed.
+    bool rescan(FsNode* metanode, ScanProgressCallback progressCb = nullptr);
+
+    // What the last rescan() changed, for callers that keep views of the
+    // tree: the directories whose entries were re-read or dropped, and the
+    // subtrees cut out of the tree. Those are detached but not freed until
+    // taken and released, and their parent pointers still lead back into
+    // the tree, so references to them can be found and dropped first.
+    const std::vector<FsNode*>& changedDirs() const { return changedDirs_; }
+    std::vector<std::unique_ptr<FsNode>> takeRemoved() { return std::exchange(removed_, {}); }
+
+    // Stat a single path into node without following a final symlink.
+    // Returns false if it can't be stat'ed.
+    bool statPath(const std::filesystem::path& path, FsNode* node);
+
+    // Set before calling scan()
+    ScanOptions options;
+
     // Set to true from another thread to cancel a running scan
     std::atomic<bool> cancelRequested{false};
 
 private:
+    // Pick backend_ from options.backend and what this build supports.
+    void resolveBackend();
+
+    // Compile options.exclude into filter_ if it changed since last time.
+    void compileFilter();
+
     // Recursively process a directory, adding children to parentNode.
     void processDir(const std::filesystem::path& dirPath, FsNode* parentNode, int depth);
 
+    // Work-stealing parallel traversal below rootNode (see FsScanner.cpp).
+    void processDirParallel(const std::filesystem::path& rootPath, FsNode* rootNode,
+                            unsigned int threadCount);
+
+    // True if directory node at path must not be read: it is on another
+    // filesystem in oneFileSystem mode, or its (device, inode) was already
+    // claimed during this scan through a path sorting before this one, e.g.
+    // by a bind mount (flagged NODE_FLAG_DUPLICATE). A copy that claims a
+    // directory read before under a later path displaces it.
+    bool skipDir(FsNode* node, const std::filesystem::path& path);
+
+    void clearVisited();
+
+    // Once the walk is done, empty the copies displaced by skipDir().
+    void dropDisplacedDirs(FsNode* metanode);
+    void emptyDuplicateDirs(FsNode* dir);
+
+    // Detach dir's children (all, or from first on) into removed_ and record
+    // dir in changedDirs_.
+    void dropChildren(FsNode* dir, size_t first = 0);
+
+    // Lazy scan: flag node as a placeholder instead of reading it when it
+    // lies deeper than options.maxDepth.
+    bool deferDir(FsNode* node, int depth);
+
+    // Enumerate one directory and attach its entries to dirNode.
+    // Only the caller touches dirNode->children, so no locking is needed.
+    void readDir(const std::filesystem::path& dirPath, FsNode* dirNode, ScanStats& stats);
+
+#ifdef __linux__
+    // readDir() for ScanBackend::Getdents and ScanBackend::IoUring.
+    void readDirGetdents(const std::filesystem::path& dirPath, FsNode* dirNode, ScanStats& stats);
+#endif
+
+    // Number a subtree rescan() added, depth-first from nextId_. scan()
+    // leaves numbering to FsTree::setupTree().
+    void assignIds(FsNode* node);
+
+    // Rescan helpers: refreshDir() re-stats dirNode and decides whether its
+    // entries must be re-read; refreshEntries() re-reads them and merges the
+    // result into the existing children.
+    void refreshDir(const std::filesystem::path& dirPath, FsNode* dirNode, int depth,
+                    time_t previousScanTime);
+    void refreshEntries(const std::filesystem::path& dirPath, FsNode* dirNode, int depth,
+                        time_t previousScanTime);
+
+#ifdef _WIN32
     // Map std::filesystem::file_type to our NodeType enum.
     NodeType classifyFileType(std::filesystem::file_type ft) const;
 
     // Populate stat fields (size, timestamps, etc.) from filesystem status.
+    // POSIX builds fill the same fields from a single lstat() instead.
     void populateStats(FsNode* node, const std::filesystem::path& entryPath,
                        const std::filesystem::file_status& status);
+#endif
 
+    // Fold a worker's pending counters into stats_ and report progress.
+    void flushProgress(const std::string& currentDir, ScanStats& pending);
+
+    ScanBackend backend_ = ScanBackend::Portable;
+    ScanFilter filter_;
+    std::vector<std::string> filterRules_;  // options.exclude behind filter_
     ScanStats stats_{};
     ScanProgressCallback progressCb_;
+    std::mutex progressMutex_;
     unsigned int nextId_ = 0;
     double lastProgressTime_ = 0.0;
+
+    // Directories read so far, by (device, inode), sharded so that scan
+    // workers rarely wait on each other; a bind mount's second view is
+    // skipped. The copy kept is the one with the smallest path, whatever
+    // order the workers reach them in.
+    struct VisitedDir {
+        std::filesystem::path path;
+        FsNode* node;
+    };
+    struct VisitedShard {
+        std::mutex mutex;
+        std::unordered_map<FileKey, VisitedDir, FileKeyHash> dirs;
+        std::vector<FsNode*> displaced;  // read, then claimed by a smaller path
+    };
+    static constexpr size_t VISITED_SHARDS = 64;
+    std::array<VisitedShard, VISITED_SHARDS> visited_;
+    uint64_t rootDevice_ = 0;
+
+    // Subtrees created by the current rescan, numbered once it finishes.
+    std::vector<FsNode*> freshNodes_;
+
+    // See changedDirs() and takeRemoved(). scan() frees what it removes.
+    std::vector<FsNode*> changedDirs_;
+    std::vector<std::unique_ptr<FsNode>> removed_;
 };
 
 } // namespace fsvng
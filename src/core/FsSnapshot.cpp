@@ -0,0 +1,326 @@
+#include "FsSnapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fsvng {
+namespace FsSnapshot {
+
+namespace {
+
+void setError(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+// ============================================================================
+// MappedFile - read-only memory mapping of a whole file
+// ============================================================================
+
+class MappedFile {
+public:
+    ~MappedFile() { unmap(); }
+
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file_, &fileSize) || fileSize.QuadPart == 0) {
+            return false;
+        }
+        size_ = static_cast<size_t>(fileSize.QuadPart);
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) {
+            return false;
+        }
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        return data_ != nullptr;
+#else
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        // Records are consumed front to back exactly once.
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+        return true;
+#endif
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void unmap() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) munmap(const_cast<char*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace
+
+// ============================================================================
+// save
+// ============================================================================
+
+bool save(const FsNode* metanode, const std::string& path, std::string* error) {
+    if (!metanode) {
+        setError(error, "No tree to save");
+        return false;
+    }
+
+    // Breadth-first numbering: a node's children are appended to the queue
+    // together, so they land in one contiguous record range.
+    std::vector<SnapshotRecord> records;
+    std::string names;
+    std::deque<const FsNode*> queue;
+    queue.push_back(metanode);
+    uint32_t nextIndex = 1;
+
+    while (!queue.empty()) {
+        const FsNode* node = queue.front();
+        queue.pop_front();
+
+        SnapshotRecord rec;
+        std::memset(&rec, 0, sizeof(rec));
+        rec.nameOffset = names.size();
+        rec.nameLength = static_cast<uint32_t>(node->name.size());
+        rec.id = static_cast<uint32_t>(records.size());  // as setupTree() numbers
+        rec.firstChild = nextIndex;
+        rec.childCount = static_cast<uint32_t>(node->children.size());
+        rec.userId = node->userId;
+        rec.groupId = node->groupId;
+        rec.size = node->size;
+        rec.sizeAlloc = node->sizeAlloc;
+        rec.inode = node->inode;
+        rec.device = node->device;
+        rec.atime = static_cast<int64_t>(node->atime);
+        rec.mtime = static_cast<int64_t>(node->mtime);
+        rec.ctime = static_cast<int64_t>(node->ctime);
+        rec.perms = node->perms;
+        rec.type = static_cast<uint8_t>(node->type);
+        if (node->flags & NODE_FLAG_UNSCANNED) {
+            rec.flags |= SNAPSHOT_FLAG_UNSCANNED;
+        }
+        if (node->flags & NODE_FLAG_MULTILINK) {
+            rec.flags |= SNAPSHOT_FLAG_MULTILINK;
+        }
+        if (node->flags & NODE_FLAG_DUPLICATE) {
+            rec.flags |= SNAPSHOT_FLAG_DUPLICATE;
+        }
+        records.push_back(rec);
+        names += node->name;
+
+        nextIndex += rec.childCount;
+        for (const auto& child : node->children) {
+            queue.push_back(child.get());
+        }
+    }
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.recordSize = sizeof(SnapshotRecord);
+    header.nodeCount = records.size();
+    header.recordsOffset = sizeof(SnapshotHeader);
+    header.namesOffset = header.recordsOffset + records.size() * sizeof(SnapshotRecord);
+    header.namesSize = names.size();
+    header.createdTime = static_cast<int64_t>(std::time(nullptr));
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            setError(error, "Cannot open " + tmpPath + " for writing");
+            return false;
+        }
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(records.data()),
+                  static_cast<std::streamsize>(records.size() * sizeof(SnapshotRecord)));
+        ofs.write(names.data(), static_cast<std::streamsize>(names.size()));
+        if (!ofs.good()) {
+            setError(error, "Write to " + tmpPath + " failed");
+            ofs.close();
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    bool renamed = MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+    if (!renamed) {
+        setError(error, "Cannot replace " + path);
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// load
+// ============================================================================
+
+std::unique_ptr<FsNode> load(const std::string& path, std::string* error) {
+    MappedFile file;
+    if (!file.map(path)) {
+        setError(error, "Cannot open " + path);
+        return nullptr;
+    }
+
+    // Validate the header and that every section lies inside the file.
+    if (file.size() < sizeof(SnapshotHeader)) {
+        setError(error, "Not a snapshot file: " + path);
+        return nullptr;
+    }
+    SnapshotHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0) {
+        setError(error, "Not a snapshot file: " + path);
+        return nullptr;
+    }
+    if (header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK ||
+        header.headerSize != sizeof(SnapshotHeader) ||
+        header.recordSize != sizeof(SnapshotRecord)) {
+        setError(error, "Unsupported snapshot version or byte order: " + path);
+        return nullptr;
+    }
+    uint64_t fileSize = file.size();
+    if (header.nodeCount < 2 ||
+        header.recordsOffset > fileSize ||
+        header.nodeCount > (fileSize - header.recordsOffset) / sizeof(SnapshotRecord) ||
+        header.namesOffset > fileSize ||
+        header.namesSize > fileSize - header.namesOffset) {
+        setError(error, "Truncated snapshot: " + path);
+        return nullptr;
+    }
+
+    const auto* records = reinterpret_cast<const SnapshotRecord*>(file.data() + header.recordsOffset);
+    const char* names = file.data() + header.namesOffset;
+    const uint64_t count = header.nodeCount;
+
+    std::vector<FsNode*> nodes(count, nullptr);
+    auto metanode = std::make_unique<FsNode>();
+    nodes[0] = metanode.get();
+
+    // Records are breadth-first, so a parent always exists before its
+    // children; each child range is checked to start past its parent.
+    for (uint64_t i = 0; i < count; ++i) {
+        const SnapshotRecord& rec = records[i];
+        FsNode* node = nodes[i];
+        if (!node || rec.type >= NUM_NODE_TYPES || rec.id >= count ||
+            rec.nameOffset > header.namesSize ||
+            rec.nameLength > header.namesSize - rec.nameOffset ||
+            (rec.childCount > 0 &&
+             (rec.firstChild <= i || rec.firstChild > count ||
+              rec.childCount > count - rec.firstChild))) {
+            setError(error, "Corrupt snapshot: " + path);
+            return nullptr;
+        }
+
+        node->type = static_cast<NodeType>(rec.type);
+        node->id = rec.id;
+        node->name.assign(names + rec.nameOffset, rec.nameLength);
+        node->size = rec.size;
+        node->sizeAlloc = rec.sizeAlloc;
+        node->inode = rec.inode;
+        node->device = rec.device;
+        node->userId = rec.userId;
+        node->groupId = rec.groupId;
+        node->perms = rec.perms;
+        node->atime = static_cast<time_t>(rec.atime);
+        node->mtime = static_cast<time_t>(rec.mtime);
+        node->ctime = static_cast<time_t>(rec.ctime);
+        if (rec.flags & SNAPSHOT_FLAG_UNSCANNED) {
+            node->flags |= NODE_FLAG_UNSCANNED;
+        }
+        if (rec.flags & SNAPSHOT_FLAG_MULTILINK) {
+            node->flags |= NODE_FLAG_MULTILINK;
+        }
+        if (rec.flags & SNAPSHOT_FLAG_DUPLICATE) {
+            node->flags |= NODE_FLAG_DUPLICATE;
+        }
+
+        node->children.reserve(rec.childCount);
+        for (uint32_t c = 0; c < rec.childCount; ++c) {
+            uint64_t childIndex = static_cast<uint64_t>(rec.firstChild) + c;
+            if (nodes[childIndex]) {
+                setError(error, "Corrupt snapshot: " + path);
+                return nullptr;
+            }
+            nodes[childIndex] = node->addChild(std::make_unique<FsNode>());
+        }
+    }
+
+    if (metanode->type != NODE_METANODE || metanode->children.empty() ||
+        !metanode->children[0]->isDir()) {
+        setError(error, "Corrupt snapshot: " + path);
+        return nullptr;
+    }
+    return metanode;
+}
+
+bool isSnapshot(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (!ifs.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+} // namespace FsSnapshot
+} // namespace fsvng
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "FsNode.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace fsvng {
+
+// ============================================================================
+// FsSnapshot - persistent binary scan snapshots
+//
+// File layout (host byte order, checked on load):
+//   SnapshotHeader
+//   SnapshotRecord[nodeCount]   fixed-width, breadth-first, so the children
+//                               of any node are one contiguous record range
+//   name blob                   all node names back to back, no separators
+//
+// Record 0 is the metanode and record 1 the scanned root directory.
+// Loading maps the file and builds nodes straight from the records; the
+// only variable-length data are the names, addressed by offset/length.
+// ============================================================================
+
+namespace FsSnapshot {
+
+    inline constexpr char MAGIC[8] = { 'F', 'S', 'V', 'S', 'N', 'A', 'P', '\0' };
+    inline constexpr uint32_t VERSION = 3;
+    inline constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    // SnapshotRecord::flags
+    inline constexpr uint8_t SNAPSHOT_FLAG_UNSCANNED = 1 << 0;  // NODE_FLAG_UNSCANNED
+    inline constexpr uint8_t SNAPSHOT_FLAG_MULTILINK = 1 << 1;  // NODE_FLAG_MULTILINK
+    inline constexpr uint8_t SNAPSHOT_FLAG_DUPLICATE = 1 << 2;  // NODE_FLAG_DUPLICATE
+
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;       // BYTE_ORDER_MARK as written by the saver
+        uint32_t headerSize;      // sizeof(SnapshotHeader)
+        uint32_t recordSize;      // sizeof(SnapshotRecord)
+        uint64_t nodeCount;
+        uint64_t recordsOffset;
+        uint64_t namesOffset;
+        uint64_t namesSize;
+        int64_t createdTime;      // when the snapshot was written
+    };
+
+    struct SnapshotRecord {
+        uint64_t nameOffset;      // into the name blob
+        uint32_t nameLength;
+        uint32_t id;
+        uint32_t firstChild;      // record index of first child
+        uint32_t childCount;
+        uint32_t userId;
+        uint32_t groupId;
+        int64_t size;
+        int64_t sizeAlloc;
+        uint64_t inode;
+        uint64_t device;
+        int64_t atime;
+        int64_t mtime;
+        int64_t ctime;
+        uint16_t perms;
+        uint8_t type;
+        uint8_t flags;            // SNAPSHOT_FLAG_*
+        uint8_t reserved[4];
+    };
+
+    static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must be 64 bytes");
+    static_assert(sizeof(SnapshotRecord) == 96, "snapshot record must be 96 bytes");
+
+    // Write the tree under metanode to path. The file is written to a
+    // temporary name and renamed into place, so readers never see a partial
+    // snapshot. Returns false and sets *error on failure.
+    bool save(const FsNode* metanode, const std::string& path, std::string* error = nullptr);
+
+    // Load a snapshot written by save(). Returns the metanode (whose first
+    // child is the root directory), or nullptr and sets *error on failure.
+    std::unique_ptr<FsNode> load(const std::string& path, std::string* error = nullptr);
+
+    // True if path is a regular file starting with the snapshot magic.
+    bool isSnapshot(const std::string& path);
+
+} // namespace FsSnapshot
+} // namespace fsvng
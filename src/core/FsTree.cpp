@@ -1,10 +1,255 @@
 #include "FsTree.h"
+#include "FsSnapshot.h"
+#include "NodeStore.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
 
 namespace fsvng {
 
+namespace {
+
+bool isPathSeparator(char c) {
+#ifdef _WIN32
+    return c == '/' || c == '\\';
+#else
+    return c == '/';
+#endif
+}
+
+// ASCII-only case folding, independent of the C locale.
+inline unsigned char foldCase(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+}
+
+// Precomputed sortChildren() key: the comparator only touches names when
+// the first 8 folded bytes of two equally sized entries agree.
+struct SortKey {
+    int64_t size;
+    uint64_t prefix;  // folded name bytes 0-7, big-endian, zero-padded
+    uint32_t index;   // position in the unsorted children
+    bool dir;
+};
+
+uint64_t foldedPrefix(const std::string& name) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        unsigned char c = i < name.size() ? foldCase(static_cast<unsigned char>(name[i])) : 0;
+        prefix = (prefix << 8) | c;
+    }
+    return prefix;
+}
+
+// Case-insensitive a < b, for names whose first 8 folded bytes are equal.
+bool foldedLessFrom8(const std::string& a, const std::string& b) {
+    size_t len = std::min(a.size(), b.size());
+    for (size_t i = 8; i < len; ++i) {
+        unsigned char ac = foldCase(static_cast<unsigned char>(a[i]));
+        unsigned char bc = foldCase(static_cast<unsigned char>(b[i]));
+        if (ac != bc) return ac < bc;
+    }
+    return a.size() < b.size();
+}
+
+// sortChildren() order, for comparing two nodes directly.
+bool sortsBefore(const FsNode* a, const FsNode* b) {
+    bool aDir = a->isDir();
+    bool bDir = b->isDir();
+    if (aDir != bDir) return aDir;
+    int64_t aSize = aDir ? a->subtree.size : a->size;
+    int64_t bSize = bDir ? b->subtree.size : b->size;
+    if (aSize != bSize) return aSize > bSize;
+    uint64_t aPrefix = foldedPrefix(a->name);
+    uint64_t bPrefix = foldedPrefix(b->name);
+    if (aPrefix != bPrefix) return aPrefix < bPrefix;
+    return foldedLessFrom8(a->name, b->name);
+}
+
+// What a child adds to its parent's subtree totals (see aggregateChildren()).
+struct SubtreeTotals {
+    int64_t size = 0;
+    int64_t sizeAlloc = 0;
+    unsigned int counts[NUM_NODE_TYPES] = {};
+};
+
+SubtreeTotals contribution(const FsNode* node) {
+    SubtreeTotals totals;
+    totals.counts[node->type] = 1;
+    if (!(node->flags & NODE_FLAG_DUPLICATE)) {
+        totals.size = node->size;
+        totals.sizeAlloc = node->sizeAlloc;
+    }
+    if (node->isDir()) {
+        totals.size += node->subtree.size;
+        totals.sizeAlloc += node->subtree.sizeAlloc;
+        for (int i = 0; i < NUM_NODE_TYPES; ++i) {
+            totals.counts[i] += node->subtree.counts[i];
+        }
+    }
+    return totals;
+}
+
+// Move node within its parent's children to where sortChildren() would put
+// it, assuming the others are in order.
+void reposition(FsNode* node) {
+    FsNode* parent = node->parent;
+    if (!parent) return;
+    auto& siblings = parent->children;
+    auto it = std::find_if(siblings.begin(), siblings.end(),
+                           [node](const std::unique_ptr<FsNode>& c) { return c.get() == node; });
+    if (it == siblings.end()) return;
+
+    if (it != siblings.begin() && sortsBefore(node, (it - 1)->get())) {
+        auto to = std::upper_bound(siblings.begin(), it, node,
+            [](const FsNode* n, const std::unique_ptr<FsNode>& c) { return sortsBefore(n, c.get()); });
+        std::rotate(to, it, it + 1);
+    } else if (it + 1 != siblings.end() && sortsBefore((it + 1)->get(), node)) {
+        auto to = std::lower_bound(it + 1, siblings.end(), node,
+            [](const std::unique_ptr<FsNode>& c, const FsNode* n) { return sortsBefore(c.get(), n); });
+        std::rotate(it, it + 1, to);
+    }
+}
+
+// Add (sign = 1) or take away (sign = -1) totals from dir and each of its
+// ancestors, re-placing each among its siblings as its size changes.
+void propagate(FsNode* dir, const SubtreeTotals& totals, int sign) {
+    for (FsNode* node = dir; node != nullptr; node = node->parent) {
+        node->subtree.size += sign * totals.size;
+        node->subtree.sizeAlloc += sign * totals.sizeAlloc;
+        for (int i = 0; i < NUM_NODE_TYPES; ++i) {
+            node->subtree.counts[i] += sign > 0 ? totals.counts[i] : 0u - totals.counts[i];
+        }
+        reposition(node);
+    }
+}
+
+// Take node out of its parent's children.
+std::unique_ptr<FsNode> detach(FsNode* node) {
+    auto& siblings = node->parent->children;
+    auto it = std::find_if(siblings.begin(), siblings.end(),
+                           [node](const std::unique_ptr<FsNode>& c) { return c.get() == node; });
+    std::unique_ptr<FsNode> owned = std::move(*it);
+    siblings.erase(it);
+    node->parent = nullptr;
+    return owned;
+}
+
+// Put child into dir's (sorted) children at its place.
+FsNode* insertSorted(FsNode* dir, std::unique_ptr<FsNode> child) {
+    FsNode* raw = child.get();
+    auto& children = dir->children;
+    auto at = std::upper_bound(children.begin(), children.end(), raw,
+        [](const FsNode* n, const std::unique_ptr<FsNode>& c) { return sortsBefore(n, c.get()); });
+    children.insert(at, std::move(child));
+    raw->parent = dir;
+    return raw;
+}
+
+// ============================================================================
+// setupParallel task graph
+//
+// The tree is cut into tasks of roughly SETUP_TASK_NODES nodes. A run task
+// calls setupRecursive() on a range of a directory's children; a join task
+// aggregates one large directory once all tasks below it have finished, and
+// then releases its own parent. Run tasks and childless joins start ready.
+// ============================================================================
+
+struct SetupTask {
+    FsNode* node;
+    uint32_t begin = 0, end = 0;  // run task: node->children[begin, end)
+    int32_t parent = -1;          // task waiting on this one
+    uint32_t dependencies = 0;
+    bool join = false;
+};
+
+struct SetupPlan {
+    size_t nodes;
+    int32_t task;  // join task for this subtree, or -1 if it fits in a run
+};
+
+SetupPlan planSetup(FsNode* node, std::vector<SetupPlan>& stack, std::vector<SetupTask>& tasks,
+                    size_t grain) {
+    if (node->children.empty()) {
+        return {1, -1};
+    }
+
+    // Children's plans go on the shared stack, so planning doesn't allocate
+    // per directory.
+    size_t base = stack.size();
+    size_t total = 1;
+    for (auto& child : node->children) {
+        if (child->children.empty()) {
+            ++total;
+        } else {
+            SetupPlan plan = planSetup(child.get(), stack, tasks, grain);
+            stack.push_back(plan);
+            total += plan.nodes;
+        }
+    }
+    if (total < grain) {
+        stack.resize(base);
+        return {total, -1};
+    }
+
+    auto join = static_cast<int32_t>(tasks.size());
+    tasks.push_back({node, 0, 0, -1, 0, true});
+
+    size_t next = base;
+    size_t runNodes = 0;
+    uint32_t runBegin = 0;
+    auto flushRun = [&](uint32_t end) {
+        if (runNodes > 0) {
+            tasks.push_back({node, runBegin, end, join, 0, false});
+            tasks[join].dependencies++;
+            runNodes = 0;
+        }
+    };
+    for (uint32_t i = 0; i < node->children.size(); ++i) {
+        if (node->children[i]->children.empty()) {
+            continue;
+        }
+        SetupPlan plan = stack[next++];
+        if (plan.task >= 0) {
+            flushRun(i);
+            tasks[plan.task].parent = join;
+            tasks[join].dependencies++;
+            continue;
+        }
+        if (runNodes == 0) {
+            runBegin = i;
+        }
+        runNodes += plan.nodes;
+        if (runNodes >= grain) {
+            flushRun(i + 1);
+        }
+    }
+    flushRun(static_cast<uint32_t>(node->children.size()));
+
+    stack.resize(base);
+    return {total, join};
+}
+
+// Compare two nodes' paths component by component, so the order does not
+// depend on how a scan happened to list or number them.
+bool pathBefore(const FsNode* a, const FsNode* b) {
+    std::vector<const FsNode*> pathA, pathB;
+    for (; a; a = a->parent) pathA.push_back(a);
+    for (; b; b = b->parent) pathB.push_back(b);
+    auto itA = pathA.rbegin(), itB = pathB.rbegin();
+    for (; itA != pathA.rend() && itB != pathB.rend(); ++itA, ++itB) {
+        if (*itA != *itB) {
+            return (*itA)->name < (*itB)->name;
+        }
+    }
+    return pathA.size() < pathB.size();
+}
+
+} // namespace
+
 FsTree& FsTree::instance() {
     static FsTree inst;
     return inst;
@@ -21,17 +266,68 @@ FsNode* FsTree::rootDir() const {
     return nullptr;
 }
 
+FsTree::~FsTree() {
+    if (reaper_.joinable()) {
+        reaper_.join();
+    }
+}
+
 void FsTree::setRoot(std::unique_ptr<FsNode> root) {
-    // Clear old lookup tables (they reference the old tree)
+    // Drop old lookup tables and geometry (they reference the old tree)
+    disposeTree();
+    root_ = std::move(root);
+}
+
+void FsTree::disposeTree() {
+    std::unique_ptr<FsNode> tree = std::move(root_);
+    size_t nodeCount = nodeTable_.size();
+    nodeTable_.clear();
+    nameIndex_.clear();
+    dropNodeStore();
+    treeChanged();
+    GeometryStore::instance().clear();
+
+    if (nodeCount < REAP_IN_BACKGROUND) {
+        return;  // tree goes out of scope here
+    }
+    // Nodes are freed into NodePool, which any thread may do. One tree at
+    // a time; a second large teardown waits for the first.
+    if (reaper_.joinable()) {
+        reaper_.join();
+    }
+    reaper_ = std::thread([doomed = std::move(tree)]() mutable { doomed.reset(); });
+}
+
+std::unique_ptr<FsNode> FsTree::releaseRoot() {
     nodeTable_.clear();
-    pathTable_.clear();
+    nameIndex_.clear();
+    dropNodeStore();
+    treeChanged();
+    return std::move(root_);
+}
+
+void FsTree::restoreRoot(std::unique_ptr<FsNode> root) {
+    assert(!root_);
     root_ = std::move(root);
+    treeChanged();
+}
+
+bool FsTree::saveSnapshot(const std::string& path, std::string* error) const {
+    return FsSnapshot::save(root_.get(), path, error);
+}
+
+bool FsTree::loadSnapshot(const std::string& path, std::string* error) {
+    auto metanode = FsSnapshot::load(path, error);
+    if (!metanode) {
+        return false;
+    }
+    setRoot(std::move(metanode));
+    setupTree();
+    return true;
 }
 
 void FsTree::clear() {
-    root_.reset();
-    nodeTable_.clear();
-    pathTable_.clear();
+    disposeTree();
     nextId_ = 0;
 }
 
@@ -43,16 +339,76 @@ FsNode* FsTree::nodeById(unsigned int id) const {
 }
 
 FsNode* FsTree::nodeByPath(const std::string& absname) const {
-    auto it = pathTable_.find(absname);
-    if (it != pathTable_.end()) {
-        return it->second;
+    if (!root_) {
+        return nullptr;
+    }
+
+    // The top-level directory's name is its whole path ("/home/user"), so
+    // it is matched as a prefix; the rest is split at separators.
+    FsNode* node = nullptr;
+    std::string_view rest;
+    for (auto& top : root_->children) {
+        const std::string& prefix = top->name;
+        if (absname.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        rest = std::string_view(absname).substr(prefix.size());
+        bool rootIsSeparator = !prefix.empty() && isPathSeparator(prefix.back());
+        if (rest.empty() || rootIsSeparator || isPathSeparator(rest.front())) {
+            node = top.get();
+            break;
+        }
+    }
+
+    while (node && !rest.empty()) {
+        size_t start = 0;
+        while (start < rest.size() && isPathSeparator(rest[start])) {
+            ++start;
+        }
+        size_t end = start;
+        while (end < rest.size() && !isPathSeparator(rest[end])) {
+            ++end;
+        }
+        if (start == end) {
+            break;  // trailing separator
+        }
+        node = findChild(node, rest.substr(start, end - start));
+        rest = rest.substr(end);
+    }
+    return node;
+}
+
+FsNode* FsTree::findChild(const FsNode* dir, std::string_view name) const {
+    if (dir->children.size() <= NAME_INDEX_MIN_CHILDREN) {
+        for (auto& child : dir->children) {
+            if (child->name == name) {
+                return child.get();
+            }
+        }
+        return nullptr;
+    }
+
+    auto [it, inserted] = nameIndex_.try_emplace(dir);
+    std::vector<FsNode*>& index = it->second;
+    if (inserted) {
+        index.reserve(dir->children.size());
+        for (auto& child : dir->children) {
+            index.push_back(child.get());
+        }
+        std::sort(index.begin(), index.end(),
+                  [](const FsNode* a, const FsNode* b) { return a->name < b->name; });
+    }
+    auto pos = std::lower_bound(index.begin(), index.end(), name,
+                                [](const FsNode* n, std::string_view key) { return n->name < key; });
+    if (pos != index.end() && (*pos)->name == name) {
+        return *pos;
     }
     return nullptr;
 }
 
 void FsTree::buildNodeTable() {
     nodeTable_.clear();
-    pathTable_.clear();
+    nameIndex_.clear();
 
     if (!root_) {
         return;
@@ -81,100 +437,379 @@ void FsTree::buildNodeTable() {
     // Populate via recursive traversal.
     struct Populator {
         std::vector<FsNode*>& table;
-        std::unordered_map<std::string, FsNode*>& paths;
 
         void visit(FsNode* node) {
             if (!node) return;
             if (node->id < table.size()) {
                 table[node->id] = node;
             }
-            if (!node->isMetanode()) {
-                paths[node->absName()] = node;
-            }
             for (auto& child : node->children) {
                 visit(child.get());
             }
         }
     };
 
-    Populator pop{nodeTable_, pathTable_};
+    Populator pop{nodeTable_};
     pop.visit(root_.get());
 }
 
-void FsTree::setupTree() {
+void FsTree::numberBreadthFirst() {
+    nodeTable_.clear();
+    nameIndex_.clear();
+
+    // The ID table doubles as the queue: each node's children are appended,
+    // and numbered, as it is reached.
+    size_t count = 1;
+    for (unsigned int c : root_->subtree.counts) {
+        count += c;
+    }
+    nodeTable_.reserve(count);
+    root_->id = 0;
+    nodeTable_.push_back(root_.get());
+    for (size_t i = 0; i < nodeTable_.size(); ++i) {
+        for (auto& child : nodeTable_[i]->children) {
+            child->id = static_cast<unsigned int>(nodeTable_.size());
+            nodeTable_.push_back(child.get());
+        }
+    }
+    nextId_ = static_cast<unsigned int>(nodeTable_.size());
+}
+
+std::shared_ptr<const NodeStore> FsTree::nodeStore() const {
+    std::lock_guard<std::mutex> lock(nodeStoreMutex_);
+    if (!nodeStore_ || nodeStore_->generation() != generation_) {
+        auto store = std::make_shared<NodeStore>();
+        store->build(nodeTable_, generation_);
+        nodeStore_ = std::move(store);
+    }
+    return nodeStore_;
+}
+
+void FsTree::dropNodeStore() {
+    std::lock_guard<std::mutex> lock(nodeStoreMutex_);
+    nodeStore_.reset();
+}
+
+void FsTree::setupTree(unsigned int threadCount) {
+    treeChanged();
+    if (root_) {
+        dedupHardLinks();
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        if (threadCount > 1) {
+            setupParallel(root_.get(), threadCount);
+        } else {
+            setupRecursive(root_.get());
+        }
+        numberBreadthFirst();
+    }
+}
+
+void FsTree::updateTree(bool rebuildTables) {
+    treeChanged();
     if (root_) {
-        setupRecursive(root_.get());
-        buildNodeTable();
+        if (rebuildTables) {
+            dedupHardLinks();
+        }
+        updateRecursive(root_.get());
+        if (rebuildTables) {
+            buildNodeTable();
+        }
+    }
+}
+
+// ============================================================================
+// Incremental mutation
+// ============================================================================
+
+FsNode* FsTree::addChild(FsNode* dir, std::unique_ptr<FsNode> child) {
+    FsNode* raw = child.get();
+    raw->parent = dir;
+    registerSubtree(raw);
+    setupRecursive(raw);
+    insertSorted(dir, std::move(child));
+    propagate(dir, contribution(raw), 1);
+    nameIndex_.erase(dir);
+    treeChanged();
+    return raw;
+}
+
+std::unique_ptr<FsNode> FsTree::removeSubtree(FsNode* node) {
+    FsNode* parent = node->parent;
+    if (!parent) {
+        return nullptr;
+    }
+    propagate(parent, contribution(node), -1);
+    std::unique_ptr<FsNode> owned = detach(node);
+    unregisterSubtree(node);
+    nameIndex_.erase(parent);
+    treeChanged();
+    return owned;
+}
+
+void FsTree::updateSize(FsNode* node, int64_t size, int64_t sizeAlloc) {
+    SubtreeTotals delta;
+    if (!(node->flags & NODE_FLAG_DUPLICATE)) {
+        delta.size = size - node->size;
+        delta.sizeAlloc = sizeAlloc - node->sizeAlloc;
+    }
+    node->size = size;
+    node->sizeAlloc = sizeAlloc;
+    reposition(node);
+    if (node->parent) {
+        propagate(node->parent, delta, 1);
+    }
+    treeChanged();
+}
+
+bool FsTree::moveNode(FsNode* node, FsNode* newParent, const std::string& newName) {
+    FsNode* oldParent = node->parent;
+    if (!oldParent || newParent->isWithin(node)) {
+        return false;
+    }
+    SubtreeTotals totals = contribution(node);
+    propagate(oldParent, totals, -1);
+    std::unique_ptr<FsNode> owned = detach(node);
+    node->name = newName;
+    insertSorted(newParent, std::move(owned));
+    propagate(newParent, totals, 1);
+    nameIndex_.erase(oldParent);
+    nameIndex_.erase(newParent);
+    treeChanged();
+    return true;
+}
+
+void FsTree::registerSubtree(FsNode* node) {
+    node->id = allocateId();
+    if (node->id >= nodeTable_.size()) {
+        nodeTable_.resize(node->id + 1, nullptr);
+    }
+    nodeTable_[node->id] = node;
+    for (auto& child : node->children) {
+        registerSubtree(child.get());
+    }
+}
+
+void FsTree::unregisterSubtree(FsNode* node) {
+    if (node->id < nodeTable_.size() && nodeTable_[node->id] == node) {
+        nodeTable_[node->id] = nullptr;
+    }
+    if (!node->children.empty()) {
+        nameIndex_.erase(node);
+    }
+    for (auto& child : node->children) {
+        unregisterSubtree(child.get());
+    }
+}
+
+void FsTree::dedupHardLinks() {
+    // Gather every hard-linked file, plus former ones whose flag is stale.
+    std::vector<FsNode*> linked;
+    std::vector<FsNode*> stack{root_.get()};
+    while (!stack.empty()) {
+        FsNode* node = stack.back();
+        stack.pop_back();
+        if (!node->isDir() && (node->flags & (NODE_FLAG_MULTILINK | NODE_FLAG_DUPLICATE))) {
+            linked.push_back(node);
+        }
+        for (auto& child : node->children) {
+            stack.push_back(child.get());
+        }
+    }
+
+    // A link that owns the bytes keeps them as long as it exists, so
+    // re-sorting and renumbering don't move them between directories. A new
+    // group, or one whose owner is gone, goes to the link with the lowest ID;
+    // in a tree not numbered yet (fresh from FsScanner::scan()), to the
+    // first by path.
+    auto ranksBefore = [](const FsNode* a, const FsNode* b) {
+        bool aOwns = !(a->flags & NODE_FLAG_DUPLICATE);
+        bool bOwns = !(b->flags & NODE_FLAG_DUPLICATE);
+        if (aOwns != bOwns) {
+            return aOwns;
+        }
+        return a->id != b->id ? a->id < b->id : pathBefore(a, b);
+    };
+    std::unordered_map<FileKey, const FsNode*, FileKeyHash> owners;
+    for (FsNode* node : linked) {
+        if (node->flags & NODE_FLAG_MULTILINK) {
+            auto [it, inserted] = owners.emplace(node->fileKey(), node);
+            if (!inserted && ranksBefore(node, it->second)) {
+                it->second = node;
+            }
+        }
+    }
+    for (FsNode* node : linked) {
+        bool duplicate = (node->flags & NODE_FLAG_MULTILINK) &&
+                         owners[node->fileKey()] != node;
+        if (duplicate != ((node->flags & NODE_FLAG_DUPLICATE) != 0)) {
+            node->flags ^= NODE_FLAG_DUPLICATE;
+            node->parent->markDirty();
+        }
     }
 }
 
 void FsTree::setupRecursive(FsNode* node) {
     if (!node) return;
 
-    // Initialize subtree counts for directories.
-    if (node->isDir() || node->isMetanode()) {
-        node->subtree.size = 0;
-        std::memset(node->subtree.counts, 0, sizeof(node->subtree.counts));
+    // Recurse into children first.
+    for (auto& child : node->children) {
+        setupRecursive(child.get());
+    }
+    aggregateChildren(node);
+    node->flags &= ~NODE_FLAG_SUBTREE_DIRTY;
+}
 
-        // Recurse into children first.
-        for (auto& child : node->children) {
-            setupRecursive(child.get());
+void FsTree::setupParallel(FsNode* root, unsigned int threadCount) {
+    std::vector<SetupTask> tasks;
+    std::vector<SetupPlan> stack;
+    planSetup(root, stack, tasks, SETUP_TASK_NODES);
+    if (tasks.size() < 2) {
+        setupRecursive(root);
+        return;
+    }
+
+    std::vector<std::atomic<uint32_t>> waiting(tasks.size());
+    std::vector<int32_t> ready;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        waiting[i].store(tasks[i].dependencies, std::memory_order_relaxed);
+        if (tasks[i].dependencies == 0) {
+            ready.push_back(static_cast<int32_t>(i));
         }
+    }
 
-        // After children are set up, accumulate subtree info.
-        for (auto& child : node->children) {
-            FsNode* c = child.get();
+    std::mutex mutex;
+    std::condition_variable wake;
+    size_t remaining = tasks.size();
 
-            // Add this child's own contribution.
-            node->subtree.counts[c->type]++;
-            node->subtree.size += c->size;
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return !ready.empty() || remaining == 0; });
+            if (remaining == 0) {
+                return;
+            }
+            const SetupTask& task = tasks[ready.back()];
+            ready.pop_back();
+            lock.unlock();
 
-            // If child is a directory, also add its subtree.
-            if (c->isDir()) {
-                node->subtree.size += c->subtree.size;
-                for (int i = 0; i < NUM_NODE_TYPES; ++i) {
-                    node->subtree.counts[i] += c->subtree.counts[i];
+            FsNode* node = task.node;
+            if (task.join) {
+                // Run tasks cover only children with children of their own
+                for (auto& child : node->children) {
+                    if (child->children.empty()) {
+                        setupRecursive(child.get());
+                    }
+                }
+                aggregateChildren(node);
+                node->flags &= ~NODE_FLAG_SUBTREE_DIRTY;
+            } else {
+                for (uint32_t i = task.begin; i < task.end; ++i) {
+                    FsNode* child = node->children[i].get();
+                    if (!child->children.empty()) {
+                        setupRecursive(child);
+                    }
                 }
             }
+            bool parentReady = task.parent >= 0 &&
+                               waiting[task.parent].fetch_sub(1, std::memory_order_acq_rel) == 1;
+
+            // A released parent is picked up by this thread on the next pass.
+            lock.lock();
+            if (parentReady) {
+                ready.push_back(task.parent);
+            }
+            if (--remaining == 0) {
+                wake.notify_all();
+            }
         }
+    };
 
-        // Sort children: directories first, then by size descending, then alphabetically.
-        sortChildren(node);
+    threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, tasks.size()));
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
     }
 }
 
-void FsTree::sortChildren(FsNode* node) {
-    if (!node) return;
+void FsTree::updateRecursive(FsNode* node) {
+    if (!node || !(node->flags & NODE_FLAG_SUBTREE_DIRTY)) return;
 
-    std::sort(node->children.begin(), node->children.end(),
-        [](const std::unique_ptr<FsNode>& a, const std::unique_ptr<FsNode>& b) -> bool {
-            // Directories come before non-directories.
-            bool aIsDir = a->isDir();
-            bool bIsDir = b->isDir();
-            if (aIsDir != bIsDir) {
-                return aIsDir;  // dirs first
-            }
+    for (auto& child : node->children) {
+        updateRecursive(child.get());
+    }
+    aggregateChildren(node);
+    node->flags &= ~NODE_FLAG_SUBTREE_DIRTY;
+}
 
-            // Within same category, larger size first.
-            int64_t aSize = aIsDir ? a->subtree.size : a->size;
-            int64_t bSize = bIsDir ? b->subtree.size : b->size;
-            if (aSize != bSize) {
-                return aSize > bSize;
-            }
+void FsTree::aggregateChildren(FsNode* node) {
+    if (!node->isDir() && !node->isMetanode()) return;
+
+    // Initialize subtree counts for directories.
+    node->subtree.size = 0;
+    node->subtree.sizeAlloc = 0;
+    std::memset(node->subtree.counts, 0, sizeof(node->subtree.counts));
+
+    for (auto& child : node->children) {
+        FsNode* c = child.get();
+
+        // Add this child's own contribution. Further links to an already
+        // counted inode add to the counts but not the byte totals.
+        node->subtree.counts[c->type]++;
+        if (!(c->flags & NODE_FLAG_DUPLICATE)) {
+            node->subtree.size += c->size;
+            node->subtree.sizeAlloc += c->sizeAlloc;
+        }
 
-            // Tie-break: alphabetical by name (case-insensitive comparison
-            // for consistency with original).
-            // Use a simple locale-independent comparison.
-            const std::string& an = a->name;
-            const std::string& bn = b->name;
-            size_t len = std::min(an.size(), bn.size());
-            for (size_t i = 0; i < len; ++i) {
-                char ac = static_cast<char>(std::tolower(static_cast<unsigned char>(an[i])));
-                char bc = static_cast<char>(std::tolower(static_cast<unsigned char>(bn[i])));
-                if (ac != bc) return ac < bc;
+        // If child is a directory, also add its subtree.
+        if (c->isDir()) {
+            node->subtree.size += c->subtree.size;
+            node->subtree.sizeAlloc += c->subtree.sizeAlloc;
+            for (int i = 0; i < NUM_NODE_TYPES; ++i) {
+                node->subtree.counts[i] += c->subtree.counts[i];
             }
-            return an.size() < bn.size();
-        });
+        }
+    }
+
+    // Sort children: directories first, then by size descending, then alphabetically.
+    sortChildren(node);
+}
+
+void FsTree::sortChildren(FsNode* node) {
+    if (!node || node->children.size() < 2) return;
+
+    // Directories first, then larger size first, then case-insensitive name.
+    // Keys are built once per child so the comparator does no case folding
+    // in the common case.
+    thread_local std::vector<SortKey> keys;
+    thread_local std::vector<std::unique_ptr<FsNode>> scratch;
+    auto& children = node->children;
+    keys.clear();
+    for (size_t i = 0; i < children.size(); ++i) {
+        const FsNode* c = children[i].get();
+        bool dir = c->isDir();
+        keys.push_back({dir ? c->subtree.size : c->size, foldedPrefix(c->name),
+                        static_cast<uint32_t>(i), dir});
+    }
+    std::sort(keys.begin(), keys.end(), [&](const SortKey& a, const SortKey& b) {
+        if (a.dir != b.dir) return a.dir;
+        if (a.size != b.size) return a.size > b.size;
+        if (a.prefix != b.prefix) return a.prefix < b.prefix;
+        return foldedLessFrom8(children[a.index]->name, children[b.index]->name);
+    });
+
+    scratch.resize(children.size());
+    std::move(children.begin(), children.end(), scratch.begin());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        children[i] = std::move(scratch[keys[i].index]);
+    }
+    scratch.clear();
 }
 
 } // namespace fsvng
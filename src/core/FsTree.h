@@ -3,12 +3,17 @@
 #include "FsNode.h"
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 namespace fsvng {
 
+class NodeStore;
+
 // ============================================================================
 // FsTree - singleton tree container with O(1) lookup
 // ============================================================================
@@ -16,6 +21,7 @@ namespace fsvng {
 class FsTree {
 public:
     static FsTree& instance();
+    ~FsTree();
 
     // Access the metanode (root of the internal tree structure).
     FsNode* root() const;
@@ -23,45 +29,155 @@ public:
     // Access the first child of the metanode (the actual scanned directory).
     FsNode* rootDir() const;
 
-    // Replace the tree root.
+    // Replace the tree root. A large old tree is destroyed on a background
+    // thread, so switching roots doesn't wait for millions of destructors.
     void setRoot(std::unique_ptr<FsNode> root);
 
-    // Clear the entire tree.
+    // Take the tree out, leaving FsTree empty (e.g. to patch it off-thread).
+    std::unique_ptr<FsNode> releaseRoot();
+
+    // Put a tree taken out with releaseRoot() back into the empty FsTree.
+    // Unlike setRoot(), its nodes keep their geometry. Call updateTree()
+    // next to rebuild the lookup tables.
+    void restoreRoot(std::unique_ptr<FsNode> root);
+
+    // Write the current tree to a binary snapshot (see FsSnapshot).
+    bool saveSnapshot(const std::string& path, std::string* error = nullptr) const;
+
+    // Replace the tree with one loaded from a snapshot and set it up.
+    bool loadSnapshot(const std::string& path, std::string* error = nullptr);
+
+    // Clear the entire tree (destroyed in the background, like setRoot()).
     void clear();
 
     // O(1) lookup by node ID.
     FsNode* nodeById(unsigned int id) const;
 
-    // Lookup by absolute path (uses a hash map built during buildNodeTable).
+    // Lookup by absolute path, as returned by FsNode::absName(). Walks down
+    // one component at a time; large directories get a name index on first
+    // use.
     FsNode* nodeByPath(const std::string& absname) const;
 
     // Build the lookup tables (called after scan or tree modification).
     void buildNodeTable();
 
     // Sort children and compute subtree info (replaces setup_fstree_recursive).
-    void setupTree();
+    // Large trees are split into subtree tasks run on threadCount threads
+    // (0 = one per hardware thread). Nodes are then renumbered breadth-first
+    // in sorted order (see numberBreadthFirst()).
+    void setupTree(unsigned int threadCount = 0);
+
+    // Like setupTree(), but only revisits nodes flagged NODE_FLAG_SUBTREE_DIRTY
+    // (the spine above each change); clean subtrees keep their totals.
+    // Pass rebuildTables = false when no nodes were added or removed, e.g.
+    // after only sizes changed, to skip the O(n) lookup table rebuild.
+    void updateTree(bool rebuildTables = true);
+
+    // In-place edits of a set-up tree. Each patches subtree totals up the
+    // ancestor chain, moves changed nodes to their sorted place among their
+    // siblings and keeps the ID table current: O(depth + siblings) instead
+    // of an updateTree() pass. Hard-link ownership (NODE_FLAG_DUPLICATE) is
+    // only recomputed by setupTree()/updateTree().
+
+    // Attach child and its subtree under dir; the subtree gets fresh IDs and
+    // is set up.
+    FsNode* addChild(FsNode* dir, std::unique_ptr<FsNode> child);
+
+    // Detach node and its subtree, whose IDs leave the table. Returns
+    // nullptr for the metanode.
+    std::unique_ptr<FsNode> removeSubtree(FsNode* node);
+
+    // Change a node's own size and allocated size.
+    void updateSize(FsNode* node, int64_t size, int64_t sizeAlloc);
+
+    // Reattach node under newParent (possibly its current parent) as
+    // newName. Fails if newParent is inside node's subtree.
+    bool moveNode(FsNode* node, FsNode* newParent, const std::string& newName);
 
     // Current number of allocated node IDs.
     unsigned int nodeCount() const { return nextId_; }
 
-    // Allocate the next unique node ID.
-    unsigned int allocateId() { return nextId_++; }
+    // Allocate the next unique node ID. A reused ID starts with blank geometry.
+    unsigned int allocateId() {
+        GeometryStore::instance().reset(nextId_);
+        return nextId_++;
+    }
+
+    // Bumped by every call that changes the tree or replaces it, so derived
+    // data (queries, indexes) can tell whether it is still current.
+    uint64_t generation() const { return generation_; }
+
+    // Hot fields of every node in structure-of-arrays form, rebuilt on the
+    // first call after the tree changed and shared until the next change.
+    // Like any reader, must not overlap changes to the tree; concurrent
+    // callers wait for one build.
+    std::shared_ptr<const NodeStore> nodeStore() const;
 
 private:
     FsTree() = default;
     FsTree(const FsTree&) = delete;
     FsTree& operator=(const FsTree&) = delete;
 
-    // Recursive helper for setupTree.
+    // Invalidate derived data after a change.
+    void treeChanged() { ++generation_; }
+
+    // Free the NodeStore columns along with the tree they describe.
+    void dropNodeStore();
+
+    // Flag every hard link to a file except one as NODE_FLAG_DUPLICATE, so
+    // each inode's bytes are counted once. Parents of changed links are
+    // marked dirty.
+    void dedupHardLinks();
+
+    // Detach the root and lookup tables and destroy them, on reaper_ if the
+    // tree has at least REAP_IN_BACKGROUND nodes.
+    void disposeTree();
+    static constexpr size_t REAP_IN_BACKGROUND = 100000;
+
+    // Give node and its subtree fresh IDs and table entries, or clear them.
+    void registerSubtree(FsNode* node);
+    void unregisterSubtree(FsNode* node);
+
+    // Give every node a new ID in breadth-first order of the sorted tree and
+    // rebuild the ID table. Each directory's children then hold a contiguous
+    // ID range, so ID-indexed columns (GeometryStore, NodeStore) are read in
+    // traversal order, and IDs no longer depend on how scan threads
+    // interleaved. Edits afterwards append fresh IDs at the end.
+    void numberBreadthFirst();
+
+    // Recursive helpers for setupTree and updateTree.
     void setupRecursive(FsNode* node);
+    void updateRecursive(FsNode* node);
+
+    // setupRecursive() on threadCount threads; see setupTree().
+    void setupParallel(FsNode* root, unsigned int threadCount);
+
+    // Rough number of nodes handled serially by one setupParallel task.
+    static constexpr size_t SETUP_TASK_NODES = 8192;
+
+    // Recompute a directory's subtree totals from its children and re-sort them.
+    static void aggregateChildren(FsNode* node);
 
     // Sort a directory node's children: dirs first, then by size desc, then alpha.
     static void sortChildren(FsNode* node);
 
+    // The child of dir called name, or nullptr.
+    FsNode* findChild(const FsNode* dir, std::string_view name) const;
+
+    // Directories with more children than this are searched through
+    // nameIndex_ rather than scanned.
+    static constexpr size_t NAME_INDEX_MIN_CHILDREN = 32;
+
     std::unique_ptr<FsNode> root_;
     std::vector<FsNode*> nodeTable_;
-    std::unordered_map<std::string, FsNode*> pathTable_;
+    // Children sorted by name, per directory; dropped whenever the tables are
+    // rebuilt.
+    mutable std::unordered_map<const FsNode*, std::vector<FsNode*>> nameIndex_;
     unsigned int nextId_ = 0;
+    uint64_t generation_ = 0;
+    mutable std::mutex nodeStoreMutex_;
+    mutable std::shared_ptr<const NodeStore> nodeStore_;
+    std::thread reaper_;
 };
 
 } // namespace fsvng
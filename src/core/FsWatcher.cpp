@@ -0,0 +1,343 @@
+#include "FsWatcher.h"
+#include "FsTree.h"
+#include "PlatformUtils.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fsvng {
+
+namespace {
+
+#ifdef __linux__
+// Entry-level changes in a watched directory, plus the directory itself
+// going away (only acted on for the root).
+constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB |
+                                IN_DELETE_SELF | IN_MOVE_SELF |
+                                IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+#endif
+
+std::string joinPath(const std::string& dir, const std::string& name) {
+    if (!dir.empty() && (dir.back() == '/' || dir.back() == '\\')) {
+        return dir + name;
+    }
+    return dir + '/' + name;
+}
+
+FsNode* findChild(FsNode* dir, const std::string& name) {
+    for (auto& child : dir->children) {
+        if (child->name == name) {
+            return child.get();
+        }
+    }
+    return nullptr;
+}
+
+bool hasMultiLink(const FsNode* node) {
+    if (node->flags & (NODE_FLAG_MULTILINK | NODE_FLAG_DUPLICATE)) {
+        return true;
+    }
+    for (auto& child : node->children) {
+        if (hasMultiLink(child.get())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+FsWatcher::~FsWatcher() {
+    stop();
+}
+
+// ============================================================================
+// Start / stop
+// ============================================================================
+
+bool FsWatcher::start(FsNode* metanode) {
+    stop();
+    if (!metanode || metanode->children.empty()) {
+        return false;
+    }
+
+#ifdef __linux__
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    metanode_ = metanode;
+    scanner_.options = options;
+    filter_ = ScanFilter(options.exclude);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.clear();
+        overflowed_ = false;
+        unwatchedDirs_ = 0;
+    }
+
+    const FsNode* rootNode = metanode->children[0].get();
+    addWatches(rootNode, rootNode->name);
+
+    running_ = true;
+    thread_ = std::thread(&FsWatcher::readLoop, this);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FsWatcher::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+#ifdef __linux__
+    if (fd_ >= 0) {
+        close(fd_);  // drops every watch
+        fd_ = -1;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(mutex_);
+    wdPaths_.clear();
+    pathWds_.clear();
+    pending_.clear();
+    metanode_ = nullptr;
+}
+
+size_t FsWatcher::unwatchedDirs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return unwatchedDirs_;
+}
+
+// ============================================================================
+// Watch bookkeeping
+// ============================================================================
+
+void FsWatcher::watchSubtree(const FsNode* dirNode) {
+    if (running_.load()) {
+        addWatches(dirNode, dirNode->absName());
+    }
+}
+
+void FsWatcher::addWatches(const FsNode* dirNode, const std::string& path) {
+#ifdef __linux__
+    if (dirNode->flags & NODE_FLAG_UNSCANNED) {
+        return;
+    }
+    int wd = inotify_add_watch(fd_, path.c_str(), WATCH_MASK);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (wd < 0) {
+            unwatchedDirs_++;
+        } else {
+            // A directory moved within the tree keeps its watch descriptor;
+            // forget the old path so removing it later leaves the watch alone.
+            auto it = wdPaths_.find(wd);
+            if (it != wdPaths_.end() && it->second != path) {
+                pathWds_.erase(it->second);
+            }
+            wdPaths_[wd] = path;
+            pathWds_[path] = wd;
+        }
+    }
+    for (const auto& child : dirNode->children) {
+        if (child->isDir()) {
+            addWatches(child.get(), joinPath(path, child->name));
+        }
+    }
+#else
+    (void)dirNode;
+    (void)path;
+#endif
+}
+
+void FsWatcher::removeWatches(const FsNode* dirNode, const std::string& path) {
+#ifdef __linux__
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pathWds_.find(path);
+        if (it != pathWds_.end()) {
+            inotify_rm_watch(fd_, it->second);
+            wdPaths_.erase(it->second);
+            pathWds_.erase(it);
+        }
+    }
+    for (const auto& child : dirNode->children) {
+        if (child->isDir()) {
+            removeWatches(child.get(), joinPath(path, child->name));
+        }
+    }
+#else
+    (void)dirNode;
+    (void)path;
+#endif
+}
+
+// ============================================================================
+// Reader thread - records touched entries, never touches the tree
+// ============================================================================
+
+void FsWatcher::readLoop() {
+#ifdef __linux__
+    alignas(struct inotify_event) char buf[16384];
+    std::string rootPath = metanode_->children[0]->name;
+
+    while (running_.load()) {
+        struct pollfd pfd = {fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t len = read(fd_, buf, sizeof(buf));
+        if (len <= 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (ssize_t off = 0; off < len;) {
+            const auto* ev = reinterpret_cast<const struct inotify_event*>(buf + off);
+            off += sizeof(struct inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                overflowed_ = true;
+                continue;
+            }
+            auto it = wdPaths_.find(ev->wd);
+            if (it == wdPaths_.end()) {
+                continue;
+            }
+            if (ev->mask & IN_IGNORED) {
+                pathWds_.erase(it->second);
+                wdPaths_.erase(it);
+                continue;
+            }
+            if (ev->len == 0) {
+                // Event on a watched directory itself; its parent reports
+                // the same change as an entry event, except for the root.
+                if ((ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) && it->second == rootPath) {
+                    overflowed_ = true;
+                }
+                continue;
+            }
+            if (pending_.empty()) {
+                firstPendingTime_ = PlatformUtils::getTime();
+            }
+            pending_.emplace(it->second, ev->name);
+        }
+    }
+#endif
+}
+
+bool FsWatcher::hasPendingBatch(double batchWindow) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (overflowed_) {
+        return true;
+    }
+    return !pending_.empty() && PlatformUtils::getTime() - firstPendingTime_ >= batchWindow;
+}
+
+// ============================================================================
+// Applying a batch
+// ============================================================================
+
+WatchBatch FsWatcher::applyPending() {
+    WatchBatch batch;
+    std::set<std::pair<std::string, std::string>> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries.swap(pending_);
+        batch.rescanNeeded = overflowed_;
+        overflowed_ = false;
+    }
+    if (!metanode_) {
+        return batch;
+    }
+
+    // Sorted order visits a directory's own entry before anything inside it,
+    // so a new directory is scanned before events below it are looked at.
+    for (const auto& [dirPath, name] : entries) {
+        FsNode* dir = findDir(dirPath);
+        if (dir && !(dir->flags & NODE_FLAG_UNSCANNED) && applyEntry(dir, dirPath, name, batch) &&
+            std::find(batch.changedDirs.begin(), batch.changedDirs.end(), dir) ==
+                batch.changedDirs.end()) {
+            batch.changedDirs.push_back(dir);
+        }
+    }
+    return batch;
+}
+
+FsNode* FsWatcher::findDir(const std::string& path) const {
+    FsNode* node = FsTree::instance().nodeByPath(path);
+    return node && node->isDir() ? node : nullptr;
+}
+
+bool FsWatcher::applyEntry(FsNode* dir, const std::string& dirPath, const std::string& name,
+                           WatchBatch& batch) {
+    FsTree& tree = FsTree::instance();
+    std::string path = joinPath(dirPath, name);
+    FsNode probe;
+    bool exists = !filter_.excludes(dirPath, name) && scanner_.statPath(path, &probe);
+    FsNode* child = findChild(dir, name);
+
+    if (exists && child && child->type == probe.type) {
+        bool changed = child->size != probe.size || child->sizeAlloc != probe.sizeAlloc ||
+                       child->mtime != probe.mtime || child->inode != probe.inode;
+        if (child->size != probe.size || child->sizeAlloc != probe.sizeAlloc) {
+            tree.updateSize(child, probe.size, probe.sizeAlloc);
+        }
+        child->copyStat(probe);
+        return changed;
+    }
+    if (!exists && !child) {
+        return false;  // created and deleted again within the batch
+    }
+
+    // Created, deleted, or replaced by a different type. Renames arrive as
+    // a delete of the old name and a create of the new one.
+    if (child) {
+        removeChild(child, path, batch);
+    }
+    if (exists) {
+        std::unique_ptr<FsNode> node;
+        if (probe.type == NODE_DIRECTORY) {
+            std::unique_ptr<FsNode> scanned = scanner_.scan(path);
+            node = std::move(scanned->children[0]);
+            node->name = name;
+        } else {
+            node = std::make_unique<FsNode>();
+            node->copyStat(probe);
+            node->name = name;
+        }
+        batch.hardLinksChanged |= hasMultiLink(node.get());
+        FsNode* added = tree.addChild(dir, std::move(node));
+        if (added->isDir()) {
+            addWatches(added, path);
+        }
+    }
+    return true;
+}
+
+void FsWatcher::removeChild(FsNode* child, const std::string& path, WatchBatch& batch) {
+    if (onRemove) {
+        onRemove(child);
+    }
+    auto inside = [child](FsNode* changed) { return changed->isWithin(child); };
+    batch.changedDirs.erase(std::remove_if(batch.changedDirs.begin(), batch.changedDirs.end(),
+                                           inside),
+                            batch.changedDirs.end());
+    if (child->isDir()) {
+        removeWatches(child, path);
+    }
+    batch.hardLinksChanged |= hasMultiLink(child);
+    FsTree::instance().removeSubtree(child);
+}
+
+} // namespace fsvng
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "FsNode.h"
+#include "FsScanner.h"
+#include "ScanFilter.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fsvng {
+
+// Result of one FsWatcher::applyPending() call.
+struct WatchBatch {
+    std::vector<FsNode*> changedDirs;  // directories whose entries were patched
+    bool hardLinksChanged = false;     // run FsTree::updateTree() to re-dedup
+    bool rescanNeeded = false;         // events were lost; the tree may be stale
+};
+
+// ============================================================================
+// FsWatcher - keeps a scanned tree in sync with filesystem events
+//
+// On Linux every directory gets an inotify watch. The reader thread only
+// records which (directory, entry name) pairs were touched; applyPending()
+// later re-stats each pair once on the thread that owns the tree, so a burst
+// of writes to one file costs a single lstat. Other platforms have no
+// backend yet and start() returns false.
+// ============================================================================
+
+class FsWatcher {
+public:
+    FsWatcher() = default;
+    ~FsWatcher();
+    FsWatcher(const FsWatcher&) = delete;
+    FsWatcher& operator=(const FsWatcher&) = delete;
+
+    // Watch the tree under metanode, which must be FsTree's root (new nodes
+    // take their IDs from FsTree::allocateId()). The tree must stay alive
+    // until stop(). Placeholder directories are not watched.
+    bool start(FsNode* metanode);
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // True once events are waiting and the oldest is batchWindow seconds old.
+    bool hasPendingBatch(double batchWindow) const;
+
+    // Apply every recorded event to the tree through FsTree's in-place
+    // edits, which keep totals, order and IDs current; new nodes get IDs
+    // past the current maximum. Must be called on the thread that owns the
+    // tree.
+    WatchBatch applyPending();
+
+    // Watch a directory that FsLoader has just filled in.
+    void watchSubtree(const FsNode* dirNode);
+
+    // Set before start(): the options the tree was scanned with. New
+    // directories are scanned with them; entries matching options.exclude
+    // are ignored, and removed from the tree if they were in it.
+    ScanOptions options;
+
+    // Called with each subtree just before it is deleted from the tree.
+    std::function<void(FsNode*)> onRemove;
+
+    // Directories left unwatched, e.g. because the inotify watch limit
+    // (fs.inotify.max_user_watches) was reached.
+    size_t unwatchedDirs() const;
+
+private:
+    void readLoop();
+
+    // Watch dirNode and every directory below it.
+    void addWatches(const FsNode* dirNode, const std::string& path);
+    void removeWatches(const FsNode* dirNode, const std::string& path);
+
+    // Find the directory node for an absolute path, or nullptr.
+    FsNode* findDir(const std::string& path) const;
+
+    // Re-stat dir/name and patch dir's children to match. Returns true if
+    // anything changed.
+    bool applyEntry(FsNode* dir, const std::string& dirPath, const std::string& name,
+                    WatchBatch& batch);
+    void removeChild(FsNode* child, const std::string& path, WatchBatch& batch);
+
+    FsNode* metanode_ = nullptr;
+    FsScanner scanner_;
+    ScanFilter filter_;
+    int fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // Guards everything below; shared with the reader thread.
+    mutable std::mutex mutex_;
+    std::unordered_map<int, std::string> wdPaths_;
+    std::unordered_map<std::string, int> pathWds_;
+    std::set<std::pair<std::string, std::string>> pending_;  // dir path, entry name
+    double firstPendingTime_ = 0.0;
+    bool overflowed_ = false;
+    size_t unwatchedDirs_ = 0;
+};
+
+} // namespace fsvng
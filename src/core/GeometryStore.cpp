@@ -0,0 +1,27 @@
+#include "GeometryStore.h"
+
+namespace fsvng {
+
+// ============================================================================
+// GeometryStore
+// ============================================================================
+
+void GeometryStore::retainOnly(FsvMode mode) {
+    if (mode != FSV_DISCV) discv.clear();
+    if (mode != FSV_MAPV) mapv.clear();
+    if (mode != FSV_TREEV) treev.clear();
+}
+
+void GeometryStore::reset(unsigned int id) {
+    discv.reset(id);
+    mapv.reset(id);
+    treev.reset(id);
+}
+
+void GeometryStore::clear() {
+    discv.clear();
+    mapv.clear();
+    treev.clear();
+}
+
+} // namespace fsvng
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Types.h"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace fsvng {
+
+// ============================================================================
+// Geometry parameter structs - one per visualization mode
+// ============================================================================
+
+struct DiscVGeomParams {
+    double radius = 0.0;
+    double theta = 0.0;
+    XYvec pos{};
+};
+
+struct MapVGeomParams {
+    XYvec c0{};   // lower-left corner
+    XYvec c1{};   // upper-right corner
+    double height = 0.0;
+};
+
+struct TreeVGeomParams {
+    struct {
+        double distance = 0.0;
+        double theta = 0.0;
+        double height = 0.0;
+    } leaf;
+    struct {
+        double theta = 0.0;
+        double depth = 0.0;
+        double arc_width = 0.0;
+        double height = 0.0;
+        double subtree_arc_width = 0.0;
+    } platform;
+};
+
+// ============================================================================
+// NodeColumn - per-node values indexed by node ID
+//
+// Stored in fixed-size chunks that never move, so references stay valid
+// while the column grows. Slots come into existence zeroed on first write
+// access; reads of slots not there yet see a zeroed T.
+// ============================================================================
+
+template <typename T>
+class NodeColumn {
+public:
+    T& operator[](unsigned int id) {
+        assert(id != INVALID_NODE_ID);
+        size_t chunk = id >> CHUNK_BITS;
+        if (chunk >= chunks_.size()) {
+            grow(chunk);
+        }
+        return chunks_[chunk][id & CHUNK_MASK];
+    }
+
+    const T& get(unsigned int id) const {
+        size_t chunk = id >> CHUNK_BITS;
+        if (chunk >= chunks_.size()) {
+            static const T zero{};
+            return zero;
+        }
+        return chunks_[chunk][id & CHUNK_MASK];
+    }
+
+    bool empty() const { return chunks_.empty(); }
+
+    // Zero a slot, e.g. when its ID is handed to a new node.
+    void reset(unsigned int id) {
+        if ((id >> CHUNK_BITS) < chunks_.size()) {
+            (*this)[id] = T{};
+        }
+    }
+
+    void clear() {
+        chunks_.clear();
+        chunks_.shrink_to_fit();
+    }
+
+private:
+    static constexpr unsigned int CHUNK_BITS = 12;  // 4096 nodes per chunk
+    static constexpr unsigned int CHUNK_MASK = (1u << CHUNK_BITS) - 1;
+
+    void grow(size_t chunk) {
+        while (chunks_.size() <= chunk) {
+            chunks_.push_back(std::make_unique<T[]>(size_t(1) << CHUNK_BITS));
+        }
+    }
+
+    std::vector<std::unique_ptr<T[]>> chunks_;
+};
+
+// ============================================================================
+// GeometryStore - per-mode layout geometry, kept off FsNode
+//
+// Each mode's column is only populated while that mode is laid out; on a
+// mode switch GeometryManager drops the others. FsNode::mapvGeom() and
+// friends index these columns by node ID.
+// ============================================================================
+
+class GeometryStore {
+public:
+    static GeometryStore& instance() {
+        static GeometryStore s;
+        return s;
+    }
+
+    NodeColumn<DiscVGeomParams> discv;
+    NodeColumn<MapVGeomParams> mapv;
+    NodeColumn<TreeVGeomParams> treev;
+
+    // Free the columns of every mode except mode.
+    void retainOnly(FsvMode mode);
+
+    // Zero id's slot in every column, for an ID that is being reused.
+    void reset(unsigned int id);
+
+    void clear();
+
+private:
+    GeometryStore() = default;
+    GeometryStore(const GeometryStore&) = delete;
+    GeometryStore& operator=(const GeometryStore&) = delete;
+};
+
+} // namespace fsvng
@@ -0,0 +1,452 @@
+#include "NameIndex.h"
+#include "ScanFilter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <regex>
+#include <unordered_map>
+
+namespace fsvng {
+
+namespace {
+
+inline char foldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+std::string folded(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) {
+        c = foldCase(c);
+    }
+    return out;
+}
+
+inline uint32_t trigramAt(std::string_view s, size_t i) {
+    return (uint32_t(static_cast<unsigned char>(s[i])) << 16) |
+           (uint32_t(static_cast<unsigned char>(s[i + 1])) << 8) |
+           uint32_t(static_cast<unsigned char>(s[i + 2]));
+}
+
+// Distinct trigrams of s, ascending.
+void trigramsOf(std::string_view s, std::vector<uint32_t>& out) {
+    out.clear();
+    for (size_t i = 0; i + 3 <= s.size(); ++i) {
+        out.push_back(trigramAt(s, i));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+struct Posting {
+    uint32_t gram;
+    uint32_t nameId;
+};
+
+// Stable LSD radix sort on the trigram's three bytes.
+void sortByTrigram(std::vector<Posting>& pairs) {
+    std::vector<Posting> scratch(pairs.size());
+    for (int shift = 0; shift < 24; shift += 8) {
+        size_t starts[257] = {};
+        for (const Posting& p : pairs) {
+            starts[((p.gram >> shift) & 0xff) + 1]++;
+        }
+        for (int b = 1; b <= 256; ++b) {
+            starts[b] += starts[b - 1];
+        }
+        for (const Posting& p : pairs) {
+            scratch[starts[(p.gram >> shift) & 0xff]++] = p;
+        }
+        pairs.swap(scratch);
+    }
+}
+
+// Runs of literal characters that every match of the glob contains.
+std::vector<std::string> globLiterals(const std::string& glob) {
+    std::vector<std::string> literals(1);
+    for (char c : glob) {
+        if (c == '*' || c == '?') {
+            literals.emplace_back();
+        } else {
+            literals.back() += c;
+        }
+    }
+    return literals;
+}
+
+// Conservative literal runs that every match of an ECMAScript regex
+// contains: plain characters and escaped punctuation. Groups, classes,
+// alternations and other escapes (with their hex, octal or control
+// payload) contribute nothing, and a quantified character ends the run
+// before it.
+std::vector<std::string> regexLiterals(const std::string& re) {
+    if (re.find('|') != std::string::npos) {
+        return {};
+    }
+    std::vector<std::string> literals(1);
+    auto endRun = [&] {
+        if (!literals.back().empty()) {
+            literals.emplace_back();
+        }
+    };
+    auto quantified = [&](size_t i) { return i + 1 < re.size() && std::strchr("*?{", re[i + 1]); };
+
+    int depth = 0;
+    for (size_t i = 0; i < re.size(); ++i) {
+        char c = re[i];
+        if (c == '\\' && i + 1 < re.size()) {
+            char next = re[++i];
+            if (!std::isalnum(static_cast<unsigned char>(next))) {
+                if (depth == 0 && !quantified(i)) {
+                    literals.back() += next;
+                } else {
+                    endRun();
+                }
+                continue;
+            }
+            endRun();
+            // Skip the payload of \xHH, \uHHHH and \cX, and the digits of
+            // \0 (octal) or a backreference
+            bool digits = std::isdigit(static_cast<unsigned char>(next)) != 0;
+            size_t payload = next == 'x' ? 2 : next == 'u' ? 4 : next == 'c' ? 1 : digits ? SIZE_MAX : 0;
+            for (; payload > 0 && i + 1 < re.size(); --payload) {
+                auto p = static_cast<unsigned char>(re[i + 1]);
+                bool more = next == 'c' ? std::isalpha(p) : digits ? std::isdigit(p) : std::isxdigit(p);
+                if (!more) {
+                    break;
+                }
+                ++i;
+            }
+        } else if (c == '[') {
+            // Skip the class; a ']' right after '[' or '[^' is a member.
+            size_t j = i + 1;
+            if (j < re.size() && re[j] == '^') ++j;
+            if (j < re.size() && re[j] == ']') ++j;
+            while (j < re.size() && re[j] != ']') {
+                j += re[j] == '\\' ? 2 : 1;
+            }
+            i = j;
+            endRun();
+        } else if (c == '{') {
+            size_t close = re.find('}', i);
+            i = close == std::string::npos ? re.size() : close;
+            endRun();
+        } else if (c == '(' || c == ')') {
+            depth = c == '(' ? depth + 1 : std::max(0, depth - 1);
+            endRun();
+        } else if (depth == 0 && !std::strchr(".^$*+?]}", c) && !quantified(i)) {
+            literals.back() += c;
+        } else {
+            endRun();
+        }
+    }
+    return literals;
+}
+
+} // namespace
+
+// ============================================================================
+// NameIndexInput
+// ============================================================================
+
+NameIndexInput NameIndexInput::collect(const FsNode* metanode) {
+    NameIndexInput input;
+    if (!metanode) {
+        return input;
+    }
+    std::vector<const FsNode*> stack;
+    for (auto& child : metanode->children) {
+        stack.push_back(child.get());
+    }
+    while (!stack.empty()) {
+        const FsNode* node = stack.back();
+        stack.pop_back();
+        input.names += node->name;
+        input.ends.push_back(static_cast<uint32_t>(input.names.size()));
+        input.ids.push_back(node->id);
+        input.sizes.push_back(node->isDir() ? node->subtree.size : node->size);
+        for (auto& child : node->children) {
+            stack.push_back(child.get());
+        }
+    }
+    return input;
+}
+
+// ============================================================================
+// Build
+// ============================================================================
+
+NameIndex::NameIndex(const NameIndexInput& input) {
+    const size_t n = input.ids.size();
+
+    // Intern folded names. The buffer is sized up front so the keys, which
+    // point into it, stay valid.
+    names_.reserve(input.names.size());
+    std::unordered_map<std::string_view, uint32_t> ids;
+    ids.reserve(n);
+    std::vector<uint32_t> nameOf(n);
+    std::string scratch;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t begin = i == 0 ? 0 : input.ends[i - 1];
+        scratch.assign(input.names, begin, input.ends[i] - begin);
+        for (char& c : scratch) {
+            c = foldCase(c);
+        }
+        auto it = ids.find(scratch);
+        if (it == ids.end()) {
+            size_t at = names_.size();
+            names_ += scratch;
+            nameEnds_.push_back(static_cast<uint32_t>(names_.size()));
+            it = ids.emplace(std::string_view(names_).substr(at, scratch.size()),
+                             static_cast<uint32_t>(nameEnds_.size() - 1)).first;
+        }
+        nameOf[i] = it->second;
+    }
+    ids = {};
+
+    // Nodes grouped by name (counting sort).
+    nameNodes_.assign(nameEnds_.size() + 1, 0);
+    for (uint32_t nameId : nameOf) {
+        nameNodes_[nameId + 1]++;
+    }
+    for (size_t k = 1; k < nameNodes_.size(); ++k) {
+        nameNodes_[k] += nameNodes_[k - 1];
+    }
+    nodes_.resize(n);
+    {
+        std::vector<uint32_t> cursor(nameNodes_.begin(), nameNodes_.end() - 1);
+        for (size_t i = 0; i < n; ++i) {
+            nodes_[cursor[nameOf[i]]++] = {input.ids[i], input.sizes[i]};
+        }
+    }
+
+    // Posting lists: every (trigram, name) pair, generated in name order and
+    // radix-sorted by trigram a byte at a time. The sort is stable, so each
+    // list comes out in name order, and costs nothing per unused trigram.
+    std::vector<Posting> pairs;
+    std::vector<uint32_t> grams;
+    for (uint32_t nameId = 0; nameId < nameEnds_.size(); ++nameId) {
+        trigramsOf(name(nameId), grams);
+        for (uint32_t g : grams) {
+            pairs.push_back({g, nameId});
+        }
+    }
+    sortByTrigram(pairs);
+
+    postings_.resize(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (i == 0 || pairs[i].gram != pairs[i - 1].gram) {
+            trigrams_.push_back(pairs[i].gram);
+            trigramStarts_.push_back(static_cast<uint32_t>(i));
+        }
+        postings_[i] = pairs[i].nameId;
+    }
+    trigramStarts_.push_back(static_cast<uint32_t>(pairs.size()));
+}
+
+size_t NameIndex::memoryUsage() const {
+    return names_.capacity() + nameEnds_.capacity() * sizeof(uint32_t) +
+           nameNodes_.capacity() * sizeof(uint32_t) + nodes_.capacity() * sizeof(Match) +
+           (trigrams_.capacity() + trigramStarts_.capacity() + postings_.capacity()) *
+               sizeof(uint32_t);
+}
+
+// ============================================================================
+// Query
+// ============================================================================
+
+std::vector<uint32_t> NameIndex::candidates(const std::vector<std::string>& literals,
+                                            bool* all) const {
+    // Gather the posting list of every trigram, shortest first.
+    std::vector<std::pair<uint32_t, uint32_t>> lists;  // [begin, end) in postings_
+    std::vector<uint32_t> grams;
+    for (const std::string& literal : literals) {
+        trigramsOf(literal, grams);
+        for (uint32_t g : grams) {
+            auto it = std::lower_bound(trigrams_.begin(), trigrams_.end(), g);
+            if (it == trigrams_.end() || *it != g) {
+                *all = false;
+                return {};  // no name has this trigram
+            }
+            size_t k = static_cast<size_t>(it - trigrams_.begin());
+            lists.emplace_back(trigramStarts_[k], trigramStarts_[k + 1]);
+        }
+    }
+    *all = lists.empty();
+    if (lists.empty()) {
+        return {};
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) {
+        return a.second - a.first < b.second - b.first;
+    });
+    lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+    std::vector<uint32_t> result(postings_.begin() + lists[0].first,
+                                 postings_.begin() + lists[0].second);
+    for (size_t l = 1; l < lists.size() && !result.empty(); ++l) {
+        auto from = postings_.begin() + lists[l].first;
+        auto to = postings_.begin() + lists[l].second;
+        size_t kept = 0;
+        for (uint32_t nameId : result) {
+            from = std::lower_bound(from, to, nameId);
+            if (from == to) {
+                break;
+            }
+            if (*from == nameId) {
+                result[kept++] = nameId;
+            }
+        }
+        result.resize(kept);
+    }
+    return result;
+}
+
+std::vector<NameIndex::Match> NameIndex::query(const std::string& text, NameQuery kind,
+                                               size_t limit, size_t* total,
+                                               std::string* error) const {
+    if (total) {
+        *total = 0;
+    }
+    std::string pattern = folded(text);
+    if (pattern.empty()) {
+        return {};
+    }
+
+    std::vector<std::string> literals;
+    std::function<bool(std::string_view)> matches;
+    ScanFilter glob;
+    std::regex re;
+    switch (kind) {
+    case NameQuery::Substring:
+        literals.push_back(pattern);
+        matches = [&](std::string_view name) { return name.find(pattern) != std::string_view::npos; };
+        break;
+    case NameQuery::Glob:
+        literals = globLiterals(pattern);
+        glob = ScanFilter({pattern});
+        matches = [&](std::string_view name) { return glob.excludes(std::string(), name); };
+        break;
+    case NameQuery::Regex:
+        try {
+            re = std::regex(text, std::regex::ECMAScript | std::regex::icase | std::regex::optimize);
+        } catch (const std::regex_error& e) {
+            if (error) {
+                *error = e.what();
+            }
+            return {};
+        }
+        literals = regexLiterals(pattern);
+        matches = [&](std::string_view name) {
+            return std::regex_search(name.begin(), name.end(), re);
+        };
+        break;
+    }
+
+    bool all = false;
+    std::vector<uint32_t> names = candidates(literals, &all);
+    if (all) {
+        names.resize(nameEnds_.size());
+        for (uint32_t i = 0; i < names.size(); ++i) {
+            names[i] = i;
+        }
+    }
+
+    std::vector<Match> found;
+    for (uint32_t nameId : names) {
+        if (matches(name(nameId))) {
+            found.insert(found.end(), nodes_.begin() + nameNodes_[nameId],
+                         nodes_.begin() + nameNodes_[nameId + 1]);
+        }
+    }
+    if (total) {
+        *total = found.size();
+    }
+
+    auto larger = [](const Match& a, const Match& b) {
+        return a.size != b.size ? a.size > b.size : a.id < b.id;
+    };
+    if (found.size() > limit) {
+        std::partial_sort(found.begin(), found.begin() + limit, found.end(), larger);
+        found.resize(limit);
+    } else {
+        std::sort(found.begin(), found.end(), larger);
+    }
+    return found;
+}
+
+// ============================================================================
+// NameSearch
+// ============================================================================
+
+NameSearch::~NameSearch() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void NameSearch::rebuild(const FsNode* metanode) {
+    auto input = std::make_unique<NameIndexInput>(NameIndexInput::collect(metanode));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = std::move(input);
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&NameSearch::workerLoop, this);
+        }
+    }
+    cv_.notify_all();
+}
+
+void NameSearch::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_++;
+    pending_.reset();
+    index_.reset();
+}
+
+std::shared_ptr<const NameIndex> NameSearch::index() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_;
+}
+
+bool NameSearch::isBuilding() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return building_ || pending_;
+}
+
+void NameSearch::wait() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !building_ && !pending_; });
+}
+
+void NameSearch::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopping_ || pending_; });
+        if (stopping_) {
+            return;
+        }
+        std::unique_ptr<NameIndexInput> input = std::move(pending_);
+        uint64_t generation = generation_;
+        building_ = true;
+        lock.unlock();
+
+        auto index = std::make_shared<const NameIndex>(*input);
+        input.reset();
+
+        lock.lock();
+        building_ = false;
+        if (generation == generation_) {
+            index_ = std::move(index);
+        }
+        cv_.notify_all();
+    }
+}
+
+} // namespace fsvng
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "FsNode.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace fsvng {
+
+// ============================================================================
+// NameIndex - trigram index over every node name in a tree
+//
+// Distinct names are interned once, case-folded (ASCII), into one buffer;
+// each maps to the nodes carrying it. For every three-byte sequence there is
+// a sorted list of the names containing it, so a query only verifies the
+// names that contain all of its literal trigrams. Immutable once built;
+// results are node IDs, to be resolved with FsTree::nodeById().
+// ============================================================================
+
+// Names, IDs and sizes copied out of a tree, so the index can be built off
+// the thread that owns it.
+struct NameIndexInput {
+    std::string names;            // every node's name, back to back
+    std::vector<uint32_t> ends;   // end of each node's name in names
+    std::vector<unsigned int> ids;
+    std::vector<int64_t> sizes;   // subtree size for directories
+
+    // Copy from every node below metanode. O(n); call on the tree's thread.
+    static NameIndexInput collect(const FsNode* metanode);
+};
+
+enum class NameQuery {
+    Substring,  // name contains the text
+    Glob,       // whole name matches, * and ? as in scan.exclude
+    Regex       // ECMAScript regex found anywhere in the name
+};
+
+class NameIndex {
+public:
+    struct Match {
+        unsigned int id;
+        int64_t size;
+    };
+
+    explicit NameIndex(const NameIndexInput& input);
+
+    // Up to limit matching nodes, largest first. All queries ignore ASCII
+    // case. *total gets the number of matches; an invalid regex sets
+    // *error and returns nothing.
+    std::vector<Match> query(const std::string& text, NameQuery kind, size_t limit,
+                             size_t* total = nullptr, std::string* error = nullptr) const;
+
+    size_t nameCount() const { return nameEnds_.size(); }
+    size_t nodeCount() const { return nodes_.size(); }
+
+    // Approximate heap bytes held by the index.
+    size_t memoryUsage() const;
+
+private:
+    std::string_view name(uint32_t nameId) const {
+        uint32_t begin = nameId == 0 ? 0 : nameEnds_[nameId - 1];
+        return std::string_view(names_).substr(begin, nameEnds_[nameId] - begin);
+    }
+
+    // Names containing every trigram of every literal, or all names when no
+    // literal is at least 3 bytes long (*all is set then).
+    std::vector<uint32_t> candidates(const std::vector<std::string>& literals, bool* all) const;
+
+    std::string names_;                 // folded distinct names, back to back
+    std::vector<uint32_t> nameEnds_;
+    std::vector<uint32_t> nameNodes_;   // nodes_ range of each name, size nameCount() + 1
+    std::vector<Match> nodes_;          // grouped by name
+
+    // Posting lists: postings_[trigramStarts_[k] .. trigramStarts_[k + 1]) are
+    // the names containing trigrams_[k], ascending
+    std::vector<uint32_t> trigrams_;
+    std::vector<uint32_t> trigramStarts_;
+    std::vector<uint32_t> postings_;
+};
+
+// ============================================================================
+// NameSearch - keeps a NameIndex of the current tree, built in the background
+//
+// rebuild() copies the names on the calling thread and hands them to a
+// worker, which swaps the finished index in; until then queries see the
+// previous one. A rebuild requested while one is running replaces it.
+// ============================================================================
+
+class NameSearch {
+public:
+    NameSearch() = default;
+    ~NameSearch();
+    NameSearch(const NameSearch&) = delete;
+    NameSearch& operator=(const NameSearch&) = delete;
+
+    // Index the tree under metanode. Call on the thread that owns it.
+    void rebuild(const FsNode* metanode);
+
+    // Forget the index and any build in progress (the tree was replaced).
+    void clear();
+
+    // The latest finished index, or nullptr.
+    std::shared_ptr<const NameIndex> index() const;
+
+    bool isBuilding() const;
+
+    // Block until no build is queued or running.
+    void wait() const;
+
+private:
+    void workerLoop();
+
+    std::thread thread_;
+
+    // Guards everything below; shared with the worker thread.
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;
+    std::shared_ptr<const NameIndex> index_;
+    std::unique_ptr<NameIndexInput> pending_;
+    uint64_t generation_ = 0;  // bumped by clear(); stale builds are dropped
+    bool building_ = false;
+    bool stopping_ = false;
+};
+
+} // namespace fsvng
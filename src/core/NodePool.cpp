@@ -0,0 +1,238 @@
+#include "NodePool.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace fsvng {
+namespace NodePool {
+
+namespace {
+
+// Blocks are aligned to their size, so masking a node's address finds the
+// header at the start of its block.
+struct alignas(64) BlockHeader {
+    // Live allocations, plus one while the block is some thread's current
+    // block.
+    std::atomic<size_t> refs{1};
+    // Released slots, linked through their first word. Any thread pushes;
+    // the owning thread takes the whole chain at once.
+    std::atomic<void*> freed{nullptr};
+    std::atomic<bool> owned{true};   // some thread's current block
+    std::atomic<bool> listed{false}; // on the reusable list; set under listMutex
+
+    size_t slotSize;
+    char* top = nullptr;             // bump pointer while not owned
+    BlockHeader* prev = nullptr;     // reusable list links, under listMutex
+    BlockHeader* next = nullptr;
+
+    explicit BlockHeader(size_t size) : slotSize(size) {}
+};
+
+constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+
+std::atomic<size_t> blocksAllocated{0};
+
+// Blocks no thread owns that have released slots to hand out again
+std::mutex listMutex;
+BlockHeader* reusable = nullptr;
+
+void link(BlockHeader* block) {
+    block->prev = nullptr;
+    block->next = reusable;
+    if (reusable) {
+        reusable->prev = block;
+    }
+    reusable = block;
+    block->listed.store(true);
+}
+
+void unlink(BlockHeader* block) {
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        reusable = block->next;
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+    block->listed.store(false);
+}
+
+BlockHeader* newBlock(size_t slotSize) {
+#ifdef _WIN32
+    void* mem = _aligned_malloc(BLOCK_SIZE, BLOCK_SIZE);
+#else
+    void* mem = std::aligned_alloc(BLOCK_SIZE, BLOCK_SIZE);
+#endif
+    if (!mem) {
+        throw std::bad_alloc();
+    }
+    blocksAllocated.fetch_add(1, std::memory_order_relaxed);
+    BlockHeader* block = new (mem) BlockHeader(slotSize);
+    block->top = reinterpret_cast<char*>(block) + sizeof(BlockHeader);
+    return block;
+}
+
+void unref(BlockHeader* block) {
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        {
+            std::lock_guard<std::mutex> lock(listMutex);
+            if (block->listed.load()) {
+                unlink(block);
+            }
+        }
+        block->~BlockHeader();
+#ifdef _WIN32
+        _aligned_free(block);
+#else
+        std::free(block);
+#endif
+        blocksAllocated.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void pushFreed(BlockHeader* block, void* p) {
+    void* head = block->freed.load(std::memory_order_relaxed);
+    do {
+        *static_cast<void**>(p) = head;
+    } while (!block->freed.compare_exchange_weak(head, p));
+}
+
+struct ThreadBlock {
+    BlockHeader* block = nullptr;
+    char* next = nullptr;
+    char* end = nullptr;
+    void* free = nullptr;  // slots taken from block->freed
+
+    // Hand the block back. Slots released while it was owned make it
+    // reusable; a release that saw it owned relies on this check.
+    void disown() {
+        while (free) {
+            void* p = free;
+            free = *static_cast<void**>(p);
+            pushFreed(block, p);
+        }
+        {
+            std::lock_guard<std::mutex> lock(listMutex);
+            block->top = next;
+            block->owned.store(false);
+            if (block->freed.load() && !block->listed.load()) {
+                link(block);
+            }
+        }
+        unref(block);
+        block = nullptr;
+    }
+
+    // Make a reusable block of this slot size, or a new one, current.
+    void adopt(size_t size) {
+        BlockHeader* found = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(listMutex);
+            for (BlockHeader* b = reusable; b && !found; b = b->next) {
+                if (b->slotSize != size) {
+                    continue;
+                }
+                // A block whose last slot is being released is left to
+                // its releaser to unlink and free.
+                size_t refs = b->refs.load();
+                while (refs > 0 && !b->refs.compare_exchange_weak(refs, refs + 1)) {
+                }
+                if (refs > 0) {
+                    found = b;
+                }
+            }
+            if (found) {
+                unlink(found);
+                found->owned.store(true);
+                next = found->top;
+            }
+        }
+        if (!found) {
+            found = newBlock(size);
+            next = found->top;
+        }
+        block = found;
+        end = reinterpret_cast<char*>(found) + BLOCK_SIZE;
+        free = found->freed.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    ~ThreadBlock() {
+        if (block) {
+            disown();
+        }
+    }
+};
+
+thread_local ThreadBlock current;
+
+} // namespace
+
+void* allocate(size_t size) {
+    assert(size <= MAX_ALLOCATION);
+    size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    ThreadBlock& t = current;
+    if (t.block && t.block->slotSize != size) {
+        t.disown();
+    }
+    for (;;) {
+        if (!t.block) {
+            t.adopt(size);
+        }
+        if (!t.free && t.next + size > t.end) {
+            t.free = t.block->freed.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (t.free || t.next + size <= t.end) {
+            break;
+        }
+        t.disown();
+    }
+
+    void* p;
+    if (t.free) {
+        p = t.free;
+        t.free = *static_cast<void**>(p);
+    } else {
+        p = t.next;
+        t.next += size;
+    }
+    // Only the owning thread adds references, and it holds one already.
+    t.block->refs.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+void release(void* p) {
+    if (!p) {
+        return;
+    }
+    auto addr = reinterpret_cast<uintptr_t>(p) & ~(uintptr_t(BLOCK_SIZE) - 1);
+    BlockHeader* block = reinterpret_cast<BlockHeader*>(addr);
+
+    // The slot goes back to its block. A block no thread owns is listed so
+    // that the next thread needing one picks it up instead of a new block;
+    // an owned one is reused by its owner, or listed when the owner lets go.
+    pushFreed(block, p);
+    if (!block->owned.load() && !block->listed.load()) {
+        std::lock_guard<std::mutex> lock(listMutex);
+        if (!block->owned.load() && !block->listed.load()) {
+            link(block);
+        }
+    }
+    unref(block);
+}
+
+size_t blockCount() {
+    return blocksAllocated.load(std::memory_order_relaxed);
+}
+
+} // namespace NodePool
+} // namespace fsvng
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+namespace fsvng {
+
+// ============================================================================
+// NodePool - bump allocator behind FsNode's operator new/delete
+//
+// Each thread carves nodes out of its own 256 KiB block with a pointer bump,
+// so a scan costs one malloc per ~1000 nodes instead of one per node, and
+// nodes created together sit together in memory. A block serves a single
+// slot size, counts its live nodes and is returned to the system when the
+// last one is deleted, which may happen on any thread. Deleted slots go on
+// their block's free list: its owning thread reuses them, and a block no
+// thread owns is put on a shared list for the next thread that needs a
+// block, so trees edited node by node (FsWatcher, FsLoader) don't leave
+// mostly empty blocks behind.
+// ============================================================================
+
+namespace NodePool {
+
+    // Allocate size bytes (at most MAX_ALLOCATION) from this thread's block.
+    void* allocate(size_t size);
+
+    // Return memory from allocate(); frees its block once the block is empty.
+    void release(void* p);
+
+    // Blocks currently allocated, across all threads.
+    size_t blockCount();
+
+    inline constexpr size_t BLOCK_SIZE = 256 * 1024;
+    inline constexpr size_t MAX_ALLOCATION = 4096;
+
+} // namespace NodePool
+} // namespace fsvng
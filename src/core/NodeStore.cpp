@@ -0,0 +1,151 @@
+#include "NodeStore.h"
+#include "FsNode.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+namespace fsvng {
+
+namespace {
+
+// Fold name's extension into buf; its length, or 0 if it has none. Only
+// the last MAX_EXTENSION_LENGTH + 1 characters are looked at.
+size_t foldedExtension(const std::string& name, char* buf) {
+    const size_t len = name.size();
+    const size_t stop =
+        len > NodeStore::MAX_EXTENSION_LENGTH ? len - NodeStore::MAX_EXTENSION_LENGTH : 0;
+    size_t dot = len;
+    while (dot > stop && name[dot - 1] != '.') {
+        --dot;
+    }
+    // dot is one past the '.'; a leading dot marks a dotfile
+    if (dot <= 1 || dot == len || name[dot - 1] != '.') {
+        return 0;
+    }
+    for (size_t i = dot; i < len; ++i) {
+        char c = name[i];
+        buf[i - dot] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    return len - dot;
+}
+
+} // namespace
+
+// ============================================================================
+// NodeStore
+// ============================================================================
+
+void NodeStore::build(const std::vector<FsNode*>& nodeTable, uint64_t generation,
+                      unsigned int threadCount) {
+    const size_t n = nodeTable.size();
+    generation_ = generation;
+    parent_.assign(n, NONE);
+    firstChild_.assign(n, 0);
+    childCount_.assign(n, 0);
+    type_.assign(n, static_cast<uint8_t>(NUM_NODE_TYPES));
+    flags_.assign(n, 0);
+    size_.assign(n, 0);
+    sizeAlloc_.assign(n, 0);
+    subtreeSize_.assign(n, 0);
+    subtreeSizeAlloc_.assign(n, 0);
+    userId_.assign(n, 0);
+    extension_.assign(n, 0);
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned int>(
+        std::clamp<size_t>(n / MIN_NODES_PER_THREAD, 1, threadCount));
+    auto rangeBegin = [&](unsigned int i) { return n * i / threadCount; };
+
+    // Each thread fills its ID range of the columns. Child lists and
+    // extension numbers are local to the range until merged below.
+    std::vector<Range> ranges(threadCount);
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(&NodeStore::fillRange, this, std::cref(nodeTable), rangeBegin(i),
+                             rangeBegin(i + 1), std::ref(ranges[i]));
+    }
+    fillRange(nodeTable, 0, rangeBegin(1), ranges[0]);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    childIds_.clear();
+    extensionNames_.assign(1, std::string());
+    std::unordered_map<std::string, uint32_t> extensionIds;
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        Range& range = ranges[i];
+        uint32_t childBase = static_cast<uint32_t>(childIds_.size());
+        childIds_.insert(childIds_.end(), range.childIds.begin(), range.childIds.end());
+
+        std::vector<uint32_t> global(range.extensionNames.size() + 1, 0);
+        for (size_t e = 0; e < range.extensionNames.size(); ++e) {
+            auto [it, inserted] = extensionIds.try_emplace(
+                range.extensionNames[e], static_cast<uint32_t>(extensionNames_.size()));
+            if (inserted) {
+                extensionNames_.push_back(range.extensionNames[e]);
+            }
+            global[e + 1] = it->second;
+        }
+        for (size_t id = rangeBegin(i); id < rangeBegin(i + 1); ++id) {
+            firstChild_[id] += childBase;
+            extension_[id] = global[extension_[id]];
+        }
+    }
+}
+
+void NodeStore::fillRange(const std::vector<FsNode*>& nodeTable, size_t begin, size_t end,
+                          Range& out) {
+    std::unordered_map<std::string, uint32_t> extensionIds;
+    std::string key;
+    char buf[MAX_EXTENSION_LENGTH];
+    uint32_t lastExtension = 0;  // runs of siblings tend to share one
+    for (size_t id = begin; id < end; ++id) {
+        const FsNode* node = nodeTable[id];
+        if (!node) {
+            continue;
+        }
+        parent_[id] = node->parent ? node->parent->id : NONE;
+        firstChild_[id] = static_cast<uint32_t>(out.childIds.size());
+        childCount_[id] = static_cast<uint32_t>(node->children.size());
+        type_[id] = static_cast<uint8_t>(node->type);
+        flags_[id] = node->flags;
+        size_[id] = node->size;
+        sizeAlloc_[id] = node->sizeAlloc;
+        subtreeSize_[id] = node->subtree.size;
+        subtreeSizeAlloc_[id] = node->subtree.sizeAlloc;
+        userId_[id] = node->userId;
+        size_t length = node->isDir() ? 0 : foldedExtension(node->name, buf);
+        if (length > 0) {
+            if (lastExtension == 0 || key.size() != length ||
+                key.compare(0, length, buf, length) != 0) {
+                key.assign(buf, length);
+                auto [it, inserted] = extensionIds.try_emplace(
+                    key, static_cast<uint32_t>(out.extensionNames.size() + 1));
+                if (inserted) {
+                    out.extensionNames.push_back(key);
+                }
+                lastExtension = it->second;
+            }
+            extension_[id] = lastExtension;
+        }
+        for (const auto& child : node->children) {
+            out.childIds.push_back(child->id);
+        }
+    }
+}
+
+size_t NodeStore::memoryUsage() const {
+    return (parent_.capacity() + firstChild_.capacity() + childCount_.capacity() +
+            userId_.capacity() + extension_.capacity() + childIds_.capacity()) *
+               sizeof(uint32_t) +
+           type_.capacity() + flags_.capacity() * sizeof(uint16_t) +
+           (size_.capacity() + sizeAlloc_.capacity() + subtreeSize_.capacity() +
+            subtreeSizeAlloc_.capacity()) * sizeof(int64_t);
+}
+
+} // namespace fsvng
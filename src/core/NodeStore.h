@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fsvng {
+
+class FsNode;
+
+// ============================================================================
+// NodeStore - dense structure-of-arrays copy of the tree's hot fields
+//
+// Indexed by node ID. Whole-tree passes that only need structure, types,
+// sizes, owners and file extensions (SizeReport) walk these columns in ID
+// order instead of chasing one FsNode pointer per node; names and
+// timestamps stay on FsNode. Built by FsTree::nodeStore() and only
+// describes the tree of the generation it was built from.
+// ============================================================================
+
+class NodeStore {
+public:
+    static constexpr uint32_t NONE = INVALID_NODE_ID;
+
+    // Longer "extensions" are more likely part of a name than a file type.
+    static constexpr size_t MAX_EXTENSION_LENGTH = 16;
+
+    // Rebuild from FsTree's ID table (nullptr for unused IDs), split across
+    // threadCount threads (0 = one per hardware thread).
+    void build(const std::vector<FsNode*>& nodeTable, uint64_t generation,
+               unsigned int threadCount = 0);
+
+    // FsTree::generation() the columns describe.
+    uint64_t generation() const { return generation_; }
+
+    size_t size() const { return type_.size(); }
+    bool contains(unsigned int id) const {
+        return id < type_.size() && type_[id] != NUM_NODE_TYPES;
+    }
+
+    uint32_t parent(unsigned int id) const { return parent_[id]; }
+    uint32_t childCount(unsigned int id) const { return childCount_[id]; }
+    // ID of a node's i-th child, in FsTree's sort order.
+    uint32_t child(unsigned int id, uint32_t i) const { return childIds_[firstChild_[id] + i]; }
+    // NUM_NODE_TYPES for an unused ID.
+    NodeType type(unsigned int id) const { return static_cast<NodeType>(type_[id]); }
+    uint16_t flags(unsigned int id) const { return flags_[id]; }
+    int64_t nodeSize(unsigned int id) const { return size_[id]; }
+    int64_t nodeSizeAlloc(unsigned int id) const { return sizeAlloc_[id]; }
+    int64_t subtreeSize(unsigned int id) const { return subtreeSize_[id]; }
+    int64_t subtreeSizeAlloc(unsigned int id) const { return subtreeSizeAlloc_[id]; }
+    uint32_t userId(unsigned int id) const { return userId_[id]; }
+
+    // A file's case-folded extension, interned: an index into the
+    // extensions seen, 0 standing for none (also used for directories;
+    // dotfiles and overlong suffixes count as none).
+    uint32_t extension(unsigned int id) const { return extension_[id]; }
+    const std::string& extensionName(uint32_t ext) const { return extensionNames_[ext]; }
+
+    // Approximate heap bytes held by the columns.
+    size_t memoryUsage() const;
+
+private:
+    // Threads only pay off once each gets a good share of the ID table.
+    static constexpr size_t MIN_NODES_PER_THREAD = 16 * 1024;
+
+    // One thread's share of build(): child IDs and extensions (numbered
+    // from 1 in extensionNames order) of its ID range.
+    struct Range {
+        std::vector<uint32_t> childIds;
+        std::vector<std::string> extensionNames;
+    };
+    void fillRange(const std::vector<FsNode*>& nodeTable, size_t begin, size_t end, Range& out);
+
+    uint64_t generation_ = 0;
+
+    // Hot columns
+    std::vector<uint32_t> parent_;
+    std::vector<uint32_t> firstChild_;   // index into childIds_
+    std::vector<uint32_t> childCount_;
+    std::vector<uint8_t> type_;          // NodeType; NUM_NODE_TYPES if unused
+    std::vector<uint16_t> flags_;
+    std::vector<int64_t> size_;
+    std::vector<int64_t> sizeAlloc_;
+    std::vector<int64_t> subtreeSize_;
+    std::vector<int64_t> subtreeSizeAlloc_;
+    std::vector<uint32_t> userId_;
+    std::vector<uint32_t> extension_;
+
+    std::vector<std::string> extensionNames_;  // [0] is ""
+
+    // Children of every node, each node's run contiguous
+    std::vector<uint32_t> childIds_;
+};
+
+} // namespace fsvng
@@ -43,8 +43,12 @@ std::string getUserName(uint32_t uid) {
     (void)uid;
     return "User";
 #else
-    struct passwd* pw = getpwuid(static_cast<uid_t>(uid));
-    if (pw && pw->pw_name) {
+    // Reentrant lookup: reports resolve owners on worker threads.
+    struct passwd pwd;
+    struct passwd* pw = nullptr;
+    char buf[4096];
+    if (getpwuid_r(static_cast<uid_t>(uid), &pwd, buf, sizeof(buf), &pw) == 0 &&
+        pw && pw->pw_name) {
         return std::string(pw->pw_name);
     }
     return std::to_string(uid);
@@ -56,8 +60,11 @@ std::string getGroupName(uint32_t gid) {
     (void)gid;
     return "Users";
 #else
-    struct group* gr = getgrgid(static_cast<gid_t>(gid));
-    if (gr && gr->gr_name) {
+    struct group grp;
+    struct group* gr = nullptr;
+    char buf[4096];
+    if (getgrgid_r(static_cast<gid_t>(gid), &grp, buf, sizeof(buf), &gr) == 0 &&
+        gr && gr->gr_name) {
         return std::string(gr->gr_name);
     }
     return std::to_string(gid);
@@ -13,6 +13,7 @@ namespace PlatformUtils {
     double getTime();
 
     // Get user name from UID (POSIX) or return placeholder (Windows).
+    // Thread-safe.
     std::string getUserName(uint32_t uid);
 
     // Get group name from GID (POSIX) or return placeholder (Windows).
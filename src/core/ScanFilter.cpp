@@ -0,0 +1,238 @@
+#include "ScanFilter.h"
+#include "PlatformUtils.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+
+namespace fsvng {
+
+namespace {
+
+bool hasWildcard(const std::string& s) {
+    return s.find_first_of("*?") != std::string::npos;
+}
+
+// "/a/b" -> "/a", "/a" -> "/", "C:/a" -> "C:"
+std::string parentPath(const std::string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return std::string();
+    }
+    return slash == 0 ? std::string("/") : path.substr(0, slash);
+}
+
+std::string joinPath(const std::string& dir, std::string_view name) {
+    std::string path = dir;
+    if (path.empty() || path.back() != '/') {
+        path += '/';
+    }
+    path += name;
+    return path;
+}
+
+} // namespace
+
+ScanFilter::ScanFilter(const std::vector<std::string>& rules) {
+    for (std::string rule : rules) {
+#ifdef _WIN32
+        std::replace(rule.begin(), rule.end(), '\\', '/');
+#endif
+        while (rule.size() > 1 && rule.back() == '/') {
+            rule.pop_back();
+        }
+        if (rule.empty()) {
+            continue;
+        }
+
+        if (rule.find('/') == std::string::npos) {
+            if (hasWildcard(rule)) {
+                nameGlobs_.push_back(rule);
+            } else {
+                nameLiterals_.insert(rule);
+            }
+        } else if (hasWildcard(rule)) {
+            pathGlobs_.push_back(rule);
+        } else {
+            pathLiteralDirs_.insert(parentPath(rule));
+            pathLiterals_.insert(rule);
+        }
+    }
+    compileGlobs();
+}
+
+bool ScanFilter::empty() const {
+    return nameLiterals_.empty() && nameGlobs_.empty() && !hasPathRules();
+}
+
+bool ScanFilter::excludes(const std::string& dirPath, std::string_view name) const {
+    if (!nameLiterals_.empty()) {
+        // No heterogeneous lookup before C++20; a per-thread key keeps its
+        // capacity, so this does not allocate per entry.
+        static thread_local std::string key;
+        key.assign(name.data(), name.size());
+        if (nameLiterals_.count(key)) {
+            return true;
+        }
+    }
+    if (!nameGlobs_.empty() && matchNameGlobs(name)) {
+        return true;
+    }
+    if (!hasPathRules()) {
+        return false;
+    }
+
+    std::string dir = dirPath;
+    if (dir.size() > 1 && dir.back() == '/') {
+        dir.pop_back();
+    }
+    if (!pathGlobs_.empty() || pathLiteralDirs_.count(dir)) {
+        std::string path = joinPath(dir, name);
+        if (pathLiterals_.count(path)) {
+            return true;
+        }
+        for (const std::string& glob : pathGlobs_) {
+            if (PlatformUtils::wildcardMatch(glob, path)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ScanFilter::matchNameGlobs(std::string_view name) const {
+    if (dfa_.empty()) {
+        std::string str(name);
+        for (const std::string& glob : nameGlobs_) {
+            if (PlatformUtils::wildcardMatch(glob, str)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int32_t state = 0;
+    for (unsigned char c : name) {
+        state = dfa_[static_cast<size_t>(state) * classCount_ + charClass_[c]];
+        if (state == deadState_) {
+            return false;
+        }
+    }
+    return accepting_[state] != 0;
+}
+
+// ============================================================================
+// Glob automaton
+//
+// Each glob of length n contributes NFA states 0..n, state i meaning "the
+// first i pattern characters are matched" and n being accepting. A '*' at
+// position i loops on any character and has an epsilon edge to i + 1. The
+// DFA states are the reachable sets of NFA states, one bit per state.
+// ============================================================================
+
+void ScanFilter::compileGlobs() {
+    if (nameGlobs_.empty()) {
+        return;
+    }
+
+    // NFA: symbol per state, '\0' marking the accepting end of a glob.
+    std::vector<char> symbols;
+    std::vector<size_t> starts;
+    for (const std::string& glob : nameGlobs_) {
+        starts.push_back(symbols.size());
+        symbols.insert(symbols.end(), glob.begin(), glob.end());
+        symbols.push_back('\0');
+    }
+    const size_t nfaStates = symbols.size();
+    const size_t words = (nfaStates + 63) / 64;
+    using StateSet = std::vector<uint64_t>;
+
+    for (char sym : symbols) {
+        auto c = static_cast<unsigned char>(sym);
+        if (sym != '\0' && sym != '*' && sym != '?' && charClass_[c] == 0) {
+            charClass_[c] = static_cast<uint8_t>(classCount_++);
+        }
+    }
+
+    auto test = [](const StateSet& set, size_t s) { return (set[s / 64] >> (s % 64)) & 1; };
+    auto add = [](StateSet& set, size_t s) { set[s / 64] |= uint64_t(1) << (s % 64); };
+
+    // Follow the epsilon edges out of '*'. They only lead forward, so one
+    // ascending pass reaches the closure.
+    auto close = [&](StateSet& set) {
+        for (size_t s = 0; s < nfaStates; ++s) {
+            if (test(set, s) && symbols[s] == '*') {
+                add(set, s + 1);
+            }
+        }
+    };
+    auto step = [&](const StateSet& set, size_t cls) {
+        StateSet next(words, 0);
+        for (size_t s = 0; s < nfaStates; ++s) {
+            if (!test(set, s)) {
+                continue;
+            }
+            char sym = symbols[s];
+            auto c = static_cast<unsigned char>(sym);
+            if (sym == '*') {
+                add(next, s);
+            } else if (sym == '?' || (sym != '\0' && cls != 0 && charClass_[c] == cls)) {
+                add(next, s + 1);
+            }
+        }
+        close(next);
+        return next;
+    };
+
+    StateSet start(words, 0);
+    for (size_t s : starts) {
+        add(start, s);
+    }
+    close(start);
+
+    std::map<StateSet, int32_t> ids;
+    std::deque<StateSet> work;
+    ids.emplace(start, 0);
+    work.push_back(start);
+
+    while (!work.empty()) {
+        StateSet set = std::move(work.front());
+        work.pop_front();
+        int32_t id = ids[set];
+
+        bool accepting = false;
+        bool dead = true;
+        for (size_t s = 0; s < nfaStates; ++s) {
+            if (test(set, s)) {
+                dead = false;
+                accepting = accepting || symbols[s] == '\0';
+            }
+        }
+        if (accepting_.size() <= static_cast<size_t>(id)) {
+            accepting_.resize(id + 1, 0);
+        }
+        accepting_[id] = accepting;
+        if (dead) {
+            deadState_ = id;
+        }
+
+        dfa_.resize(ids.size() * classCount_, -1);
+        for (size_t cls = 0; cls < classCount_; ++cls) {
+            StateSet next = step(set, cls);
+            auto [it, inserted] = ids.emplace(next, static_cast<int32_t>(ids.size()));
+            if (inserted) {
+                if (ids.size() > MAX_DFA_STATES) {
+                    dfa_.clear();
+                    accepting_.clear();
+                    deadState_ = -1;
+                    return;
+                }
+                work.push_back(next);
+            }
+            dfa_.resize(ids.size() * classCount_, -1);
+            dfa_[static_cast<size_t>(id) * classCount_ + cls] = it->second;
+        }
+    }
+}
+
+} // namespace fsvng
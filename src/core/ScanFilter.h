@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace fsvng {
+
+// ============================================================================
+// ScanFilter - exclusion rules compiled for matching during a scan
+//
+// A rule without a '/' matches entry names anywhere in the tree (".git",
+// "node_modules", "*.o"); a rule with one matches absolute paths ("/proc",
+// "/home/*/.cache"). Both support the * and ? wildcards of
+// PlatformUtils::wildcardMatch. Literal rules go into hash sets; all name
+// globs are compiled into one DFA, so an entry name is checked against
+// every glob in a single pass over its characters.
+// ============================================================================
+
+class ScanFilter {
+public:
+    ScanFilter() = default;
+    explicit ScanFilter(const std::vector<std::string>& rules);
+
+    bool empty() const;
+
+    // True if the entry name inside directory dirPath is excluded. dirPath
+    // is only consulted when there are path rules (see hasPathRules()).
+    // Takes the name as a view so scanners can test raw directory entries
+    // before copying them into a node.
+    bool excludes(const std::string& dirPath, std::string_view name) const;
+
+    // Path rules need the entry's directory; callers may skip building it
+    // when this is false.
+    bool hasPathRules() const { return !pathLiterals_.empty() || !pathGlobs_.empty(); }
+
+private:
+    bool matchNameGlobs(std::string_view name) const;
+
+    // Subset construction over the combined NFA of nameGlobs_. Leaves dfa_
+    // empty (matching falls back to one wildcardMatch per glob) if the
+    // automaton would exceed MAX_DFA_STATES.
+    void compileGlobs();
+
+    static constexpr size_t MAX_DFA_STATES = 4096;
+
+    std::unordered_set<std::string> nameLiterals_;
+    std::vector<std::string> nameGlobs_;
+    std::unordered_set<std::string> pathLiterals_;
+    std::unordered_set<std::string> pathLiteralDirs_;  // parents of pathLiterals_
+    std::vector<std::string> pathGlobs_;
+
+    // DFA over character classes: every byte that appears literally in some
+    // glob has its own class, all other bytes share class 0.
+    uint8_t charClass_[256] = {};
+    size_t classCount_ = 1;
+    std::vector<int32_t> dfa_;      // [state * classCount_ + class] -> state
+    std::vector<char> accepting_;
+    int32_t deadState_ = -1;        // no glob can match any more
+};
+
+} // namespace fsvng
@@ -0,0 +1,273 @@
+#include "SizeReport.h"
+#include "FsTree.h"
+#include "NodeStore.h"
+#include "PlatformUtils.h"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+namespace fsvng {
+
+namespace {
+
+// Threads only pay off once each gets a good share of the ID table.
+constexpr size_t MIN_NODES_PER_THREAD = 16 * 1024;
+
+// How often a thread looks at the cancel flag.
+constexpr size_t CANCEL_CHECK_INTERVAL = 64 * 1024;
+
+struct Entry {
+    int64_t size;
+    unsigned int id;
+};
+
+// Larger first; equal sizes by ID, so results don't depend on how the
+// ID range was split.
+inline bool ranksBefore(const Entry& a, const Entry& b) {
+    return a.size != b.size ? a.size > b.size : a.id < b.id;
+}
+
+// The limit best entries seen so far; the worst of them on top.
+class TopHeap {
+public:
+    explicit TopHeap(size_t limit = 0) : limit_(limit) {}
+
+    void push(const Entry& e) {
+        if (entries_.size() < limit_) {
+            entries_.push_back(e);
+            std::push_heap(entries_.begin(), entries_.end(), ranksBefore);
+        } else if (limit_ > 0 && ranksBefore(e, entries_.front())) {
+            std::pop_heap(entries_.begin(), entries_.end(), ranksBefore);
+            entries_.back() = e;
+            std::push_heap(entries_.begin(), entries_.end(), ranksBefore);
+        }
+    }
+
+    void merge(const TopHeap& other) {
+        for (const Entry& e : other.entries_) {
+            push(e);
+        }
+    }
+
+    std::vector<unsigned int> sortedIds() {
+        std::sort(entries_.begin(), entries_.end(), ranksBefore);
+        std::vector<unsigned int> ids;
+        ids.reserve(entries_.size());
+        for (const Entry& e : entries_) {
+            ids.push_back(e.id);
+        }
+        return ids;
+    }
+
+private:
+    size_t limit_;
+    std::vector<Entry> entries_;
+};
+
+struct GroupTotals {
+    std::string name;
+    int64_t size = 0;
+    uint64_t files = 0;
+    TopHeap largest;
+};
+
+// Partial report of one ID range.
+struct Partial {
+    TopHeap files;
+    TopHeap dirs;
+    std::unordered_map<uint32_t, GroupTotals> extensions;  // by NodeStore::extension()
+    std::unordered_map<uint32_t, GroupTotals> owners;      // by user ID
+};
+
+GroupTotals& groupFor(std::unordered_map<uint32_t, GroupTotals>& groups, uint32_t key,
+                      size_t topN) {
+    auto it = groups.find(key);
+    if (it == groups.end()) {
+        it = groups.emplace(key, GroupTotals{std::string(), 0, 0, TopHeap(topN)}).first;
+    }
+    return it->second;
+}
+
+void addToGroup(GroupTotals& group, const Entry& e) {
+    group.size += e.size;
+    group.files++;
+    group.largest.push(e);
+}
+
+void mergeGroup(GroupTotals& into, const GroupTotals& from) {
+    into.size += from.size;
+    into.files += from.files;
+    into.largest.merge(from.largest);
+}
+
+void scanRange(const NodeStore& store, unsigned int begin, unsigned int end,
+               const SizeReport::Options& options, const std::atomic<bool>* cancel,
+               Partial& out) {
+    for (unsigned int id = begin; id < end; ++id) {
+        if (cancel && (id - begin) % CANCEL_CHECK_INTERVAL == 0 && cancel->load()) {
+            return;
+        }
+        NodeType type = store.type(id);
+        if (type == NUM_NODE_TYPES || type == NODE_METANODE) {
+            continue;
+        }
+        if (type == NODE_DIRECTORY) {
+            int64_t size = options.allocated ? store.subtreeSizeAlloc(id) : store.subtreeSize(id);
+            out.dirs.push({size, id});
+            continue;
+        }
+        if (store.flags(id) & NODE_FLAG_DUPLICATE) {
+            continue;
+        }
+
+        Entry e{options.allocated ? store.nodeSizeAlloc(id) : store.nodeSize(id), id};
+        out.files.push(e);
+
+        addToGroup(groupFor(out.extensions, store.extension(id), options.topN), e);
+        addToGroup(groupFor(out.owners, store.userId(id), options.topN), e);
+    }
+}
+
+template <typename Key>
+std::vector<SizeReport::Group> finishGroups(std::unordered_map<Key, GroupTotals>& groups) {
+    std::vector<SizeReport::Group> result;
+    result.reserve(groups.size());
+    for (auto& [key, totals] : groups) {
+        SizeReport::Group g;
+        g.name = std::move(totals.name);
+        g.size = totals.size;
+        g.files = totals.files;
+        g.largest = totals.largest.sortedIds();
+        result.push_back(std::move(g));
+    }
+    std::sort(result.begin(), result.end(),
+              [](const SizeReport::Group& a, const SizeReport::Group& b) {
+                  return a.size != b.size ? a.size > b.size : a.name < b.name;
+              });
+    return result;
+}
+
+} // namespace
+
+// ============================================================================
+// SizeReport
+// ============================================================================
+
+SizeReport SizeReport::compute(const FsTree& tree, const Options& options,
+                               unsigned int threadCount, const std::atomic<bool>* cancel) {
+    SizeReport report;
+    report.options = options;
+    report.generation = tree.generation();
+
+    std::shared_ptr<const NodeStore> store = tree.nodeStore();
+    unsigned int nodeCount = static_cast<unsigned int>(store->size());
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned int>(std::clamp<size_t>(
+        nodeCount / MIN_NODES_PER_THREAD, 1, threadCount));
+
+    std::vector<Partial> partials;
+    partials.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        partials.push_back({TopHeap(options.topN), TopHeap(options.topN), {}, {}});
+    }
+
+    auto rangeBegin = [&](unsigned int i) {
+        return static_cast<unsigned int>(uint64_t(nodeCount) * i / threadCount);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(scanRange, std::cref(*store), rangeBegin(i), rangeBegin(i + 1),
+                             std::cref(options), cancel, std::ref(partials[i]));
+    }
+    scanRange(*store, 0, rangeBegin(1), options, cancel, partials[0]);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    if (cancel && cancel->load()) {
+        return report;
+    }
+
+    Partial& all = partials[0];
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        Partial& p = partials[i];
+        all.files.merge(p.files);
+        all.dirs.merge(p.dirs);
+        for (auto& [key, totals] : p.extensions) {
+            mergeGroup(groupFor(all.extensions, key, options.topN), totals);
+        }
+        for (auto& [key, totals] : p.owners) {
+            mergeGroup(groupFor(all.owners, key, options.topN), totals);
+        }
+    }
+    for (auto& [ext, totals] : all.extensions) {
+        totals.name = store->extensionName(ext);
+    }
+    for (auto& [uid, totals] : all.owners) {
+        totals.name = PlatformUtils::getUserName(uid);
+    }
+
+    report.largestFiles = all.files.sortedIds();
+    report.largestDirs = all.dirs.sortedIds();
+    report.byExtension = finishGroups(all.extensions);
+    report.byOwner = finishGroups(all.owners);
+    return report;
+}
+
+// ============================================================================
+// SizeReporter
+// ============================================================================
+
+SizeReporter::~SizeReporter() {
+    cancel();
+}
+
+void SizeReporter::request(const SizeReport::Options& options) {
+    if (running_.load() || isCurrent(options)) {
+        return;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    cancel_ = false;
+    running_ = true;
+    thread_ = std::thread([this, options] {
+        auto report = std::make_shared<const SizeReport>(
+            SizeReport::compute(FsTree::instance(), options, 0, &cancel_));
+        if (!cancel_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            report_ = std::move(report);
+        }
+        running_ = false;
+    });
+}
+
+bool SizeReporter::isCurrent(const SizeReport::Options& options) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return report_ && report_->generation == FsTree::instance().generation() &&
+           report_->options.topN == options.topN &&
+           report_->options.allocated == options.allocated;
+}
+
+std::shared_ptr<const SizeReport> SizeReporter::report() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return report_;
+}
+
+void SizeReporter::cancel() {
+    cancel_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SizeReporter::clear() {
+    cancel();
+    std::lock_guard<std::mutex> lock(mutex_);
+    report_.reset();
+}
+
+} // namespace fsvng
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fsvng {
+
+class FsTree;
+
+// ============================================================================
+// SizeReport - where the space goes: the largest files and directories of
+// the whole tree, and totals with their largest files per file extension
+// and per owner
+//
+// Computed in one pass over the FsTree::nodeStore() columns in ID order,
+// split across threads, each keeping bounded min-heaps; the partial results
+// are merged at the end.
+// Hard-link duplicates (NODE_FLAG_DUPLICATE) are left out, as in subtree
+// totals. Results are node IDs, to be resolved with FsTree::nodeById().
+// ============================================================================
+
+struct SizeReport {
+    struct Options {
+        size_t topN = 100;
+        bool allocated = false;  // rank by sizeAlloc (disk usage) instead of size
+    };
+
+    struct Group {
+        std::string name;          // extension without the dot, or user name
+        int64_t size = 0;
+        uint64_t files = 0;
+        std::vector<unsigned int> largest;  // up to topN IDs, largest first
+    };
+
+    Options options;
+    uint64_t generation = 0;                 // FsTree::generation() it describes
+    std::vector<unsigned int> largestFiles;  // every non-directory node
+    std::vector<unsigned int> largestDirs;   // by subtree size
+    std::vector<Group> byExtension;          // largest total first
+    std::vector<Group> byOwner;
+
+    // Must not run concurrently with changes to the tree. Returns an empty
+    // report if *cancel becomes true.
+    static SizeReport compute(const FsTree& tree, const Options& options,
+                              unsigned int threadCount = 0,
+                              const std::atomic<bool>* cancel = nullptr);
+};
+
+// ============================================================================
+// SizeReporter - computes SizeReports on a worker thread and keeps the last
+//
+// While isRunning() the worker reads the tree, so its owner must hold back
+// any change to it (or cancel() first).
+// ============================================================================
+
+class SizeReporter {
+public:
+    SizeReporter() = default;
+    ~SizeReporter();
+    SizeReporter(const SizeReporter&) = delete;
+    SizeReporter& operator=(const SizeReporter&) = delete;
+
+    // Start a report of FsTree's current tree unless the last one already
+    // describes it with these options, or one is being computed.
+    void request(const SizeReport::Options& options);
+
+    bool isRunning() const { return running_.load(); }
+
+    // True if the last report matches the tree and options.
+    bool isCurrent(const SizeReport::Options& options) const;
+
+    // The last finished report, or nullptr.
+    std::shared_ptr<const SizeReport> report() const;
+
+    // Stop a running computation and wait for the worker.
+    void cancel();
+
+    // cancel() and forget the last report (the tree is being replaced).
+    void clear();
+
+private:
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> cancel_{false};
+
+    mutable std::mutex mutex_;  // guards report_
+    std::shared_ptr<const SizeReport> report_;
+};
+
+} // namespace fsvng
@@ -0,0 +1,182 @@
+#include "StatxRing.h"
+
+#ifdef FSVNG_HAVE_IO_URING
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+namespace fsvng {
+
+namespace {
+
+int ioUringSetup(unsigned int entries, io_uring_params* p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int ioUringEnter(int fd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+                                    flags, nullptr, 0));
+}
+
+unsigned int* ringField(void* ring, uint32_t offset) {
+    return reinterpret_cast<unsigned int*>(static_cast<char*>(ring) + offset);
+}
+
+} // namespace
+
+StatxRing::~StatxRing() {
+    close();
+}
+
+bool StatxRing::init(unsigned int entries) {
+    close();
+
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    int fd = ioUringSetup(entries, &p);
+    if (fd < 0) {
+        return false;
+    }
+    fd_ = fd;
+    sqEntries_ = p.sq_entries;
+
+    sqRingSize_ = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    cqRingSize_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        close();
+        return false;
+    }
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            cqRing_ = nullptr;
+            close();
+            return false;
+        }
+    }
+
+    sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        close();
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sqHead_  = ringField(sqRing_, p.sq_off.head);
+    sqTail_  = ringField(sqRing_, p.sq_off.tail);
+    sqMask_  = ringField(sqRing_, p.sq_off.ring_mask);
+    sqArray_ = ringField(sqRing_, p.sq_off.array);
+    cqHead_  = ringField(cqRing_, p.cq_off.head);
+    cqTail_  = ringField(cqRing_, p.cq_off.tail);
+    cqMask_  = ringField(cqRing_, p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(cqRing_) + p.cq_off.cqes);
+    return true;
+}
+
+void StatxRing::close() {
+    if (sqes_) {
+        munmap(sqes_, sqesSize_);
+        sqes_ = nullptr;
+    }
+    if (cqRing_ && cqRing_ != sqRing_) {
+        munmap(cqRing_, cqRingSize_);
+    }
+    cqRing_ = nullptr;
+    if (sqRing_) {
+        munmap(sqRing_, sqRingSize_);
+        sqRing_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool StatxRing::statAll(int dirFd, const char* const* names, size_t count,
+                        struct statx* out, int* results) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    size_t done = 0;
+    while (done < count) {
+        unsigned int batch = static_cast<unsigned int>(
+            std::min<size_t>(count - done, sqEntries_));
+
+        // Fill the submission queue.
+        unsigned int tail = *sqTail_;
+        unsigned int mask = *sqMask_;
+        for (unsigned int i = 0; i < batch; ++i) {
+            unsigned int idx = (tail + i) & mask;
+            io_uring_sqe* sqe = &sqes_[idx];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dirFd;
+            sqe->addr = reinterpret_cast<uint64_t>(names[done + i]);
+            sqe->len = STATX_BASIC_STATS;
+            sqe->off = reinterpret_cast<uint64_t>(&out[done + i]);
+            sqe->statx_flags = AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT;
+            sqe->user_data = done + i;
+            sqArray_[idx] = idx;
+        }
+        __atomic_store_n(sqTail_, tail + batch, __ATOMIC_RELEASE);
+
+        // Submit and wait for the whole batch, normally in one syscall. If
+        // the wait is interrupted, resubmit whatever the kernel hasn't
+        // consumed and keep waiting for the rest.
+        unsigned int reaped = 0;
+        while (reaped < batch) {
+            unsigned int head = *cqHead_;
+            unsigned int cqTail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            if (head == cqTail) {
+                unsigned int unsubmitted = tail + batch - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+                if (ioUringEnter(fd_, unsubmitted, batch - reaped, IORING_ENTER_GETEVENTS) < 0 &&
+                    errno != EINTR) {
+                    close();
+                    return false;
+                }
+                continue;
+            }
+            for (; head != cqTail; ++head) {
+                const io_uring_cqe& cqe = cqes_[head & *cqMask_];
+                if (cqe.res == -EINVAL) {
+                    // Kernel predates IORING_OP_STATX (< 5.6).
+                    __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+                    close();
+                    return false;
+                }
+                results[cqe.user_data] = cqe.res;
+                ++reaped;
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        }
+
+        done += batch;
+    }
+    return true;
+}
+
+} // namespace fsvng
+
+#endif // FSVNG_HAVE_IO_URING
@@ -0,0 +1,68 @@
+#pragma once
+
+#ifdef FSVNG_HAVE_IO_URING
+
+#include <sys/stat.h>
+
+#include <cstddef>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace fsvng {
+
+// ============================================================================
+// StatxRing - minimal io_uring wrapper that batches IORING_OP_STATX
+//
+// Talks to the kernel through the raw io_uring_setup/io_uring_enter
+// syscalls, so there is no liburing dependency. One ring per scan thread.
+// ============================================================================
+
+class StatxRing {
+public:
+    StatxRing() = default;
+    ~StatxRing();
+
+    StatxRing(const StatxRing&) = delete;
+    StatxRing& operator=(const StatxRing&) = delete;
+
+    // Create the ring. Returns false if io_uring is unavailable (old kernel,
+    // seccomp policy, io_uring_disabled sysctl, ...).
+    bool init(unsigned int entries);
+
+    bool usable() const { return fd_ >= 0; }
+
+    // Stat count names relative to dirFd (without following symlinks),
+    // submitting as many requests per io_uring_enter as the ring holds.
+    // results[i] receives 0 or -errno for names[i]. Returns false if the
+    // ring failed as a whole (e.g. the kernel lacks IORING_OP_STATX); the
+    // ring is then closed and the caller should stat synchronously.
+    bool statAll(int dirFd, const char* const* names, size_t count,
+                 struct statx* out, int* results);
+
+private:
+    void close();
+
+    int fd_ = -1;
+    unsigned int sqEntries_ = 0;
+
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqesSize_ = 0;
+
+    unsigned int* sqHead_ = nullptr;
+    unsigned int* sqTail_ = nullptr;
+    unsigned int* sqMask_ = nullptr;
+    unsigned int* sqArray_ = nullptr;
+    unsigned int* cqHead_ = nullptr;
+    unsigned int* cqTail_ = nullptr;
+    unsigned int* cqMask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+} // namespace fsvng
+
+#endif // FSVNG_HAVE_IO_URING
@@ -59,6 +59,10 @@ enum NodeType {
     NUM_NODE_TYPES
 };
 
+// ID of a node not numbered yet (see FsTree::setupTree()); never indexes
+// an ID-keyed column
+inline constexpr unsigned int INVALID_NODE_ID = 0xFFFFFFFFu;
+
 enum FsvMode {
     FSV_DISCV = 0,
     FSV_MAPV,
@@ -71,6 +75,8 @@ enum ColorMode {
     COLOR_BY_NODETYPE = 0,
     COLOR_BY_TIMESTAMP,
     COLOR_BY_WPATTERN,
+    COLOR_BY_DUPLICATE,
+    COLOR_BY_GROWTH,
     COLOR_NONE
 };
 
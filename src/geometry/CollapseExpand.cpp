@@ -3,6 +3,7 @@
 #include "core/FsNode.h"
 #include "core/FsTree.h"
 #include "ui/DirTreePanel.h"
+#include "ui/MainWindow.h"
 #include "animation/Morph.h"
 #include "animation/Animation.h"
 
@@ -91,6 +92,12 @@ void CollapseExpand::execute(FsNode* dnode, ColExpAction action) {
     MorphEngine& morphEngine = MorphEngine::instance();
 
     if (depth == 0) {
+        // A placeholder left by a lazy scan is loaded ahead of everything else
+        if (action != ColExpAction::CollapseRecursive &&
+            (dnode->flags & NODE_FLAG_UNSCANNED)) {
+            MainWindow::instance().loadSubtree(dnode);
+        }
+
         // Top-level call: update dir tree and determine max recursion depth
         switch (action) {
             case ColExpAction::CollapseRecursive:
@@ -7,7 +7,6 @@
 #include "renderer/ShaderProgram.h"
 #include "animation/Morph.h"
 #include "animation/Animation.h"
-#include "ui/ThemeManager.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
@@ -43,7 +42,7 @@ void DiscVLayout::initRecursive(FsNode* dnode, double stemTheta) {
     if (dnode->children.empty())
         return;
 
-    double dirRadius = dnode->discvGeom.radius;
+    double dirRadius = dnode->discvGeom().radius;
 
     // Assign radii and arc widths to child nodes
     double totalArcWidth = 0.0;
@@ -59,9 +58,9 @@ void DiscVLayout::initRecursive(FsNode* dnode, double stemTheta) {
         double dist = dirRadius + radius * (1.0 + LEAF_STEM_PROPORTION);
         double arcWidth = 2.0 * deg(std::asin(radius / dist));
 
-        node->discvGeom.radius = radius;
-        node->discvGeom.theta = arcWidth;  // temporary value
-        node->discvGeom.pos.x = dist;       // temporary value
+        node->discvGeom().radius = radius;
+        node->discvGeom().theta = arcWidth;  // temporary value
+        node->discvGeom().pos.x = dist;       // temporary value
         totalArcWidth += arcWidth;
     }
 
@@ -99,34 +98,34 @@ void DiscVLayout::initRecursive(FsNode* dnode, double stemTheta) {
 
     for (size_t idx = 0; idx < sortedNodes.size(); ++idx) {
         FsNode* node = sortedNodes[idx].node;
-        double arcWidth = k * node->discvGeom.theta;
-        double dist = node->discvGeom.pos.x;
+        double arcWidth = k * node->discvGeom().theta;
+        double dist = node->discvGeom().pos.x;
 
         if (stagger && out) {
             // Push leaf out
-            dist += 2.0 * node->discvGeom.radius;
+            dist += 2.0 * node->discvGeom().radius;
         }
 
         if (idx == 0) {
             // First (largest) node
-            node->discvGeom.theta = theta0;
+            node->discvGeom().theta = theta0;
             theta0 += 0.5 * arcWidth;
             theta1 -= 0.5 * arcWidth;
             out = !out;
         } else if (even) {
-            node->discvGeom.theta = theta0 + 0.5 * arcWidth;
+            node->discvGeom().theta = theta0 + 0.5 * arcWidth;
             theta0 += arcWidth;
             out = !out;
         } else {
-            node->discvGeom.theta = theta1 - 0.5 * arcWidth;
+            node->discvGeom().theta = theta1 - 0.5 * arcWidth;
             theta1 -= arcWidth;
         }
 
-        node->discvGeom.pos.x = dist * std::cos(rad(node->discvGeom.theta));
-        node->discvGeom.pos.y = dist * std::sin(rad(node->discvGeom.theta));
+        node->discvGeom().pos.x = dist * std::cos(rad(node->discvGeom().theta));
+        node->discvGeom().pos.y = dist * std::sin(rad(node->discvGeom().theta));
 
         if (node->isDir()) {
-            initRecursive(node, node->discvGeom.theta + 180.0);
+            initRecursive(node, node->discvGeom().theta + 180.0);
         }
 
         even = !even;
@@ -145,13 +144,13 @@ void DiscVLayout::init() {
     FsNode* rootDir = tree.rootDir();
     if (!rootDir) return;
 
-    metanode->discvGeom.radius = 0.0;
-    metanode->discvGeom.theta = 0.0;
+    metanode->discvGeom().radius = 0.0;
+    metanode->discvGeom().theta = 0.0;
 
     initRecursive(metanode, 270.0);
 
-    metanode->discvGeom.pos.x = 0.0;
-    metanode->discvGeom.pos.y = -rootDir->discvGeom.radius;
+    metanode->discvGeom().pos.x = 0.0;
+    metanode->discvGeom().pos.y = -rootDir->discvGeom().radius;
 }
 
 // ============================================================================
@@ -164,8 +163,8 @@ void DiscVLayout::buildNodeDisc(FsNode* node, double dirDeployment,
     int segCount = static_cast<int>(360.0 / CURVE_GRANULARITY + 0.999);
 
     XYvec center;
-    center.x = dirDeployment * node->discvGeom.pos.x;
-    center.y = dirDeployment * node->discvGeom.pos.y;
+    center.x = dirDeployment * node->discvGeom().pos.x;
+    center.y = dirDeployment * node->discvGeom().pos.y;
 
     glm::vec3 col(0.7f, 0.7f, 0.7f);
     if (node->color) {
@@ -184,8 +183,8 @@ void DiscVLayout::buildNodeDisc(FsNode* node, double dirDeployment,
     // Edge vertices
     for (int s = 0; s <= segCount; ++s) {
         double theta = static_cast<double>(s) / static_cast<double>(segCount) * 360.0;
-        double px = center.x + node->discvGeom.radius * std::cos(rad(theta));
-        double py = center.y + node->discvGeom.radius * std::sin(rad(theta));
+        double px = center.x + node->discvGeom().radius * std::cos(rad(theta));
+        double py = center.y + node->discvGeom().radius * std::sin(rad(theta));
 
         vertices.push_back({glm::vec3(static_cast<float>(px),
                                        static_cast<float>(py), 0.0f),
@@ -220,12 +219,12 @@ void DiscVLayout::buildFolderOutline(FsNode* dnode,
     glm::vec3 nUp(0.0f, 0.0f, 1.0f);
 
     // Draw a ring outline as a series of thin quads
-    double innerRadius = dnode->discvGeom.radius * 0.92;
-    double outerRadius = dnode->discvGeom.radius;
+    double innerRadius = dnode->discvGeom().radius * 0.92;
+    double outerRadius = dnode->discvGeom().radius;
 
     // Center position
-    double cx = dnode->discvGeom.pos.x;
-    double cy = dnode->discvGeom.pos.y;
+    double cx = dnode->discvGeom().pos.x;
+    double cy = dnode->discvGeom().pos.y;
 
     for (int s = 0; s < segCount; ++s) {
         double theta0 = static_cast<double>(s) / static_cast<double>(segCount) * 360.0;
@@ -301,8 +300,7 @@ void DiscVLayout::buildDir(FsNode* dnode,
 // drawRecursive - port of discv_draw_recursive
 // ============================================================================
 
-void DiscVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
-                                const glm::mat4& proj, bool geometry) {
+void DiscVLayout::drawRecursive(FsNode* dnode, bool geometry) {
     GeometryManager& gm = GeometryManager::instance();
     MatrixStack& ms = gm.modelStack();
 
@@ -311,8 +309,8 @@ void DiscVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
     bool dirCollapsed = dnode->isCollapsed();
     bool dirExpanded = dnode->isExpanded();
 
-    ms.translate(static_cast<float>(dnode->discvGeom.pos.x),
-                 static_cast<float>(dnode->discvGeom.pos.y),
+    ms.translate(static_cast<float>(dnode->discvGeom().pos.x),
+                 static_cast<float>(dnode->discvGeom().pos.y),
                  0.0f);
     float dep = static_cast<float>(dnode->deployment);
     ms.scale(dep, dep, 1.0f);
@@ -331,13 +329,10 @@ void DiscVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
             }
 
             if (!verts.empty()) {
-                float nodeGlow = ThemeManager::instance().currentTheme().baseEmissive + dnode->glowIntensity;
-                ShaderProgram& shader = Renderer::instance().getNodeShader();
-                shader.use();
-                shader.setMat4("uModel", ms.top());
-                shader.setMat4("uView", view);
-                shader.setMat4("uProjection", proj);
-                shader.setFloat("uGlowIntensity", nodeGlow);
+                Renderer& renderer = Renderer::instance();
+                renderer.getNodeShader().use();
+                renderer.setNodeDrawUniforms(ms.top(), normalMatrixOf(ms.top()),
+                                             dnode->glowIntensity);
 
                 MeshBuffer mesh;
                 mesh.upload(verts, inds);
@@ -357,7 +352,7 @@ void DiscVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
             FsNode* node = childPtr.get();
             if (!node->isDir())
                 break;
-            drawRecursive(node, view, proj, geometry);
+            drawRecursive(node, geometry);
         }
     }
 
@@ -368,7 +363,7 @@ void DiscVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
 // draw - port of discv_draw
 // ============================================================================
 
-void DiscVLayout::draw(const glm::mat4& view, const glm::mat4& projection, bool highDetail) {
+void DiscVLayout::draw(bool highDetail) {
     FsTree& tree = FsTree::instance();
     FsNode* root = tree.root();
     if (!root) return;
@@ -377,7 +372,7 @@ void DiscVLayout::draw(const glm::mat4& view, const glm::mat4& projection, bool
     gm.modelStack().loadIdentity();
 
     // Draw geometry
-    drawRecursive(root, view, projection, true);
+    drawRecursive(root, true);
 
     if (highDetail) {
         // High detail: labels, cursor
@@ -385,7 +380,7 @@ void DiscVLayout::draw(const glm::mat4& view, const glm::mat4& projection, bool
     }
 }
 
-void DiscVLayout::drawForPicking(const glm::mat4& view, const glm::mat4& projection) {
+void DiscVLayout::drawForPicking() {
     FsTree& tree = FsTree::instance();
     FsNode* root = tree.root();
     if (!root) return;
@@ -393,7 +388,7 @@ void DiscVLayout::drawForPicking(const glm::mat4& view, const glm::mat4& project
     GeometryManager& gm = GeometryManager::instance();
     gm.modelStack().loadIdentity();
 
-    drawRecursive(root, view, projection, true);
+    drawRecursive(root, true);
 }
 
 } // namespace fsvng
@@ -15,8 +15,8 @@ public:
     static DiscVLayout& instance();
 
     void init();
-    void draw(const glm::mat4& view, const glm::mat4& projection, bool highDetail);
-    void drawForPicking(const glm::mat4& view, const glm::mat4& projection);
+    void draw(bool highDetail);
+    void drawForPicking();
 
     static constexpr double CURVE_GRANULARITY = 15.0;
     static constexpr double LEAF_RANGE_ARC_WIDTH = 315.0;
@@ -26,8 +26,7 @@ private:
     DiscVLayout() = default;
 
     void initRecursive(FsNode* dnode, double stemTheta);
-    void drawRecursive(FsNode* dnode, const glm::mat4& view, const glm::mat4& proj,
-                       bool geometry);
+    void drawRecursive(FsNode* dnode, bool geometry);
     void buildNodeDisc(FsNode* node, double dirDeployment,
                        std::vector<Vertex>& vertices,
                        std::vector<uint32_t>& indices);
@@ -6,6 +6,7 @@
 #include "ui/DirTreePanel.h"
 #include "renderer/Renderer.h"
 #include "renderer/MeshBuffer.h"
+#include "renderer/PackedVertex.h"
 #include "renderer/ShaderProgram.h"
 #include "animation/Morph.h"
 #include "animation/Animation.h"
@@ -45,9 +46,15 @@ GeometryManager& GeometryManager::instance() {
 void GeometryManager::init(FsvMode mode) {
     mode_ = mode;
 
-    // Reset draw stages
+    // Only the active mode's geometry is kept in memory
+    GeometryStore::instance().retainOnly(mode);
+
+    // Reset draw stages; every mesh is built afresh for the new layout
     lowDrawStage_ = 0;
     highDrawStage_ = 0;
+    meshCache_.clear();
+    recordedDraws_.clear();
+    invalidateBounds();
 
     FsTree& tree = FsTree::instance();
     FsNode* root = tree.root();
@@ -69,26 +76,68 @@ void GeometryManager::init(FsvMode mode) {
     }
 }
 
-void GeometryManager::draw(const glm::mat4& view, const glm::mat4& projection, bool highDetail) {
+void GeometryManager::draw(bool highDetail) {
+    int stage = highDetail ? highDrawStage_ : lowDrawStage_;
+    const FrameUniforms& frame = Renderer::instance().frameUniforms();
+    frustum_ = Frustum(frame.projection * frame.view);
+
+    // MapV draws instanced, gathering its instances (and their bounds)
+    // again only at stage 0, before it culls them against those bounds
+    if (mode_ == FSV_MAPV) {
+        bool wasValid = boundsValid_;
+        boundsValid_ = true;
+        if (MapVLayout::instance().drawInstanced(stage == 0)) {
+            if (highDetail)
+                advanceHighDrawStage();
+            else
+                advanceLowDrawStage();
+            return;
+        }
+        boundsValid_ = wasValid;
+    }
+
+    if (stage == 2) {
+        replayRecordedDraws();
+        return;
+    }
+
+    // Stage 1 walks the same meshes as the last one, so record them
+    Renderer::instance().getNodeShader().use();
+    ++drawPass_;
+    recording_ = (stage == 1);
+    if (recording_)
+        recordedDraws_.clear();
+
     switch (mode_) {
         case FSV_MAPV:
-            MapVLayout::instance().draw(view, projection, highDetail);
+            MapVLayout::instance().draw(highDetail);
             break;
         case FSV_TREEV:
-            TreeVLayout::instance().draw(view, projection, highDetail);
+            TreeVLayout::instance().draw(highDetail);
             break;
         default:
             break;
     }
+
+    if (recording_) {
+        pruneMeshCache();
+        recording_ = false;
+        boundsValid_ = true;
+    }
+    if (highDetail)
+        advanceHighDrawStage();
+    else
+        advanceLowDrawStage();
 }
 
-void GeometryManager::drawForPicking(const glm::mat4& view, const glm::mat4& projection) {
+void GeometryManager::drawForPicking() {
+    Renderer::instance().getNodeShader().use();
     switch (mode_) {
         case FSV_MAPV:
-            MapVLayout::instance().drawForPicking(view, projection);
+            MapVLayout::instance().drawForPicking();
             break;
         case FSV_TREEV:
-            TreeVLayout::instance().drawForPicking(view, projection);
+            TreeVLayout::instance().drawForPicking();
             break;
         default:
             break;
@@ -106,6 +155,22 @@ void GeometryManager::queueRebuild(FsNode* dnode) {
 void GeometryManager::queueUncachedDraw() {
     lowDrawStage_ = 0;
     highDrawStage_ = 0;
+    invalidateBounds();
+}
+
+void GeometryManager::relayoutDir(FsNode* dnode) {
+    if (!dnode || !dnode->isDir()) return;
+
+    switch (mode_) {
+        case FSV_MAPV:
+            MapVLayout::instance().relayoutDir(dnode);
+            break;
+        case FSV_TREEV:
+            TreeVLayout::instance().relayoutDir(dnode);
+            break;
+        default:
+            break;
+    }
 }
 
 void GeometryManager::cameraPanFinished() {
@@ -154,6 +219,152 @@ void GeometryManager::freeAll() {
     highlightNode_ = nullptr;
     lowDrawStage_ = 0;
     highDrawStage_ = 0;
+    meshCache_.clear();
+    recordedDraws_.clear();
+    invalidateBounds();
+    MapVLayout::instance().freeInstanced();
+}
+
+// ============================================================================
+// Mesh cache
+// ============================================================================
+
+static bool& staleFlag(FsNode* dnode, GeometryManager::MeshSlot slot) {
+    switch (slot) {
+        case GeometryManager::MESH_B:
+            return dnode->bDlistStale;
+        case GeometryManager::MESH_C:
+            return dnode->cDlistStale;
+        default:
+            return dnode->aDlistStale;
+    }
+}
+
+const MeshBuffer* GeometryManager::cachedMesh(FsNode* dnode, MeshSlot slot, double r0) {
+    if (staleFlag(dnode, slot))
+        return nullptr;
+    auto it = meshCache_.find(dnode->id);
+    if (it == meshCache_.end())
+        return nullptr;
+    DirMeshes& entry = it->second;
+    if (!entry.built[slot] || entry.r0[slot] != r0)
+        return nullptr;
+    entry.lastPass = drawPass_;
+    return &entry.mesh[slot];
+}
+
+const MeshBuffer* GeometryManager::storeMesh(FsNode* dnode, MeshSlot slot,
+                                             const std::vector<PackedVertex>& vertices,
+                                             const std::vector<uint32_t>& indices,
+                                             double r0) {
+    DirMeshes& entry = meshCache_[dnode->id];
+    entry.bounds[slot] = Aabb();
+    if (vertices.empty()) {
+        entry.mesh[slot].destroy();
+    } else {
+        entry.mesh[slot].upload(vertices, indices);
+        for (const PackedVertex& v : vertices)
+            entry.bounds[slot].add(v.position);
+    }
+    entry.r0[slot] = r0;
+    entry.built[slot] = true;
+    entry.lastPass = drawPass_;
+    staleFlag(dnode, slot) = false;
+    return &entry.mesh[slot];
+}
+
+void GeometryManager::drawMesh(const MeshBuffer* mesh, const FsNode* dnode) {
+    if (!mesh->isValid())
+        return;
+
+    const glm::mat4& model = modelStack_.top();
+    glm::mat3 normalMatrix = normalMatrixOf(model);
+    Renderer::instance().setNodeDrawUniforms(model, normalMatrix, dnode->glowIntensity);
+    mesh->draw(GL_TRIANGLES);
+
+    if (!recording_)
+        return;
+
+    // Meshes come from the cache, which holds their local bounds
+    Aabb bounds;
+    auto it = meshCache_.find(dnode->id);
+    if (it != meshCache_.end()) {
+        const MeshBuffer* first = it->second.mesh;
+        if (mesh >= first && mesh < first + NUM_MESH_SLOTS)
+            bounds = it->second.bounds[mesh - first].transformed(model);
+    }
+    recordedDraws_.push_back({mesh, model, normalMatrix, dnode, bounds, 0});
+    if (!openSubtrees_.empty())
+        recordedDraws_[openSubtrees_.back()].bounds.add(bounds);
+}
+
+void GeometryManager::beginSubtree(const FsNode* dnode) {
+    if (!recording_)
+        return;
+    openSubtrees_.push_back(recordedDraws_.size());
+    recordedDraws_.push_back({nullptr, glm::mat4(1.0f), glm::mat3(1.0f), dnode, Aabb(), 0});
+}
+
+void GeometryManager::endSubtree(const FsNode* dnode) {
+    if (!recording_ || openSubtrees_.empty())
+        return;
+    RecordedDraw& marker = recordedDraws_[openSubtrees_.back()];
+    openSubtrees_.pop_back();
+    marker.skipTo = recordedDraws_.size();
+    subtreeBounds_[dnode->id] = marker.bounds;
+    if (!openSubtrees_.empty())
+        recordedDraws_[openSubtrees_.back()].bounds.add(marker.bounds);
+}
+
+void GeometryManager::setSubtreeBounds(const FsNode* dnode, const Aabb& bounds) {
+    subtreeBounds_[dnode->id] = bounds;
+}
+
+bool GeometryManager::subtreeInView(const FsNode* dnode) const {
+    if (!boundsValid_)
+        return true;
+    auto it = subtreeBounds_.find(dnode->id);
+    return it == subtreeBounds_.end() || frustum_.intersects(it->second);
+}
+
+void GeometryManager::invalidateBounds() {
+    boundsValid_ = false;
+    openSubtrees_.clear();
+    subtreeBounds_.clear();
+}
+
+// Stage 2: the frame is what stage 1 drew, so skip the walk. Subtrees whose
+// bounds miss the view frustum are skipped whole. Glow is read live, since
+// PulseEffect changes it without queueing a redraw.
+void GeometryManager::replayRecordedDraws() {
+    if (recordedDraws_.empty())
+        return;
+
+    Renderer& renderer = Renderer::instance();
+    renderer.getNodeShader().use();
+    for (size_t i = 0; i < recordedDraws_.size();) {
+        const RecordedDraw& rec = recordedDraws_[i];
+        if (!frustum_.intersects(rec.bounds)) {
+            i = rec.mesh ? i + 1 : rec.skipTo;
+            continue;
+        }
+        if (rec.mesh) {
+            renderer.setNodeDrawUniforms(rec.model, rec.normalMatrix, rec.dnode->glowIntensity);
+            rec.mesh->draw(GL_TRIANGLES);
+        }
+        ++i;
+    }
+}
+
+// Drop the meshes of directories the last full walk did not reach (removed,
+// or under a collapsed directory); they are built again if needed.
+void GeometryManager::pruneMeshCache() {
+    for (auto it = meshCache_.begin(); it != meshCache_.end();) {
+        if (it->second.lastPass != drawPass_)
+            it = meshCache_.erase(it);
+        else
+            ++it;
+    }
 }
 
 bool GeometryManager::shouldHighlight(FsNode* node) const {
@@ -180,7 +391,7 @@ double GeometryManager::mapvNodeZ0(FsNode* node) const {
     double z = 0.0;
     FsNode* upNode = node->parent;
     while (upNode != nullptr) {
-        z += upNode->mapvGeom.height;
+        z += upNode->mapvGeom().height;
         upNode = upNode->parent;
     }
     return z;
@@ -193,7 +404,7 @@ double GeometryManager::mapvMaxExpandedHeight(FsNode* dnode) const {
         double maxHeight = 0.0;
         for (auto& childPtr : dnode->children) {
             FsNode* node = childPtr.get();
-            double height = node->mapvGeom.height;
+            double height = node->mapvGeom().height;
             if (node->isDir()) {
                 height += mapvMaxExpandedHeight(node);
                 maxHeight = std::max(maxHeight, height);
@@ -228,7 +439,7 @@ double GeometryManager::treevPlatformR0(FsNode* dnode) const {
     FsNode* upNode = dnode->parent;
     while (upNode != nullptr) {
         r0 += TreeVLayout::PLATFORM_SPACING_DEPTH;
-        r0 += upNode->treevGeom.platform.depth;
+        r0 += upNode->treevGeom().platform.depth;
         upNode = upNode->parent;
     }
     r0 += treevCoreRadius_;
@@ -242,7 +453,7 @@ double GeometryManager::treevPlatformTheta(FsNode* dnode) const {
     double theta = 0.0;
     FsNode* upNode = dnode;
     while (upNode != nullptr) {
-        theta += upNode->treevGeom.platform.theta;
+        theta += upNode->treevGeom().platform.theta;
         upNode = upNode->parent;
     }
     return theta;
@@ -255,7 +466,7 @@ double GeometryManager::treevMaxLeafHeight(FsNode* dnode) const {
     for (auto& childPtr : dnode->children) {
         FsNode* node = childPtr.get();
         if (treevIsLeaf(node)) {
-            maxHeight = std::max(maxHeight, node->treevGeom.leaf.height);
+            maxHeight = std::max(maxHeight, node->treevGeom().leaf.height);
         }
     }
     return maxHeight;
@@ -265,7 +476,7 @@ void GeometryManager::treevGetExtentsRecursive(FsNode* dnode, RTvec* c0, RTvec*
                                                 double r0, double theta) const {
     assert(dnode->isDir());
 
-    double subtreeR0 = r0 + dnode->treevGeom.platform.depth + TreeVLayout::PLATFORM_SPACING_DEPTH;
+    double subtreeR0 = r0 + dnode->treevGeom().platform.depth + TreeVLayout::PLATFORM_SPACING_DEPTH;
 
     for (auto& childPtr : dnode->children) {
         FsNode* node = childPtr.get();
@@ -273,14 +484,14 @@ void GeometryManager::treevGetExtentsRecursive(FsNode* dnode, RTvec* c0, RTvec*
             break;
         if (!treevIsLeaf(node)) {
             treevGetExtentsRecursive(node, c0, c1, subtreeR0,
-                theta + node->treevGeom.platform.theta);
+                theta + node->treevGeom().platform.theta);
         }
     }
 
     c0->r = std::min(c0->r, r0);
-    c0->theta = std::min(c0->theta, theta - dnode->treevGeom.platform.arc_width);
-    c1->r = std::max(c1->r, r0 + dnode->treevGeom.platform.depth);
-    c1->theta = std::max(c1->theta, theta + dnode->treevGeom.platform.arc_width);
+    c0->theta = std::min(c0->theta, theta - dnode->treevGeom().platform.arc_width);
+    c1->r = std::max(c1->r, r0 + dnode->treevGeom().platform.depth);
+    c1->theta = std::max(c1->theta, theta + dnode->treevGeom().platform.arc_width);
 }
 
 void GeometryManager::treevGetExtents(FsNode* dnode, RTvec* extC0, RTvec* extC1) const {
@@ -1,13 +1,15 @@
 #pragma once
 
 #include "core/Types.h"
+#include "camera/Frustum.h"
+#include "renderer/MeshBuffer.h"
+#include <unordered_map>
 #include <vector>
 #include <glm/glm.hpp>
 
 namespace fsvng {
 
 class FsNode;
-class MeshBuffer;
 
 // Explicit matrix stack replacing glPushMatrix/glPopMatrix
 class MatrixStack {
@@ -30,12 +32,17 @@ public:
     static GeometryManager& instance();
 
     void init(FsvMode mode);
-    void draw(const glm::mat4& view, const glm::mat4& projection, bool highDetail);
-    void drawForPicking(const glm::mat4& view, const glm::mat4& projection);
+    // Camera and lighting come from the frame uniforms
+    // (Renderer::setFrameUniforms), set once per frame by the caller
+    void draw(bool highDetail);
+    void drawForPicking();
 
     // Queue a directory for geometry rebuild
     void queueRebuild(FsNode* dnode);
 
+    // Lay out a directory's children again after the tree changed under it
+    void relayoutDir(FsNode* dnode);
+
     // Hook for camera pan completion
     void cameraPanFinished();
 
@@ -68,6 +75,41 @@ public:
     // Signal that geometry needs uncached redraw
     void queueUncachedDraw();
 
+    // Per-directory mesh cache. Slots follow the node's stale flags: A is
+    // the directory's own geometry, B its TreeV branches, C the leaf a
+    // partially deployed TreeV directory shrinks into.
+    enum MeshSlot { MESH_A, MESH_B, MESH_C, NUM_MESH_SLOTS };
+
+    // dnode's uploaded mesh for slot, or nullptr if it must be built again
+    // (stale flag set, never built, or built at another r0)
+    const MeshBuffer* cachedMesh(FsNode* dnode, MeshSlot slot, double r0 = 0.0);
+
+    // Upload freshly built geometry as dnode's mesh for slot and clear the
+    // slot's stale flag
+    const MeshBuffer* storeMesh(FsNode* dnode, MeshSlot slot,
+                                const std::vector<PackedVertex>& vertices,
+                                const std::vector<uint32_t>& indices, double r0 = 0.0);
+
+    // Draw a cached mesh with the model stack's top; recorded at stage 1
+    void drawMesh(const MeshBuffer* mesh, const FsNode* dnode);
+
+    // Bracket the draws of dnode's subtree during the walk, so a stage 1
+    // recording learns the subtree's world bounds and stage 2 can skip it
+    // whole when they are outside the view frustum
+    void beginSubtree(const FsNode* dnode);
+    void endSubtree(const FsNode* dnode);
+
+    // World bounds of dnode's subtree, for layouts that do not walk with
+    // beginSubtree()/endSubtree()
+    void setSubtreeBounds(const FsNode* dnode, const Aabb& bounds);
+
+    // False only if dnode's subtree is known to be outside this frame's
+    // view frustum
+    bool subtreeInView(const FsNode* dnode) const;
+
+    // False only if world-space bounds are outside this frame's view frustum
+    bool inView(const Aabb& bounds) const { return frustum_.intersects(bounds); }
+
     // Draw stage management
     int lowDrawStage() const { return lowDrawStage_; }
     int highDrawStage() const { return highDrawStage_; }
@@ -80,6 +122,10 @@ private:
     void treevGetExtentsRecursive(FsNode* dnode, RTvec* c0, RTvec* c1,
                                   double r0, double theta) const;
 
+    void replayRecordedDraws();
+    void invalidateBounds();
+    void pruneMeshCache();
+
     FsvMode mode_ = FSV_NONE;
     MatrixStack modelStack_;
     FsNode* highlightNode_ = nullptr;
@@ -94,6 +140,37 @@ private:
     int lowDrawStage_ = 0;
     int highDrawStage_ = 0;
 
+    struct DirMeshes {
+        MeshBuffer mesh[NUM_MESH_SLOTS];
+        double r0[NUM_MESH_SLOTS] = {};
+        bool built[NUM_MESH_SLOTS] = {};
+        Aabb bounds[NUM_MESH_SLOTS];  // in the mesh's own frame
+        unsigned int lastPass = 0;  // last walk that drew it
+    };
+    std::unordered_map<unsigned int, DirMeshes> meshCache_;  // by directory ID
+
+    // What a stage 1 walk drew, for stage 2 to replay. A subtree is
+    // recorded as a marker (no mesh) holding its bounds, then its draws;
+    // the marker's skipTo is the index just past them.
+    struct RecordedDraw {
+        const MeshBuffer* mesh;
+        glm::mat4 model;
+        glm::mat3 normalMatrix;
+        const FsNode* dnode;  // for its glow
+        Aabb bounds;          // world space
+        size_t skipTo;
+    };
+    std::vector<RecordedDraw> recordedDraws_;
+    std::vector<size_t> openSubtrees_;  // markers of the subtrees being walked
+    unsigned int drawPass_ = 0;
+    bool recording_ = false;
+
+    // Subtree bounds by directory ID, valid from the recording (or
+    // instanced regather) until the next rebuild
+    std::unordered_map<unsigned int, Aabb> subtreeBounds_;
+    bool boundsValid_ = false;
+    Frustum frustum_;  // of the frame being drawn
+
     friend class TreeVLayout;
 };
 
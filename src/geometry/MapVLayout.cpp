@@ -1,18 +1,21 @@
 #include "geometry/MapVLayout.h"
 #include "geometry/GeometryManager.h"
+#include "core/FsDiff.h"
 #include "core/FsNode.h"
 #include "core/FsTree.h"
 #include "ui/DirTreePanel.h"
 #include "renderer/Renderer.h"
+#include "renderer/PackedVertex.h"
 #include "renderer/ShaderProgram.h"
 #include "animation/Morph.h"
 #include "animation/Animation.h"
-#include "ui/ThemeManager.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
 #include <cmath>
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <vector>
 #include <memory>
 
@@ -36,22 +39,21 @@ MapVLayout& MapVLayout::instance() {
     return inst;
 }
 
+int64_t MapVLayout::layoutSize(const FsNode* node, int64_t minSize) const {
+    if (deltaSizes_)
+        return std::max(minSize, deltaSizes_->deltaOf(node));
+    int64_t size = std::max(minSize, sizeByAllocation_ ? node->sizeAlloc : node->size);
+    if (node->isDir())
+        size += sizeByAllocation_ ? node->subtree.sizeAlloc : node->subtree.size;
+    return size;
+}
+
 // ============================================================================
 // Layout algorithm: THE TREEMAP
 // Ported from mapv_init_recursive in geometry.c
 // ============================================================================
 
 void MapVLayout::initRecursive(FsNode* dnode) {
-    // Internal block/row structures for treemap algorithm
-    struct MapVBlock {
-        FsNode* node;
-        double area;
-    };
-    struct MapVRow {
-        size_t firstBlockIndex;
-        double area;
-    };
-
     assert(dnode->isDir());
 
     MorphEngine::instance().morphBreak(&dnode->deployment);
@@ -70,8 +72,8 @@ void MapVLayout::initRecursive(FsNode* dnode) {
     dirDims.x = dnode->mapvWidth();
     dirDims.y = dnode->mapvDepth();
     double k = sideSlantRatios[NODE_DIRECTORY];
-    dirDims.x -= 2.0 * std::min(dnode->mapvGeom.height, k * dirDims.x);
-    dirDims.y -= 2.0 * std::min(dnode->mapvGeom.height, k * dirDims.y);
+    dirDims.x -= 2.0 * std::min(dnode->mapvGeom().height, k * dirDims.x);
+    dirDims.y -= 2.0 * std::min(dnode->mapvGeom().height, k * dirDims.y);
 
     // Approximate/nominal node border width
     double a = BORDER_PROPORTION * std::sqrt(dirDims.x * dirDims.y);
@@ -83,59 +85,58 @@ void MapVLayout::initRecursive(FsNode* dnode) {
     dirDims.y -= nominalBorder;
     double dirArea = dirDims.x * dirDims.y;
 
+    // This directory's blocks and rows go on top of the scratch stacks,
+    // above those of the directories being laid out further up; they are
+    // addressed by index since recursing may grow the stacks.
+    const size_t firstBlock = blocks_.size();
+    const size_t firstRow = rows_.size();
+
     // First pass: create blocks, find total area, create block list
-    std::vector<MapVBlock> blockList;
     double totalBlockArea = 0.0;
 
     for (auto& childPtr : dnode->children) {
         FsNode* node = childPtr.get();
-        int64_t size = std::max(int64_t(4096), node->size);
-        if (node->isDir())
-            size += node->subtree.size;
+        int64_t size = layoutSize(node, 4096);
         k = std::sqrt(static_cast<double>(size)) + nominalBorder;
         double area = k * k; // SQR(k)
         totalBlockArea += area;
 
-        MapVBlock block;
-        block.node = node;
-        block.area = area;
-        blockList.push_back(block);
+        blocks_.push_back({node, area});
     }
+    const size_t endBlock = blocks_.size();
 
     // Scale factor: blocks total area > directory area, scale down
     double scaleFactor = dirArea / totalBlockArea;
 
     // Second pass: scale blocks and generate first-draft rows
-    std::vector<MapVRow> rowList;
-    MapVRow* currentRow = nullptr;
+    bool rowOpen = false;
 
-    for (size_t i = 0; i < blockList.size(); ++i) {
-        MapVBlock& block = blockList[i];
+    for (size_t i = firstBlock; i < endBlock; ++i) {
+        MapVBlock& block = blocks_[i];
         block.area *= scaleFactor;
 
-        if (currentRow == nullptr) {
+        if (!rowOpen) {
             // Begin new row
-            MapVRow newRow;
-            newRow.firstBlockIndex = i;
-            newRow.area = 0.0;
-            rowList.push_back(newRow);
-            currentRow = &rowList.back();
+            rows_.push_back({i, 0.0});
+            rowOpen = true;
         }
 
         // Add block to row
-        currentRow->area += block.area;
+        MapVRow& currentRow = rows_.back();
+        currentRow.area += block.area;
 
         // Dimensions of block (blockDims.y == depth of row)
         XYvec blockDims;
-        blockDims.y = currentRow->area / dirDims.x;
+        blockDims.y = currentRow.area / dirDims.x;
         blockDims.x = block.area / blockDims.y;
 
         // Check aspect ratio of block
         if ((blockDims.x / blockDims.y) < 1.0) {
             // Next block will go into next row
-            currentRow = nullptr;
+            rowOpen = false;
         }
     }
+    const size_t endRow = rows_.size();
 
     // Third pass - optimize layout (placeholder as in original)
     // Note to self: write layout optimization routine sometime
@@ -149,48 +150,47 @@ void MapVLayout::initRecursive(FsNode* dnode) {
     XYvec pos;
     pos.y = startPos.y;
 
-    size_t blockIdx = 0;
-    for (size_t rowIdx = 0; rowIdx < rowList.size(); ++rowIdx) {
-        MapVRow& row = rowList[rowIdx];
+    size_t blockIdx = firstBlock;
+    for (size_t rowIdx = firstRow; rowIdx < endRow; ++rowIdx) {
         XYvec blockDims;
-        blockDims.y = row.area / dirDims.x;
+        blockDims.y = rows_[rowIdx].area / dirDims.x;
         pos.x = startPos.x;
 
         // Note first block of next row
-        size_t nextFirstBlockIndex = (rowIdx + 1 < rowList.size())
-            ? rowList[rowIdx + 1].firstBlockIndex
-            : blockList.size();
+        size_t nextFirstBlockIndex = (rowIdx + 1 < endRow)
+            ? rows_[rowIdx + 1].firstBlockIndex
+            : endBlock;
 
         // Output one row
-        while (blockIdx < blockList.size()) {
+        while (blockIdx < endBlock) {
             if (blockIdx == nextFirstBlockIndex)
                 break; // finished with row
 
-            MapVBlock& block = blockList[blockIdx];
-            blockDims.x = block.area / blockDims.y;
+            FsNode* node = blocks_[blockIdx].node;
+            double blockArea = blocks_[blockIdx].area;
+            blockDims.x = blockArea / blockDims.y;
 
-            int64_t size = std::max(int64_t(256), block.node->size);
-            if (block.node->isDir())
-                size += block.node->subtree.size;
+            int64_t size = layoutSize(node, 256);
             double area = scaleFactor * static_cast<double>(size);
 
             // Calculate exact width of block's border region
             k = blockDims.x + blockDims.y;
-            // area == scaled area of node, block.area == scaled area of node+border
-            double border = 0.25 * (k - std::sqrt(k * k - 4.0 * (block.area - area)));
+            // area == scaled area of node, blockArea == scaled area of node+border
+            double border = 0.25 * (k - std::sqrt(k * k - 4.0 * (blockArea - area)));
 
             // Assign geometry (pos is right/rear corner of block)
-            block.node->mapvGeom.c0.x = pos.x - blockDims.x + border;
-            block.node->mapvGeom.c0.y = pos.y - blockDims.y + border;
-            block.node->mapvGeom.c1.x = pos.x - border;
-            block.node->mapvGeom.c1.y = pos.y - border;
-
-            if (block.node->isDir()) {
-                block.node->mapvGeom.height = DIR_HEIGHT;
+            MapVGeomParams& geom = node->mapvGeom();
+            geom.c0.x = pos.x - blockDims.x + border;
+            geom.c0.y = pos.y - blockDims.y + border;
+            geom.c1.x = pos.x - border;
+            geom.c1.y = pos.y - border;
+
+            if (node->isDir()) {
+                geom.height = DIR_HEIGHT;
                 // Recurse into directory
-                initRecursive(block.node);
+                initRecursive(node);
             } else {
-                block.node->mapvGeom.height = LEAF_HEIGHT;
+                geom.height = LEAF_HEIGHT;
             }
 
             pos.x -= blockDims.x;
@@ -199,6 +199,9 @@ void MapVLayout::initRecursive(FsNode* dnode) {
 
         pos.y -= blockDims.y;
     }
+
+    blocks_.resize(firstBlock);
+    rows_.resize(firstRow);
 }
 
 // ============================================================================
@@ -215,28 +218,29 @@ void MapVLayout::init() {
 
     // Determine dimensions of bottommost (root) node
     XYvec rootDims;
-    rootDims.y = std::sqrt(static_cast<double>(metanode->subtree.size) / ROOT_ASPECT_RATIO);
+    int64_t totalSize = sizeByAllocation_ ? metanode->subtree.sizeAlloc : metanode->subtree.size;
+    rootDims.y = std::sqrt(static_cast<double>(totalSize) / ROOT_ASPECT_RATIO);
     rootDims.x = ROOT_ASPECT_RATIO * rootDims.y;
 
     // Set up base geometry for metanode
-    metanode->mapvGeom.height = 0.0;
+    metanode->mapvGeom().height = 0.0;
 
     // Set up root directory geometry
-    rootDir->mapvGeom.c0.x = -0.5 * rootDims.x;
-    rootDir->mapvGeom.c0.y = -0.5 * rootDims.y;
-    rootDir->mapvGeom.c1.x = 0.5 * rootDims.x;
-    rootDir->mapvGeom.c1.y = 0.5 * rootDims.y;
-    rootDir->mapvGeom.height = DIR_HEIGHT;
+    rootDir->mapvGeom().c0.x = -0.5 * rootDims.x;
+    rootDir->mapvGeom().c0.y = -0.5 * rootDims.y;
+    rootDir->mapvGeom().c1.x = 0.5 * rootDims.x;
+    rootDir->mapvGeom().c1.y = 0.5 * rootDims.y;
+    rootDir->mapvGeom().height = DIR_HEIGHT;
 
     initRecursive(rootDir);
 
     // Initial cursor state
     double k = 4.0; // default scale for initial cursor
-    cursorPrevC0_.x = k * rootDir->mapvGeom.c0.x;
-    cursorPrevC0_.y = k * rootDir->mapvGeom.c0.y;
+    cursorPrevC0_.x = k * rootDir->mapvGeom().c0.x;
+    cursorPrevC0_.y = k * rootDir->mapvGeom().c0.y;
     cursorPrevC0_.z = -0.25 * k * rootDir->mapvDepth();
-    cursorPrevC1_.x = k * rootDir->mapvGeom.c1.x;
-    cursorPrevC1_.y = k * rootDir->mapvGeom.c1.y;
+    cursorPrevC1_.x = k * rootDir->mapvGeom().c1.x;
+    cursorPrevC1_.y = k * rootDir->mapvGeom().c1.y;
     cursorPrevC1_.z = 0.25 * k * rootDir->mapvDepth();
 }
 
@@ -255,12 +259,12 @@ void MapVLayout::cameraPanFinished() {
 // ============================================================================
 
 void MapVLayout::buildNodeMesh(FsNode* node,
-                               std::vector<Vertex>& vertices,
+                               std::vector<PackedVertex>& vertices,
                                std::vector<uint32_t>& indices) {
     // Dimensions of node
     double dimsX = node->mapvWidth();
     double dimsY = node->mapvDepth();
-    double dimsZ = node->mapvGeom.height;
+    double dimsZ = node->mapvGeom().height;
 
     // Calculate normals for slanted sides
     double k = sideSlantRatios[node->type];
@@ -284,7 +288,7 @@ void MapVLayout::buildNodeMesh(FsNode* node,
         col = glm::vec3(node->color->r, node->color->g, node->color->b);
     }
 
-    auto& gp = node->mapvGeom;
+    auto& gp = node->mapvGeom();
     float x0 = static_cast<float>(gp.c0.x);
     float y0 = static_cast<float>(gp.c0.y);
     float x1 = static_cast<float>(gp.c1.x);
@@ -301,27 +305,27 @@ void MapVLayout::buildNodeMesh(FsNode* node,
     // Rear face (y1 side)
     // Bottom-left-rear, Top-left-rear, Bottom-right-rear, Top-right-rear
     glm::vec3 nRear(0.0f, normalY, normalZny);
-    vertices.push_back({glm::vec3(x0, y1, 0.0f), nRear, col, glm::vec2(0.0f)});         // 0
-    vertices.push_back({glm::vec3(x0 + ox, y1 - oy, h), nRear, col, glm::vec2(0.0f)});  // 1
+    vertices.push_back({glm::vec3(x0, y1, 0.0f), nRear, col});         // 0
+    vertices.push_back({glm::vec3(x0 + ox, y1 - oy, h), nRear, col});  // 1
 
     // Right face (x1 side)
     glm::vec3 nRight(normalX, 0.0f, normalZnx);
-    vertices.push_back({glm::vec3(x1, y1, 0.0f), nRight, col, glm::vec2(0.0f)});        // 2
-    vertices.push_back({glm::vec3(x1 - ox, y1 - oy, h), nRight, col, glm::vec2(0.0f)}); // 3
+    vertices.push_back({glm::vec3(x1, y1, 0.0f), nRight, col});        // 2
+    vertices.push_back({glm::vec3(x1 - ox, y1 - oy, h), nRight, col}); // 3
 
     // Front face (y0 side)
     glm::vec3 nFront(0.0f, -normalY, normalZny);
-    vertices.push_back({glm::vec3(x1, y0, 0.0f), nFront, col, glm::vec2(0.0f)});        // 4
-    vertices.push_back({glm::vec3(x1 - ox, y0 + oy, h), nFront, col, glm::vec2(0.0f)}); // 5
+    vertices.push_back({glm::vec3(x1, y0, 0.0f), nFront, col});        // 4
+    vertices.push_back({glm::vec3(x1 - ox, y0 + oy, h), nFront, col}); // 5
 
     // Left face (x0 side)
     glm::vec3 nLeft(-normalX, 0.0f, normalZnx);
-    vertices.push_back({glm::vec3(x0, y0, 0.0f), nLeft, col, glm::vec2(0.0f)});         // 6
-    vertices.push_back({glm::vec3(x0 + ox, y0 + oy, h), nLeft, col, glm::vec2(0.0f)});  // 7
+    vertices.push_back({glm::vec3(x0, y0, 0.0f), nLeft, col});         // 6
+    vertices.push_back({glm::vec3(x0 + ox, y0 + oy, h), nLeft, col});  // 7
 
     // Closing vertices (same as rear, for quad strip wrap)
-    vertices.push_back({glm::vec3(x0, y1, 0.0f), nLeft, col, glm::vec2(0.0f)});         // 8
-    vertices.push_back({glm::vec3(x0 + ox, y1 - oy, h), nLeft, col, glm::vec2(0.0f)});  // 9
+    vertices.push_back({glm::vec3(x0, y1, 0.0f), nLeft, col});         // 8
+    vertices.push_back({glm::vec3(x0 + ox, y1 - oy, h), nLeft, col});  // 9
 
     // Convert quad strip to triangles: each consecutive pair of vertices forms a quad
     // Quad 0 (rear): 0,1,2,3 -> triangles (0,1,2), (2,1,3)
@@ -340,10 +344,10 @@ void MapVLayout::buildNodeMesh(FsNode* node,
     // Top face
     glm::vec3 nTop(0.0f, 0.0f, 1.0f);
     uint32_t topBase = static_cast<uint32_t>(vertices.size());
-    vertices.push_back({glm::vec3(x0 + ox, y0 + oy, h), nTop, col, glm::vec2(0.0f)});   // 0
-    vertices.push_back({glm::vec3(x1 - ox, y0 + oy, h), nTop, col, glm::vec2(0.0f)});   // 1
-    vertices.push_back({glm::vec3(x1 - ox, y1 - oy, h), nTop, col, glm::vec2(0.0f)});   // 2
-    vertices.push_back({glm::vec3(x0 + ox, y1 - oy, h), nTop, col, glm::vec2(0.0f)});   // 3
+    vertices.push_back({glm::vec3(x0 + ox, y0 + oy, h), nTop, col});   // 0
+    vertices.push_back({glm::vec3(x1 - ox, y0 + oy, h), nTop, col});   // 1
+    vertices.push_back({glm::vec3(x1 - ox, y1 - oy, h), nTop, col});   // 2
+    vertices.push_back({glm::vec3(x0 + ox, y1 - oy, h), nTop, col});   // 3
 
     // Two triangles for the top quad
     indices.push_back(topBase + 0); indices.push_back(topBase + 1); indices.push_back(topBase + 2);
@@ -355,7 +359,7 @@ void MapVLayout::buildNodeMesh(FsNode* node,
 // ============================================================================
 
 void MapVLayout::buildFolderMesh(FsNode* dnode,
-                                 std::vector<Vertex>& vertices,
+                                 std::vector<PackedVertex>& vertices,
                                  std::vector<uint32_t>& indices) {
     assert(dnode->isDir());
 
@@ -363,12 +367,12 @@ void MapVLayout::buildFolderMesh(FsNode* dnode,
     double dimsX = dnode->mapvWidth();
     double dimsY = dnode->mapvDepth();
     double k = sideSlantRatios[NODE_DIRECTORY];
-    double offsetX = std::min(dnode->mapvGeom.height, k * dimsX);
-    double offsetY = std::min(dnode->mapvGeom.height, k * dimsY);
-    double c0x = dnode->mapvGeom.c0.x + offsetX;
-    double c0y = dnode->mapvGeom.c0.y + offsetY;
-    double c1x = dnode->mapvGeom.c1.x - offsetX;
-    double c1y = dnode->mapvGeom.c1.y - offsetY;
+    double offsetX = std::min(dnode->mapvGeom().height, k * dimsX);
+    double offsetY = std::min(dnode->mapvGeom().height, k * dimsY);
+    double c0x = dnode->mapvGeom().c0.x + offsetX;
+    double c0y = dnode->mapvGeom().c0.y + offsetY;
+    double c1x = dnode->mapvGeom().c1.x - offsetX;
+    double c1y = dnode->mapvGeom().c1.y - offsetY;
     dimsX -= 2.0 * offsetX;
     dimsY -= 2.0 * offsetY;
 
@@ -382,7 +386,7 @@ void MapVLayout::buildFolderMesh(FsNode* dnode,
     double ftabx = fc1x - (MAGIC_NUMBER - 1.0) * (fc1x - fc0x);
     double ftaby = fc1y - border;
 
-    float h = static_cast<float>(dnode->mapvGeom.height);
+    float h = static_cast<float>(dnode->mapvGeom().height);
 
     glm::vec3 col(0.7f, 0.7f, 0.7f);
     if (dnode->color) {
@@ -420,10 +424,10 @@ void MapVLayout::buildFolderMesh(FsNode* dnode,
         float ny = dx / len * lineWidth * 0.5f;
 
         uint32_t vbase = static_cast<uint32_t>(vertices.size());
-        vertices.push_back({glm::vec3(pts[i].x + nx, pts[i].y + ny, h + 0.1f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(pts[i].x - nx, pts[i].y - ny, h + 0.1f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(pts[i+1].x + nx, pts[i+1].y + ny, h + 0.1f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(pts[i+1].x - nx, pts[i+1].y - ny, h + 0.1f), nUp, col, glm::vec2(0.0f)});
+        vertices.push_back({glm::vec3(pts[i].x + nx, pts[i].y + ny, h + 0.1f), nUp, col});
+        vertices.push_back({glm::vec3(pts[i].x - nx, pts[i].y - ny, h + 0.1f), nUp, col});
+        vertices.push_back({glm::vec3(pts[i+1].x + nx, pts[i+1].y + ny, h + 0.1f), nUp, col});
+        vertices.push_back({glm::vec3(pts[i+1].x - nx, pts[i+1].y - ny, h + 0.1f), nUp, col});
 
         indices.push_back(vbase + 0); indices.push_back(vbase + 1); indices.push_back(vbase + 2);
         indices.push_back(vbase + 2); indices.push_back(vbase + 1); indices.push_back(vbase + 3);
@@ -435,7 +439,7 @@ void MapVLayout::buildFolderMesh(FsNode* dnode,
 // ============================================================================
 
 void MapVLayout::buildDir(FsNode* dnode,
-                          std::vector<Vertex>& vertices,
+                          std::vector<PackedVertex>& vertices,
                           std::vector<uint32_t>& indices) {
     assert(dnode->isDir() || dnode->isMetanode());
 
@@ -449,15 +453,15 @@ void MapVLayout::buildDir(FsNode* dnode,
 // Draw (port of mapv_draw_recursive + mapv_draw)
 // ============================================================================
 
-void MapVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
-                               const glm::mat4& proj, bool geometry) {
+void MapVLayout::drawRecursive(FsNode* dnode, bool geometry) {
     assert(dnode->isDir() || dnode->isMetanode());
 
     GeometryManager& gm = GeometryManager::instance();
     MatrixStack& ms = gm.modelStack();
 
     ms.push();
-    ms.translate(0.0f, 0.0f, static_cast<float>(dnode->mapvGeom.height));
+    gm.beginSubtree(dnode);
+    ms.translate(0.0f, 0.0f, static_cast<float>(dnode->mapvGeom().height));
 
     bool dirCollapsed = dnode->isCollapsed();
     bool dirExpanded = dnode->isExpanded();
@@ -468,33 +472,20 @@ void MapVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
     }
 
     if (geometry) {
-        // Draw directory face or geometry of children
-        float nodeGlow = ThemeManager::instance().currentTheme().baseEmissive + dnode->glowIntensity;
-
-        // Rebuild mesh each frame (to be optimized with mesh caching)
-        std::vector<Vertex> vertices;
-        std::vector<uint32_t> indices;
-
-        if (dirCollapsed) {
-            buildFolderMesh(dnode, vertices, indices);
-        } else {
-            buildDir(dnode, vertices, indices);
-        }
-
-        if (!vertices.empty()) {
-            ShaderProgram& shader = Renderer::instance().getNodeShader();
-            shader.use();
-            shader.setMat4("uModel", ms.top());
-            shader.setMat4("uView", view);
-            shader.setMat4("uProjection", proj);
-            shader.setFloat("uGlowIntensity", nodeGlow);
-
-            MeshBuffer mesh;
-            mesh.upload(vertices, indices);
-            mesh.draw(GL_TRIANGLES);
+        // Draw directory face or geometry of children, rebuilding the
+        // mesh only if the directory was queued for it
+        const MeshBuffer* mesh = gm.cachedMesh(dnode, GeometryManager::MESH_A);
+        if (!mesh) {
+            std::vector<PackedVertex> vertices;
+            std::vector<uint32_t> indices;
+            if (dirCollapsed) {
+                buildFolderMesh(dnode, vertices, indices);
+            } else {
+                buildDir(dnode, vertices, indices);
+            }
+            mesh = gm.storeMesh(dnode, GeometryManager::MESH_A, vertices, indices);
         }
-
-        dnode->aDlistStale = false;
+        gm.drawMesh(mesh, dnode);
     }
 
     // Update geometry status
@@ -506,14 +497,15 @@ void MapVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
             FsNode* node = childPtr.get();
             if (!node->isDir())
                 break;
-            drawRecursive(node, view, proj, geometry);
+            drawRecursive(node, geometry);
         }
     }
 
+    gm.endSubtree(dnode);
     ms.pop();
 }
 
-void MapVLayout::draw(const glm::mat4& view, const glm::mat4& projection, bool highDetail) {
+void MapVLayout::draw(bool highDetail) {
     FsTree& tree = FsTree::instance();
     FsNode* root = tree.root();
     if (!root) return;
@@ -522,7 +514,7 @@ void MapVLayout::draw(const glm::mat4& view, const glm::mat4& projection, bool h
     gm.modelStack().loadIdentity();
 
     // Draw geometry
-    drawRecursive(root, view, projection, true);
+    drawRecursive(root, true);
 
     if (highDetail) {
         // High-detail: outlines, labels, cursor would go here
@@ -530,7 +522,7 @@ void MapVLayout::draw(const glm::mat4& view, const glm::mat4& projection, bool h
     }
 }
 
-void MapVLayout::drawForPicking(const glm::mat4& view, const glm::mat4& projection) {
+void MapVLayout::drawForPicking() {
     FsTree& tree = FsTree::instance();
     FsNode* root = tree.root();
     if (!root) return;
@@ -541,17 +533,282 @@ void MapVLayout::drawForPicking(const glm::mat4& view, const glm::mat4& projecti
     // For picking, we draw each node with a unique color encoding its ID
     // This is a simplified picking pass - full implementation would encode
     // node IDs into the color channel of a picking framebuffer
-    drawRecursive(root, view, projection, true);
+    drawRecursive(root, true);
+}
+
+// ============================================================================
+// Instanced drawing: one unit box for every block, one unit folder outline
+// for every collapsed directory, placed by per-instance attributes in the
+// mapv_box/mapv_folder vertex shaders
+// ============================================================================
+
+MapVLayout::MapVInstance MapVLayout::instanceOf(const FsNode* node, float zBase, float zScale) {
+    const MapVGeomParams& geom = node->mapvGeom();
+    RGBcolor col{0.7f, 0.7f, 0.7f};
+    if (node->color)
+        col = *node->color;
+
+    MapVInstance inst;
+    inst.corners[0] = static_cast<float>(geom.c0.x);
+    inst.corners[1] = static_cast<float>(geom.c0.y);
+    inst.corners[2] = static_cast<float>(geom.c1.x);
+    inst.corners[3] = static_cast<float>(geom.c1.y);
+    inst.zBase = zBase;
+    inst.zScale = zScale;
+    inst.height = static_cast<float>(geom.height);
+    inst.slant = sideSlantRatios[node->type];
+    inst.color[0] = PackedVertex::packUnorm8(col.r);
+    inst.color[1] = PackedVertex::packUnorm8(col.g);
+    inst.color[2] = PackedVertex::packUnorm8(col.b);
+    inst.color[3] = 255;
+    return inst;
+}
+
+void MapVLayout::initInstanceBatch(InstanceBatch& batch, const std::vector<PackedVertex>& vertices,
+                                   const std::vector<uint32_t>& indices) {
+    batch.mesh.upload(vertices, indices);
+    batch.instances.create();
+    batch.glow.create();
+
+    GLsizei stride = sizeof(MapVInstance);
+    batch.mesh.addInstanceAttrib(4, batch.instances.id(), 4, GL_FLOAT, false, stride,
+                                 offsetof(MapVInstance, corners));
+    batch.mesh.addInstanceAttrib(5, batch.instances.id(), 4, GL_FLOAT, false, stride,
+                                 offsetof(MapVInstance, zBase));
+    batch.mesh.addInstanceAttrib(6, batch.instances.id(), 4, GL_UNSIGNED_BYTE, true, stride,
+                                 offsetof(MapVInstance, color));
+    batch.mesh.addInstanceAttrib(7, batch.glow.id(), 1, GL_FLOAT, false, sizeof(float), 0);
+}
+
+// Walks the tree as drawRecursive() does, tracking the frame's z offset and
+// scale instead of a matrix.
+Aabb MapVLayout::gatherRecursive(FsNode* dnode, float zBase, float zScale) {
+    zBase += zScale * static_cast<float>(dnode->mapvGeom().height);
+
+    bool dirCollapsed = dnode->isCollapsed();
+    bool dirExpanded = dnode->isExpanded();
+
+    if (!dirCollapsed && !dirExpanded)
+        zScale *= static_cast<float>(dnode->deployment);
+
+    Aabb bounds;
+    uint32_t boxRange = 0;
+    if (dirCollapsed) {
+        uint32_t first = static_cast<uint32_t>(folders_.data.size());
+        const MapVInstance& inst = folders_.data.emplace_back(instanceOf(dnode, zBase, zScale));
+        float z = zBase + zScale * (inst.height + 0.1f);
+        bounds.add(glm::vec3(inst.corners[0], inst.corners[1], z));
+        bounds.add(glm::vec3(inst.corners[2], inst.corners[3], z));
+        folders_.ranges.push_back({dnode, first, 1, bounds});
+    } else if (!dnode->children.empty()) {
+        uint32_t first = static_cast<uint32_t>(boxes_.data.size());
+        for (auto& childPtr : dnode->children) {
+            const MapVInstance& inst = boxes_.data.emplace_back(instanceOf(childPtr.get(), zBase, zScale));
+            bounds.add(glm::vec3(inst.corners[0], inst.corners[1], zBase));
+            bounds.add(glm::vec3(inst.corners[2], inst.corners[3],
+                                 zBase + zScale * inst.height));
+        }
+        boxRange = static_cast<uint32_t>(boxes_.ranges.size());
+        GlowRange& range = boxes_.ranges.emplace_back(
+            GlowRange{dnode, first, static_cast<uint32_t>(dnode->children.size()), bounds});
+        range.foldersFirst = static_cast<uint32_t>(folders_.ranges.size());
+    }
+
+    // Update geometry status
+    dnode->geomExpanded = !dirCollapsed;
+
+    if (!dirCollapsed) {
+        for (auto& childPtr : dnode->children) {
+            FsNode* node = childPtr.get();
+            if (!node->isDir())
+                break;
+            bounds.add(gatherRecursive(node, zBase, zScale));
+        }
+        if (!dnode->children.empty()) {
+            GlowRange& range = boxes_.ranges[boxRange];
+            range.end = static_cast<uint32_t>(boxes_.ranges.size());
+            range.foldersEnd = static_cast<uint32_t>(folders_.ranges.size());
+        }
+    }
+
+    GeometryManager::instance().setSubtreeBounds(dnode, bounds);
+    return bounds;
+}
+
+// Walks the box ranges in gather (pre-)order, skipping each subtree whose
+// bounds miss the view with its folders, then packs the kept ranges'
+// instances together so one instanced call draws just them.
+void MapVLayout::cullInstances() {
+    const GeometryManager& geometry = GeometryManager::instance();
+    for (InstanceBatch* batch : {&boxes_, &folders_}) {
+        batch->drawn.clear();
+        batch->drawData.clear();
+        batch->drawGlow.clear();
+    }
+
+    uint32_t folder = 0;
+    auto cullFolders = [&](uint32_t end) {
+        for (; folder < end; ++folder) {
+            if (geometry.inView(folders_.ranges[folder].bounds))
+                addDrawn(folders_, folder);
+        }
+    };
+    uint32_t box = 0;
+    while (box < boxes_.ranges.size()) {
+        const GlowRange& range = boxes_.ranges[box];
+        cullFolders(range.foldersFirst);
+        if (!geometry.subtreeInView(range.dnode)) {
+            box = range.end;
+            folder = range.foldersEnd;
+            continue;
+        }
+        if (geometry.inView(range.bounds))
+            addDrawn(boxes_, box);
+        ++box;
+    }
+    cullFolders(static_cast<uint32_t>(folders_.ranges.size()));
+
+    uploadDrawn(boxes_);
+    uploadDrawn(folders_);
+}
+
+void MapVLayout::addDrawn(InstanceBatch& batch, uint32_t rangeIndex) {
+    GlowRange& range = batch.ranges[rangeIndex];
+    range.drawFirst = static_cast<uint32_t>(batch.drawData.size());
+    range.glow = range.dnode->glowIntensity;
+    batch.drawn.push_back(rangeIndex);
+    batch.drawData.insert(batch.drawData.end(), batch.data.begin() + range.first,
+                          batch.data.begin() + range.first + range.count);
+    batch.drawGlow.insert(batch.drawGlow.end(), range.count, range.glow);
+}
+
+void MapVLayout::uploadDrawn(InstanceBatch& batch) {
+    batch.instances.upload(batch.drawData.data(), batch.drawData.size() * sizeof(MapVInstance));
+    batch.glow.upload(batch.drawGlow.data(), batch.drawGlow.size() * sizeof(float));
+}
+
+// Glow pulses without a redraw being queued; re-send only the drawn ranges
+// whose directory's glow changed.
+void MapVLayout::updateGlow(InstanceBatch& batch) {
+    for (uint32_t rangeIndex : batch.drawn) {
+        GlowRange& range = batch.ranges[rangeIndex];
+        float glow = range.dnode->glowIntensity;
+        if (glow == range.glow)
+            continue;
+        range.glow = glow;
+        std::fill_n(batch.drawGlow.begin() + range.drawFirst, range.count, glow);
+        batch.glow.update(range.drawFirst * sizeof(float), &batch.drawGlow[range.drawFirst],
+                          range.count * sizeof(float));
+    }
+}
+
+bool MapVLayout::drawInstanced(bool regather) {
+    Renderer& renderer = Renderer::instance();
+    ShaderProgram& boxShader = renderer.getMapVBoxShader();
+    ShaderProgram& folderShader = renderer.getMapVFolderShader();
+    if (boxShader.getId() == 0 || folderShader.getId() == 0)
+        return false;
+
+    FsNode* root = FsTree::instance().root();
+    if (!root)
+        return true;
+
+    if (!boxes_.mesh.isValid()) {
+        // Unit box: each vertex's position selects its corner (at c1.x, at
+        // c1.y, on top) and its normal the face it lights, in the order
+        // buildNodeMesh() emits them
+        static const float box[14][6] = {
+            {0, 1, 0,  0, 1, 0}, {0, 1, 1,  0, 1, 0},    // rear
+            {1, 1, 0,  1, 0, 0}, {1, 1, 1,  1, 0, 0},    // right
+            {1, 0, 0,  0, -1, 0}, {1, 0, 1,  0, -1, 0},  // front
+            {0, 0, 0,  -1, 0, 0}, {0, 0, 1,  -1, 0, 0},  // left
+            {0, 1, 0,  -1, 0, 0}, {0, 1, 1,  -1, 0, 0},  // closing
+            {0, 0, 1,  0, 0, 1}, {1, 0, 1,  0, 0, 1},    // top
+            {1, 1, 1,  0, 0, 1}, {0, 1, 1,  0, 0, 1}
+        };
+        std::vector<PackedVertex> vertices;
+        for (const auto& v : box) {
+            vertices.push_back({glm::vec3(v[0], v[1], v[2]), glm::vec3(v[3], v[4], v[5]),
+                                glm::vec3(0.0f)});
+        }
+        std::vector<uint32_t> indices;
+        for (uint32_t quad = 0; quad < 4; ++quad) {
+            uint32_t b = 2 * quad;
+            indices.insert(indices.end(), {b, b + 1, b + 2, b + 2, b + 1, b + 3});
+        }
+        indices.insert(indices.end(), {10, 11, 12, 10, 12, 13});
+        initInstanceBatch(boxes_, vertices, indices);
+
+        // Unit folder outline: four vertices per segment, selecting the
+        // segment, its start or end, and the side of the line
+        vertices.clear();
+        indices.clear();
+        glm::vec3 nUp(0.0f, 0.0f, 1.0f);
+        for (uint32_t seg = 0; seg < 7; ++seg) {
+            float s = static_cast<float>(seg);
+            uint32_t b = static_cast<uint32_t>(vertices.size());
+            vertices.push_back({glm::vec3(s, 0.0f, 1.0f), nUp, glm::vec3(0.0f)});
+            vertices.push_back({glm::vec3(s, 0.0f, -1.0f), nUp, glm::vec3(0.0f)});
+            vertices.push_back({glm::vec3(s, 1.0f, 1.0f), nUp, glm::vec3(0.0f)});
+            vertices.push_back({glm::vec3(s, 1.0f, -1.0f), nUp, glm::vec3(0.0f)});
+            indices.insert(indices.end(), {b, b + 1, b + 2, b + 2, b + 1, b + 3});
+        }
+        initInstanceBatch(folders_, vertices, indices);
+        regather = true;
+    }
+
+    if (regather) {
+        for (InstanceBatch* batch : {&boxes_, &folders_}) {
+            batch->data.clear();
+            batch->ranges.clear();
+        }
+        gatherRecursive(root, 0.0f, 1.0f);
+    }
+
+    // The instances do not move with the camera, so the kept set only
+    // changes when the view does
+    const FrameUniforms& frame = renderer.frameUniforms();
+    glm::mat4 viewProj = frame.projection * frame.view;
+    if (regather || std::memcmp(&viewProj, &culledFor_, sizeof(glm::mat4)) != 0) {
+        culledFor_ = viewProj;
+        cullInstances();
+    } else {
+        updateGlow(boxes_);
+        updateGlow(folders_);
+    }
+
+    std::pair<InstanceBatch*, ShaderProgram*> passes[] = {
+        {&boxes_, &boxShader}, {&folders_, &folderShader}
+    };
+    for (auto& [batch, shader] : passes) {
+        if (batch->drawData.empty())
+            continue;
+        shader->use();
+        batch->mesh.drawInstanced(static_cast<int>(batch->drawData.size()), GL_TRIANGLES);
+    }
+    return true;
+}
+
+void MapVLayout::freeInstanced() {
+    for (InstanceBatch* batch : {&boxes_, &folders_}) {
+        batch->mesh.destroy();
+        batch->instances.destroy();
+        batch->glow.destroy();
+        batch->data.clear();
+        batch->ranges.clear();
+        batch->drawn.clear();
+        batch->drawData.clear();
+        batch->drawGlow.clear();
+    }
 }
 
 void MapVLayout::drawNodeMesh(FsNode* node, const glm::mat4& model) {
-    std::vector<Vertex> vertices;
+    std::vector<PackedVertex> vertices;
     std::vector<uint32_t> indices;
     buildNodeMesh(node, vertices, indices);
 
     if (!vertices.empty()) {
-        ShaderProgram& shader = Renderer::instance().getNodeShader();
-        shader.setMat4("uModel", model);
+        Renderer::instance().setNodeDrawUniforms(model, normalMatrixOf(model), 0.0f);
 
         MeshBuffer mesh;
         mesh.upload(vertices, indices);
@@ -560,13 +817,12 @@ void MapVLayout::drawNodeMesh(FsNode* node, const glm::mat4& model) {
 }
 
 void MapVLayout::drawFolder(FsNode* dnode, const glm::mat4& model) {
-    std::vector<Vertex> vertices;
+    std::vector<PackedVertex> vertices;
     std::vector<uint32_t> indices;
     buildFolderMesh(dnode, vertices, indices);
 
     if (!vertices.empty()) {
-        ShaderProgram& shader = Renderer::instance().getNodeShader();
-        shader.setMat4("uModel", model);
+        Renderer::instance().setNodeDrawUniforms(model, normalMatrixOf(model), 0.0f);
 
         MeshBuffer mesh;
         mesh.upload(vertices, indices);
@@ -1,25 +1,53 @@
 #pragma once
 
 #include "core/Types.h"
+#include "camera/Frustum.h"
 #include "renderer/MeshBuffer.h"
 
 #include <glm/glm.hpp>
+#include <memory>
 #include <vector>
 
 namespace fsvng {
 
 class FsNode;
+struct FsDiff;
 
 class MapVLayout {
 public:
     static MapVLayout& instance();
 
     void init();
-    void draw(const glm::mat4& view, const glm::mat4& projection, bool highDetail);
-    void drawForPicking(const glm::mat4& view, const glm::mat4& projection);
+    void draw(bool highDetail);
+    void drawForPicking();
+
+    // Draw every visible block with one instanced call and every collapsed
+    // directory's folder with another, gathering the instances again first
+    // if regather. Only the directories whose instances can be in view are
+    // uploaded, chosen again when the camera has moved. Returns false,
+    // having drawn nothing, if the instanced shaders are unavailable.
+    bool drawInstanced(bool regather);
+
+    // Forget the gathered instances and free their buffers
+    void freeInstanced();
 
     void cameraPanFinished();
 
+    // Re-lay out dnode's children after they changed, within dnode's
+    // current footprint.
+    void relayoutDir(FsNode* dnode) { initRecursive(dnode); }
+
+    // Size blocks by allocated (on-disk) bytes instead of logical size.
+    // Takes effect on the next init().
+    void setSizeByAllocation(bool enable) { sizeByAllocation_ = enable; }
+    bool sizeByAllocation() const { return sizeByAllocation_; }
+
+    // Size blocks by growth since a snapshot (nodes that did not grow get
+    // the minimum size), or by size again with nullptr. Takes effect on the
+    // next init().
+    void setDeltaSizes(std::shared_ptr<const FsDiff> diff) { deltaSizes_ = std::move(diff); }
+    bool sizeByDelta() const { return deltaSizes_ != nullptr; }
+
     // Constants
     static constexpr double BORDER_PROPORTION = 0.01;
     static constexpr double ROOT_ASPECT_RATIO = 1.2;
@@ -33,29 +61,98 @@ private:
     MapVLayout() = default;
 
     void initRecursive(FsNode* dnode);
-    void drawRecursive(FsNode* dnode, const glm::mat4& view, const glm::mat4& proj,
-                       bool geometry);
+
+    // Size of a node (own size clamped to minSize, plus its subtree; or its
+    // growth clamped to minSize) as used for block area
+    int64_t layoutSize(const FsNode* node, int64_t minSize) const;
+    void drawRecursive(FsNode* dnode, bool geometry);
     void drawNodeMesh(FsNode* node, const glm::mat4& model);
     void drawFolder(FsNode* dnode, const glm::mat4& model);
     void drawCursor(double pos, const glm::mat4& view, const glm::mat4& proj);
 
     // Generate mesh for a MapV node (slanted box)
-    void buildNodeMesh(FsNode* node, std::vector<Vertex>& vertices,
+    void buildNodeMesh(FsNode* node, std::vector<PackedVertex>& vertices,
                        std::vector<uint32_t>& indices);
 
     // Generate mesh for a MapV folder outline on top of collapsed dir
-    void buildFolderMesh(FsNode* dnode, std::vector<Vertex>& vertices,
+    void buildFolderMesh(FsNode* dnode, std::vector<PackedVertex>& vertices,
                          std::vector<uint32_t>& indices);
 
     // Build all children geometry for a directory
-    void buildDir(FsNode* dnode, std::vector<Vertex>& vertices,
+    void buildDir(FsNode* dnode, std::vector<PackedVertex>& vertices,
                   std::vector<uint32_t>& indices);
 
+    // Treemap scratch stacks shared by every level of initRecursive()
+    struct MapVBlock {
+        FsNode* node;
+        double area;
+    };
+    struct MapVRow {
+        size_t firstBlockIndex;
+        double area;
+    };
+    std::vector<MapVBlock> blocks_;
+    std::vector<MapVRow> rows_;
+
+    // One block, or one collapsed directory's folder, as drawn instanced
+    struct MapVInstance {
+        float corners[4];  // c0.x, c0.y, c1.x, c1.y
+        float zBase;       // of the frame the node is drawn in
+        float zScale;      // deployment of the directories above
+        float height;
+        float slant;       // side slant ratio of the node's type
+        uint8_t color[4];
+    };
+
+    // Instances drawn in one directory's frame, which share its glow and
+    // are culled together
+    struct GlowRange {
+        const FsNode* dnode;
+        uint32_t first;
+        uint32_t count;
+        Aabb bounds;           // world bounds of these instances
+        // Boxes only: the ranges of dnode's subtree end before ranges[end],
+        // and its folders are folders_.ranges[foldersFirst, foldersEnd)
+        uint32_t end = 0;
+        uint32_t foldersFirst = 0;
+        uint32_t foldersEnd = 0;
+        uint32_t drawFirst = 0;  // in the uploaded instances, if drawn
+        float glow = 0.0f;       // as last uploaded
+    };
+
+    // Geometry of every instance for one unit mesh. data holds them all;
+    // the buffers hold only those of the ranges listed in drawn.
+    struct InstanceBatch {
+        MeshBuffer mesh;
+        InstanceBuffer instances;
+        InstanceBuffer glow;
+        std::vector<MapVInstance> data;
+        std::vector<GlowRange> ranges;
+        std::vector<uint32_t> drawn;        // indices into ranges
+        std::vector<MapVInstance> drawData;
+        std::vector<float> drawGlow;
+    };
+
+    void initInstanceBatch(InstanceBatch& batch, const std::vector<PackedVertex>& vertices,
+                           const std::vector<uint32_t>& indices);
+    // Returns the world bounds of what it gathered for dnode's subtree
+    Aabb gatherRecursive(FsNode* dnode, float zBase, float zScale);
+    static MapVInstance instanceOf(const FsNode* node, float zBase, float zScale);
+    // Choose the ranges in view and upload their instances
+    void cullInstances();
+    static void addDrawn(InstanceBatch& batch, uint32_t rangeIndex);
+    static void uploadDrawn(InstanceBatch& batch);
+    static void updateGlow(InstanceBatch& batch);
+
+    InstanceBatch boxes_;    // blocks, in their parent's frame
+    InstanceBatch folders_;  // outlines on collapsed directories
+    glm::mat4 culledFor_{0.0f};  // view-projection of the last cullInstances()
+
+    bool sizeByAllocation_ = false;
+    std::shared_ptr<const FsDiff> deltaSizes_;
+
     XYZvec cursorPrevC0_{};
     XYZvec cursorPrevC1_{};
-
-    // Cached mesh buffers per directory
-    // We use the dirty flag approach instead of display lists
 };
 
 } // namespace fsvng
@@ -3,11 +3,9 @@
 #include "core/FsNode.h"
 #include "core/FsTree.h"
 #include "ui/DirTreePanel.h"
-#include "renderer/Renderer.h"
-#include "renderer/ShaderProgram.h"
+#include "renderer/PackedVertex.h"
 #include "animation/Morph.h"
 #include "animation/Animation.h"
-#include "ui/ThemeManager.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
@@ -84,8 +82,9 @@ void TreeVLayout::reshapePlatform(FsNode* dnode, double r0) {
     // inner edge length that is two leaf node edges long
     double minArcWidth = (180.0 * (2.0 * LEAF_NODE_EDGE + PLATFORM_SPACING_WIDTH) / PI) / r0;
 
-    dnode->treevGeom.platform.arc_width = std::max(minArcWidth, arcWidth);
-    dnode->treevGeom.platform.depth = depth;
+    auto& platform = dnode->treevGeom().platform;
+    platform.arc_width = std::max(minArcWidth, arcWidth);
+    platform.depth = depth;
 
     // Directory will need rebuilding
     GeometryManager::instance().queueRebuild(dnode);
@@ -116,7 +115,7 @@ void TreeVLayout::arrangeRecursive(FsNode* dnode, double r0, bool reshapeTree) {
 
     // Recurse into expanded subdirectories, and obtain the overall
     // arc width of the subtree
-    double subtreeR0 = r0 + dnode->treevGeom.platform.depth + PLATFORM_SPACING_DEPTH;
+    double subtreeR0 = r0 + dnode->treevGeom().platform.depth + PLATFORM_SPACING_DEPTH;
     double subtreeArcWidth = 0.0;
 
     for (auto& childPtr : dnode->children) {
@@ -124,13 +123,13 @@ void TreeVLayout::arrangeRecursive(FsNode* dnode, double r0, bool reshapeTree) {
         if (!node->isDir())
             break;
         arrangeRecursive(node, subtreeR0, reshapeTree);
+        auto& platform = node->treevGeom().platform;
         double arcWidth = node->deployment
-            * std::max(node->treevGeom.platform.arc_width,
-                       node->treevGeom.platform.subtree_arc_width);
-        node->treevGeom.platform.theta = arcWidth; // temporary value
+            * std::max(platform.arc_width, platform.subtree_arc_width);
+        platform.theta = arcWidth; // temporary value
         subtreeArcWidth += arcWidth;
     }
-    dnode->treevGeom.platform.subtree_arc_width = subtreeArcWidth;
+    dnode->treevGeom().platform.subtree_arc_width = subtreeArcWidth;
 
     // Spread the subdirectories, sweeping counterclockwise
     double theta = -0.5 * subtreeArcWidth;
@@ -138,8 +137,9 @@ void TreeVLayout::arrangeRecursive(FsNode* dnode, double r0, bool reshapeTree) {
         FsNode* node = childPtr.get();
         if (!node->isDir())
             break;
-        double arcWidth = node->treevGeom.platform.theta;
-        node->treevGeom.platform.theta = theta + 0.5 * arcWidth;
+        auto& platform = node->treevGeom().platform;
+        double arcWidth = platform.theta;
+        platform.theta = theta + 0.5 * arcWidth;
         theta += arcWidth;
     }
 
@@ -158,24 +158,24 @@ void TreeVLayout::arrange(bool initialArrange) {
 
     double rootR0 = coreRadius_ + PLATFORM_SPACING_DEPTH;
     arrangeRecursive(rootDir, rootR0, initialArrange);
-    rootDir->treevGeom.platform.arc_width = MAX_ARC_WIDTH;
+    rootDir->treevGeom().platform.arc_width = MAX_ARC_WIDTH;
 
     // Check that the tree's total arc width is within bounds
     for (;;) {
-        double subtreeArc = rootDir->treevGeom.platform.subtree_arc_width;
+        double subtreeArc = rootDir->treevGeom().platform.subtree_arc_width;
         if (subtreeArc > MAX_ARC_WIDTH) {
             // Grow core radius
             coreRadius_ *= CORE_GROW_FACTOR;
             rootR0 = coreRadius_ + PLATFORM_SPACING_DEPTH;
             arrangeRecursive(rootDir, rootR0, true);
-            rootDir->treevGeom.platform.arc_width = MAX_ARC_WIDTH;
+            rootDir->treevGeom().platform.arc_width = MAX_ARC_WIDTH;
         } else if (subtreeArc < MIN_ARC_WIDTH &&
                    coreRadius_ > MIN_CORE_RADIUS) {
             // Shrink core radius
             coreRadius_ = std::max(MIN_CORE_RADIUS, coreRadius_ / CORE_GROW_FACTOR);
             rootR0 = coreRadius_ + PLATFORM_SPACING_DEPTH;
             arrangeRecursive(rootDir, rootR0, true);
-            rootDir->treevGeom.platform.arc_width = MAX_ARC_WIDTH;
+            rootDir->treevGeom().platform.arc_width = MAX_ARC_WIDTH;
         } else {
             break;
         }
@@ -198,21 +198,22 @@ void TreeVLayout::initRecursive(FsNode* dnode) {
         GeometryManager::instance().queueRebuild(dnode);
     }
 
-    dnode->flags = 0;
+    dnode->flags &= static_cast<uint16_t>(~NEED_REARRANGE);
 
     // Assign heights to leaf nodes using log scale to handle extreme size ranges
     // (0-byte files next to multi-GB files). Log scale gives a reasonable visual
     // ratio: log2(64)=6 vs log2(10GB)=33, instead of sqrt which gives 8 vs 103K.
     for (auto& childPtr : dnode->children) {
         FsNode* node = childPtr.get();
+        TreeVGeomParams& geom = node->treevGeom();
         int64_t size = std::max(int64_t(64), node->size);
         if (node->isDir()) {
             size += node->subtree.size;
-            node->treevGeom.platform.height = PLATFORM_HEIGHT;
+            geom.platform.height = PLATFORM_HEIGHT;
             initRecursive(node);
         }
         double logHeight = std::log2(static_cast<double>(size));
-        node->treevGeom.leaf.height = logHeight * LEAF_HEIGHT_MULTIPLIER * 16.0;
+        geom.leaf.height = logHeight * LEAF_HEIGHT_MULTIPLIER * 16.0;
     }
 }
 
@@ -237,18 +238,18 @@ void TreeVLayout::init() {
 
     // Set up metanode as invisible center (depth=0)
     // theta=0 because draw skips metanode, so its rotation shouldn't be in the chain
-    metanode->treevGeom.platform.theta = 0.0;
-    metanode->treevGeom.platform.depth = 0.0;
-    metanode->treevGeom.platform.arc_width = MAX_ARC_WIDTH;
-    metanode->treevGeom.platform.height = 0.0;
+    metanode->treevGeom().platform.theta = 0.0;
+    metanode->treevGeom().platform.depth = 0.0;
+    metanode->treevGeom().platform.arc_width = MAX_ARC_WIDTH;
+    metanode->treevGeom().platform.height = 0.0;
     metanode->deployment = 1.0;
 
     // Set up rootDir as the effective center so its children fill the first ring.
     // (Metanode always has exactly 1 child - rootDir - which wastes a ring level.)
-    rootDir->treevGeom.platform.theta = 0.0;
-    rootDir->treevGeom.platform.height = 0.0;
-    rootDir->treevGeom.leaf.theta = 0.0;
-    rootDir->treevGeom.leaf.distance = 0.0;
+    rootDir->treevGeom().platform.theta = 0.0;
+    rootDir->treevGeom().platform.height = 0.0;
+    rootDir->treevGeom().leaf.theta = 0.0;
+    rootDir->treevGeom().leaf.distance = 0.0;
     rootDir->deployment = 1.0;
 
     // Initialize from rootDir (skip metanode level)
@@ -259,22 +260,22 @@ void TreeVLayout::init() {
     arrangeRecursive(rootDir, rootR0, true);
 
     // Override rootDir's arc_width to fill the entire ring
-    rootDir->treevGeom.platform.arc_width = MAX_ARC_WIDTH;
+    rootDir->treevGeom().platform.arc_width = MAX_ARC_WIDTH;
 
     // Core radius adjustment loop
     for (;;) {
-        double subtreeArc = rootDir->treevGeom.platform.subtree_arc_width;
+        double subtreeArc = rootDir->treevGeom().platform.subtree_arc_width;
         if (subtreeArc > MAX_ARC_WIDTH) {
             coreRadius_ *= CORE_GROW_FACTOR;
             rootR0 = coreRadius_ + PLATFORM_SPACING_DEPTH;
             arrangeRecursive(rootDir, rootR0, true);
-            rootDir->treevGeom.platform.arc_width = MAX_ARC_WIDTH;
+            rootDir->treevGeom().platform.arc_width = MAX_ARC_WIDTH;
         } else if (subtreeArc < MIN_ARC_WIDTH &&
                    coreRadius_ > MIN_CORE_RADIUS) {
             coreRadius_ = std::max(MIN_CORE_RADIUS, coreRadius_ / CORE_GROW_FACTOR);
             rootR0 = coreRadius_ + PLATFORM_SPACING_DEPTH;
             arrangeRecursive(rootDir, rootR0, true);
-            rootDir->treevGeom.platform.arc_width = MAX_ARC_WIDTH;
+            rootDir->treevGeom().platform.arc_width = MAX_ARC_WIDTH;
         } else {
             break;
         }
@@ -286,11 +287,11 @@ void TreeVLayout::init() {
     // Initial cursor state
     getCorners(rootDir, &cursorPrevC0_, &cursorPrevC1_);
     cursorPrevC0_.r *= 0.875;
-    cursorPrevC0_.theta -= rootDir->treevGeom.platform.arc_width;
+    cursorPrevC0_.theta -= rootDir->treevGeom().platform.arc_width;
     cursorPrevC0_.z = 0.0;
     cursorPrevC1_.r *= 1.125;
-    cursorPrevC1_.theta += rootDir->treevGeom.platform.arc_width;
-    cursorPrevC1_.z = rootDir->treevGeom.platform.height;
+    cursorPrevC1_.theta += rootDir->treevGeom().platform.arc_width;
+    cursorPrevC1_.z = rootDir->treevGeom().platform.height;
 }
 
 // ============================================================================
@@ -322,6 +323,16 @@ void TreeVLayout::queueRearrange(FsNode* dnode) {
     GeometryManager::instance().queueUncachedDraw();
 }
 
+void TreeVLayout::relayoutDir(FsNode* dnode) {
+    assert(dnode->isDir());
+
+    initRecursive(dnode);
+    if (!dnode->isCollapsed()) {
+        reshapePlatform(dnode, GeometryManager::instance().treevPlatformR0(dnode));
+    }
+    queueRearrange(dnode);
+}
+
 // ============================================================================
 // getCorners - port of treev_get_corners
 // ============================================================================
@@ -332,9 +343,9 @@ void TreeVLayout::getCorners(FsNode* node, RTZvec* c0, RTZvec* c1) const {
     if (gm.treevIsLeaf(node)) {
         // Absolute position of center of leaf node bottom
         RTZvec pos;
-        pos.r = gm.treevPlatformR0(node->parent) + node->treevGeom.leaf.distance;
-        pos.theta = gm.treevPlatformTheta(node->parent) + node->treevGeom.leaf.theta;
-        pos.z = node->parent->treevGeom.platform.height;
+        pos.r = gm.treevPlatformR0(node->parent) + node->treevGeom().leaf.distance;
+        pos.theta = gm.treevPlatformTheta(node->parent) + node->treevGeom().leaf.theta;
+        pos.z = node->parent->treevGeom().platform.height;
 
         // Calculate corners of leaf node
         double leafArcWidth = (180.0 * LEAF_NODE_EDGE / PI) / pos.r;
@@ -343,7 +354,7 @@ void TreeVLayout::getCorners(FsNode* node, RTZvec* c0, RTZvec* c1) const {
         c0->z = pos.z;
         c1->r = pos.r + 0.5 * LEAF_NODE_EDGE;
         c1->theta = pos.theta + 0.5 * leafArcWidth;
-        c1->z = pos.z + node->treevGeom.leaf.height;
+        c1->z = pos.z + node->treevGeom().leaf.height;
 
         // Push corners outward a bit
         double paddingArcWidth = (180.0 * LEAF_PADDING / PI) / pos.r;
@@ -361,11 +372,11 @@ void TreeVLayout::getCorners(FsNode* node, RTZvec* c0, RTZvec* c1) const {
 
         // Calculate corners of platform region
         c0->r = pos.r;
-        c0->theta = pos.theta - 0.5 * node->treevGeom.platform.arc_width;
+        c0->theta = pos.theta - 0.5 * node->treevGeom().platform.arc_width;
         c0->z = 0.0;
-        c1->r = pos.r + node->treevGeom.platform.depth;
-        c1->theta = pos.theta + 0.5 * node->treevGeom.platform.arc_width;
-        c1->z = node->treevGeom.platform.height;
+        c1->r = pos.r + node->treevGeom().platform.depth;
+        c1->theta = pos.theta + 0.5 * node->treevGeom().platform.arc_width;
+        c1->z = node->treevGeom().platform.height;
 
         // Push corners outward. Sides already encompass spacing regions
         c0->r -= PLATFORM_PADDING;
@@ -378,15 +389,15 @@ void TreeVLayout::getCorners(FsNode* node, RTZvec* c0, RTZvec* c1) const {
 // ============================================================================
 
 void TreeVLayout::buildPlatformMesh(FsNode* dnode, double r0,
-                                    std::vector<Vertex>& vertices,
+                                    std::vector<PackedVertex>& vertices,
                                     std::vector<uint32_t>& indices) {
     assert(dnode->isDir());
 
-    double r1 = r0 + dnode->treevGeom.platform.depth;
+    double r1 = r0 + dnode->treevGeom().platform.depth;
     int segCount = static_cast<int>(std::ceil(
-        dnode->treevGeom.platform.arc_width / CURVE_GRANULARITY));
+        dnode->treevGeom().platform.arc_width / CURVE_GRANULARITY));
     if (segCount < 1) segCount = 1;
-    double segArcWidth = dnode->treevGeom.platform.arc_width / static_cast<double>(segCount);
+    double segArcWidth = dnode->treevGeom().platform.arc_width / static_cast<double>(segCount);
 
     // Ensure buffers are large enough
     if (innerEdgeBuf_.size() < static_cast<size_t>(segCount + 1)) {
@@ -395,7 +406,7 @@ void TreeVLayout::buildPlatformMesh(FsNode* dnode, double r0,
     }
 
     // Calculate and cache inner/outer edge vertices
-    double theta = -0.5 * dnode->treevGeom.platform.arc_width;
+    double theta = -0.5 * dnode->treevGeom().platform.arc_width;
     for (int s = 0; s <= segCount; ++s) {
         double sinTheta = std::sin(rad(theta));
         double cosTheta = std::cos(rad(theta));
@@ -425,7 +436,7 @@ void TreeVLayout::buildPlatformMesh(FsNode* dnode, double r0,
         theta += segArcWidth;
     }
 
-    float z1 = static_cast<float>(dnode->treevGeom.platform.height);
+    float z1 = static_cast<float>(dnode->treevGeom().platform.height);
 
     glm::vec3 col(0.7f, 0.7f, 0.7f);
     if (dnode->color) {
@@ -435,10 +446,10 @@ void TreeVLayout::buildPlatformMesh(FsNode* dnode, double r0,
     // Helper lambda to add a quad
     auto addQuad = [&](glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, glm::vec3 v3, glm::vec3 n) {
         uint32_t base = static_cast<uint32_t>(vertices.size());
-        vertices.push_back({v0, n, col, glm::vec2(0.0f)});
-        vertices.push_back({v1, n, col, glm::vec2(0.0f)});
-        vertices.push_back({v2, n, col, glm::vec2(0.0f)});
-        vertices.push_back({v3, n, col, glm::vec2(0.0f)});
+        vertices.push_back({v0, n, col});
+        vertices.push_back({v1, n, col});
+        vertices.push_back({v2, n, col});
+        vertices.push_back({v3, n, col});
         indices.push_back(base + 0); indices.push_back(base + 1); indices.push_back(base + 2);
         indices.push_back(base + 0); indices.push_back(base + 2); indices.push_back(base + 3);
     };
@@ -521,13 +532,13 @@ void TreeVLayout::buildPlatformMesh(FsNode* dnode, double r0,
 // ============================================================================
 
 void TreeVLayout::buildLeafMesh(FsNode* node, double r0, bool fullNode,
-                                std::vector<Vertex>& vertices,
+                                std::vector<PackedVertex>& vertices,
                                 std::vector<uint32_t>& indices) {
     double edge, height;
 
     if (fullNode) {
         edge = LEAF_NODE_EDGE;
-        height = node->treevGeom.leaf.height;
+        height = node->treevGeom().leaf.height;
         if (node->isDir())
             height *= (1.0 - node->deployment);
     } else {
@@ -537,7 +548,7 @@ void TreeVLayout::buildLeafMesh(FsNode* node, double r0, bool fullNode,
 
     // Set up corners, centered around (r0+distance, 0, 0)
     XYvec corners[4];
-    corners[0].x = r0 + node->treevGeom.leaf.distance - 0.5 * edge;
+    corners[0].x = r0 + node->treevGeom().leaf.distance - 0.5 * edge;
     corners[0].y = -0.5 * edge;
     corners[1].x = corners[0].x + edge;
     corners[1].y = corners[0].y;
@@ -547,11 +558,11 @@ void TreeVLayout::buildLeafMesh(FsNode* node, double r0, bool fullNode,
     corners[3].y = corners[2].y;
 
     // Bottom and top
-    float z0f = static_cast<float>(node->parent ? node->parent->treevGeom.platform.height : 0.0);
+    float z0f = static_cast<float>(node->parent ? node->parent->treevGeom().platform.height : 0.0);
     float z1f = z0f + static_cast<float>(height);
 
-    double sinTheta = std::sin(rad(node->treevGeom.leaf.theta));
-    double cosTheta = std::cos(rad(node->treevGeom.leaf.theta));
+    double sinTheta = std::sin(rad(node->treevGeom().leaf.theta));
+    double cosTheta = std::cos(rad(node->treevGeom().leaf.theta));
 
     // Rotate corners into position
     XYvec rotated[4];
@@ -567,10 +578,10 @@ void TreeVLayout::buildLeafMesh(FsNode* node, double r0, bool fullNode,
 
     auto addQuad = [&](glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, glm::vec3 v3, glm::vec3 n) {
         uint32_t base = static_cast<uint32_t>(vertices.size());
-        vertices.push_back({v0, n, col, glm::vec2(0.0f)});
-        vertices.push_back({v1, n, col, glm::vec2(0.0f)});
-        vertices.push_back({v2, n, col, glm::vec2(0.0f)});
-        vertices.push_back({v3, n, col, glm::vec2(0.0f)});
+        vertices.push_back({v0, n, col});
+        vertices.push_back({v1, n, col});
+        vertices.push_back({v2, n, col});
+        vertices.push_back({v3, n, col});
         indices.push_back(base + 0); indices.push_back(base + 1); indices.push_back(base + 2);
         indices.push_back(base + 0); indices.push_back(base + 2); indices.push_back(base + 3);
     };
@@ -635,7 +646,7 @@ void TreeVLayout::buildLeafMesh(FsNode* node, double r0, bool fullNode,
 // ============================================================================
 
 void TreeVLayout::buildFolderMesh(FsNode* dnode, double r0,
-                                  std::vector<Vertex>& vertices,
+                                  std::vector<PackedVertex>& vertices,
                                   std::vector<uint32_t>& indices) {
     assert(dnode->isDir());
 
@@ -653,11 +664,11 @@ void TreeVLayout::buildFolderMesh(FsNode* dnode, double r0,
         { X3, Y4 }, { X2, Y5 }, { X1, Y5 }
     };
 
-    double folderR = r0 + dnode->treevGeom.leaf.distance;
-    double sinTheta = std::sin(rad(dnode->treevGeom.leaf.theta));
-    double cosTheta = std::cos(rad(dnode->treevGeom.leaf.theta));
-    float z = static_cast<float>((1.0 - dnode->deployment) * dnode->treevGeom.leaf.height
-              + (dnode->parent ? dnode->parent->treevGeom.platform.height : 0.0));
+    double folderR = r0 + dnode->treevGeom().leaf.distance;
+    double sinTheta = std::sin(rad(dnode->treevGeom().leaf.theta));
+    double cosTheta = std::cos(rad(dnode->treevGeom().leaf.theta));
+    float z = static_cast<float>((1.0 - dnode->deployment) * dnode->treevGeom().leaf.height
+              + (dnode->parent ? dnode->parent->treevGeom().platform.height : 0.0));
 
     glm::vec3 col(0.7f, 0.7f, 0.7f);
     if (dnode->color) {
@@ -689,10 +700,10 @@ void TreeVLayout::buildFolderMesh(FsNode* dnode, double r0,
         float ny = dx / len * lineWidth;
 
         uint32_t base = static_cast<uint32_t>(vertices.size());
-        vertices.push_back({glm::vec3(rx0 + nx, ry0 + ny, z), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(rx0 - nx, ry0 - ny, z), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(rx1 + nx, ry1 + ny, z), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(rx1 - nx, ry1 - ny, z), nUp, col, glm::vec2(0.0f)});
+        vertices.push_back({glm::vec3(rx0 + nx, ry0 + ny, z), nUp, col});
+        vertices.push_back({glm::vec3(rx0 - nx, ry0 - ny, z), nUp, col});
+        vertices.push_back({glm::vec3(rx1 + nx, ry1 + ny, z), nUp, col});
+        vertices.push_back({glm::vec3(rx1 - nx, ry1 - ny, z), nUp, col});
 
         indices.push_back(base + 0); indices.push_back(base + 1); indices.push_back(base + 2);
         indices.push_back(base + 2); indices.push_back(base + 1); indices.push_back(base + 3);
@@ -704,7 +715,7 @@ void TreeVLayout::buildFolderMesh(FsNode* dnode, double r0,
 // ============================================================================
 
 void TreeVLayout::buildBranchLoop(double loopR,
-                                  std::vector<Vertex>& vertices,
+                                  std::vector<PackedVertex>& vertices,
                                   std::vector<uint32_t>& indices) {
     int segCount = static_cast<int>(360.0 / CURVE_GRANULARITY + 0.5);
     double loopR0 = loopR - 0.5 * BRANCH_WIDTH;
@@ -721,10 +732,10 @@ void TreeVLayout::buildBranchLoop(double loopR,
         double st1 = std::sin(rad(theta1)), ct1 = std::cos(rad(theta1));
 
         uint32_t base = static_cast<uint32_t>(vertices.size());
-        vertices.push_back({glm::vec3(float(loopR0 * ct0), float(loopR0 * st0), 0.0f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(float(loopR1 * ct0), float(loopR1 * st0), 0.0f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(float(loopR0 * ct1), float(loopR0 * st1), 0.0f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(float(loopR1 * ct1), float(loopR1 * st1), 0.0f), nUp, col, glm::vec2(0.0f)});
+        vertices.push_back({glm::vec3(float(loopR0 * ct0), float(loopR0 * st0), 0.0f), nUp, col});
+        vertices.push_back({glm::vec3(float(loopR1 * ct0), float(loopR1 * st0), 0.0f), nUp, col});
+        vertices.push_back({glm::vec3(float(loopR0 * ct1), float(loopR0 * st1), 0.0f), nUp, col});
+        vertices.push_back({glm::vec3(float(loopR1 * ct1), float(loopR1 * st1), 0.0f), nUp, col});
 
         indices.push_back(base + 0); indices.push_back(base + 1); indices.push_back(base + 2);
         indices.push_back(base + 2); indices.push_back(base + 1); indices.push_back(base + 3);
@@ -736,7 +747,7 @@ void TreeVLayout::buildBranchLoop(double loopR,
 // ============================================================================
 
 void TreeVLayout::buildInBranch(double r0,
-                                std::vector<Vertex>& vertices,
+                                std::vector<PackedVertex>& vertices,
                                 std::vector<uint32_t>& indices) {
     float c0x = static_cast<float>(r0 - 0.5 * PLATFORM_SPACING_DEPTH);
     float c0y = static_cast<float>(-0.5 * BRANCH_WIDTH);
@@ -747,10 +758,10 @@ void TreeVLayout::buildInBranch(double r0,
     glm::vec3 nUp(0.0f, 0.0f, 1.0f);
 
     uint32_t base = static_cast<uint32_t>(vertices.size());
-    vertices.push_back({glm::vec3(c0x, c0y, 0.0f), nUp, col, glm::vec2(0.0f)});
-    vertices.push_back({glm::vec3(c1x, c0y, 0.0f), nUp, col, glm::vec2(0.0f)});
-    vertices.push_back({glm::vec3(c1x, c1y, 0.0f), nUp, col, glm::vec2(0.0f)});
-    vertices.push_back({glm::vec3(c0x, c1y, 0.0f), nUp, col, glm::vec2(0.0f)});
+    vertices.push_back({glm::vec3(c0x, c0y, 0.0f), nUp, col});
+    vertices.push_back({glm::vec3(c1x, c0y, 0.0f), nUp, col});
+    vertices.push_back({glm::vec3(c1x, c1y, 0.0f), nUp, col});
+    vertices.push_back({glm::vec3(c0x, c1y, 0.0f), nUp, col});
 
     indices.push_back(base + 0); indices.push_back(base + 1); indices.push_back(base + 2);
     indices.push_back(base + 0); indices.push_back(base + 2); indices.push_back(base + 3);
@@ -761,7 +772,7 @@ void TreeVLayout::buildInBranch(double r0,
 // ============================================================================
 
 void TreeVLayout::buildOutBranch(double r1, double theta0, double theta1,
-                                 std::vector<Vertex>& vertices,
+                                 std::vector<PackedVertex>& vertices,
                                  std::vector<uint32_t>& indices) {
     assert(theta1 >= theta0);
 
@@ -780,10 +791,10 @@ void TreeVLayout::buildOutBranch(double r1, double theta0, double theta1,
         float sy1 = static_cast<float>(0.5 * BRANCH_WIDTH);
 
         uint32_t base = static_cast<uint32_t>(vertices.size());
-        vertices.push_back({glm::vec3(sx0, sy0, 0.0f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(sx1, sy0, 0.0f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(sx1, sy1, 0.0f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(sx0, sy1, 0.0f), nUp, col, glm::vec2(0.0f)});
+        vertices.push_back({glm::vec3(sx0, sy0, 0.0f), nUp, col});
+        vertices.push_back({glm::vec3(sx1, sy0, 0.0f), nUp, col});
+        vertices.push_back({glm::vec3(sx1, sy1, 0.0f), nUp, col});
+        vertices.push_back({glm::vec3(sx0, sy1, 0.0f), nUp, col});
 
         indices.push_back(base + 0); indices.push_back(base + 1); indices.push_back(base + 2);
         indices.push_back(base + 0); indices.push_back(base + 2); indices.push_back(base + 3);
@@ -807,10 +818,10 @@ void TreeVLayout::buildOutBranch(double r1, double theta0, double theta1,
         double st1 = std::sin(rad(t1)), ct1 = std::cos(rad(t1));
 
         uint32_t base = static_cast<uint32_t>(vertices.size());
-        vertices.push_back({glm::vec3(float(arcR0 * ct0), float(arcR0 * st0), 0.0f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(float(arcR1 * ct0), float(arcR1 * st0), 0.0f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(float(arcR0 * ct1), float(arcR0 * st1), 0.0f), nUp, col, glm::vec2(0.0f)});
-        vertices.push_back({glm::vec3(float(arcR1 * ct1), float(arcR1 * st1), 0.0f), nUp, col, glm::vec2(0.0f)});
+        vertices.push_back({glm::vec3(float(arcR0 * ct0), float(arcR0 * st0), 0.0f), nUp, col});
+        vertices.push_back({glm::vec3(float(arcR1 * ct0), float(arcR1 * st0), 0.0f), nUp, col});
+        vertices.push_back({glm::vec3(float(arcR0 * ct1), float(arcR0 * st1), 0.0f), nUp, col});
+        vertices.push_back({glm::vec3(float(arcR1 * ct1), float(arcR1 * st1), 0.0f), nUp, col});
 
         indices.push_back(base + 0); indices.push_back(base + 1); indices.push_back(base + 2);
         indices.push_back(base + 2); indices.push_back(base + 1); indices.push_back(base + 3);
@@ -822,7 +833,7 @@ void TreeVLayout::buildOutBranch(double r1, double theta0, double theta1,
 // ============================================================================
 
 void TreeVLayout::buildDir(FsNode* dnode, double r0,
-                           std::vector<Vertex>& vertices,
+                           std::vector<PackedVertex>& vertices,
                            std::vector<uint32_t>& indices) {
     static constexpr double edge05 = 0.5 * LEAF_NODE_EDGE;
     static constexpr double edge15 = 1.5 * LEAF_NODE_EDGE;
@@ -841,7 +852,7 @@ void TreeVLayout::buildDir(FsNode* dnode, double r0,
         FsNode* node = dnode->children[childIdx].get();
 
         // Calculate available arc length of row
-        double arcLen = (PI / 180.0) * pos.r * dnode->treevGeom.platform.arc_width
+        double arcLen = (PI / 180.0) * pos.r * dnode->treevGeom().platform.arc_width
                         - PLATFORM_SPACING_WIDTH;
         // Number of nodes this row can accommodate
         int rowNodeCount = static_cast<int>(std::floor((arcLen - edge05) / edge15));
@@ -855,8 +866,14 @@ void TreeVLayout::buildDir(FsNode* dnode, double r0,
 
         for (int n = 0; (n < rowNodeCount) && (childIdx >= 0); ++n) {
             node = dnode->children[childIdx].get();
-            node->treevGeom.leaf.theta = pos.theta;
-            node->treevGeom.leaf.distance = pos.r - r0;
+            auto& leaf = node->treevGeom().leaf;
+            if (node->isDir() && (leaf.theta != pos.theta || leaf.distance != pos.r - r0)) {
+                // Subdirectories draw their own leaf, which has moved
+                node->aDlistStale = true;
+                node->cDlistStale = true;
+            }
+            leaf.theta = pos.theta;
+            leaf.distance = pos.r - r0;
 
             // Build leaf mesh - full node for non-dirs, footprint for collapsed dirs
             buildLeafMesh(node, r0, !node->isDir(), vertices, indices);
@@ -871,7 +888,7 @@ void TreeVLayout::buildDir(FsNode* dnode, double r0,
 
     // Official directory depth
     pos.r -= edge05;
-    dnode->treevGeom.platform.depth = pos.r - r0;
+    dnode->treevGeom().platform.depth = pos.r - r0;
 
     // Draw underlying directory platform
     buildPlatformMesh(dnode, r0, vertices, indices);
@@ -881,15 +898,14 @@ void TreeVLayout::buildDir(FsNode* dnode, double r0,
 // drawRecursive - port of treev_draw_recursive
 // ============================================================================
 
-bool TreeVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
-                                const glm::mat4& proj,
-                                double prevR0, double r0, bool withBranches) {
+bool TreeVLayout::drawRecursive(FsNode* dnode, double prevR0, double r0, bool withBranches) {
     assert(dnode->isDir() || dnode->isMetanode());
 
     GeometryManager& gm = GeometryManager::instance();
     MatrixStack& ms = gm.modelStack();
 
     ms.push();
+    gm.beginSubtree(dnode);
 
     bool dirCollapsed = dnode->isCollapsed();
     bool dirExpanded = dnode->isExpanded();
@@ -898,30 +914,19 @@ bool TreeVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
         if (!dirExpanded) {
             // Directory is partially deployed
             // Draw the shrinking/growing leaf
-            {
-                std::vector<Vertex> verts;
+            const MeshBuffer* mesh = gm.cachedMesh(dnode, GeometryManager::MESH_C, prevR0);
+            if (!mesh) {
+                std::vector<PackedVertex> verts;
                 std::vector<uint32_t> inds;
                 buildLeafMesh(dnode, prevR0, true, verts, inds);
                 buildFolderMesh(dnode, prevR0, verts, inds);
-
-                if (!verts.empty()) {
-                    float nodeGlow = ThemeManager::instance().currentTheme().baseEmissive + dnode->glowIntensity;
-                    ShaderProgram& shader = Renderer::instance().getNodeShader();
-                    shader.use();
-                    shader.setMat4("uModel", ms.top());
-                    shader.setMat4("uView", view);
-                    shader.setMat4("uProjection", proj);
-                    shader.setFloat("uGlowIntensity", nodeGlow);
-
-                    MeshBuffer mesh;
-                    mesh.upload(verts, inds);
-                    mesh.draw(GL_TRIANGLES);
-                }
+                mesh = gm.storeMesh(dnode, GeometryManager::MESH_C, verts, inds, prevR0);
             }
+            gm.drawMesh(mesh, dnode);
 
             // Platform should shrink to/grow from corresponding leaf position
-            double leafR = prevR0 + dnode->treevGeom.leaf.distance;
-            double leafTheta = dnode->treevGeom.leaf.theta;
+            double leafR = prevR0 + dnode->treevGeom().leaf.distance;
+            double leafTheta = dnode->treevGeom().leaf.theta;
             ms.rotate(static_cast<float>(leafTheta), 0.0f, 0.0f, 1.0f);
             ms.translate(static_cast<float>(leafR), 0.0f, 0.0f);
             float dep = static_cast<float>(dnode->deployment);
@@ -930,12 +935,15 @@ bool TreeVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
             ms.rotate(static_cast<float>(-leafTheta), 0.0f, 0.0f, 1.0f);
         }
 
-        ms.rotate(static_cast<float>(dnode->treevGeom.platform.theta), 0.0f, 0.0f, 1.0f);
+        ms.rotate(static_cast<float>(dnode->treevGeom().platform.theta), 0.0f, 0.0f, 1.0f);
     }
 
-    // Draw directory in either leaf or platform form
-    if (dnode->aDlistStale || true) {
-        std::vector<Vertex> verts;
+    // Draw directory in either leaf or platform form. Both are built at
+    // absolute radii, so a mesh built at another r0 is stale too.
+    double formR0 = dirCollapsed ? prevR0 : r0;
+    const MeshBuffer* mesh = gm.cachedMesh(dnode, GeometryManager::MESH_A, formR0);
+    if (!mesh) {
+        std::vector<PackedVertex> verts;
         std::vector<uint32_t> inds;
 
         if (dirCollapsed) {
@@ -947,34 +955,21 @@ bool TreeVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
             buildDir(dnode, r0, verts, inds);
         }
 
-        if (!verts.empty()) {
-            float nodeGlow = ThemeManager::instance().currentTheme().baseEmissive + dnode->glowIntensity;
-            ShaderProgram& shader = Renderer::instance().getNodeShader();
-            shader.use();
-            shader.setMat4("uModel", ms.top());
-            shader.setMat4("uView", view);
-            shader.setMat4("uProjection", proj);
-            shader.setFloat("uGlowIntensity", nodeGlow);
-
-            MeshBuffer mesh;
-            mesh.upload(verts, inds);
-            mesh.draw(GL_TRIANGLES);
-        }
-
-        dnode->aDlistStale = false;
+        mesh = gm.storeMesh(dnode, GeometryManager::MESH_A, verts, inds, formR0);
     }
+    gm.drawMesh(mesh, dnode);
 
     FsNode* firstNode = nullptr;
     FsNode* lastNode = nullptr;
 
     if (!dirCollapsed) {
         // Recurse into subdirectories
-        double subtreeR0 = r0 + dnode->treevGeom.platform.depth + PLATFORM_SPACING_DEPTH;
+        double subtreeR0 = r0 + dnode->treevGeom().platform.depth + PLATFORM_SPACING_DEPTH;
         for (auto& childPtr : dnode->children) {
             FsNode* node = childPtr.get();
             if (!node->isDir())
                 break;
-            if (drawRecursive(node, view, proj, r0, subtreeR0, withBranches)) {
+            if (drawRecursive(node, r0, subtreeR0, withBranches)) {
                 if (firstNode == nullptr)
                     firstNode = node;
                 lastNode = node;
@@ -984,42 +979,33 @@ bool TreeVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
 
     if (dirExpanded && withBranches) {
         // Draw interconnecting branches
-        std::vector<Vertex> branchVerts;
-        std::vector<uint32_t> branchInds;
-
-        if (dnode->isMetanode()) {
-            buildBranchLoop(r0, branchVerts, branchInds);
-            buildOutBranch(r0, 0.0, 0.0, branchVerts, branchInds);
-        } else {
-            buildInBranch(r0, branchVerts, branchInds);
-            if (firstNode != nullptr) {
-                double t0 = std::min(0.0, firstNode->treevGeom.platform.theta);
-                double t1 = std::max(0.0, lastNode->treevGeom.platform.theta);
-                buildOutBranch(r0 + dnode->treevGeom.platform.depth,
-                               t0, t1, branchVerts, branchInds);
+        const MeshBuffer* mesh = gm.cachedMesh(dnode, GeometryManager::MESH_B, r0);
+        if (!mesh) {
+            std::vector<PackedVertex> branchVerts;
+            std::vector<uint32_t> branchInds;
+
+            if (dnode->isMetanode()) {
+                buildBranchLoop(r0, branchVerts, branchInds);
+                buildOutBranch(r0, 0.0, 0.0, branchVerts, branchInds);
+            } else {
+                buildInBranch(r0, branchVerts, branchInds);
+                if (firstNode != nullptr) {
+                    double t0 = std::min(0.0, firstNode->treevGeom().platform.theta);
+                    double t1 = std::max(0.0, lastNode->treevGeom().platform.theta);
+                    buildOutBranch(r0 + dnode->treevGeom().platform.depth,
+                                   t0, t1, branchVerts, branchInds);
+                }
             }
-        }
 
-        if (!branchVerts.empty()) {
-            float nodeGlow = ThemeManager::instance().currentTheme().baseEmissive + dnode->glowIntensity;
-            ShaderProgram& shader = Renderer::instance().getNodeShader();
-            shader.use();
-            shader.setMat4("uModel", ms.top());
-            shader.setMat4("uView", view);
-            shader.setMat4("uProjection", proj);
-            shader.setFloat("uGlowIntensity", nodeGlow);
-
-            MeshBuffer mesh;
-            mesh.upload(branchVerts, branchInds);
-            mesh.draw(GL_TRIANGLES);
+            mesh = gm.storeMesh(dnode, GeometryManager::MESH_B, branchVerts, branchInds, r0);
         }
-
-        dnode->bDlistStale = false;
+        gm.drawMesh(mesh, dnode);
     }
 
     // Update geometry status
     dnode->geomExpanded = !dirCollapsed;
 
+    gm.endSubtree(dnode);
     ms.pop();
 
     return dirExpanded;
@@ -1029,7 +1015,7 @@ bool TreeVLayout::drawRecursive(FsNode* dnode, const glm::mat4& view,
 // draw - port of treev_draw
 // ============================================================================
 
-void TreeVLayout::draw(const glm::mat4& view, const glm::mat4& projection, bool highDetail) {
+void TreeVLayout::draw(bool highDetail) {
     FsNode* rootDir = FsTree::instance().rootDir();
     if (!rootDir) return;
 
@@ -1044,14 +1030,14 @@ void TreeVLayout::draw(const glm::mat4& view, const glm::mat4& projection, bool
 
     // Draw starting from rootDir (skip metanode so children fill first ring)
     double rootR0 = coreRadius_ + PLATFORM_SPACING_DEPTH;
-    drawRecursive(rootDir, view, projection, 0.0, rootR0, true);
+    drawRecursive(rootDir, 0.0, rootR0, true);
 
     if (highDetail) {
         // Labels and cursor drawing deferred to TextRenderer integration
     }
 }
 
-void TreeVLayout::drawForPicking(const glm::mat4& view, const glm::mat4& projection) {
+void TreeVLayout::drawForPicking() {
     FsNode* rootDir = FsTree::instance().rootDir();
     if (!rootDir) return;
 
@@ -1059,7 +1045,7 @@ void TreeVLayout::drawForPicking(const glm::mat4& view, const glm::mat4& project
     gm.modelStack().loadIdentity();
 
     double rootR0 = coreRadius_ + PLATFORM_SPACING_DEPTH;
-    drawRecursive(rootDir, view, projection, 0.0, rootR0, false);
+    drawRecursive(rootDir, 0.0, rootR0, false);
 }
 
 } // namespace fsvng
@@ -15,12 +15,16 @@ public:
     static TreeVLayout& instance();
 
     void init();
-    void draw(const glm::mat4& view, const glm::mat4& projection, bool highDetail);
-    void drawForPicking(const glm::mat4& view, const glm::mat4& projection);
+    void draw(bool highDetail);
+    void drawForPicking();
 
     void cameraPanFinished();
     void queueRearrange(FsNode* dnode);
 
+    // Re-lay out dnode's children after they changed; the new arc widths
+    // propagate outward on the next arrange.
+    void relayoutDir(FsNode* dnode);
+
     // Public wrapper for GeometryManager to call
     void reshapePlatformPublic(FsNode* dnode, double r0) { reshapePlatform(dnode, r0); }
 
@@ -51,30 +55,29 @@ private:
     void arrangeRecursive(FsNode* dnode, double r0, bool reshapeTree);
     void arrange(bool initialArrange);
 
-    bool drawRecursive(FsNode* dnode, const glm::mat4& view, const glm::mat4& proj,
-                       double prevR0, double r0, bool withBranches);
+    bool drawRecursive(FsNode* dnode, double prevR0, double r0, bool withBranches);
     void buildPlatformMesh(FsNode* dnode, double r0,
-                           std::vector<Vertex>& vertices,
+                           std::vector<PackedVertex>& vertices,
                            std::vector<uint32_t>& indices);
     void buildLeafMesh(FsNode* node, double r0, bool fullNode,
-                       std::vector<Vertex>& vertices,
+                       std::vector<PackedVertex>& vertices,
                        std::vector<uint32_t>& indices);
     void buildBranchLoop(double loopR,
-                         std::vector<Vertex>& vertices,
+                         std::vector<PackedVertex>& vertices,
                          std::vector<uint32_t>& indices);
     void buildInBranch(double r0,
-                       std::vector<Vertex>& vertices,
+                       std::vector<PackedVertex>& vertices,
                        std::vector<uint32_t>& indices);
     void buildOutBranch(double r1, double theta0, double theta1,
-                        std::vector<Vertex>& vertices,
+                        std::vector<PackedVertex>& vertices,
                         std::vector<uint32_t>& indices);
     void buildFolderMesh(FsNode* dnode, double r0,
-                         std::vector<Vertex>& vertices,
+                         std::vector<PackedVertex>& vertices,
                          std::vector<uint32_t>& indices);
 
     // Build leaf nodes onto a directory and lay them out in rows
     void buildDir(FsNode* dnode, double r0,
-                  std::vector<Vertex>& vertices,
+                  std::vector<PackedVertex>& vertices,
                   std::vector<uint32_t>& indices);
 
     void getCorners(FsNode* node, RTZvec* c0, RTZvec* c1) const;
@@ -1,9 +1,14 @@
 #include "MeshBuffer.h"
+#include "PackedVertex.h"
 
 #include <cstddef>
 
 namespace fsvng {
 
+// ============================================================================
+// MeshBuffer
+// ============================================================================
+
 MeshBuffer::~MeshBuffer() {
     destroy();
 }
@@ -14,6 +19,7 @@ MeshBuffer::MeshBuffer(MeshBuffer&& other) noexcept
     , ebo_(other.ebo_)
     , vertexCount_(other.vertexCount_)
     , indexCount_(other.indexCount_)
+    , format_(other.format_)
 {
     other.vao_ = 0;
     other.vbo_ = 0;
@@ -30,6 +36,7 @@ MeshBuffer& MeshBuffer::operator=(MeshBuffer&& other) noexcept {
         ebo_ = other.ebo_;
         vertexCount_ = other.vertexCount_;
         indexCount_ = other.indexCount_;
+        format_ = other.format_;
         other.vao_ = 0;
         other.vbo_ = 0;
         other.ebo_ = 0;
@@ -41,22 +48,30 @@ MeshBuffer& MeshBuffer::operator=(MeshBuffer&& other) noexcept {
 
 void MeshBuffer::upload(const std::vector<Vertex>& vertices,
                         const std::vector<uint32_t>& indices) {
-    uploadInternal(vertices, indices, GL_STATIC_DRAW);
+    uploadInternal(vertices.data(), vertices.size(), VertexFormat::Full, indices, GL_STATIC_DRAW);
+}
+
+void MeshBuffer::upload(const std::vector<PackedVertex>& vertices,
+                        const std::vector<uint32_t>& indices) {
+    uploadInternal(vertices.data(), vertices.size(), VertexFormat::Packed, indices,
+                   GL_STATIC_DRAW);
 }
 
 void MeshBuffer::uploadDynamic(const std::vector<Vertex>& vertices,
                                const std::vector<uint32_t>& indices) {
-    uploadInternal(vertices, indices, GL_DYNAMIC_DRAW);
+    uploadInternal(vertices.data(), vertices.size(), VertexFormat::Full, indices,
+                   GL_DYNAMIC_DRAW);
 }
 
-void MeshBuffer::uploadInternal(const std::vector<Vertex>& vertices,
-                                const std::vector<uint32_t>& indices,
-                                GLenum usage) {
+void MeshBuffer::uploadInternal(const void* vertices, size_t vertexCount, VertexFormat format,
+                                const std::vector<uint32_t>& indices, GLenum usage) {
     // Clean up any existing buffers
     destroy();
 
-    vertexCount_ = static_cast<int>(vertices.size());
+    vertexCount_ = static_cast<int>(vertexCount);
     indexCount_ = static_cast<int>(indices.size());
+    format_ = format;
+    size_t stride = (format == VertexFormat::Packed) ? sizeof(PackedVertex) : sizeof(Vertex);
 
     // Generate VAO
     glGenVertexArrays(1, &vao_);
@@ -66,8 +81,8 @@ void MeshBuffer::uploadInternal(const std::vector<Vertex>& vertices,
     glGenBuffers(1, &vbo_);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
     glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)),
-                 vertices.data(),
+                 static_cast<GLsizeiptr>(vertexCount * stride),
+                 vertices,
                  usage);
 
     // Generate and upload EBO if indices provided
@@ -93,7 +108,7 @@ void MeshBuffer::uploadInternal(const std::vector<Vertex>& vertices,
 }
 
 void MeshBuffer::update(const std::vector<Vertex>& vertices) {
-    if (vbo_ == 0) {
+    if (vbo_ == 0 || format_ != VertexFormat::Full) {
         return;
     }
 
@@ -139,6 +154,22 @@ void MeshBuffer::drawInstanced(int count, GLenum mode) const {
     glBindVertexArray(0);
 }
 
+void MeshBuffer::addInstanceAttrib(GLuint location, GLuint buffer, GLint size, GLenum type,
+                                   bool normalized, GLsizei stride, size_t offset) {
+    if (vao_ == 0) {
+        return;
+    }
+
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, size, type, normalized ? GL_TRUE : GL_FALSE,
+                          stride, reinterpret_cast<void*>(offset));
+    glVertexAttribDivisor(location, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void MeshBuffer::destroy() {
     if (ebo_ != 0) {
         glDeleteBuffers(1, &ebo_);
@@ -157,6 +188,29 @@ void MeshBuffer::destroy() {
 }
 
 void MeshBuffer::setupVAO() {
+    if (format_ == VertexFormat::Packed) {
+        // Attribute 0: position (3 floats)
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
+                              sizeof(PackedVertex),
+                              reinterpret_cast<void*>(offsetof(PackedVertex, position)));
+
+        // Attribute 1: normal (signed normalized 2_10_10_10)
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE,
+                              sizeof(PackedVertex),
+                              reinterpret_cast<void*>(offsetof(PackedVertex, normal)));
+
+        // Attribute 2: color (4 normalized bytes)
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                              sizeof(PackedVertex),
+                              reinterpret_cast<void*>(offsetof(PackedVertex, color)));
+
+        // Attribute 3 (texcoord) stays disabled and reads as zero
+        return;
+    }
+
     // Attribute 0: position (3 floats)
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
@@ -182,4 +236,43 @@ void MeshBuffer::setupVAO() {
                           reinterpret_cast<void*>(offsetof(Vertex, texcoord)));
 }
 
+// ============================================================================
+// InstanceBuffer
+// ============================================================================
+
+InstanceBuffer::~InstanceBuffer() {
+    destroy();
+}
+
+void InstanceBuffer::create() {
+    if (vbo_ == 0) {
+        glGenBuffers(1, &vbo_);
+    }
+}
+
+void InstanceBuffer::upload(const void* data, size_t bytes) {
+    create();
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes), data, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::update(size_t offset, const void* data, size_t bytes) {
+    if (vbo_ == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset),
+                    static_cast<GLsizeiptr>(bytes), data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::destroy() {
+    if (vbo_ != 0) {
+        glDeleteBuffers(1, &vbo_);
+        vbo_ = 0;
+    }
+}
+
 } // namespace fsvng
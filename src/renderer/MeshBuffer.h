@@ -15,6 +15,14 @@ struct Vertex {
     glm::vec2 texcoord;
 };
 
+// Compact node vertex, see PackedVertex.h
+struct PackedVertex;
+
+enum class VertexFormat {
+    Full,    // Vertex
+    Packed   // PackedVertex
+};
+
 class MeshBuffer {
 public:
     MeshBuffer() = default;
@@ -31,32 +39,67 @@ public:
     // Upload vertex data (static draw hint)
     void upload(const std::vector<Vertex>& vertices,
                 const std::vector<uint32_t>& indices = {});
+    void upload(const std::vector<PackedVertex>& vertices,
+                const std::vector<uint32_t>& indices = {});
 
     // Upload with dynamic hint (for frequently updated meshes)
     void uploadDynamic(const std::vector<Vertex>& vertices,
                        const std::vector<uint32_t>& indices = {});
 
-    // Update existing buffer data (must have been uploaded first)
+    // Update existing buffer data (must have been uploaded first, as Vertex)
     void update(const std::vector<Vertex>& vertices);
 
     void draw(GLenum mode = GL_TRIANGLES) const;
     void drawInstanced(int count, GLenum mode = GL_TRIANGLES) const;
 
+    // Feed attribute location from buffer once per instance (must have
+    // been uploaded first). buffer keeps its name across re-uploads, so
+    // this is done once.
+    void addInstanceAttrib(GLuint location, GLuint buffer, GLint size, GLenum type,
+                           bool normalized, GLsizei stride, size_t offset);
+
     bool isValid() const { return vao_ != 0; }
+    VertexFormat format() const { return format_; }
 
     void destroy();
 
 private:
     void setupVAO();
-    void uploadInternal(const std::vector<Vertex>& vertices,
-                        const std::vector<uint32_t>& indices,
-                        GLenum usage);
+    void uploadInternal(const void* vertices, size_t vertexCount, VertexFormat format,
+                        const std::vector<uint32_t>& indices, GLenum usage);
 
     GLuint vao_ = 0;
     GLuint vbo_ = 0;
     GLuint ebo_ = 0;
     int vertexCount_ = 0;
     int indexCount_ = 0;
+    VertexFormat format_ = VertexFormat::Full;
+};
+
+// Per-instance attribute data for MeshBuffer::drawInstanced()
+class InstanceBuffer {
+public:
+    InstanceBuffer() = default;
+    ~InstanceBuffer();
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    // Create the buffer, empty, so attributes can point at it
+    void create();
+
+    // Replace the contents
+    void upload(const void* data, size_t bytes);
+
+    // Overwrite part of the contents
+    void update(size_t offset, const void* data, size_t bytes);
+
+    GLuint id() const { return vbo_; }
+
+    void destroy();
+
+private:
+    GLuint vbo_ = 0;
 };
 
 } // namespace fsvng
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace fsvng {
+
+// Compact vertex for node geometry (20 bytes against Vertex's 44): normal as
+// signed normalized 10-bit components (GL_INT_2_10_10_10_REV), colour as
+// RGBA8, no texcoord. Kept apart from MeshBuffer.h so only the layouts that
+// build vertices pay for these includes.
+struct PackedVertex {
+    glm::vec3 position;
+    uint32_t normal;
+    uint8_t color[4];
+
+    PackedVertex() = default;
+    PackedVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& color)
+        : position(position), normal(packNormal(normal)),
+          color{packUnorm8(color.x), packUnorm8(color.y), packUnorm8(color.z), 255} {}
+
+    // Layouts hand over unnormalized normals; only the direction survives
+    // lighting, so scale into [-1, 1] before quantizing
+    static uint32_t packNormal(const glm::vec3& normal) {
+        float len2 = normal.x * normal.x + normal.y * normal.y + normal.z * normal.z;
+        float scale = (len2 > 0.0f && len2 != 1.0f) ? 1.0f / std::sqrt(len2) : 1.0f;
+        return packSnorm10(normal.x * scale) | (packSnorm10(normal.y * scale) << 10) |
+               (packSnorm10(normal.z * scale) << 20);
+    }
+
+    // Round to nearest without a libm call; this runs for every vertex built
+    static int roundToInt(float v) {
+        return static_cast<int>(v >= 0.0f ? v + 0.5f : v - 0.5f);
+    }
+
+    static uint32_t packSnorm10(float v) {
+        return static_cast<uint32_t>(roundToInt(std::clamp(v, -1.0f, 1.0f) * 511.0f)) & 0x3FFu;
+    }
+
+    static uint8_t packUnorm8(float v) {
+        return static_cast<uint8_t>(roundToInt(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+    }
+};
+
+} // namespace fsvng
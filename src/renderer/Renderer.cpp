@@ -1,7 +1,9 @@
 #include "Renderer.h"
 
 #include <glm/gtc/matrix_transform.hpp>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
 namespace fsvng {
 
@@ -37,6 +39,12 @@ void Renderer::init() {
     // Load shader programs
     loadShaders();
 
+    // Per-frame uniform buffer, filled by setFrameUniforms()
+    glGenBuffers(1, &frameUbo_);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUbo_);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
     initialized_ = true;
 
     std::cout << "Renderer: Initialized" << std::endl;
@@ -52,6 +60,13 @@ void Renderer::shutdown() {
     pickingShader_ = ShaderProgram();
     textShader_ = ShaderProgram();
     cursorShader_ = ShaderProgram();
+    mapvBoxShader_ = ShaderProgram();
+    mapvFolderShader_ = ShaderProgram();
+
+    if (frameUbo_ != 0) {
+        glDeleteBuffers(1, &frameUbo_);
+        frameUbo_ = 0;
+    }
 
     initialized_ = false;
 
@@ -84,18 +99,19 @@ void Renderer::renderFrame(GLuint targetFBO, int width, int height) {
     // Set up model matrix (identity for world-space geometry)
     glm::mat4 model = glm::mat4(1.0f);
 
-    // Camera/eye position for specular calculations
-    glm::vec3 viewPos(0.0f, 500.0f, 1000.0f);
-
-    // Activate the node shader and set common uniforms
+    // Camera and lighting, with the eye position for specular calculations
+    FrameUniforms frame;
+    frame.view = view;
+    frame.projection = projection;
+    frame.lightPos = lightPos_;
+    frame.ambient = ambientColor_;
+    frame.diffuse = diffuseColor_;
+    frame.viewPos = glm::vec3(0.0f, 500.0f, 1000.0f);
+    setFrameUniforms(frame);
+
+    // Activate the node shader and set its per-draw uniforms
     nodeShader_.use();
-    nodeShader_.setMat4("uModel", model);
-    nodeShader_.setMat4("uView", view);
-    nodeShader_.setMat4("uProjection", projection);
-    nodeShader_.setVec3("uLightPos", lightPos_);
-    nodeShader_.setVec3("uAmbient", ambientColor_);
-    nodeShader_.setVec3("uDiffuse", diffuseColor_);
-    nodeShader_.setVec3("uViewPos", viewPos);
+    setNodeDrawUniforms(model, normalMatrixOf(model), 0.0f);
     nodeShader_.setFloat("uHighlight", 0.0f);
 
     // Scene geometry will be drawn by the GeometryManager (to be integrated).
@@ -108,7 +124,19 @@ void Renderer::loadShaders() {
     // Shader file paths (relative to working directory)
     const std::string shaderDir = "shaders/";
 
-    if (!nodeShader_.loadFromFiles(shaderDir + "node.vert", shaderDir + "node.frag")) {
+    // The one copy of the FrameUniforms block, spliced into every shader
+    // that reads it
+    std::string frameBlock;
+    std::ifstream frameFile(shaderDir + "frame_uniforms.glsl");
+    if (frameFile.is_open()) {
+        std::ostringstream frameStream;
+        frameStream << frameFile.rdbuf();
+        frameBlock = frameStream.str();
+    } else {
+        std::cerr << "Renderer: Failed to open " << shaderDir << "frame_uniforms.glsl" << std::endl;
+    }
+
+    if (!nodeShader_.loadFromFiles(shaderDir + "node.vert", shaderDir + "node.frag", frameBlock)) {
         std::cerr << "Renderer: Failed to load node shader" << std::endl;
     }
 
@@ -123,10 +151,51 @@ void Renderer::loadShaders() {
     if (!cursorShader_.loadFromFiles(shaderDir + "cursor.vert", shaderDir + "cursor.frag")) {
         std::cerr << "Renderer: Failed to load cursor shader" << std::endl;
     }
+
+    if (!mapvBoxShader_.loadFromFiles(shaderDir + "mapv_box.vert", shaderDir + "node.frag",
+                                    frameBlock)) {
+        std::cerr << "Renderer: Failed to load MapV box shader" << std::endl;
+    }
+
+    if (!mapvFolderShader_.loadFromFiles(shaderDir + "mapv_folder.vert", shaderDir + "node.frag",
+                                       frameBlock)) {
+        std::cerr << "Renderer: Failed to load MapV folder shader" << std::endl;
+    }
+
+    bindFrameBlock(nodeShader_);
+    bindFrameBlock(mapvBoxShader_);
+    bindFrameBlock(mapvFolderShader_);
+
+    nodeModelLoc_ = nodeShader_.uniformLocation("uModel");
+    nodeNormalMatrixLoc_ = nodeShader_.uniformLocation("uNormalMatrix");
+    nodeGlowLoc_ = nodeShader_.uniformLocation("uGlowIntensity");
+}
+
+void Renderer::bindFrameBlock(ShaderProgram& shader) {
+    shader.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
 }
 
 void Renderer::setLightPosition(const glm::vec3& pos) {
     lightPos_ = pos;
 }
 
+void Renderer::setFrameUniforms(const FrameUniforms& frame) {
+    frame_ = frame;
+    if (frameUbo_ == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUbo_);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, frameUbo_);
+}
+
+void Renderer::setNodeDrawUniforms(const glm::mat4& model, const glm::mat3& normalMatrix,
+                                   float glow) {
+    nodeShader_.setMat4(nodeModelLoc_, model);
+    nodeShader_.setMat3(nodeNormalMatrixLoc_, normalMatrix);
+    nodeShader_.setFloat(nodeGlowLoc_, glow);
+}
+
 } // namespace fsvng
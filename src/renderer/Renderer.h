@@ -5,8 +5,38 @@
 
 #include "ShaderProgram.h"
 
+#include <cstddef>
+
 namespace fsvng {
 
+// Per-frame camera and lighting data shared by the node shaders through a
+// uniform buffer; mirrors the std140 block in shaders/frame_uniforms.glsl
+struct FrameUniforms {
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::vec3 lightPos{0.0f};
+    float baseGlow = 0.0f;       // emissive added to every node
+    glm::vec3 ambient{0.0f};
+    float rimIntensity = 0.0f;
+    glm::vec3 diffuse{0.0f};
+    float rimPower = 0.0f;
+    glm::vec3 viewPos{0.0f};
+    float pad0 = 0.0f;
+    glm::vec3 glowColor{0.0f};
+    float pad1 = 0.0f;
+};
+static_assert(sizeof(FrameUniforms) == 208, "FrameUniforms must match the std140 block");
+static_assert(offsetof(FrameUniforms, lightPos) == 128 && offsetof(FrameUniforms, baseGlow) == 140 &&
+              offsetof(FrameUniforms, ambient) == 144 && offsetof(FrameUniforms, rimIntensity) == 156 &&
+              offsetof(FrameUniforms, diffuse) == 160 && offsetof(FrameUniforms, rimPower) == 172 &&
+              offsetof(FrameUniforms, viewPos) == 176 && offsetof(FrameUniforms, glowColor) == 192,
+              "FrameUniforms members must sit at their std140 offsets");
+
+// Normal matrix of an affine model matrix, for uNormalMatrix
+inline glm::mat3 normalMatrixOf(const glm::mat4& model) {
+    return glm::transpose(glm::inverse(glm::mat3(model)));
+}
+
 class Renderer {
 public:
     static Renderer& instance();
@@ -23,9 +53,26 @@ public:
     ShaderProgram& getTextShader() { return textShader_; }
     ShaderProgram& getCursorShader() { return cursorShader_; }
 
+    // Instanced MapV blocks and folder outlines (lit like the node shader)
+    ShaderProgram& getMapVBoxShader() { return mapvBoxShader_; }
+    ShaderProgram& getMapVFolderShader() { return mapvFolderShader_; }
+
     // Lighting
     void setLightPosition(const glm::vec3& pos);
 
+    // Upload this frame's camera and lighting and bind them for every
+    // shader using the FrameUniforms block
+    void setFrameUniforms(const FrameUniforms& frame);
+
+    // What the last setFrameUniforms() call uploaded
+    const FrameUniforms& frameUniforms() const { return frame_; }
+
+    // Per-draw uniforms of the node shader, which must be in use
+    void setNodeDrawUniforms(const glm::mat4& model, const glm::mat3& normalMatrix,
+                             float glow);
+
+    static constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+
 private:
     Renderer() = default;
     ~Renderer() = default;
@@ -35,11 +82,22 @@ private:
     Renderer& operator=(const Renderer&) = delete;
 
     void loadShaders();
+    void bindFrameBlock(ShaderProgram& shader);
 
     ShaderProgram nodeShader_;
     ShaderProgram pickingShader_;
     ShaderProgram textShader_;
     ShaderProgram cursorShader_;
+    ShaderProgram mapvBoxShader_;
+    ShaderProgram mapvFolderShader_;
+
+    GLuint frameUbo_ = 0;
+    FrameUniforms frame_;
+
+    // Node shader per-draw uniform locations
+    GLint nodeModelLoc_ = -1;
+    GLint nodeNormalMatrixLoc_ = -1;
+    GLint nodeGlowLoc_ = -1;
 
     glm::vec3 lightPos_{0.0f, 10000.0f, 10000.0f};
     glm::vec3 ambientColor_{0.2f, 0.2f, 0.2f};
@@ -32,7 +32,34 @@ ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other) noexcept {
     return *this;
 }
 
-bool ShaderProgram::loadFromFiles(const std::string& vertPath, const std::string& fragPath) {
+namespace {
+
+// Splice prelude in after the #version directive, which must stay first
+std::string withPrelude(const std::string& source, const std::string& prelude) {
+    if (prelude.empty()) {
+        return source;
+    }
+    size_t at = 0;
+    if (source.compare(0, 8, "#version") == 0) {
+        size_t eol = source.find('\n');
+        at = (eol == std::string::npos) ? source.size() : eol + 1;
+    }
+    std::string out = source.substr(0, at);
+    if (at > 0 && out.back() != '\n') {
+        out += '\n';
+    }
+    out += prelude;
+    if (out.back() != '\n') {
+        out += '\n';
+    }
+    out.append(source, at, std::string::npos);
+    return out;
+}
+
+} // namespace
+
+bool ShaderProgram::loadFromFiles(const std::string& vertPath, const std::string& fragPath,
+                                  const std::string& prelude) {
     // Read vertex shader file
     std::ifstream vertFile(vertPath);
     if (!vertFile.is_open()) {
@@ -53,7 +80,7 @@ bool ShaderProgram::loadFromFiles(const std::string& vertPath, const std::string
     fragStream << fragFile.rdbuf();
     std::string fragSrc = fragStream.str();
 
-    return loadFromSource(vertSrc, fragSrc);
+    return loadFromSource(withPrelude(vertSrc, prelude), withPrelude(fragSrc, prelude));
 }
 
 bool ShaderProgram::loadFromSource(const std::string& vertSrc, const std::string& fragSrc) {
@@ -149,6 +176,39 @@ void ShaderProgram::setMat4(const std::string& name, const glm::mat4& m) const {
     }
 }
 
+void ShaderProgram::setMat3(const std::string& name, const glm::mat3& m) const {
+    setMat3(getUniformLocation(name), m);
+}
+
+void ShaderProgram::setFloat(GLint location, float value) const {
+    if (location >= 0) {
+        glUniform1f(location, value);
+    }
+}
+
+void ShaderProgram::setMat3(GLint location, const glm::mat3& m) const {
+    if (location >= 0) {
+        glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(m));
+    }
+}
+
+void ShaderProgram::setMat4(GLint location, const glm::mat4& m) const {
+    if (location >= 0) {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(m));
+    }
+}
+
+void ShaderProgram::bindUniformBlock(const std::string& name, GLuint binding) const {
+    if (program_ == 0) {
+        return;
+    }
+
+    GLuint index = glGetUniformBlockIndex(program_, name.c_str());
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program_, index, binding);
+    }
+}
+
 GLuint ShaderProgram::compileShader(GLenum type, const std::string& source) {
     GLuint shader = glCreateShader(type);
     const char* src = source.c_str();
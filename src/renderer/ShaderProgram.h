@@ -23,7 +23,10 @@ public:
     ShaderProgram(ShaderProgram&& other) noexcept;
     ShaderProgram& operator=(ShaderProgram&& other) noexcept;
 
-    bool loadFromFiles(const std::string& vertPath, const std::string& fragPath);
+    // prelude, if given, goes right after each stage's #version line (shared
+    // declarations such as the FrameUniforms block)
+    bool loadFromFiles(const std::string& vertPath, const std::string& fragPath,
+                       const std::string& prelude = {});
     bool loadFromSource(const std::string& vertSrc, const std::string& fragSrc);
 
     void use() const;
@@ -36,8 +39,18 @@ public:
     void setFloat(const std::string& name, float value) const;
     void setVec3(const std::string& name, const glm::vec3& v) const;
     void setVec4(const std::string& name, const glm::vec4& v) const;
+    void setMat3(const std::string& name, const glm::mat3& m) const;
     void setMat4(const std::string& name, const glm::mat4& m) const;
 
+    // Setters by location, for uniforms set on every draw
+    GLint uniformLocation(const std::string& name) const { return getUniformLocation(name); }
+    void setFloat(GLint location, float value) const;
+    void setMat3(GLint location, const glm::mat3& m) const;
+    void setMat4(GLint location, const glm::mat4& m) const;
+
+    // Attach the named uniform block (if the program has it) to a binding point
+    void bindUniformBlock(const std::string& name, GLuint binding) const;
+
 private:
     GLuint program_ = 0;
     GLuint compileShader(GLenum type, const std::string& source);
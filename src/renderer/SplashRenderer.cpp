@@ -223,7 +223,7 @@ void SplashRenderer::draw(const glm::mat4& viewProj) {
     // Use the node shader for lit rendering
     ShaderProgram& shader = Renderer::instance().getNodeShader();
     shader.use();
-    shader.setMat4("uModel", model);
+    Renderer::instance().setNodeDrawUniforms(model, normalMatrixOf(model), 0.0f);
     shader.setFloat("uHighlight", 0.0f);
 
     logoMesh_.draw(GL_TRIANGLES);
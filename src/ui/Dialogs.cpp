@@ -9,9 +9,11 @@
 #endif
 
 #include "core/FsNode.h"
+#include "core/FsTree.h"
 #include "core/Types.h"
 #include "ui/MainWindow.h"
 #include "ui/DirTreePanel.h"
+#include "ui/StatusBar.h"
 #include "geometry/CollapseExpand.h"
 #include "camera/Camera.h"
 #include "app/Config.h"
@@ -41,6 +43,16 @@ void Dialogs::showSetDefaultPath() {
     }
 }
 
+void Dialogs::showSaveSnapshot() {
+    showSaveSnapshot_ = true;
+    std::memset(snapshotPathBuf_, 0, sizeof(snapshotPathBuf_));
+}
+
+void Dialogs::showCompareSnapshot() {
+    // Keep the last path: usually the snapshot just saved
+    showCompareSnapshot_ = true;
+}
+
 void Dialogs::showColorConfig() {
     showColorConfig_ = true;
 }
@@ -52,6 +64,8 @@ void Dialogs::showAbout() {
 void Dialogs::draw() {
     drawChangeRoot();
     drawSetDefaultPath();
+    drawSaveSnapshot();
+    drawCompareSnapshot();
     drawColorConfig();
     drawAbout();
     drawProperties();
@@ -138,6 +152,83 @@ void Dialogs::drawSetDefaultPath() {
     }
 }
 
+void Dialogs::drawSaveSnapshot() {
+    if (!showSaveSnapshot_) return;
+
+    ImGui::OpenPopup("Save Snapshot");
+
+    ImVec2 center = ImGui::GetMainViewport()->GetCenter();
+    ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+    ImGui::SetNextWindowSize(ImVec2(450.0f, 0.0f), ImGuiCond_Appearing);
+
+    if (ImGui::BeginPopupModal("Save Snapshot", &showSaveSnapshot_,
+                                ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::Text("Save the scanned tree to a snapshot file:");
+        ImGui::Separator();
+
+        ImGui::InputText("##SnapshotPath", snapshotPathBuf_, sizeof(snapshotPathBuf_));
+
+        ImGui::Spacing();
+
+        if (ImGui::Button("OK", ImVec2(120.0f, 0.0f))) {
+            std::string path(snapshotPathBuf_);
+            showSaveSnapshot_ = false;
+            ImGui::CloseCurrentPopup();
+            if (!path.empty()) {
+                std::string error;
+                if (FsTree::instance().saveSnapshot(path, &error)) {
+                    StatusBar::instance().setMessage("Snapshot saved", path);
+                } else {
+                    StatusBar::instance().setMessage("Snapshot error: " + error, "");
+                }
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", ImVec2(120.0f, 0.0f))) {
+            showSaveSnapshot_ = false;
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::EndPopup();
+    }
+}
+
+void Dialogs::drawCompareSnapshot() {
+    if (!showCompareSnapshot_) return;
+
+    ImGui::OpenPopup("Compare with Snapshot");
+
+    ImVec2 center = ImGui::GetMainViewport()->GetCenter();
+    ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+    ImGui::SetNextWindowSize(ImVec2(450.0f, 0.0f), ImGuiCond_Appearing);
+
+    if (ImGui::BeginPopupModal("Compare with Snapshot", &showCompareSnapshot_,
+                                ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::Text("Compare the scanned tree with an earlier snapshot:");
+        ImGui::Separator();
+
+        ImGui::InputText("##ComparePath", snapshotPathBuf_, sizeof(snapshotPathBuf_));
+
+        ImGui::Spacing();
+
+        if (ImGui::Button("OK", ImVec2(120.0f, 0.0f))) {
+            std::string path(snapshotPathBuf_);
+            showCompareSnapshot_ = false;
+            ImGui::CloseCurrentPopup();
+            if (!path.empty()) {
+                MainWindow::instance().compareWithSnapshot(path);
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", ImVec2(120.0f, 0.0f))) {
+            showCompareSnapshot_ = false;
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::EndPopup();
+    }
+}
+
 void Dialogs::drawColorConfig() {
     if (!showColorConfig_) return;
 
@@ -259,6 +350,13 @@ void Dialogs::drawContextMenuPopup(const char* popupId, FsNode* node) {
     }
 }
 
+void Dialogs::forgetSubtree(const FsNode* node) {
+    if (propertiesNode_ && propertiesNode_->isWithin(node)) {
+        propertiesNode_ = nullptr;
+        showProperties_ = false;
+    }
+}
+
 void Dialogs::drawProperties() {
     if (!showProperties_ || !propertiesNode_) return;
 
@@ -11,22 +11,31 @@ public:
 
     void showChangeRoot();
     void showSetDefaultPath();
+    void showSaveSnapshot();
+    void showCompareSnapshot();
     void showColorConfig();
     void showAbout();
     // Draw context menu popup items (call from within a window that opened the popup)
     void drawContextMenuPopup(const char* popupId, FsNode* node);
 
+    // Close the properties window if it shows node or anything below it
+    void forgetSubtree(const FsNode* node);
+
 private:
     Dialogs() = default;
 
     void drawChangeRoot();
     void drawSetDefaultPath();
+    void drawSaveSnapshot();
+    void drawCompareSnapshot();
     void drawColorConfig();
     void drawAbout();
     void drawProperties();
 
     bool showChangeRoot_ = false;
     bool showSetDefaultPath_ = false;
+    bool showSaveSnapshot_ = false;
+    bool showCompareSnapshot_ = false;
     bool showColorConfig_ = false;
     bool showAbout_ = false;
     bool showProperties_ = false;
@@ -34,6 +43,7 @@ private:
     FsNode* propertiesNode_ = nullptr;
     char rootPathBuf_[512] = {};
     char defaultPathBuf_[512] = {};
+    char snapshotPathBuf_[512] = {};  // shared by save and compare
 };
 
 } // namespace fsvng
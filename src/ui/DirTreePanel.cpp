@@ -41,9 +41,11 @@ void DirTreePanel::drawNode(FsNode* node) {
 
     ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanAvailWidth;
 
-    // Leaf nodes (non-directories or empty dirs) get the Leaf flag
-    bool hasChildren = false;
-    if (node->isDir()) {
+    // Leaf nodes (non-directories or empty dirs) get the Leaf flag.
+    // Placeholders from a lazy scan may have children once loaded.
+    bool unscanned = (node->flags & NODE_FLAG_UNSCANNED) != 0;
+    bool hasChildren = unscanned;
+    if (!hasChildren && node->isDir()) {
         for (auto& child : node->children) {
             if (child->isDir()) {
                 hasChildren = true;
@@ -84,6 +86,10 @@ void DirTreePanel::drawNode(FsNode* node) {
     // Track expansion state
     if (nodeOpen && hasChildren) {
         expandedNodes_.insert(node);
+        if (unscanned) {
+            MainWindow::instance().loadSubtree(node);
+            ImGui::TextDisabled("Scanning...");
+        }
         for (auto& child : node->children) {
             if (child->isDir()) {
                 drawNode(child.get());
@@ -116,4 +122,19 @@ void DirTreePanel::clearExpanded() {
     selectedNode_ = nullptr;
 }
 
+void DirTreePanel::forgetSubtree(const FsNode* node) {
+    for (auto it = expandedNodes_.begin(); it != expandedNodes_.end();) {
+        if ((*it)->isWithin(node))
+            it = expandedNodes_.erase(it);
+        else
+            ++it;
+    }
+    if (selectedNode_ && selectedNode_->isWithin(node))
+        selectedNode_ = nullptr;
+    if (contextMenuNode_ && contextMenuNode_->isWithin(node))
+        contextMenuNode_ = nullptr;
+    if (contextMenuNode_pending_ && contextMenuNode_pending_->isWithin(node))
+        contextMenuNode_pending_ = nullptr;
+}
+
 } // namespace fsvng
@@ -24,6 +24,10 @@ public:
     // Clear all expansion state (call before replacing the tree)
     void clearExpanded();
 
+    // Forget expanded entries, the selection and any context menu target
+    // inside node's subtree, which is about to be deleted
+    void forgetSubtree(const FsNode* node);
+
 private:
     DirTreePanel() = default;
     void drawNode(FsNode* node);
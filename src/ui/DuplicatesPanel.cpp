@@ -0,0 +1,142 @@
+#include "ui/DuplicatesPanel.h"
+
+#include <imgui.h>
+#include <algorithm>
+
+#include "ui/MainWindow.h"
+#include "core/DuplicateFinder.h"
+#include "core/FsTree.h"
+#include "core/FsNode.h"
+#include "core/PlatformUtils.h"
+
+namespace fsvng {
+
+DuplicatesPanel& DuplicatesPanel::instance() {
+    static DuplicatesPanel s;
+    return s;
+}
+
+static const char* stageName(DuplicateFinder::Stage stage) {
+    switch (stage) {
+        case DuplicateFinder::Stage::Edges:    return "Comparing file edges";
+        case DuplicateFinder::Stage::Contents: return "Comparing contents";
+        default:                               return "Collecting files";
+    }
+}
+
+void DuplicatesPanel::draw() {
+    if (!ImGui::Begin("Duplicates")) {
+        ImGui::End();
+        return;
+    }
+
+    MainWindow& mw = MainWindow::instance();
+    FsTree& tree = FsTree::instance();
+    if (!tree.rootDir() || mw.isScanning()) {
+        ImGui::TextDisabled("No tree loaded");
+        ImGui::End();
+        return;
+    }
+
+    DuplicateFinder& finder = mw.duplicateFinder();
+    if (finder.isRunning()) {
+        if (ImGui::Button("Cancel")) {
+            finder.cancel();
+        }
+        DuplicateFinder::Progress progress = finder.progress();
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s: %s / %s files, %s read", stageName(progress.stage),
+                            PlatformUtils::formatNumber(static_cast<int64_t>(progress.filesDone)).c_str(),
+                            PlatformUtils::formatNumber(static_cast<int64_t>(progress.filesTotal)).c_str(),
+                            PlatformUtils::abbrevSize(static_cast<int64_t>(progress.bytesRead)).c_str());
+    } else if (ImGui::Button("Find Duplicates")) {
+        finder.start(tree.root(), DuplicateFinder::Options());
+    }
+
+    std::shared_ptr<const DuplicateResult> result = finder.result();
+    if (!result) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("%s wasted in %s sets of identical files",
+                PlatformUtils::abbrevSize(result->wastedBytes).c_str(),
+                PlatformUtils::formatNumber(static_cast<int64_t>(result->sets.size())).c_str());
+    if (result->unreadableFiles > 0) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%s unreadable)",
+                            PlatformUtils::formatNumber(static_cast<int64_t>(result->unreadableFiles)).c_str());
+    }
+    if (mw.getColorMode() != COLOR_BY_DUPLICATE) {
+        ImGui::SameLine();
+        if (ImGui::Button("Color by Duplicates")) {
+            mw.setColorMode(COLOR_BY_DUPLICATE);
+        }
+    }
+
+    ImGuiTableFlags tableFlags =
+        ImGuiTableFlags_Resizable |
+        ImGuiTableFlags_RowBg |
+        ImGuiTableFlags_BordersOuter |
+        ImGuiTableFlags_BordersV |
+        ImGuiTableFlags_ScrollY;
+
+    FsNode* picked = nullptr;
+    if (ImGui::BeginTable("DuplicateSets", 3, tableFlags)) {
+        ImGui::TableSetupColumn("File", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Copies", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("Wasted", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableHeadersRow();
+
+        size_t shown = std::min(result->sets.size(), MAX_SETS);
+        for (size_t i = 0; i < shown; ++i) {
+            const DuplicateSet& set = result->sets[i];
+
+            // Label a set by its first copy still in the tree.
+            FsNode* first = nullptr;
+            for (unsigned int id : set.ids) {
+                if ((first = tree.nodeById(id)) != nullptr) break;
+            }
+            if (!first) continue;
+
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::PushID(static_cast<int>(i));
+            bool open = ImGui::TreeNodeEx(first->name.c_str(), ImGuiTreeNodeFlags_SpanFullWidth);
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%zu", set.ids.size());
+            ImGui::TableSetColumnIndex(2);
+            ImGui::TextUnformatted(PlatformUtils::abbrevSize(set.wasted()).c_str());
+            if (open) {
+                for (unsigned int id : set.ids) {
+                    FsNode* node = tree.nodeById(id);
+                    if (!node) continue;
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::PushID(static_cast<int>(id));
+                    if (ImGui::Selectable(node->absName().c_str(), false,
+                                          ImGuiSelectableFlags_SpanAllColumns |
+                                          ImGuiSelectableFlags_AllowOverlap)) {
+                        picked = node;
+                    }
+                    ImGui::PopID();
+                }
+                ImGui::TreePop();
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    if (result->sets.size() > MAX_SETS) {
+        ImGui::TextDisabled("%s smaller sets not shown",
+                            PlatformUtils::formatNumber(static_cast<int64_t>(result->sets.size() - MAX_SETS)).c_str());
+    }
+    ImGui::End();
+
+    if (picked) {
+        mw.navigateTo(picked);
+    }
+}
+
+} // namespace fsvng
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+namespace fsvng {
+
+// "Duplicates" window: starts MainWindow's DuplicateFinder, shows its
+// progress, and lists the duplicate sets by wasted bytes; expanding a set
+// lists its copies, and picking one navigates to it.
+class DuplicatesPanel {
+public:
+    static DuplicatesPanel& instance();
+    void draw();
+
+private:
+    DuplicatesPanel() = default;
+
+    // Sets beyond this are summarized, not listed.
+    static constexpr size_t MAX_SETS = 1000;
+};
+
+} // namespace fsvng
@@ -148,4 +148,15 @@ void FileListPanel::showDirectory(FsNode* dirNode) {
     selectedNode_ = nullptr;
 }
 
+void FileListPanel::forgetSubtree(const FsNode* node) {
+    if (currentDir_ && currentDir_->isWithin(node))
+        currentDir_ = node->parent;
+    if (selectedNode_ && selectedNode_->isWithin(node))
+        selectedNode_ = nullptr;
+    if (contextMenuNode_ && contextMenuNode_->isWithin(node))
+        contextMenuNode_ = nullptr;
+    if (contextMenuNode_pending_ && contextMenuNode_pending_->isWithin(node))
+        contextMenuNode_pending_ = nullptr;
+}
+
 } // namespace fsvng
@@ -12,6 +12,10 @@ public:
     void showEntry(FsNode* node);
     void showDirectory(FsNode* dirNode);
 
+    // Step the listing up to node's parent if it shows node's subtree, and
+    // clear a selection or context menu target inside it
+    void forgetSubtree(const FsNode* node);
+
 private:
     FileListPanel() = default;
 
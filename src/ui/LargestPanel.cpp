@@ -0,0 +1,174 @@
+#include "ui/LargestPanel.h"
+
+#include <imgui.h>
+
+#include "ui/MainWindow.h"
+#include "core/FsTree.h"
+#include "core/FsNode.h"
+#include "core/PlatformUtils.h"
+
+namespace fsvng {
+
+LargestPanel& LargestPanel::instance() {
+    static LargestPanel s;
+    return s;
+}
+
+static const ImGuiTableFlags TABLE_FLAGS =
+    ImGuiTableFlags_Resizable |
+    ImGuiTableFlags_RowBg |
+    ImGuiTableFlags_BordersOuter |
+    ImGuiTableFlags_BordersV |
+    ImGuiTableFlags_ScrollY;
+
+void LargestPanel::drawNodeRows(const std::vector<unsigned int>& ids, bool subtreeSize,
+                                FsNode** picked) {
+    FsTree& tree = FsTree::instance();
+    for (unsigned int id : ids) {
+        // Nodes removed since the report was made are gone from the ID table.
+        FsNode* node = tree.nodeById(id);
+        if (!node) continue;
+
+        ImGui::TableNextRow();
+        ImGui::TableSetColumnIndex(0);
+        ImGui::PushID(static_cast<int>(id));
+        if (ImGui::Selectable(node->name.c_str(), false,
+                              ImGuiSelectableFlags_SpanAllColumns |
+                              ImGuiSelectableFlags_AllowOverlap)) {
+            *picked = node;
+        }
+        ImGui::PopID();
+
+        int64_t size;
+        if (subtreeSize) {
+            size = allocated_ ? node->subtree.sizeAlloc : node->subtree.size;
+        } else {
+            size = allocated_ ? node->sizeAlloc : node->size;
+        }
+        ImGui::TableSetColumnIndex(1);
+        ImGui::TextUnformatted(PlatformUtils::abbrevSize(size).c_str());
+        ImGui::TableSetColumnIndex(2);
+        std::string where = node->parent ? node->parent->absName() : std::string();
+        ImGui::TextDisabled("%s", where.c_str());
+    }
+}
+
+void LargestPanel::drawGroups(const char* tableId, const char* nameHeader,
+                              const std::vector<SizeReport::Group>& groups, FsNode** picked) {
+    if (!ImGui::BeginTable(tableId, 3, TABLE_FLAGS)) {
+        return;
+    }
+    ImGui::TableSetupColumn(nameHeader, ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+    ImGui::TableSetupColumn("Files", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableHeadersRow();
+
+    // Expanding a group lists its largest files; their location goes in the
+    // Files column.
+    for (size_t i = 0; i < groups.size(); ++i) {
+        const SizeReport::Group& group = groups[i];
+        ImGui::TableNextRow();
+        ImGui::TableSetColumnIndex(0);
+        ImGui::PushID(static_cast<int>(i));
+        bool open = ImGui::TreeNodeEx(group.name.empty() ? "(none)" : group.name.c_str(),
+                                      ImGuiTreeNodeFlags_SpanFullWidth);
+        ImGui::TableSetColumnIndex(1);
+        ImGui::TextUnformatted(PlatformUtils::abbrevSize(group.size).c_str());
+        ImGui::TableSetColumnIndex(2);
+        ImGui::TextUnformatted(PlatformUtils::formatNumber(static_cast<int64_t>(group.files)).c_str());
+        if (open) {
+            drawNodeRows(group.largest, false, picked);
+            ImGui::TreePop();
+        }
+        ImGui::PopID();
+    }
+    ImGui::EndTable();
+}
+
+void LargestPanel::draw() {
+    // Nothing is computed while the window is hidden behind another tab.
+    if (!ImGui::Begin("Largest")) {
+        ImGui::End();
+        return;
+    }
+
+    MainWindow& mw = MainWindow::instance();
+    if (!FsTree::instance().rootDir() || mw.isScanning()) {
+        ImGui::TextDisabled("No tree loaded");
+        ImGui::End();
+        return;
+    }
+
+    SizeReporter& reporter = mw.sizeReporter();
+    SizeReport::Options options{TOP_N, allocated_};
+    std::shared_ptr<const SizeReport> report = reporter.report();
+    bool current = reporter.isCurrent(options);
+    if (!current && !reporter.isRunning()) {
+        // A stale report of the same kind is kept for a while rather than
+        // recomputed after every batch of filesystem events.
+        double now = PlatformUtils::getTime();
+        bool sameKind = report && report->options.allocated == allocated_;
+        if (!sameKind || now - lastRequest_ >= REFRESH_SECONDS) {
+            reporter.request(options);
+            lastRequest_ = now;
+        }
+    }
+
+    ImGui::Checkbox("On-disk size", &allocated_);
+    if (reporter.isRunning()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled(report ? "(updating...)" : "Computing...");
+    } else if (report && !current) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(out of date)");
+    }
+    if (!report) {
+        ImGui::End();
+        return;
+    }
+
+    FsNode* picked = nullptr;
+    if (ImGui::BeginTabBar("LargestTabs")) {
+        if (ImGui::BeginTabItem("Files")) {
+            if (ImGui::BeginTable("LargestFiles", 3, TABLE_FLAGS)) {
+                ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+                ImGui::TableSetupColumn("Location", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableHeadersRow();
+                drawNodeRows(report->largestFiles, false, &picked);
+                ImGui::EndTable();
+            }
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Directories")) {
+            if (ImGui::BeginTable("LargestDirs", 3, TABLE_FLAGS)) {
+                ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+                ImGui::TableSetupColumn("Location", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableHeadersRow();
+                drawNodeRows(report->largestDirs, true, &picked);
+                ImGui::EndTable();
+            }
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Extensions")) {
+            drawGroups("LargestByExtension", "Extension", report->byExtension, &picked);
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Owners")) {
+            drawGroups("LargestByOwner", "Owner", report->byOwner, &picked);
+            ImGui::EndTabItem();
+        }
+        ImGui::EndTabBar();
+    }
+    ImGui::End();
+
+    if (picked) {
+        mw.navigateTo(picked);
+    }
+}
+
+} // namespace fsvng
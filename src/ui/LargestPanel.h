@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "core/SizeReport.h"
+
+namespace fsvng {
+
+class FsNode;
+
+// "Largest" window: the biggest files and directories of the whole tree, and
+// totals per extension and per owner, from MainWindow's SizeReporter. The
+// report is only computed while the window is visible, and recomputed at
+// most every REFRESH_SECONDS while the tree keeps changing.
+class LargestPanel {
+public:
+    static LargestPanel& instance();
+    void draw();
+
+private:
+    LargestPanel() = default;
+
+    // One table row per node; sets *picked when a row is clicked.
+    void drawNodeRows(const std::vector<unsigned int>& ids, bool subtreeSize, FsNode** picked);
+    void drawGroups(const char* tableId, const char* nameHeader,
+                    const std::vector<SizeReport::Group>& groups, FsNode** picked);
+
+    static constexpr size_t TOP_N = 100;
+    static constexpr double REFRESH_SECONDS = 5.0;
+
+    bool allocated_ = false;
+    double lastRequest_ = -REFRESH_SECONDS;
+};
+
+} // namespace fsvng
@@ -5,7 +5,10 @@
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstdlib>
 #include <stdexcept>
+#include <unordered_set>
 #include <iostream>
 
 #include "ui/MenuBar.h"
@@ -15,24 +18,57 @@
 #include "ui/ViewportPanel.h"
 #include "ui/StatusBar.h"
 #include "ui/Dialogs.h"
+#include "ui/SearchBox.h"
+#include "ui/LargestPanel.h"
+#include "ui/DuplicatesPanel.h"
+#include "core/DuplicateFinder.h"
+#include "core/FsDiff.h"
 #include "core/FsTree.h"
 #include "core/FsNode.h"
 #include "core/FsScanner.h"
+#include "core/FsSnapshot.h"
+#include "core/FsWatcher.h"
+#include "core/FsLoader.h"
+#include "core/NameIndex.h"
+#include "core/PlatformUtils.h"
+#include "core/SizeReport.h"
 #include "color/ColorSystem.h"
+#include "app/Config.h"
 #include "renderer/Renderer.h"
 #include "geometry/GeometryManager.h"
+#include "geometry/MapVLayout.h"
 #include "geometry/CollapseExpand.h"
 #include "camera/Camera.h"
 #include "ui/PulseEffect.h"
+#include "animation/Morph.h"
 
 namespace fsvng {
 
+// Filesystem events are collected for this long before the tree is patched,
+// so a burst of writes costs one layout update.
+static constexpr double WATCH_BATCH_SECONDS = 0.25;
+
+// Background-filled subtrees are grafted in at most this often; subtrees
+// the user is waiting for are grafted on the next frame.
+static constexpr double LOADER_BATCH_SECONDS = 0.5;
+
 MainWindow& MainWindow::instance() {
     static MainWindow s;
     return s;
 }
 
 MainWindow::~MainWindow() {
+    stopWatching();
+    stopLoading();
+    if (sizeReporter_) {
+        sizeReporter_->cancel();
+    }
+    if (duplicateFinder_) {
+        duplicateFinder_->cancel();
+    }
+    if (snapshotDiff_) {
+        snapshotDiff_->cancel();
+    }
     if (scanThread_.joinable()) {
         if (activeScanner_) {
             activeScanner_->cancelRequested.store(true);
@@ -45,11 +81,25 @@ void MainWindow::setInitialPath(const std::string& path) {
     initialPath_ = path;
 }
 
+void MainWindow::configureScan(ScanOptions& options) const {
+    const Config& config = Config::instance();
+    options.threadCount = config.scanThreads;
+    options.maxDepth = config.scanDepth;
+    options.oneFileSystem = config.scanOneFileSystem || oneFileSystem_;
+    options.exclude = config.scanExclude;
+    options.exclude.insert(options.exclude.end(), scanExclude_.begin(), scanExclude_.end());
+}
+
 void MainWindow::requestScan(const std::string& path) {
     if (scanning_.load()) return;
     pendingScanPath_ = path;
 }
 
+void MainWindow::requestRescan() {
+    if (scanning_.load() || !FsTree::instance().rootDir()) return;
+    pendingRescan_ = true;
+}
+
 void MainWindow::cancelScan() {
     if (activeScanner_) {
         activeScanner_->cancelRequested.store(true);
@@ -183,6 +233,220 @@ void MainWindow::setColorMode(ColorMode mode) {
     }
 }
 
+bool MainWindow::getMapVSizeByAllocation() const {
+    return MapVLayout::instance().sizeByAllocation();
+}
+
+void MainWindow::setMapVSizeByAllocation(bool enable) {
+    if (enable == MapVLayout::instance().sizeByAllocation()) return;
+    MapVLayout::instance().setSizeByAllocation(enable);
+    Config::instance().mapvSizeByAllocation = enable;
+
+    if (currentMode_ == FSV_MAPV && FsTree::instance().rootDir()) {
+        initVisualization();
+    }
+    suspendedMode_ = FSV_NONE;  // a running rescan must lay out afresh
+}
+
+bool MainWindow::getMapVSizeByGrowth() const {
+    return MapVLayout::instance().sizeByDelta();
+}
+
+void MainWindow::setMapVSizeByGrowth(bool enable) {
+    if (enable == MapVLayout::instance().sizeByDelta()) return;
+    std::shared_ptr<const FsDiff> diff = enable ? snapshotDiff().result() : nullptr;
+    if (enable && !diff) return;
+    MapVLayout::instance().setDeltaSizes(diff);
+
+    if (currentMode_ == FSV_MAPV && FsTree::instance().rootDir()) {
+        initVisualization();
+    }
+    suspendedMode_ = FSV_NONE;  // a running rescan must lay out afresh
+}
+
+bool MainWindow::isWatching() const {
+    return watcher_ && watcher_->isRunning();
+}
+
+void MainWindow::setWatching(bool enable) {
+    Config::instance().scanWatch = enable;
+    if (enable && !scanning_.load() && FsTree::instance().rootDir()) {
+        startWatching();
+    } else if (!enable) {
+        stopWatching();
+    }
+}
+
+void MainWindow::startWatching() {
+    if (!watcher_) {
+        watcher_ = std::make_unique<FsWatcher>();
+        watcher_->onRemove = [this](FsNode* node) { forgetSubtree(node); };
+    }
+    configureScan(watcher_->options);
+    if (!watcher_->start(FsTree::instance().root())) {
+        StatusBar::instance().setMessage("Cannot watch for changes on this system", "");
+        return;
+    }
+    size_t unwatched = watcher_->unwatchedDirs();
+    if (unwatched > 0) {
+        StatusBar::instance().setMessage(
+            "Watch limit reached: " + std::to_string(unwatched) + " directories not watched", "");
+    }
+}
+
+void MainWindow::stopWatching() {
+    if (watcher_) {
+        watcher_->stop();
+    }
+}
+
+void MainWindow::applyWatchEvents() {
+    if (!isWatching() || scanning_.load() || sizeReporter().isRunning() ||
+        snapshotDiff().isRunning() || !watcher_->hasPendingBatch(WATCH_BATCH_SECONDS)) {
+        return;
+    }
+
+    WatchBatch batch = watcher_->applyPending();
+    if (batch.rescanNeeded) {
+        requestRescan();
+    }
+    if (batch.changedDirs.empty()) return;
+    searchIndexStale_ = true;
+
+    if (batch.hardLinksChanged) {
+        FsTree::instance().updateTree();
+    }
+    for (FsNode* dir : batch.changedDirs) {
+        ColorSystem::instance().assignRecursive(dir);
+    }
+
+    if (visualizationReady_) {
+        relayoutChangedDirs(batch.changedDirs);
+    }
+
+    showTreeTotals();
+}
+
+void MainWindow::relayoutChangedDirs(const std::vector<FsNode*>& dirs) {
+    std::unordered_set<const FsNode*> changed(dirs.begin(), dirs.end());
+    for (FsNode* dir : dirs) {
+        bool covered = false;
+        for (const FsNode* up = dir->parent; up && !covered; up = up->parent) {
+            covered = changed.count(up) > 0;
+        }
+        if (!covered) {
+            GeometryManager::instance().relayoutDir(dir);
+        }
+    }
+}
+
+void MainWindow::showTreeTotals() {
+    FsNode* rootDir = FsTree::instance().rootDir();
+    if (!rootDir) return;
+
+    int totalFiles = rootDir->subtree.counts[NODE_REGFILE];
+    int totalDirs = rootDir->subtree.counts[NODE_DIRECTORY];
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%d directories, %d files", totalDirs, totalFiles);
+    StatusBar::instance().setMessage(rootDir->name, buf);
+}
+
+void MainWindow::loadSubtree(FsNode* dnode) {
+    if (loader_ && loader_->isRunning()) {
+        loader_->request(dnode, true);
+    }
+}
+
+void MainWindow::startLoading() {
+    if (!loader_) {
+        loader_ = std::make_unique<FsLoader>();
+    }
+    configureScan(loader_->options);
+    loader_->options.threadCount = 1;  // background work, one core is plenty
+    loader_->start();
+    loader_->requestPlaceholders(FsTree::instance().rootDir());
+    loaderFilledDirs_ = false;
+}
+
+void MainWindow::stopLoading() {
+    if (loader_) {
+        loader_->stop();
+    }
+}
+
+void MainWindow::applyLoadedSubtrees() {
+    if (!loader_ || !loader_->isRunning() || scanning_.load() ||
+        sizeReporter().isRunning() || snapshotDiff().isRunning()) {
+        return;
+    }
+
+    bool urgent = false;
+    if (loader_->completedCount(&urgent) == 0) {
+        // Background pass finished: subtree sizes are final, so lay the
+        // whole tree out again once.
+        if (loaderFilledDirs_ && loader_->isIdle() && visualizationReady_) {
+            loaderFilledDirs_ = false;
+            GeometryManager::instance().relayoutDir(FsTree::instance().rootDir());
+            refreshSearchIndex();
+        }
+        return;
+    }
+    double now = PlatformUtils::getTime();
+    if (!urgent && now - lastLoaderApply_ < LOADER_BATCH_SECONDS) return;
+    lastLoaderApply_ = now;
+
+    std::vector<FsNode*> filled = loader_->applyCompleted();
+    if (filled.empty()) return;
+    loaderFilledDirs_ = true;
+    searchIndexStale_ = true;
+
+    FsTree::instance().updateTree();
+    for (FsNode* dir : filled) {
+        ColorSystem::instance().assignRecursive(dir);
+        if (visualizationReady_) {
+            GeometryManager::instance().relayoutDir(dir);
+        }
+        if (isWatching()) {
+            watcher_->watchSubtree(dir);
+        }
+    }
+    showTreeTotals();
+}
+
+void MainWindow::forgetSubtree(FsNode* node) {
+    // Collapse/expand morphs animate the deployment of removed directories
+    std::vector<FsNode*> stack{node};
+    while (!stack.empty()) {
+        FsNode* n = stack.back();
+        stack.pop_back();
+        if (n->isDir()) {
+            MorphEngine::instance().morphBreak(&n->deployment);
+        }
+        for (auto& child : n->children) {
+            stack.push_back(child.get());
+        }
+    }
+
+    if (currentNode_ && currentNode_->isWithin(node)) {
+        currentNode_ = node->parent;
+    }
+    navHistory_.erase(std::remove_if(navHistory_.begin(), navHistory_.end(),
+                                     [node](FsNode* n) { return n->isWithin(node); }),
+                      navHistory_.end());
+    navHistoryPos_ = std::min(navHistoryPos_, (int)navHistory_.size() - 1);
+
+    GeometryManager& gm = GeometryManager::instance();
+    if (gm.getHighlightNode() && gm.getHighlightNode()->isWithin(node)) {
+        gm.setHighlightNode(nullptr);
+    }
+    PulseEffect::instance().reset();
+    DirTreePanel::instance().forgetSubtree(node);
+    FileListPanel::instance().forgetSubtree(node);
+    ViewportPanel::instance().forgetSubtree(node);
+    Dialogs::instance().forgetSubtree(node);
+    Camera::instance().forgetSubtree(node);
+}
+
 void MainWindow::initVisualization() {
     FsNode* rootDir = FsTree::instance().rootDir();
     if (!rootDir) return;
@@ -203,12 +467,20 @@ void MainWindow::initVisualization() {
 }
 
 void MainWindow::scanThreadFunc(const std::string& path) {
+    if (FsSnapshot::isSnapshot(path)) {
+        std::string error;
+        scanResult_ = FsSnapshot::load(path, &error);
+        if (!scanResult_) {
+            std::lock_guard<std::mutex> lock(progressMutex_);
+            scanError_ = error;
+        }
+        scanDone_.store(true);
+        return;
+    }
+
     try {
         auto tree = activeScanner_->scan(path, [this](const std::string& dir, const ScanStats& stats) {
-            std::lock_guard<std::mutex> lock(progressMutex_);
-            progressDir_ = dir;
-            progressFiles_ = stats.nodeCounts[NODE_REGFILE];
-            progressDirs_ = stats.nodeCounts[NODE_DIRECTORY];
+            onScanProgress(dir, stats);
         });
 
         if (activeScanner_->cancelRequested.load()) {
@@ -228,6 +500,35 @@ void MainWindow::scanThreadFunc(const std::string& path) {
     scanDone_.store(true);
 }
 
+void MainWindow::rescanThreadFunc() {
+    // scanResult_ holds the tree taken out of FsTree; it is patched in place
+    // and stays valid even if the rescan is cancelled part way.
+    try {
+        bool ok = activeScanner_->rescan(scanResult_.get(), [this](const std::string& dir, const ScanStats& stats) {
+            onScanProgress(dir, stats);
+        });
+        if (!ok) {
+            std::lock_guard<std::mutex> lock(progressMutex_);
+            scanError_ = "cannot read " + scanResult_->children[0]->name;
+        }
+    } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(progressMutex_);
+        scanError_ = e.what();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(progressMutex_);
+        scanError_ = "Unknown error during rescan";
+    }
+
+    scanDone_.store(true);
+}
+
+void MainWindow::onScanProgress(const std::string& dir, const ScanStats& stats) {
+    std::lock_guard<std::mutex> lock(progressMutex_);
+    progressDir_ = dir;
+    progressFiles_ = stats.nodeCounts[NODE_REGFILE];
+    progressDirs_ = stats.nodeCounts[NODE_DIRECTORY];
+}
+
 void MainWindow::finishScan() {
     if (scanThread_.joinable()) {
         scanThread_.join();
@@ -235,7 +536,7 @@ void MainWindow::finishScan() {
 
     scanning_.store(false);
     scanDone_.store(false);
-    activeScanner_.reset();
+    std::shared_ptr<FsScanner> scanner = std::move(activeScanner_);
 
     std::string error;
     {
@@ -244,7 +545,11 @@ void MainWindow::finishScan() {
         scanError_.clear();
     }
 
-    if (!error.empty()) {
+    // A failed rescan leaves the tree untouched, so it is put back below.
+    bool incremental = rescanning_;
+    rescanning_ = false;
+
+    if (!error.empty() && !incremental) {
         StatusBar::instance().setMessage("Scan error: " + error, "");
         scanResult_.reset();
         return;
@@ -255,17 +560,23 @@ void MainWindow::finishScan() {
         return;
     }
 
+    if (incremental) {
+        finishRescan(*scanner);
+        if (!error.empty()) {
+            StatusBar::instance().setMessage("Rescan error: " + error, "");
+        }
+        return;
+    }
+
     // Clear UI state before replacing tree
-    PulseEffect::instance().reset();
-    DirTreePanel::instance().selectNode(nullptr);
-    DirTreePanel::instance().clearExpanded();
-    FileListPanel::instance().showDirectory(nullptr);
-    currentNode_ = nullptr;
-    visualizationReady_ = false;
-    GeometryManager::instance().freeAll();
+    stopWatching();
+    stopLoading();
+    clearTreeViews();
 
     FsTree::instance().setRoot(std::move(scanResult_));
     FsTree::instance().setupTree();
+    searchIndexStale_ = true;
+    refreshSearchIndex();
     ColorSystem::instance().init();
     ColorSystem::instance().setMode(currentColorMode_);
     FsNode* root = FsTree::instance().root();
@@ -273,24 +584,213 @@ void MainWindow::finishScan() {
         ColorSystem::instance().assignRecursive(root);
     }
 
-    // Clear navigation history
-    navHistory_.clear();
-    navHistoryPos_ = -1;
-
     FsNode* rootDir = FsTree::instance().rootDir();
     if (rootDir) {
         currentNode_ = rootDir;
         DirTreePanel::instance().selectNode(rootDir);
         FileListPanel::instance().showDirectory(rootDir);
-
-        int totalFiles = rootDir->subtree.counts[NODE_REGFILE];
-        int totalDirs = rootDir->subtree.counts[NODE_DIRECTORY];
-        char buf[256];
-        snprintf(buf, sizeof(buf), "%d directories, %d files", totalDirs, totalFiles);
-        StatusBar::instance().setMessage(rootDir->name, buf);
+        showTreeTotals();
 
         // Initialize visualization
         initVisualization();
+        startLoading();
+
+        if (Config::instance().scanWatch) {
+            startWatching();
+        }
+    }
+}
+
+void MainWindow::finishRescan(FsScanner& scanner) {
+    FsTree::instance().restoreRoot(std::move(scanResult_));
+    currentNode_ = suspendedNode_;
+    navHistory_ = std::move(suspendedHistory_);
+    navHistoryPos_ = suspendedHistoryPos_;
+    suspendedNode_ = nullptr;
+    suspendedHistory_.clear();
+
+    // Cut-out subtrees are still linked to their old parents, so the views
+    // holding on to them can find out what to drop before they are freed
+    for (std::unique_ptr<FsNode>& removed : scanner.takeRemoved()) {
+        forgetSubtree(removed.get());
+    }
+
+    FsTree::instance().updateTree();
+    searchIndexStale_ = true;
+    refreshSearchIndex();
+    ColorSystem::instance().init();
+    ColorSystem::instance().setMode(currentColorMode_);
+    FsNode* root = FsTree::instance().root();
+    if (root) {
+        ColorSystem::instance().assignRecursive(root);
+    }
+
+    FsNode* rootDir = FsTree::instance().rootDir();
+    if (!rootDir) return;
+
+    if (!currentNode_ || currentNode_ == root) {
+        currentNode_ = rootDir;
+    }
+    DirTreePanel::instance().selectNode(currentNode_);
+    FileListPanel::instance().showDirectory(currentNode_->isDir() ? currentNode_ : currentNode_->parent);
+    showTreeTotals();
+
+    // Geometry laid out before the rescan is still in place; only the
+    // directories the rescan touched need laying out again. The camera stays.
+    if (suspendedMode_ == currentMode_ && GeometryManager::instance().currentMode() == currentMode_) {
+        visualizationReady_ = true;
+        relayoutChangedDirs(scanner.changedDirs());
+        GeometryManager::instance().queueUncachedDraw();
+    } else {
+        initVisualization();
+    }
+    suspendedMode_ = FSV_NONE;
+
+    startLoading();
+    if (Config::instance().scanWatch) {
+        startWatching();
+    }
+}
+
+void MainWindow::suspendTreeViews() {
+    suspendedNode_ = currentNode_;
+    suspendedHistory_ = std::move(navHistory_);
+    suspendedHistoryPos_ = navHistoryPos_;
+    suspendedMode_ = visualizationReady_ ? currentMode_ : FSV_NONE;
+    navHistory_.clear();
+    navHistoryPos_ = -1;
+    hideTreeViews();
+}
+
+void MainWindow::clearTreeViews() {
+    DirTreePanel::instance().clearExpanded();
+    GeometryManager::instance().freeAll();
+    navHistory_.clear();
+    navHistoryPos_ = -1;
+    hideTreeViews();
+}
+
+void MainWindow::hideTreeViews() {
+    PulseEffect::instance().reset();
+    DirTreePanel::instance().selectNode(nullptr);
+    FileListPanel::instance().showDirectory(nullptr);
+    currentNode_ = nullptr;
+    visualizationReady_ = false;
+    GeometryManager::instance().setHighlightNode(nullptr);
+    nameSearch().clear();
+    SearchBox::instance().clear();
+    sizeReporter().clear();
+    duplicateFinder().clear();
+    ColorSystem::instance().setDuplicates({});
+    shownDuplicates_.reset();
+    snapshotDiff().clear();
+    ColorSystem::instance().setGrowth(nullptr);
+    MapVLayout::instance().setDeltaSizes(nullptr);
+    shownDiff_.reset();
+    diffReported_ = true;
+}
+
+NameSearch& MainWindow::nameSearch() {
+    if (!nameSearch_) {
+        nameSearch_ = std::make_unique<NameSearch>();
+    }
+    return *nameSearch_;
+}
+
+SizeReporter& MainWindow::sizeReporter() {
+    if (!sizeReporter_) {
+        sizeReporter_ = std::make_unique<SizeReporter>();
+    }
+    return *sizeReporter_;
+}
+
+DuplicateFinder& MainWindow::duplicateFinder() {
+    if (!duplicateFinder_) {
+        duplicateFinder_ = std::make_unique<DuplicateFinder>();
+    }
+    return *duplicateFinder_;
+}
+
+void MainWindow::applyDuplicateResults() {
+    std::shared_ptr<const DuplicateResult> result = duplicateFinder().result();
+    if (result == shownDuplicates_) return;
+    shownDuplicates_ = result;
+
+    std::vector<unsigned int> ids;
+    if (result) {
+        ids.reserve(result->duplicateFiles);
+        for (const DuplicateSet& set : result->sets) {
+            ids.insert(ids.end(), set.ids.begin(), set.ids.end());
+        }
+    }
+    ColorSystem::instance().setDuplicates(ids);
+
+    FsNode* root = FsTree::instance().root();
+    if (root && currentColorMode_ == COLOR_BY_DUPLICATE) {
+        ColorSystem::instance().assignRecursive(root);
+        GeometryManager::instance().queueUncachedDraw();
+    }
+}
+
+SnapshotDiff& MainWindow::snapshotDiff() {
+    if (!snapshotDiff_) {
+        snapshotDiff_ = std::make_unique<SnapshotDiff>();
+    }
+    return *snapshotDiff_;
+}
+
+void MainWindow::compareWithSnapshot(const std::string& path) {
+    if (scanning_.load() || !FsTree::instance().rootDir()) {
+        StatusBar::instance().setMessage("Nothing to compare: no tree is loaded", "");
+        return;
+    }
+    snapshotDiff().start(path, MapVLayout::instance().sizeByAllocation());
+    diffReported_ = false;
+    StatusBar::instance().setMessage("Comparing with " + path + "...", "");
+}
+
+void MainWindow::applyDiffResults() {
+    if (diffReported_ || snapshotDiff().isRunning()) return;
+    diffReported_ = true;
+
+    std::string error = snapshotDiff().error();
+    std::shared_ptr<const FsDiff> diff = snapshotDiff().result();
+    if (!error.empty() || !diff) {
+        StatusBar::instance().setMessage(
+            "Compare failed: " + (error.empty() ? std::string("cancelled") : error), "");
+        return;
+    }
+    if (diff == shownDiff_) return;
+    shownDiff_ = diff;
+
+    ColorSystem::instance().setGrowth(diff);
+    FsNode* root = FsTree::instance().root();
+    if (root && currentColorMode_ == COLOR_BY_GROWTH) {
+        ColorSystem::instance().assignRecursive(root);
+        GeometryManager::instance().queueUncachedDraw();
+    }
+    if (MapVLayout::instance().sizeByDelta()) {
+        MapVLayout::instance().setDeltaSizes(diff);
+        if (currentMode_ == FSV_MAPV && FsTree::instance().rootDir()) {
+            initVisualization();
+        }
+    }
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "net %s%s, +%s in %llu new, -%s in %llu gone",
+             diff->totalDelta < 0 ? "-" : "+",
+             PlatformUtils::abbrevSize(std::llabs(diff->totalDelta)).c_str(),
+             PlatformUtils::abbrevSize(diff->addedBytes).c_str(),
+             static_cast<unsigned long long>(diff->addedNodes),
+             PlatformUtils::abbrevSize(diff->removedBytes).c_str(),
+             static_cast<unsigned long long>(diff->removedNodes));
+    StatusBar::instance().setMessage("Compared with " + snapshotDiff().baselinePath(), buf);
+}
+
+void MainWindow::refreshSearchIndex() {
+    if (searchIndexStale_ && FsTree::instance().root()) {
+        nameSearch().rebuild(FsTree::instance().root());
+        searchIndexStale_ = false;
     }
 }
 
@@ -380,9 +880,40 @@ void MainWindow::draw() {
             scanThread_.join();
         }
         activeScanner_ = std::make_shared<FsScanner>();
+        configureScan(activeScanner_->options);
         scanThread_ = std::thread(&MainWindow::scanThreadFunc, this, path);
     }
 
+    // Start a deferred rescan. The panels must not see the tree while the
+    // background thread patches it, so it is taken out of FsTree meanwhile.
+    if (pendingRescan_ && !scanning_.load()) {
+        pendingRescan_ = false;
+
+        stopWatching();
+        stopLoading();
+        suspendTreeViews();
+        scanResult_ = FsTree::instance().releaseRoot();
+
+        {
+            std::lock_guard<std::mutex> lock(progressMutex_);
+            progressDir_ = scanResult_->children[0]->name;
+            progressFiles_ = 0;
+            progressDirs_ = 0;
+            scanError_.clear();
+        }
+
+        scanning_.store(true);
+        scanDone_.store(false);
+        rescanning_ = true;
+
+        if (scanThread_.joinable()) {
+            scanThread_.join();
+        }
+        activeScanner_ = std::make_shared<FsScanner>();
+        configureScan(activeScanner_->options);
+        scanThread_ = std::thread(&MainWindow::rescanThreadFunc, this);
+    }
+
     // Do initial scan on first frame
     if (firstFrame_) {
         if (!initialPath_.empty() && !scanning_.load()) {
@@ -390,6 +921,15 @@ void MainWindow::draw() {
         }
     }
 
+    if (ImGui::IsKeyPressed(ImGuiKey_F5, false) && !ImGui::GetIO().WantTextInput) {
+        requestRescan();
+    }
+
+    applyWatchEvents();
+    applyLoadedSubtrees();
+    applyDuplicateResults();
+    applyDiffResults();
+
     // Create a fullscreen dockspace
     ImGuiWindowFlags windowFlags =
         ImGuiWindowFlags_NoDocking |
@@ -433,6 +973,8 @@ void MainWindow::draw() {
     Toolbar::instance().draw();
     DirTreePanel::instance().draw();
     FileListPanel::instance().draw();
+    LargestPanel::instance().draw();
+    DuplicatesPanel::instance().draw();
     ViewportPanel::instance().draw();
     StatusBar::instance().draw();
     Dialogs::instance().draw();
@@ -459,6 +1001,8 @@ void MainWindow::setupDockspace() {
 
     ImGui::DockBuilderDockWindow("Directory Tree", leftTopId);
     ImGui::DockBuilderDockWindow("File List", leftBottomId);
+    ImGui::DockBuilderDockWindow("Largest", leftBottomId);
+    ImGui::DockBuilderDockWindow("Duplicates", leftBottomId);
     ImGui::DockBuilderDockWindow("Viewport", rightId);
 
     ImGui::DockBuilderFinish(dockspaceId);
@@ -13,6 +13,16 @@ namespace fsvng {
 
 class FsNode;
 class FsScanner;
+class FsWatcher;
+class FsLoader;
+class NameSearch;
+class SizeReporter;
+class DuplicateFinder;
+struct DuplicateResult;
+class SnapshotDiff;
+struct FsDiff;
+struct ScanStats;
+struct ScanOptions;
 
 class MainWindow {
 public:
@@ -22,12 +32,28 @@ public:
     void draw();
     void setInitialPath(const std::string& path);
 
+    // Scan settings from the command line, for this session only (not
+    // saved to the config): -x/--one-file-system and --exclude rules
+    void setOneFileSystem(bool enable) { oneFileSystem_ = enable; }
+    void setScanExclude(const std::vector<std::string>& rules) { scanExclude_ = rules; }
+
     // Request a scan - runs on a background thread
     void requestScan(const std::string& path);
     void cancelScan();
 
+    // Refresh the current tree in place, re-reading only changed directories
+    void requestRescan();
+
     bool isScanning() const { return scanning_.load(); }
 
+    // Load a placeholder directory left by a lazy scan (scan.depth), ahead
+    // of the background pass that fills in the rest
+    void loadSubtree(FsNode* dnode);
+
+    // Follow filesystem changes under the scanned root (Linux inotify)
+    bool isWatching() const;
+    void setWatching(bool enable);
+
     // Navigate to a node in the tree panels
     void navigateTo(FsNode* node);
     void navigateBack();
@@ -40,6 +66,26 @@ public:
 
     FsNode* getCurrentNode() const { return currentNode_; }
 
+    // Name index of the current tree, built in the background after each
+    // scan. refreshSearchIndex() rebuilds it if the tree has changed since.
+    NameSearch& nameSearch();
+    void refreshSearchIndex();
+
+    // Largest files, directories, extensions and owners of the current tree,
+    // computed in the background on request. Watch and loader updates are
+    // held back while it runs.
+    SizeReporter& sizeReporter();
+
+    // Duplicate-content search over the current tree, run on request from
+    // the Duplicates panel. Its results feed COLOR_BY_DUPLICATE.
+    DuplicateFinder& duplicateFinder();
+
+    // Comparison of the current tree with a saved snapshot, run in the
+    // background. Its results feed COLOR_BY_GROWTH and delta-sized MapV;
+    // watch and loader updates are held back while it runs.
+    SnapshotDiff& snapshotDiff();
+    void compareWithSnapshot(const std::string& path);
+
     // Visualization mode
     FsvMode getMode() const { return currentMode_; }
     void setMode(FsvMode mode);
@@ -48,27 +94,91 @@ public:
     ColorMode getColorMode() const { return currentColorMode_; }
     void setColorMode(ColorMode mode);
 
+    // MapV block sizing: logical size or allocated (on-disk) size
+    bool getMapVSizeByAllocation() const;
+    void setMapVSizeByAllocation(bool enable);
+
+    // MapV block sizing by growth since the compared snapshot
+    bool getMapVSizeByGrowth() const;
+    void setMapVSizeByGrowth(bool enable);
+
 private:
     MainWindow() = default;
     void setupDockspace();
     void drawProgressOverlay();
     void finishScan();
+    void clearTreeViews();
     void initVisualization();
 
-    // Runs on the background thread
+    // Take the panels off the tree while a rescan patches it off-thread.
+    // Expansion, geometry, the camera and the navigation history are kept
+    // for finishRescan(), which puts the tree back and updates only what
+    // the rescan changed.
+    void suspendTreeViews();
+    void finishRescan(FsScanner& scanner);
+
+    // Forget derived data (search, reports, duplicates, diff) and what the
+    // panels show; shared by clearTreeViews() and suspendTreeViews()
+    void hideTreeViews();
+
+    // Re-lay out the topmost of dirs; everything below them is laid out
+    // again with them. Ancestors keep their footprint.
+    void relayoutChangedDirs(const std::vector<FsNode*>& dirs);
+
+    // Fill scanner options from the config and command line
+    void configureScan(ScanOptions& options) const;
+
+    // Run on the background thread
     void scanThreadFunc(const std::string& path);
+    void rescanThreadFunc();
+    void onScanProgress(const std::string& dir, const ScanStats& stats);
+
+    // Filesystem watching
+    void startWatching();
+    void stopWatching();
+    void applyWatchEvents();
+    void forgetSubtree(FsNode* node);
+
+    // Lazy scanning
+    void startLoading();
+    void stopLoading();
+    void applyLoadedSubtrees();
+
+    // Hand new DuplicateFinder results to ColorSystem
+    void applyDuplicateResults();
+
+    // Hand a new SnapshotDiff result to ColorSystem and MapVLayout
+    void applyDiffResults();
+
+    void showTreeTotals();
 
     bool firstFrame_ = true;
     bool dockspaceInitialized_ = false;
     std::string initialPath_;
+    bool oneFileSystem_ = false;
+    std::vector<std::string> scanExclude_;
     std::string pendingScanPath_;
+    bool pendingRescan_ = false;
 
     // Background scan state
     std::atomic<bool> scanning_{false};
     std::atomic<bool> scanDone_{false};
+    bool rescanning_ = false;  // scanResult_ is the current tree being patched
     std::thread scanThread_;
     std::unique_ptr<FsNode> scanResult_;
     std::shared_ptr<FsScanner> activeScanner_;
+    std::unique_ptr<FsWatcher> watcher_;
+    std::unique_ptr<FsLoader> loader_;
+    double lastLoaderApply_ = 0.0;
+    bool loaderFilledDirs_ = false;  // relayout from the root once idle
+    std::unique_ptr<NameSearch> nameSearch_;
+    bool searchIndexStale_ = false;
+    std::unique_ptr<SizeReporter> sizeReporter_;
+    std::unique_ptr<DuplicateFinder> duplicateFinder_;
+    std::shared_ptr<const DuplicateResult> shownDuplicates_;  // last given to ColorSystem
+    std::unique_ptr<SnapshotDiff> snapshotDiff_;
+    std::shared_ptr<const FsDiff> shownDiff_;  // last given to ColorSystem
+    bool diffReported_ = true;                 // outcome of the last comparison shown
 
     // Thread-safe progress info
     mutable std::mutex progressMutex_;
@@ -82,6 +192,12 @@ private:
     int navHistoryPos_ = -1;
     FsNode* currentNode_ = nullptr;
 
+    // Kept by suspendTreeViews() while a rescan runs
+    FsNode* suspendedNode_ = nullptr;
+    std::vector<FsNode*> suspendedHistory_;
+    int suspendedHistoryPos_ = -1;
+    FsvMode suspendedMode_ = FSV_NONE;  // laid out in, or FSV_NONE
+
     // Visualization state
     FsvMode currentMode_ = FSV_MAPV;
     ColorMode currentColorMode_ = COLOR_BY_NODETYPE;
@@ -4,6 +4,8 @@
 #include <SDL.h>
 
 #include "core/Types.h"
+#include "core/FsDiff.h"
+#include "core/FsTree.h"
 #include "ui/Dialogs.h"
 #include "ui/MainWindow.h"
 #include "ui/ThemeManager.h"
@@ -32,6 +34,20 @@ void MenuBar::drawFileMenu() {
         if (ImGui::MenuItem("Change Root...")) {
             Dialogs::instance().showChangeRoot();
         }
+        bool hasTree = FsTree::instance().rootDir() != nullptr;
+        if (ImGui::MenuItem("Rescan", "F5", false, hasTree)) {
+            MainWindow::instance().requestRescan();
+        }
+        bool watching = MainWindow::instance().isWatching();
+        if (ImGui::MenuItem("Watch for Changes", nullptr, &watching, hasTree)) {
+            MainWindow::instance().setWatching(watching);
+        }
+        if (ImGui::MenuItem("Save Snapshot...", nullptr, false, hasTree)) {
+            Dialogs::instance().showSaveSnapshot();
+        }
+        if (ImGui::MenuItem("Compare with Snapshot...", nullptr, false, hasTree)) {
+            Dialogs::instance().showCompareSnapshot();
+        }
         ImGui::Separator();
         if (ImGui::MenuItem("Set Default Path...")) {
             Dialogs::instance().showSetDefaultPath();
@@ -61,6 +77,16 @@ void MenuBar::drawVisMenu() {
         if (ImGui::RadioButton("TreeV", currentMode == FSV_TREEV)) {
             mw.setMode(FSV_TREEV);
         }
+        ImGui::Separator();
+        bool byAlloc = mw.getMapVSizeByAllocation();
+        if (ImGui::MenuItem("MapV: Size by Disk Usage", nullptr, &byAlloc)) {
+            mw.setMapVSizeByAllocation(byAlloc);
+        }
+        bool byGrowth = mw.getMapVSizeByGrowth();
+        bool compared = mw.snapshotDiff().result() != nullptr;
+        if (ImGui::MenuItem("MapV: Size by Growth", nullptr, &byGrowth, compared)) {
+            mw.setMapVSizeByGrowth(byGrowth);
+        }
         ImGui::EndMenu();
     }
 }
@@ -79,6 +105,12 @@ void MenuBar::drawColorsMenu() {
         if (ImGui::RadioButton("By Wildcard", currentColorMode == COLOR_BY_WPATTERN)) {
             mw.setColorMode(COLOR_BY_WPATTERN);
         }
+        if (ImGui::RadioButton("By Duplicates", currentColorMode == COLOR_BY_DUPLICATE)) {
+            mw.setColorMode(COLOR_BY_DUPLICATE);
+        }
+        if (ImGui::RadioButton("By Growth", currentColorMode == COLOR_BY_GROWTH)) {
+            mw.setColorMode(COLOR_BY_GROWTH);
+        }
         ImGui::Separator();
         if (ImGui::MenuItem("Configure Colors...")) {
             Dialogs::instance().showColorConfig();
@@ -0,0 +1,129 @@
+#include "ui/SearchBox.h"
+
+#include <imgui.h>
+#include <cfloat>
+#include <cstring>
+
+#include "ui/MainWindow.h"
+#include "core/FsTree.h"
+#include "core/PlatformUtils.h"
+
+namespace fsvng {
+
+SearchBox& SearchBox::instance() {
+    static SearchBox s;
+    return s;
+}
+
+void SearchBox::clear() {
+    results_.clear();
+    total_ = 0;
+    error_.clear();
+    queriedIndex_.reset();
+    open_ = false;
+}
+
+void SearchBox::runQuery(const NameIndex* index) {
+    results_.clear();
+    total_ = 0;
+    error_.clear();
+    if (!index || buffer_[0] == '\0') {
+        return;
+    }
+    NameQuery kind = NameQuery::Substring;
+    if (regex_) {
+        kind = NameQuery::Regex;
+    } else if (std::strpbrk(buffer_, "*?")) {
+        kind = NameQuery::Glob;
+    }
+    results_ = index->query(buffer_, kind, MAX_RESULTS, &total_, &error_);
+}
+
+void SearchBox::draw() {
+    MainWindow& mw = MainWindow::instance();
+    NameSearch& search = mw.nameSearch();
+
+    ImGui::SetNextItemWidth(ImGui::GetFontSize() * 14.0f);
+    bool edited = ImGui::InputTextWithHint("##NameSearch", "Find by name (*, ?)",
+                                           buffer_, sizeof(buffer_));
+    bool inputActive = ImGui::IsItemActive();
+    if (ImGui::IsItemActivated()) {
+        mw.refreshSearchIndex();
+        open_ = true;
+    }
+    ImVec2 listPos(ImGui::GetItemRectMin().x, ImGui::GetItemRectMax().y);
+    ImGui::SameLine();
+    edited |= ImGui::Checkbox("Regex", &regex_);
+
+    // Re-run when the text changes or a newer index has been built.
+    std::shared_ptr<const NameIndex> index = search.index();
+    if (edited || index != queriedIndex_) {
+        queriedIndex_ = index;
+        runQuery(index.get());
+        open_ = open_ || edited;
+    }
+    if (inputActive && ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+        open_ = false;
+    }
+    if (!open_ || buffer_[0] == '\0') {
+        return;
+    }
+
+    FsTree& tree = FsTree::instance();
+    FsNode* picked = nullptr;
+    if (inputActive && ImGui::IsKeyPressed(ImGuiKey_Enter)) {
+        for (const NameIndex::Match& match : results_) {
+            if ((picked = tree.nodeById(match.id)) != nullptr) {
+                break;
+            }
+        }
+    }
+
+    float fontSize = ImGui::GetFontSize();
+    ImGui::SetNextWindowPos(listPos);
+    ImGui::SetNextWindowSizeConstraints(ImVec2(fontSize * 24.0f, 0.0f),
+                                        ImVec2(FLT_MAX, fontSize * 24.0f));
+    ImGuiWindowFlags flags =
+        ImGuiWindowFlags_NoDecoration |
+        ImGuiWindowFlags_AlwaysAutoResize |
+        ImGuiWindowFlags_NoSavedSettings |
+        ImGuiWindowFlags_NoFocusOnAppearing |
+        ImGuiWindowFlags_NoDocking;
+    bool listFocused = false;
+    if (ImGui::Begin("##NameSearchResults", nullptr, flags)) {
+        listFocused = ImGui::IsWindowFocused();
+        if (!error_.empty()) {
+            ImGui::TextDisabled("Invalid regex: %s", error_.c_str());
+        } else if (!queriedIndex_) {
+            ImGui::TextDisabled("Indexing names...");
+        } else {
+            ImGui::TextDisabled("%s matches%s", PlatformUtils::formatNumber(total_).c_str(),
+                                search.isBuilding() ? " (updating index...)" : "");
+        }
+
+        // Removed nodes are gone from the ID table and are skipped.
+        for (const NameIndex::Match& match : results_) {
+            FsNode* node = tree.nodeById(match.id);
+            if (!node) continue;
+            ImGui::PushID(static_cast<int>(match.id));
+            if (ImGui::Selectable(node->name.c_str())) {
+                picked = node;
+            }
+            ImGui::SameLine();
+            std::string where = node->parent ? node->parent->absName() : std::string();
+            ImGui::TextDisabled("%s  %s", PlatformUtils::abbrevSize(match.size).c_str(),
+                                where.c_str());
+            ImGui::PopID();
+        }
+    }
+    ImGui::End();
+
+    if (picked) {
+        mw.navigateTo(picked);
+        open_ = false;
+    } else if (!inputActive && !listFocused) {
+        open_ = false;
+    }
+}
+
+} // namespace fsvng
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/NameIndex.h"
+
+namespace fsvng {
+
+// Toolbar field that looks names up in MainWindow's NameIndex and lists the
+// largest matches below it; picking one navigates to it. Text with * or ?
+// is a glob over the whole name, otherwise a substring, unless Regex is on.
+class SearchBox {
+public:
+    static SearchBox& instance();
+    void draw();
+
+    // Drop results (the tree they refer to is going away).
+    void clear();
+
+private:
+    SearchBox() = default;
+    void runQuery(const NameIndex* index);
+
+    static constexpr size_t MAX_RESULTS = 200;
+
+    char buffer_[256] = {};
+    bool regex_ = false;
+    bool open_ = false;
+    std::vector<NameIndex::Match> results_;
+    size_t total_ = 0;
+    std::string error_;
+    std::shared_ptr<const NameIndex> queriedIndex_;  // index results_ came from
+};
+
+} // namespace fsvng
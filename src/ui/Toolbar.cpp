@@ -5,6 +5,7 @@
 
 #include "core/Types.h"
 #include "ui/MainWindow.h"
+#include "ui/SearchBox.h"
 #include "camera/Camera.h"
 
 namespace fsvng {
@@ -64,6 +65,11 @@ void Toolbar::draw() {
         if (ImGui::RadioButton("Tree", currentMode == FSV_TREEV)) {
             mw.setMode(FSV_TREEV);
         }
+
+        ImGui::SameLine();
+        ImGui::SeparatorEx(ImGuiSeparatorFlags_Vertical);
+        ImGui::SameLine();
+        SearchBox::instance().draw();
     }
     ImGui::End();
 }
@@ -24,6 +24,11 @@ ViewportPanel& ViewportPanel::instance() {
     return s;
 }
 
+void ViewportPanel::forgetSubtree(const FsNode* node) {
+    if (contextMenuNode_ && contextMenuNode_->isWithin(node))
+        contextMenuNode_ = nullptr;
+}
+
 void ViewportPanel::createFBO(int width, int height) {
     // Delete existing resources if resizing
     if (fbo_ != 0) {
@@ -202,7 +207,7 @@ static double mapvNodeZBase(FsNode* node) {
     double z = 0.0;
     FsNode* p = node->parent;
     while (p) {
-        z += p->mapvGeom.height;
+        z += p->mapvGeom().height;
         p = p->parent;
     }
     return z;
@@ -233,19 +238,19 @@ FsNode* ViewportPanel::hitTestMapVRecursive(FsNode* dnode, float mx, float my,
                                              double zBase, int depth) {
     if (depth > 10) return nullptr;
 
-    double childZBase = zBase + dnode->mapvGeom.height;
+    double childZBase = zBase + dnode->mapvGeom().height;
     FsNode* bestHit = nullptr;
 
     for (auto& childPtr : dnode->children) {
         FsNode* node = childPtr.get();
 
-        float z = static_cast<float>(childZBase + node->mapvGeom.height);
+        float z = static_cast<float>(childZBase + node->mapvGeom().height);
 
         // Project top face corners to screen space
-        glm::vec3 c0World(static_cast<float>(node->mapvGeom.c0.x),
-                          static_cast<float>(node->mapvGeom.c0.y), z);
-        glm::vec3 c1World(static_cast<float>(node->mapvGeom.c1.x),
-                          static_cast<float>(node->mapvGeom.c1.y), z);
+        glm::vec3 c0World(static_cast<float>(node->mapvGeom().c0.x),
+                          static_cast<float>(node->mapvGeom().c0.y), z);
+        glm::vec3 c1World(static_cast<float>(node->mapvGeom().c1.x),
+                          static_cast<float>(node->mapvGeom().c1.y), z);
 
         float sx0, sy0, sx1, sy1;
         bool c0ok = projectToScreen(cachedViewProj_, c0World, imgPos_, imgSize_, sx0, sy0);
@@ -293,7 +298,7 @@ void ViewportPanel::drawMapVLabelsRecursive(FsNode* dnode, const glm::mat4& view
                                              ImDrawList* drawList, double zBase, int depth) {
     if (depth > 20) return;
 
-    double childZBase = zBase + dnode->mapvGeom.height;
+    double childZBase = zBase + dnode->mapvGeom().height;
 
     for (auto& childPtr : dnode->children) {
         FsNode* node = childPtr.get();
@@ -303,7 +308,7 @@ void ViewportPanel::drawMapVLabelsRecursive(FsNode* dnode, const glm::mat4& view
         glm::vec3 worldPos(
             static_cast<float>(node->mapvCenterX()),
             static_cast<float>(node->mapvCenterY()),
-            static_cast<float>(childZBase + node->mapvGeom.height)
+            static_cast<float>(childZBase + node->mapvGeom().height)
         );
 
         // Project center
@@ -313,14 +318,14 @@ void ViewportPanel::drawMapVLabelsRecursive(FsNode* dnode, const glm::mat4& view
         if (centerVisible) {
             // Project two corners of the top face to estimate screen size
             glm::vec3 c0World(
-                static_cast<float>(node->mapvGeom.c0.x),
-                static_cast<float>(node->mapvGeom.c0.y),
-                static_cast<float>(childZBase + node->mapvGeom.height)
+                static_cast<float>(node->mapvGeom().c0.x),
+                static_cast<float>(node->mapvGeom().c0.y),
+                static_cast<float>(childZBase + node->mapvGeom().height)
             );
             glm::vec3 c1World(
-                static_cast<float>(node->mapvGeom.c1.x),
-                static_cast<float>(node->mapvGeom.c1.y),
-                static_cast<float>(childZBase + node->mapvGeom.height)
+                static_cast<float>(node->mapvGeom().c1.x),
+                static_cast<float>(node->mapvGeom().c1.y),
+                static_cast<float>(childZBase + node->mapvGeom().height)
             );
 
             float sx0, sy0, sx1, sy1;
@@ -361,10 +366,11 @@ void ViewportPanel::drawMapVLabelsRecursive(FsNode* dnode, const glm::mat4& view
             }
         }
 
-        // Always recurse into expanded directories regardless of projection.
-        // When zoomed deep, intermediate dirs project outside viewport but
-        // their children are visible and need labels.
-        if (isExpandedDir) {
+        // Recurse into expanded directories regardless of their own
+        // projection (when zoomed deep, intermediate dirs project outside
+        // the viewport but their children need labels), unless the whole
+        // subtree is outside the view frustum
+        if (isExpandedDir && GeometryManager::instance().subtreeInView(node)) {
             drawMapVLabelsRecursive(node, viewProj, imgPos, imgSize, drawList,
                                      childZBase, depth + 1);
         }
@@ -440,13 +446,13 @@ void ViewportPanel::drawTreeVLabelsRecursive(FsNode* dnode, const glm::mat4& vie
         const char* name = node->name.c_str();
 
         if (!node->isDir()) {
-            double r = platformR0 + node->treevGeom.leaf.distance;
-            double theta = platformTheta + node->treevGeom.leaf.theta;
+            double r = platformR0 + node->treevGeom().leaf.distance;
+            double theta = platformTheta + node->treevGeom().leaf.theta;
             double thetaRad = theta * PI / 180.0;
             float worldX = static_cast<float>(r * std::cos(thetaRad));
             float worldY = static_cast<float>(r * std::sin(thetaRad));
-            double parentHeight = dnode->treevGeom.platform.height;
-            float topZ = static_cast<float>(parentHeight + node->treevGeom.leaf.height);
+            double parentHeight = dnode->treevGeom().platform.height;
+            float topZ = static_cast<float>(parentHeight + node->treevGeom().leaf.height);
             float baseZ = static_cast<float>(parentHeight);
 
             // Label on TOP of leaf
@@ -460,20 +466,21 @@ void ViewportPanel::drawTreeVLabelsRecursive(FsNode* dnode, const glm::mat4& vie
         } else {
             double childR0 = gm.treevPlatformR0(node);
             double childTheta = gm.treevPlatformTheta(node);
-            double r = childR0 + 0.5 * node->treevGeom.platform.depth;
+            double r = childR0 + 0.5 * node->treevGeom().platform.depth;
             double thetaRad = childTheta * PI / 180.0;
             float worldX = static_cast<float>(r * std::cos(thetaRad));
             float worldY = static_cast<float>(r * std::sin(thetaRad));
-            float topZ = static_cast<float>(node->treevGeom.platform.height);
-            float edgeOffset = static_cast<float>(node->treevGeom.platform.depth * 0.5);
+            float topZ = static_cast<float>(node->treevGeom().platform.height);
+            float edgeOffset = static_cast<float>(node->treevGeom().platform.depth * 0.5);
 
             // Label on top of platform
             drawTreeVLabel(drawList, viewProj, imgPos, imgSize,
                            glm::vec3(worldX, worldY, topZ), edgeOffset, name);
         }
 
-        // Always recurse into expanded directories regardless of projection
-        if (isExpandedDir) {
+        // Recurse into expanded directories regardless of projection,
+        // unless the whole subtree is outside the view frustum
+        if (isExpandedDir && gm.subtreeInView(node)) {
             drawTreeVLabelsRecursive(node, viewProj, imgPos, imgSize, drawList, depth + 1);
         }
     }
@@ -533,25 +540,23 @@ void ViewportPanel::draw() {
             cachedView = cam.getViewMatrix();
             cachedProj = cam.getProjectionMatrix(aspect);
 
-            // Set up node shader common uniforms (lighting + glow from theme)
-            ShaderProgram& nodeShader = Renderer::instance().getNodeShader();
-            nodeShader.use();
-            nodeShader.setMat4("uView", cachedView);
-            nodeShader.setMat4("uProjection", cachedProj);
-            nodeShader.setVec3("uLightPos", theme.lightPos);
-            nodeShader.setVec3("uAmbient", theme.ambient);
-            nodeShader.setVec3("uDiffuse", theme.diffuse);
-            nodeShader.setVec3("uViewPos", glm::vec3(0.0f, 500.0f, 1000.0f));
-            nodeShader.setFloat("uHighlight", 0.0f);
-            // Glow/rim uniforms from theme
-            nodeShader.setVec3("uGlowColor", theme.glowColor);
-            nodeShader.setFloat("uGlowIntensity", theme.baseEmissive);
-            nodeShader.setFloat("uRimIntensity", theme.rimIntensity);
-            nodeShader.setFloat("uRimPower", theme.rimPower);
-            nodeShader.unuse();
+            // Camera, lighting and glow from theme, shared by all node
+            // shaders through the frame uniform buffer
+            FrameUniforms frame;
+            frame.view = cachedView;
+            frame.projection = cachedProj;
+            frame.lightPos = theme.lightPos;
+            frame.ambient = theme.ambient;
+            frame.diffuse = theme.diffuse;
+            frame.viewPos = glm::vec3(0.0f, 500.0f, 1000.0f);
+            frame.glowColor = theme.glowColor;
+            frame.baseGlow = theme.baseEmissive;
+            frame.rimIntensity = theme.rimIntensity;
+            frame.rimPower = theme.rimPower;
+            Renderer::instance().setFrameUniforms(frame);
 
             // Draw geometry
-            GeometryManager::instance().draw(cachedView, cachedProj, true);
+            GeometryManager::instance().draw(true);
         }
 
         // Disable 3D state before returning to ImGui
@@ -19,6 +19,9 @@ public:
     int getWidth() const { return width_; }
     int getHeight() const { return height_; }
 
+    // Cancel a context menu opened on a node inside node's subtree
+    void forgetSubtree(const FsNode* node);
+
 private:
     ViewportPanel() = default;
     void createFBO(int width, int height);
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "core/Types.h"
+#include "camera/Frustum.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <cmath>
@@ -50,3 +51,42 @@ TEST(CameraTest, ProjectionMatrix) {
     float ndcZ = nearPoint.z / nearPoint.w;
     EXPECT_NEAR(ndcZ, -1.0f, 0.01f);
 }
+
+TEST(CameraTest, FrustumCulling) {
+    glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 1000), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 1.0f, 1.0f, 10000.0f);
+    Frustum frustum(proj * view);
+
+    Aabb center;
+    center.add(glm::vec3(-10, -10, -10));
+    center.add(glm::vec3(10, 10, 10));
+    EXPECT_TRUE(frustum.intersects(center));
+
+    // Off to the side, and behind the eye
+    Aabb side;
+    side.add(glm::vec3(5000, 0, 0));
+    side.add(glm::vec3(5100, 100, 100));
+    EXPECT_FALSE(frustum.intersects(side));
+    Aabb behind;
+    behind.add(glm::vec3(-10, -10, 1100));
+    behind.add(glm::vec3(10, 10, 1200));
+    EXPECT_FALSE(frustum.intersects(behind));
+
+    EXPECT_FALSE(frustum.intersects(Aabb()));
+    EXPECT_TRUE(Frustum().intersects(side));
+}
+
+TEST(CameraTest, AabbTransformed) {
+    Aabb box;
+    box.add(glm::vec3(0, 0, 0));
+    box.add(glm::vec3(2, 1, 1));
+
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(10, 0, 0));
+    m = glm::rotate(m, glm::radians(90.0f), glm::vec3(0, 0, 1));
+    Aabb out = box.transformed(m);
+    EXPECT_NEAR(out.min.x, 9.0f, 1e-4f);
+    EXPECT_NEAR(out.max.x, 10.0f, 1e-4f);
+    EXPECT_NEAR(out.min.y, 0.0f, 1e-4f);
+    EXPECT_NEAR(out.max.y, 2.0f, 1e-4f);
+    EXPECT_NEAR(out.max.z, 1.0f, 1e-4f);
+}
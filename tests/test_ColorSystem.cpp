@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include "core/Types.h"
 #include "core/PlatformUtils.h"
+#include "core/FsDiff.h"
+#include "core/FsNode.h"
+#include "color/ColorSystem.h"
 
 using namespace fsvng;
 
@@ -74,3 +77,75 @@ TEST(ColorSystemTest, WildcardMatch) {
     EXPECT_FALSE(PlatformUtils::wildcardMatch("f?le.txt", "fiile.txt"));
     EXPECT_TRUE(PlatformUtils::wildcardMatch("*", "anything"));
 }
+
+TEST(ColorSystemTest, DuplicateMode) {
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    FsNode* dir = meta->addChild(std::make_unique<FsNode>());
+    dir->type = NODE_DIRECTORY;
+    dir->id = 1;
+    FsNode* copy = dir->addChild(std::make_unique<FsNode>());
+    copy->type = NODE_REGFILE;
+    copy->id = 2;
+    FsNode* unique = dir->addChild(std::make_unique<FsNode>());
+    unique->type = NODE_REGFILE;
+    unique->id = 3;
+
+    ColorSystem& colors = ColorSystem::instance();
+    colors.init();
+    colors.setMode(COLOR_BY_DUPLICATE);
+    colors.setDuplicates({2});
+    colors.assignRecursive(meta.get());
+    EXPECT_EQ(copy->color, &colors.getConfig().byDuplicate.duplicateColor);
+    EXPECT_EQ(unique->color, &colors.getConfig().byDuplicate.uniqueColor);
+    EXPECT_EQ(dir->color, &colors.getConfig().byNodetype.colors[NODE_DIRECTORY]);
+
+    // Recoloring marks the directory meshes holding the colors for rebuild
+    dir->aDlistStale = false;
+    dir->bDlistStale = false;
+    dir->cDlistStale = false;
+    colors.setDuplicates({});
+    colors.assignRecursive(meta.get());
+    EXPECT_EQ(copy->color, &colors.getConfig().byDuplicate.uniqueColor);
+    EXPECT_TRUE(dir->aDlistStale);
+    EXPECT_TRUE(dir->cDlistStale);
+    EXPECT_FALSE(dir->bDlistStale);
+    colors.setMode(COLOR_BY_NODETYPE);
+}
+
+TEST(ColorSystemTest, GrowthMode) {
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    FsNode* dir = meta->addChild(std::make_unique<FsNode>());
+    dir->type = NODE_DIRECTORY;
+    dir->id = 1;
+    FsNode* files[4];
+    for (unsigned int i = 0; i < 4; ++i) {
+        files[i] = dir->addChild(std::make_unique<FsNode>());
+        files[i]->type = NODE_REGFILE;
+        files[i]->id = 2 + i;
+    }
+
+    auto diff = std::make_shared<FsDiff>();
+    diff->delta = {0, 0, 0, 4096, int64_t(1) << 40, -4096};  // IDs 2..5: same, +, ++, -
+
+    ColorSystem& colors = ColorSystem::instance();
+    colors.init();
+    colors.setMode(COLOR_BY_GROWTH);
+    colors.setGrowth(diff);
+    colors.assignRecursive(meta.get());
+    const auto& config = colors.getConfig().byGrowth;
+    EXPECT_EQ(files[0]->color, &config.unchangedColor);
+    EXPECT_EQ(dir->color, &colors.getConfig().byNodetype.colors[NODE_DIRECTORY]);
+
+    // Bigger growth is closer to the grow color; shrinking leans to blue
+    EXPECT_GT(files[1]->color->r, config.unchangedColor.r);
+    EXPECT_GT(files[2]->color->r, files[1]->color->r);
+    EXPECT_FLOAT_EQ(files[2]->color->r, config.growColor.r);
+    EXPECT_GT(files[3]->color->b, config.unchangedColor.b);
+
+    colors.setGrowth(nullptr);
+    colors.assignRecursive(meta.get());
+    EXPECT_EQ(files[1]->color, &config.unchangedColor);
+    colors.setMode(COLOR_BY_NODETYPE);
+}
@@ -1,6 +1,13 @@
 #include <gtest/gtest.h>
+#include "core/FsDiff.h"
 #include "core/FsNode.h"
 #include "core/FsTree.h"
+#include "core/NameIndex.h"
+#include "core/NodeStore.h"
+#include "core/SizeReport.h"
+#include <chrono>
+#include <thread>
+#include <utility>
 
 using namespace fsvng;
 
@@ -69,13 +76,15 @@ TEST(FsNodeTest, AbsName) {
 
 TEST(FsNodeTest, MapVHelpers) {
     FsNode node;
-    node.mapvGeom.c0 = {-100.0, -50.0};
-    node.mapvGeom.c1 = {100.0, 50.0};
+    node.id = 1;
+    node.mapvGeom().c0 = {-100.0, -50.0};
+    node.mapvGeom().c1 = {100.0, 50.0};
 
     EXPECT_DOUBLE_EQ(node.mapvWidth(), 200.0);
     EXPECT_DOUBLE_EQ(node.mapvDepth(), 100.0);
     EXPECT_DOUBLE_EQ(node.mapvCenterX(), 0.0);
     EXPECT_DOUBLE_EQ(node.mapvCenterY(), 0.0);
+    GeometryStore::instance().clear();
 }
 
 TEST(FsTreeTest, SetupTree) {
@@ -127,3 +136,835 @@ TEST(FsTreeTest, SetupTree) {
 
     tree.clear();
 }
+
+TEST(FsTreeTest, SortTieBreaksOnFoldedName) {
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    FsNode* root = meta->addChild(std::make_unique<FsNode>());
+    root->type = NODE_DIRECTORY;
+    root->name = "root";
+    for (const char* name : {"longname_b", "LongName_A", "long", "Apple", "banana"}) {
+        auto file = std::make_unique<FsNode>();
+        file->type = NODE_REGFILE;
+        file->name = name;
+        file->size = 10;
+        root->addChild(std::move(file));
+    }
+
+    auto& tree = FsTree::instance();
+    tree.setRoot(std::move(meta));
+    tree.setupTree(1);
+    std::vector<std::string> order;
+    for (auto& child : tree.rootDir()->children) {
+        order.push_back(child->name);
+    }
+    EXPECT_EQ(order, (std::vector<std::string>{"Apple", "banana", "long", "LongName_A", "longname_b"}));
+    tree.clear();
+}
+
+namespace {
+
+// Deterministic tree of about 60k nodes with uneven directory sizes.
+std::unique_ptr<FsNode> makeWideTree() {
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    FsNode* root = meta->addChild(std::make_unique<FsNode>());
+    root->type = NODE_DIRECTORY;
+    root->name = "/wide";
+    unsigned int seed = 1;
+    for (int d = 0; d < 40; ++d) {
+        FsNode* dir = root->addChild(std::make_unique<FsNode>());
+        dir->type = NODE_DIRECTORY;
+        dir->name = "dir" + std::to_string(d);
+        for (int s = 0; s < d; ++s) {
+            FsNode* sub = dir->addChild(std::make_unique<FsNode>());
+            sub->type = NODE_DIRECTORY;
+            sub->name = "Sub" + std::to_string(s);
+            for (int f = 0; f < 70; ++f) {
+                auto file = std::make_unique<FsNode>();
+                file->type = NODE_REGFILE;
+                file->name = "f" + std::to_string(f);
+                seed = seed * 1103515245 + 12345;
+                file->size = (seed >> 16) % 50;  // plenty of size ties
+                sub->addChild(std::move(file));
+            }
+        }
+    }
+    unsigned int nextId = 0;
+    std::vector<FsNode*> stack{meta.get()};
+    while (!stack.empty()) {
+        FsNode* node = stack.back();
+        stack.pop_back();
+        node->id = nextId++;
+        for (auto& child : node->children) {
+            stack.push_back(child.get());
+        }
+    }
+    return meta;
+}
+
+void collectShape(const FsNode* node, std::vector<std::string>& out) {
+    out.push_back(node->name + ":" + std::to_string(node->subtree.size) + ":" +
+                  std::to_string(node->subtree.counts[NODE_REGFILE]));
+    for (auto& child : node->children) {
+        collectShape(child.get(), out);
+    }
+}
+
+} // namespace
+
+TEST(FsTreeTest, ParallelSetupMatchesSerial) {
+    auto& tree = FsTree::instance();
+    std::vector<std::string> serial, parallel;
+
+    tree.setRoot(makeWideTree());
+    tree.setupTree(1);
+    collectShape(tree.root(), serial);
+
+    tree.setRoot(makeWideTree());
+    tree.setupTree(4);
+    collectShape(tree.root(), parallel);
+    for (auto& dir : tree.rootDir()->children) {
+        EXPECT_FALSE(dir->flags & NODE_FLAG_SUBTREE_DIRTY);
+        for (auto& sub : dir->children) {
+            EXPECT_FALSE(sub->children.back()->flags & NODE_FLAG_SUBTREE_DIRTY);
+        }
+    }
+
+    EXPECT_GT(serial.size(), 50000u);
+    EXPECT_EQ(serial, parallel);
+    tree.clear();
+}
+
+TEST(FsTreeTest, SetupNumbersBreadthFirst) {
+    auto& tree = FsTree::instance();
+    tree.setRoot(makeWideTree());
+    tree.setupTree(4);
+
+    // Dense IDs in level order; every directory's children hold a
+    // contiguous range, in their sorted order.
+    unsigned int expected = 1;
+    for (unsigned int id = 0; id < tree.nodeCount(); ++id) {
+        const FsNode* node = tree.nodeById(id);
+        ASSERT_NE(node, nullptr);
+        EXPECT_EQ(node->id, id);
+        for (const auto& child : node->children) {
+            EXPECT_EQ(child->id, expected++);
+        }
+    }
+    EXPECT_EQ(expected, tree.nodeCount());
+
+    // The same whatever the setup threading
+    std::string probe = tree.nodeById(tree.nodeCount() / 2)->absName();
+    tree.setRoot(makeWideTree());
+    tree.setupTree(1);
+    EXPECT_EQ(tree.nodeByPath(probe)->id, tree.nodeCount() / 2);
+    tree.clear();
+}
+
+TEST(FsTreeTest, HardLinkOwnerSurvivesRenumbering) {
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    FsNode* root = meta->addChild(std::make_unique<FsNode>());
+    root->type = NODE_DIRECTORY;
+    root->name = "/links";
+    auto addDir = [&](const char* name) {
+        FsNode* dir = root->addChild(std::make_unique<FsNode>());
+        dir->type = NODE_DIRECTORY;
+        dir->name = name;
+        return dir;
+    };
+    auto addFile = [](FsNode* dir, const char* name, int64_t size, uint64_t inode) {
+        FsNode* file = dir->addChild(std::make_unique<FsNode>());
+        file->type = NODE_REGFILE;
+        file->name = name;
+        file->size = size;
+        file->inode = inode;
+        if (inode == 7) file->flags |= NODE_FLAG_MULTILINK;
+        return file;
+    };
+    // "small" was scanned first, so its link has the lower scan ID and owns
+    // the bytes; "big" sorts first and gets lower IDs once renumbered.
+    FsNode* small = addDir("small");
+    FsNode* smallLink = addFile(small, "link", 100, 7);
+    FsNode* big = addDir("big");
+    addFile(big, "data", 1000, 1);
+    FsNode* bigLink = addFile(big, "link", 100, 7);
+    unsigned int nextId = 0;
+    for (FsNode* node : {meta.get(), root, small, smallLink, big, big->children[0].get(), bigLink}) {
+        node->id = nextId++;
+    }
+
+    auto& tree = FsTree::instance();
+    tree.setRoot(std::move(meta));
+    tree.setupTree(1);
+    EXPECT_LT(bigLink->id, smallLink->id);
+    EXPECT_FALSE(smallLink->flags & NODE_FLAG_DUPLICATE);
+    EXPECT_TRUE(bigLink->flags & NODE_FLAG_DUPLICATE);
+
+    tree.updateTree();
+    EXPECT_FALSE(smallLink->flags & NODE_FLAG_DUPLICATE);
+    EXPECT_TRUE(bigLink->flags & NODE_FLAG_DUPLICATE);
+    EXPECT_EQ(small->subtree.size, 100);
+    EXPECT_EQ(big->subtree.size, 1000);
+    tree.clear();
+}
+
+TEST(FsTreeTest, InPlaceEditsMatchFullSetup) {
+    auto& tree = FsTree::instance();
+    tree.setRoot(makeWideTree());
+    tree.setupTree(1);
+    FsNode* root = tree.rootDir();
+    auto dir = [&](const std::string& path) { return tree.nodeByPath("/wide/" + path); };
+
+    FsNode* grown = dir("dir5/Sub2/f3");
+    tree.updateSize(grown, 100000, 102400);
+    EXPECT_EQ(dir("dir5/Sub2")->children[0].get(), grown);
+    EXPECT_EQ(root->children[0]->name, "dir5");
+
+    auto added = std::make_unique<FsNode>();
+    added->type = NODE_DIRECTORY;
+    added->name = "new";
+    FsNode* file = added->addChild(std::make_unique<FsNode>());
+    file->type = NODE_REGFILE;
+    file->name = "payload";
+    file->size = 777;
+    FsNode* addedPtr = tree.addChild(dir("dir3"), std::move(added));
+    EXPECT_EQ(tree.nodeById(file->id), file);
+    EXPECT_EQ(dir("dir3/new/payload"), file);
+    EXPECT_EQ(addedPtr->subtree.size, 777);
+
+    FsNode* doomed = dir("dir7/Sub1");
+    unsigned int doomedId = doomed->id;
+    std::unique_ptr<FsNode> removed = tree.removeSubtree(doomed);
+    EXPECT_EQ(removed.get(), doomed);
+    EXPECT_EQ(tree.nodeById(doomedId), nullptr);
+    EXPECT_EQ(dir("dir7/Sub1"), nullptr);
+
+    FsNode* moved = dir("dir9/Sub0");
+    EXPECT_FALSE(tree.moveNode(dir("dir9"), moved, "loop"));
+    EXPECT_TRUE(tree.moveNode(moved, dir("dir2"), "Moved"));
+    EXPECT_EQ(dir("dir2/Moved"), moved);
+    EXPECT_EQ(dir("dir9/Sub0"), nullptr);
+
+    std::vector<std::string> patched, rebuilt;
+    collectShape(tree.root(), patched);
+    std::vector<FsNode*> stack{tree.root()};
+    while (!stack.empty()) {
+        FsNode* node = stack.back();
+        stack.pop_back();
+        node->flags |= NODE_FLAG_SUBTREE_DIRTY;
+        for (auto& child : node->children) {
+            stack.push_back(child.get());
+        }
+    }
+    tree.updateTree();
+    collectShape(tree.root(), rebuilt);
+    EXPECT_EQ(patched, rebuilt);
+    tree.clear();
+}
+
+TEST(FsTreeTest, SubtreeAllocatedSize) {
+    auto& tree = FsTree::instance();
+
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    meta->id = tree.allocateId();
+
+    auto root = std::make_unique<FsNode>();
+    root->type = NODE_DIRECTORY;
+    root->name = "root";
+    root->id = tree.allocateId();
+    root->sizeAlloc = 4096;
+
+    auto sub = std::make_unique<FsNode>();
+    sub->type = NODE_DIRECTORY;
+    sub->name = "sub";
+    sub->id = tree.allocateId();
+    sub->sizeAlloc = 4096;
+
+    // Sparse file: large logical size, little allocated
+    auto sparse = std::make_unique<FsNode>();
+    sparse->type = NODE_REGFILE;
+    sparse->name = "disk.img";
+    sparse->id = tree.allocateId();
+    sparse->size = 1 << 30;
+    sparse->sizeAlloc = 8192;
+
+    FsNode* rootPtr = meta->addChild(std::move(root));
+    FsNode* subPtr = rootPtr->addChild(std::move(sub));
+    subPtr->addChild(std::move(sparse));
+
+    tree.setRoot(std::move(meta));
+    tree.setupTree();
+
+    EXPECT_EQ(tree.rootDir()->subtree.size, 1 << 30);
+    EXPECT_EQ(tree.rootDir()->subtree.sizeAlloc, 4096 + 8192);
+    EXPECT_EQ(tree.root()->subtree.sizeAlloc, 4096 + 4096 + 8192);
+
+    tree.clear();
+}
+
+TEST(FsTreeTest, UpdateTreeOnlyRevisitsDirtySpine) {
+    auto& tree = FsTree::instance();
+
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    auto root = std::make_unique<FsNode>();
+    root->type = NODE_DIRECTORY;
+    root->name = "root";
+    FsNode* rootPtr = meta->addChild(std::move(root));
+
+    FsNode* dirs[2];
+    FsNode* files[2];
+    for (int i = 0; i < 2; ++i) {
+        auto dir = std::make_unique<FsNode>();
+        dir->type = NODE_DIRECTORY;
+        dir->name = "d" + std::to_string(i);
+        dir->id = 2 + i * 2;
+        auto file = std::make_unique<FsNode>();
+        file->type = NODE_REGFILE;
+        file->name = "f";
+        file->id = 3 + i * 2;
+        file->size = 100;
+        dirs[i] = rootPtr->addChild(std::move(dir));
+        files[i] = dirs[i]->addChild(std::move(file));
+    }
+    rootPtr->id = 1;
+
+    tree.setRoot(std::move(meta));
+    tree.setupTree();
+    EXPECT_EQ(rootPtr->flags & NODE_FLAG_SUBTREE_DIRTY, 0);
+    EXPECT_EQ(rootPtr->subtree.size, 200);
+
+    // Change both files but only flag one; the clean subtree keeps its total
+    files[0]->size = 1000;
+    files[1]->size = 5000;
+    dirs[0]->markDirty();
+    EXPECT_NE(rootPtr->flags & NODE_FLAG_SUBTREE_DIRTY, 0);
+    EXPECT_EQ(dirs[1]->flags & NODE_FLAG_SUBTREE_DIRTY, 0);
+
+    tree.updateTree();
+    EXPECT_EQ(dirs[0]->subtree.size, 1000);
+    EXPECT_EQ(dirs[1]->subtree.size, 100);
+    EXPECT_EQ(rootPtr->subtree.size, 1100);
+    EXPECT_EQ(rootPtr->children[0].get(), dirs[0]);  // re-sorted by size
+    EXPECT_EQ(rootPtr->flags & NODE_FLAG_SUBTREE_DIRTY, 0);
+
+    tree.clear();
+}
+
+TEST(FsTreeTest, NodeStoreMirrorsTree) {
+    auto& tree = FsTree::instance();
+
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    auto root = std::make_unique<FsNode>();
+    root->type = NODE_DIRECTORY;
+    root->name = "root";
+    FsNode* rootPtr = meta->addChild(std::move(root));
+    const char* names[] = {"a.TXT", "b.txt", ".profile"};
+    FsNode* files[3];
+    for (int i = 0; i < 3; ++i) {
+        auto file = std::make_unique<FsNode>();
+        file->type = NODE_REGFILE;
+        file->name = names[i];
+        file->size = 100 * (i + 1);
+        file->sizeAlloc = 4096;
+        files[i] = rootPtr->addChild(std::move(file));
+    }
+
+    tree.setRoot(std::move(meta));
+    tree.setupTree();
+
+    std::shared_ptr<const NodeStore> store = tree.nodeStore();
+    unsigned int rootId = tree.rootDir()->id;
+    ASSERT_TRUE(store->contains(rootId));
+    EXPECT_EQ(store->type(rootId), NODE_DIRECTORY);
+    EXPECT_EQ(store->parent(rootId), tree.root()->id);
+    EXPECT_EQ(store->subtreeSize(rootId), 600);
+    EXPECT_EQ(store->subtreeSizeAlloc(rootId), 3 * 4096);
+    ASSERT_EQ(store->childCount(rootId), 3u);
+    for (uint32_t i = 0; i < 3; ++i) {
+        const FsNode* child = tree.rootDir()->children[i].get();
+        EXPECT_EQ(store->child(rootId, i), child->id);
+        EXPECT_EQ(store->nodeSize(child->id), child->size);
+        EXPECT_EQ(store->parent(child->id), rootId);
+    }
+    EXPECT_EQ(store->parent(tree.root()->id), NodeStore::NONE);
+    EXPECT_FALSE(store->contains(1000));
+
+    // Extensions are case-folded and shared; dotfiles and directories have none
+    uint32_t txt = store->extension(files[0]->id);
+    EXPECT_EQ(store->extensionName(txt), "txt");
+    EXPECT_EQ(store->extension(files[1]->id), txt);
+    EXPECT_EQ(store->extension(files[2]->id), 0u);
+    EXPECT_EQ(store->extension(rootId), 0u);
+
+    // Shared while the tree is unchanged, rebuilt after an edit
+    EXPECT_EQ(tree.nodeStore(), store);
+    FsNode* file = tree.rootDir()->children[0].get();
+    int64_t oldSize = file->size;
+    tree.updateSize(file, 1000, 4096);
+    std::shared_ptr<const NodeStore> updated = tree.nodeStore();
+    EXPECT_NE(updated, store);
+    EXPECT_EQ(updated->nodeSize(file->id), 1000);
+    EXPECT_EQ(updated->subtreeSize(rootId), 600 - oldSize + 1000);
+    EXPECT_EQ(store->nodeSize(file->id), oldSize);  // a copy already handed out stays as it was
+
+    tree.clear();
+}
+
+TEST(FsTreeTest, GeometryKeptPerModeById) {
+    FsNode a;
+    a.id = 1;
+    FsNode b;
+    b.id = 5000;  // lands in another chunk
+    MapVGeomParams& ga = a.mapvGeom();
+    ga.height = 3.0;
+    b.mapvGeom().height = 7.0;
+    EXPECT_DOUBLE_EQ(ga.height, 3.0);  // references survive growth
+    EXPECT_DOUBLE_EQ(b.mapvGeom().height, 7.0);
+
+    a.treevGeom().platform.depth = 2.0;
+    GeometryStore::instance().retainOnly(FSV_TREEV);
+    EXPECT_TRUE(GeometryStore::instance().mapv.empty());
+    EXPECT_DOUBLE_EQ(a.treevGeom().platform.depth, 2.0);
+
+    // Reads through a const node don't grow the column; neither does a node
+    // that has no ID yet alias anyone's slot
+    GeometryStore::instance().clear();
+    EXPECT_DOUBLE_EQ(std::as_const(a).treevGeom().platform.depth, 0.0);
+    EXPECT_TRUE(GeometryStore::instance().treev.empty());
+    const FsNode unnumbered;
+    EXPECT_EQ(unnumbered.id, INVALID_NODE_ID);
+    a.id = 0;
+    a.mapvGeom().height = 4.0;
+    EXPECT_DOUBLE_EQ(unnumbered.mapvGeom().height, 0.0);
+    GeometryStore::instance().clear();
+}
+
+TEST(FsTreeTest, NodesComeFromPoolAndReturnOnClear) {
+    auto root = std::make_unique<FsNode>();  // makes sure this thread has a block
+    root->type = NODE_DIRECTORY;
+    root->name = "/";
+    size_t before = NodePool::blockCount();
+
+    FsNode* dir = root->addChild(std::make_unique<FsNode>());
+    dir->type = NODE_DIRECTORY;
+    dir->name = "dir";
+    for (int i = 0; i < 5000; ++i) {
+        auto file = std::make_unique<FsNode>();
+        file->type = NODE_REGFILE;
+        file->name = "f" + std::to_string(i);
+        dir->addChild(std::move(file));
+    }
+    EXPECT_GT(NodePool::blockCount(), before);
+
+    FsTree& tree = FsTree::instance();
+    tree.setRoot(std::move(root));
+    tree.setupTree();
+    tree.clear();
+    EXPECT_LE(NodePool::blockCount(), before + 1);  // at most the current block
+}
+
+TEST(FsTreeTest, PoolReusesSlotsOfDeletedNodes) {
+    // Nodes added and removed one at a time, a few of each round kept, as
+    // FsWatcher does to a long-lived tree
+    std::vector<std::unique_ptr<FsNode>> kept;
+    kept.push_back(std::make_unique<FsNode>());  // makes sure this thread has a block
+    size_t before = NodePool::blockCount();
+    for (int round = 0; round < 50; ++round) {
+        std::vector<std::unique_ptr<FsNode>> added;
+        for (int i = 0; i < 2000; ++i) {
+            added.push_back(std::make_unique<FsNode>());
+        }
+        for (size_t i = 0; i < added.size(); i += 100) {
+            kept.push_back(std::move(added[i]));
+        }
+    }
+    // 1000 live nodes fit in a few blocks; without reuse this is ~100
+    EXPECT_LE(NodePool::blockCount(), before + 8);
+
+    kept.clear();
+    EXPECT_LE(NodePool::blockCount(), before + 1);
+}
+
+TEST(FsTreeTest, LargeTreeIsFreedInBackground) {
+    auto meta = std::make_unique<FsNode>();  // makes sure this thread has a block
+    meta->type = NODE_METANODE;
+    size_t before = NodePool::blockCount();
+
+    FsNode* root = meta->addChild(std::make_unique<FsNode>());
+    root->type = NODE_DIRECTORY;
+    root->name = "/";
+    for (int d = 0; d < 120; ++d) {
+        FsNode* dir = root->addChild(std::make_unique<FsNode>());
+        dir->type = NODE_DIRECTORY;
+        dir->name = "d" + std::to_string(d);
+        for (int i = 0; i < 1000; ++i) {
+            FsNode* file = dir->addChild(std::make_unique<FsNode>());
+            file->type = NODE_REGFILE;
+            file->name = "f" + std::to_string(i);
+        }
+    }
+
+    FsTree& tree = FsTree::instance();
+    tree.setRoot(std::move(meta));
+    tree.setupTree();
+    ASSERT_GE(tree.nodeCount(), 100000u);
+    tree.clear();  // over the threshold, so torn down on the reaper thread
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (NodePool::blockCount() > before + 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_LE(NodePool::blockCount(), before + 1);
+
+    // Blocks the reaper emptied are gone; new nodes still allocate normally
+    auto node = std::make_unique<FsNode>();
+    node->name = "after";
+    EXPECT_EQ(node->name, "after");
+}
+
+TEST(FsTreeTest, NodeByPathWalksComponents) {
+    auto metanode = std::make_unique<FsNode>();
+    metanode->type = NODE_METANODE;
+    FsNode* top = metanode->addChild(std::make_unique<FsNode>());
+    top->type = NODE_DIRECTORY;
+    top->name = "/data/top";
+    FsNode* sub = top->addChild(std::make_unique<FsNode>());
+    sub->type = NODE_DIRECTORY;
+    sub->name = "sub";
+    FsNode* small = sub->addChild(std::make_unique<FsNode>());
+    small->type = NODE_REGFILE;
+    small->name = "small.txt";
+    std::vector<FsNode*> files;
+    for (int i = 0; i < 100; ++i) {  // enough to get a name index
+        auto file = std::make_unique<FsNode>();
+        file->type = NODE_REGFILE;
+        file->name = "file" + std::to_string(i);
+        file->size = i;
+        files.push_back(top->addChild(std::move(file)));
+    }
+
+    FsTree& tree = FsTree::instance();
+    tree.setRoot(std::move(metanode));
+    tree.setupTree();
+
+    EXPECT_EQ(tree.nodeByPath("/data/top"), top);
+    EXPECT_EQ(tree.nodeByPath("/data/top/"), top);
+    EXPECT_EQ(tree.nodeByPath("/data/top/sub/small.txt"), small);
+    EXPECT_EQ(tree.nodeByPath(small->absName()), small);
+    for (FsNode* file : files) {
+        EXPECT_EQ(tree.nodeByPath(file->absName()), file);
+    }
+    EXPECT_EQ(tree.nodeByPath("/data/topsub"), nullptr);
+    EXPECT_EQ(tree.nodeByPath("/data/top/file100"), nullptr);
+    EXPECT_EQ(tree.nodeByPath("/data/top/sub/missing"), nullptr);
+    EXPECT_EQ(tree.nodeByPath("/data"), nullptr);
+
+    tree.clear();
+    EXPECT_EQ(tree.nodeByPath("/data/top"), nullptr);
+}
+
+TEST(NameIndexTest, SubstringGlobAndRegexRankedBySize) {
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    FsNode* root = meta->addChild(std::make_unique<FsNode>());
+    root->type = NODE_DIRECTORY;
+    root->name = "/home";
+    root->id = 1;
+    unsigned int nextId = 2;
+    auto add = [&](FsNode* dir, const std::string& name, int64_t size) {
+        auto node = std::make_unique<FsNode>();
+        node->type = NODE_REGFILE;
+        node->name = name;
+        node->size = size;
+        node->id = nextId++;
+        return dir->addChild(std::move(node));
+    };
+    FsNode* src = add(root, "src", 0);
+    src->type = NODE_DIRECTORY;
+    FsNode* mainSmall = add(src, "main.cpp", 10);
+    FsNode* mainBig = add(root, "Main.CPP", 500);
+    FsNode* readme = add(root, "README.md", 50);
+    FsNode* domain = add(src, "domain.h", 20);
+    add(src, "ma", 1);
+
+    NameIndex index(NameIndexInput::collect(meta.get()));
+    EXPECT_EQ(index.nodeCount(), 7u);  // with /home itself
+    EXPECT_EQ(index.nameCount(), 6u);  // main.cpp is interned once
+
+    size_t total = 0;
+    auto hits = index.query("main", NameQuery::Substring, 10, &total);
+    ASSERT_EQ(total, 3u);  // Main.CPP, main.cpp, domain.h
+    EXPECT_EQ(hits[0].id, mainBig->id);
+    EXPECT_EQ(hits[1].id, domain->id);
+    EXPECT_EQ(hits[2].id, mainSmall->id);
+
+    hits = index.query("main", NameQuery::Substring, 1, &total);
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(total, 3u);
+
+    EXPECT_EQ(index.query("ma", NameQuery::Substring, 10, &total).size(), 4u);
+    EXPECT_TRUE(index.query("xyz", NameQuery::Substring, 10).empty());
+
+    hits = index.query("*.md", NameQuery::Glob, 10);
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(hits[0].id, readme->id);
+    EXPECT_EQ(index.query("ma??.cpp", NameQuery::Glob, 10).size(), 2u);
+    EXPECT_TRUE(index.query("main", NameQuery::Glob, 10).empty());  // whole name
+
+    EXPECT_EQ(index.query("^ma.n\\.c(pp|c)$", NameQuery::Regex, 10).size(), 2u);
+    EXPECT_EQ(index.query("do+main", NameQuery::Regex, 10).size(), 1u);
+    EXPECT_EQ(index.query("mai?n", NameQuery::Regex, 10).size(), 3u);
+    std::string error;
+    EXPECT_TRUE(index.query("(", NameQuery::Regex, 10, nullptr, &error).empty());
+    EXPECT_FALSE(error.empty());
+}
+
+TEST(NameIndexTest, RegexEscapePayloadsAreNotLiterals) {
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    FsNode* root = meta->addChild(std::make_unique<FsNode>());
+    root->type = NODE_DIRECTORY;
+    root->name = "/";
+    root->id = 1;
+    unsigned int nextId = 2;
+    for (const char* name : {"foo.bar", "abc", "x1y"}) {
+        auto node = std::make_unique<FsNode>();
+        node->type = NODE_REGFILE;
+        node->name = name;
+        node->id = nextId++;
+        root->addChild(std::move(node));
+    }
+
+    NameIndex index(NameIndexInput::collect(meta.get()));
+    EXPECT_EQ(index.query("foo\\x2ebar", NameQuery::Regex, 10).size(), 1u);
+    EXPECT_EQ(index.query("a\\u0062c", NameQuery::Regex, 10).size(), 1u);
+    EXPECT_EQ(index.query("^x\\x31y$", NameQuery::Regex, 10).size(), 1u);
+    EXPECT_EQ(index.query("foo\\.bar", NameQuery::Regex, 10).size(), 1u);
+    EXPECT_TRUE(index.query("foo\\x2cbar", NameQuery::Regex, 10).empty());
+}
+
+TEST(NameIndexTest, SearchBuildsInBackground) {
+    auto& tree = FsTree::instance();
+    tree.setRoot(makeWideTree());
+    tree.setupTree(1);
+
+    NameSearch search;
+    EXPECT_EQ(search.index(), nullptr);
+    search.rebuild(tree.root());
+    search.wait();
+    auto index = search.index();
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(index->nodeCount(), tree.nodeCount() - 1);  // all but the metanode
+
+    auto hits = index->query("sub38", NameQuery::Substring, 5);
+    ASSERT_EQ(hits.size(), 1u);  // only dir39 has a Sub38
+    EXPECT_EQ(tree.nodeById(hits[0].id), tree.nodeByPath("/wide/dir39/Sub38"));
+
+    search.clear();
+    EXPECT_EQ(search.index(), nullptr);
+    tree.clear();
+}
+
+TEST(SizeReportTest, LargestFilesDirsAndGroups) {
+    auto meta = std::make_unique<FsNode>();
+    meta->type = NODE_METANODE;
+    FsNode* root = meta->addChild(std::make_unique<FsNode>());
+    root->type = NODE_DIRECTORY;
+    root->name = "/data";
+    root->id = 1;
+    unsigned int nextId = 2;
+    auto add = [&](FsNode* dir, const std::string& name, int64_t size, uint32_t uid) {
+        auto node = std::make_unique<FsNode>();
+        node->type = NODE_REGFILE;
+        node->name = name;
+        node->size = size;
+        node->userId = uid;
+        node->id = nextId++;
+        return dir->addChild(std::move(node));
+    };
+    FsNode* media = add(root, "media", 0, 0);
+    media->type = NODE_DIRECTORY;
+    FsNode* movie = add(media, "movie.MKV", 900, 1000);
+    FsNode* clip = add(media, "clip.mkv", 300, 1000);
+    FsNode* notes = add(root, "notes.txt", 40, 1001);
+    add(root, ".bashrc", 5, 1001);
+    FsNode* link = add(media, "movie-link.mkv", 900, 1000);
+    for (FsNode* n : {movie, link}) {  // counted once, like subtree totals
+        n->inode = 42;
+        n->flags |= NODE_FLAG_MULTILINK;
+    }
+
+    auto& tree = FsTree::instance();
+    tree.setRoot(std::move(meta));
+    tree.setupTree(1);
+
+    SizeReport report = SizeReport::compute(tree, {2, false});
+    EXPECT_EQ(report.generation, tree.generation());
+    EXPECT_EQ(report.largestFiles, (std::vector<unsigned int>{movie->id, clip->id}));
+    EXPECT_EQ(report.largestDirs, (std::vector<unsigned int>{root->id, media->id}));
+
+    ASSERT_EQ(report.byExtension.size(), 3u);
+    EXPECT_EQ(report.byExtension[0].name, "mkv");  // case folded
+    EXPECT_EQ(report.byExtension[0].size, 1200);
+    EXPECT_EQ(report.byExtension[0].files, 2u);
+    EXPECT_EQ(report.byExtension[0].largest, (std::vector<unsigned int>{movie->id, clip->id}));
+    EXPECT_EQ(report.byExtension[1].name, "txt");
+    EXPECT_EQ(report.byExtension[2].name, "");  // .bashrc has none
+
+    ASSERT_EQ(report.byOwner.size(), 2u);
+    EXPECT_EQ(report.byOwner[0].size, 1200);
+    EXPECT_EQ(report.byOwner[1].size, 45);
+    EXPECT_EQ(report.byOwner[1].largest.front(), notes->id);
+    tree.clear();
+}
+
+TEST(SizeReportTest, ParallelMatchesSerialAndCachesPerGeneration) {
+    auto& tree = FsTree::instance();
+    tree.setRoot(makeWideTree());
+    tree.setupTree(1);
+
+    SizeReport serial = SizeReport::compute(tree, {50, false}, 1);
+    SizeReport parallel = SizeReport::compute(tree, {50, false}, 4);
+    ASSERT_EQ(serial.largestFiles.size(), 50u);
+    EXPECT_EQ(serial.largestFiles, parallel.largestFiles);
+    EXPECT_EQ(serial.largestDirs, parallel.largestDirs);
+    ASSERT_EQ(serial.byExtension.size(), 1u);  // no f<n> has an extension
+    EXPECT_EQ(serial.byExtension[0].largest, parallel.byExtension[0].largest);
+    EXPECT_EQ(serial.byExtension[0].size, tree.root()->children[0]->subtree.size);
+
+    SizeReporter reporter;
+    reporter.request({50, false});
+    reporter.cancel();  // may or may not have finished; either way no worker
+    reporter.request({50, false});
+    while (reporter.isRunning()) {
+        std::this_thread::yield();
+    }
+    ASSERT_NE(reporter.report(), nullptr);
+    EXPECT_EQ(reporter.report()->largestFiles, serial.largestFiles);
+    EXPECT_TRUE(reporter.isCurrent({50, false}));
+    EXPECT_FALSE(reporter.isCurrent({50, true}));
+
+    FsNode* file = tree.nodeByPath("/wide/dir39/Sub0/f0");
+    ASSERT_NE(file, nullptr);
+    tree.updateSize(file, 1000000, 1000000);
+    EXPECT_FALSE(reporter.isCurrent({50, false}));
+    reporter.request({50, false});
+    while (reporter.isRunning()) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(reporter.report()->largestFiles.front(), file->id);
+
+    reporter.clear();
+    EXPECT_EQ(reporter.report(), nullptr);
+    tree.clear();
+}
+
+TEST(FsDiffTest, AlignsByPathAndTotalsDeltas) {
+    auto makeTree = [](const std::vector<std::pair<std::string, int64_t>>& entries) {
+        // "dir/" entries are directories; parents come before their children
+        auto meta = std::make_unique<FsNode>();
+        meta->type = NODE_METANODE;
+        FsNode* root = meta->addChild(std::make_unique<FsNode>());
+        root->type = NODE_DIRECTORY;
+        root->name = "/data";
+        unsigned int nextId = 0;
+        meta->id = nextId++;
+        root->id = nextId++;
+        for (const auto& [path, size] : entries) {
+            FsNode* dir = root;
+            std::string rest = path;
+            size_t slash;
+            while ((slash = rest.find('/')) != std::string::npos && slash + 1 < rest.size()) {
+                std::string part = rest.substr(0, slash);
+                for (auto& child : dir->children) {
+                    if (child->name == part) dir = child.get();
+                }
+                rest = rest.substr(slash + 1);
+            }
+            auto node = std::make_unique<FsNode>();
+            bool isDir = rest.back() == '/';
+            node->type = isDir ? NODE_DIRECTORY : NODE_REGFILE;
+            node->name = isDir ? rest.substr(0, rest.size() - 1) : rest;
+            node->size = size;
+            node->id = nextId++;
+            dir->addChild(std::move(node));
+        }
+        return meta;
+    };
+
+    auto& tree = FsTree::instance();
+    tree.setRoot(makeTree({{"keep.txt", 100}, {"grow.txt", 60}, {"new.txt", 30},
+                           {"newdir/", 0}, {"newdir/c", 4}, {"swap/", 0}, {"swap/d", 1},
+                           {"sub/", 0}, {"sub/x", 20}, {"sub/y", 2}}));
+    tree.setupTree(1);
+    auto node = [&](const char* path) { return tree.nodeByPath(std::string("/data/") + path); };
+
+    FsDiff diffs[2];
+    for (int i = 0; i < 2; ++i) {
+        auto base = makeTree({{"keep.txt", 100}, {"grow.txt", 10}, {"gone.txt", 50},
+                              {"olddir/", 0}, {"olddir/a", 5}, {"olddir/b", 7},
+                              {"swap", 3}, {"sub/", 0}, {"sub/x", 20}});
+        diffs[i] = FsDiff::compare(base.get(), tree.root(), tree.nodeCount(), false,
+                                   i == 0 ? 1 : 4);
+    }
+    const FsDiff& diff = diffs[0];
+    EXPECT_EQ(diffs[1].delta, diff.delta);
+    EXPECT_EQ(diffs[1].flags, diff.flags);
+    ASSERT_EQ(diffs[1].removed.size(), diff.removed.size());
+
+    EXPECT_EQ(diff.deltaOf(node("keep.txt")), 0);
+    EXPECT_EQ(diff.flagsOf(node("keep.txt")), 0);
+    EXPECT_EQ(diff.deltaOf(node("grow.txt")), 50);
+    EXPECT_EQ(diff.flagsOf(node("grow.txt")), FsDiff::CHANGED);
+    EXPECT_EQ(diff.flagsOf(node("new.txt")), FsDiff::ADDED | FsDiff::CHANGED);
+    EXPECT_EQ(diff.deltaOf(node("newdir")), 4);
+    EXPECT_TRUE(diff.flagsOf(node("newdir/c")) & FsDiff::ADDED);
+    EXPECT_TRUE(diff.flagsOf(node("swap")) & FsDiff::ADDED);  // was a file
+    EXPECT_EQ(diff.deltaOf(node("sub")), 2);
+    EXPECT_EQ(diff.flagsOf(node("sub/x")), 0);
+
+    ASSERT_EQ(diff.removed.size(), 3u);
+    EXPECT_EQ(diff.removed[0].name, "gone.txt");
+    EXPECT_EQ(diff.removed[1].name, "olddir");
+    EXPECT_EQ(diff.removed[1].size, 12);
+    EXPECT_TRUE(diff.removed[1].dir);
+    EXPECT_EQ(diff.removed[2].name, "swap");
+    EXPECT_EQ(diff.removed[2].parentId, tree.rootDir()->id);
+
+    EXPECT_EQ(diff.totalDelta, 22);
+    EXPECT_EQ(diff.addedBytes, 30 + 4 + 1 + 2);
+    EXPECT_EQ(diff.removedBytes, 50 + 5 + 7 + 3);
+    EXPECT_EQ(diff.addedNodes, 6u);
+    EXPECT_EQ(diff.removedNodes, 5u);
+    tree.clear();
+}
+
+TEST(FsDiffTest, ParallelMatchesSerialOnWideTree) {
+    auto& tree = FsTree::instance();
+    tree.setRoot(makeWideTree());
+    tree.setupTree(1);
+    FsNode* file = tree.nodeByPath("/wide/dir30/Sub7/f3");
+    ASSERT_NE(file, nullptr);
+    int64_t oldSize = file->size;
+    tree.updateSize(file, oldSize + 1000, 0);
+
+    auto serialBase = makeWideTree();
+    auto parallelBase = makeWideTree();
+    FsDiff serial = FsDiff::compare(serialBase.get(), tree.root(), tree.nodeCount(), false, 1);
+    FsDiff parallel = FsDiff::compare(parallelBase.get(), tree.root(), tree.nodeCount(), false, 4);
+    EXPECT_EQ(serial.delta, parallel.delta);
+    EXPECT_EQ(serial.totalDelta, 1000);
+    EXPECT_EQ(serial.deltaOf(tree.nodeByPath("/wide/dir30")), 1000);
+    EXPECT_EQ(serial.deltaOf(tree.nodeByPath("/wide/dir29")), 0);
+    EXPECT_TRUE(serial.removed.empty());
+    EXPECT_EQ(serial.addedNodes, 0u);
+
+    // Base totals are filled in as a side effect
+    EXPECT_EQ(serialBase->children[0]->subtree.size, tree.rootDir()->subtree.size - 1000);
+    tree.clear();
+}
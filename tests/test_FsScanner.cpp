@@ -1,8 +1,18 @@
 #include <gtest/gtest.h>
+#include "core/DuplicateFinder.h"
 #include "core/FsScanner.h"
+#include "core/FsLoader.h"
 #include "core/FsNode.h"
+#include "core/FsSnapshot.h"
+#include "core/FsTree.h"
+#include "core/FsWatcher.h"
+#include "core/PlatformUtils.h"
+#include "core/ScanFilter.h"
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <thread>
 
 using namespace fsvng;
 
@@ -62,3 +72,664 @@ TEST(FsScannerTest, ProgressCallback) {
 
     fs::remove_all(tempDir);
 }
+
+// Compare two scanned trees node by node (names, types, sizes and IDs).
+static void expectSameTree(const FsNode* a, const FsNode* b) {
+    ASSERT_EQ(a->name, b->name);
+    EXPECT_EQ(a->type, b->type);
+    EXPECT_EQ(a->size, b->size);
+    EXPECT_EQ(a->id, b->id);
+    ASSERT_EQ(a->childCount(), b->childCount()) << a->absName();
+    for (size_t i = 0; i < a->childCount(); ++i) {
+        expectSameTree(a->children[i].get(), b->children[i].get());
+    }
+}
+
+TEST(FsScannerTest, ParallelMatchesSerial) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_parallel";
+    fs::remove_all(tempDir);
+
+    // A few levels of directories with files in each
+    for (int i = 0; i < 6; ++i) {
+        fs::path d = tempDir / ("dir" + std::to_string(i));
+        for (int j = 0; j < 4; ++j) {
+            fs::path sub = d / ("sub" + std::to_string(j));
+            fs::create_directories(sub);
+            for (int k = 0; k < 3; ++k) {
+                std::ofstream(sub / ("f" + std::to_string(k))) << std::string(i * 100 + j * 10 + k, 'x');
+            }
+        }
+        std::ofstream(d / "top.txt") << "top";
+    }
+
+    FsScanner serial;
+    auto serialRoot = serial.scan(tempDir.string());
+
+    FsScanner parallel;
+    parallel.options.threadCount = 4;
+    int lastFiles = 0;
+    auto parallelRoot = parallel.scan(tempDir.string(), [&](const std::string&, const ScanStats& stats) {
+        lastFiles = stats.nodeCounts[NODE_REGFILE];
+    });
+
+    ASSERT_NE(serialRoot, nullptr);
+    ASSERT_NE(parallelRoot, nullptr);
+    expectSameTree(serialRoot.get(), parallelRoot.get());
+
+    // The final progress report covers every file
+    EXPECT_EQ(lastFiles, 6 * 4 * 3 + 6);
+
+    fs::remove_all(tempDir);
+}
+
+static const FsNode* findChild(const FsNode* dir, const std::string& name) {
+    for (const auto& child : dir->children) {
+        if (child->name == name) return child.get();
+    }
+    return nullptr;
+}
+
+TEST(FsScannerTest, RescanReusesUnchangedDirectories) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_rescan";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "same" / "deep");
+    fs::create_directories(tempDir / "changed");
+    std::ofstream(tempDir / "same" / "keep.txt") << "keep";
+    std::ofstream(tempDir / "same" / "deep" / "grow.txt") << "v1";
+    std::ofstream(tempDir / "changed" / "old.txt") << "old";
+    std::ofstream(tempDir / "changed" / "gone.txt") << "gone";
+
+    // Directories modified in the same second as a scan are always re-read,
+    // so backdate them to make the unchanged ones look settled.
+    auto past = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    for (const char* dir : {"", "same", "same/deep", "changed"}) {
+        fs::last_write_time(tempDir / dir, past);
+    }
+
+    FsScanner scanner;
+    FsTree& tree = FsTree::instance();
+    tree.setRoot(scanner.scan(tempDir.string()));
+    tree.setupTree();
+
+    const FsNode* rootDir = tree.rootDir();
+    const FsNode* same = findChild(rootDir, "same");
+    const FsNode* keep = findChild(same, "keep.txt");
+    const FsNode* changed = findChild(rootDir, "changed");
+    const FsNode* oldFile = findChild(changed, "old.txt");
+    unsigned int keepId = keep->id;
+    unsigned int maxId = tree.nodeCount() - 1;
+
+    // "deep" gains a subdirectory, "changed" loses one file and gains another.
+    fs::create_directories(tempDir / "same" / "deep" / "new");
+    std::ofstream(tempDir / "same" / "deep" / "new" / "n.bin") << std::string(1000, 'n');
+    fs::remove(tempDir / "changed" / "gone.txt");
+    std::ofstream(tempDir / "changed" / "added.txt") << "added";
+
+    int filesRead = 0;
+    ASSERT_TRUE(scanner.rescan(tree.root(), [&](const std::string&, const ScanStats& stats) {
+        filesRead = stats.nodeCounts[NODE_REGFILE];
+    }));
+    tree.updateTree();
+
+    // Nodes of entries still present survive, IDs included
+    EXPECT_EQ(findChild(rootDir, "same"), same);
+    EXPECT_EQ(findChild(same, "keep.txt"), keep);
+    EXPECT_EQ(keep->id, keepId);
+    EXPECT_EQ(findChild(changed, "old.txt"), oldFile);
+    EXPECT_EQ(findChild(changed, "gone.txt"), nullptr);
+
+    // Removed entries are handed over still linked to their old parent, and
+    // only the re-read directories are reported as changed
+    std::vector<std::unique_ptr<FsNode>> removed = scanner.takeRemoved();
+    ASSERT_EQ(removed.size(), 1u);
+    EXPECT_EQ(removed[0]->name, "gone.txt");
+    EXPECT_EQ(removed[0]->parent, changed);
+    std::vector<FsNode*> changedDirs = scanner.changedDirs();
+    std::sort(changedDirs.begin(), changedDirs.end(),
+              [](const FsNode* a, const FsNode* b) { return a->name < b->name; });
+    ASSERT_EQ(changedDirs.size(), 2u);
+    EXPECT_EQ(changedDirs[0], changed);
+    EXPECT_EQ(changedDirs[1]->name, "deep");
+
+    // New entries get fresh IDs and resolve through the node table
+    const FsNode* added = findChild(changed, "added.txt");
+    ASSERT_NE(added, nullptr);
+    EXPECT_GT(added->id, maxId);
+    EXPECT_EQ(tree.nodeById(added->id), added);
+
+    // Only the changed directories were re-read: "changed" (old, added) and
+    // "deep" (grow.txt), plus the new directory's file
+    EXPECT_EQ(filesRead, 4);
+
+    // Totals match a full scan of the new state
+    int64_t rescannedSize = rootDir->subtree.size;
+    std::vector<unsigned int> rescannedCounts(rootDir->subtree.counts,
+                                              rootDir->subtree.counts + NUM_NODE_TYPES);
+    FsScanner fresh;
+    tree.setRoot(fresh.scan(tempDir.string()));
+    tree.setupTree();
+    const FsNode* expected = tree.rootDir();
+    EXPECT_EQ(rescannedSize, expected->subtree.size);
+    for (int i = 0; i < NUM_NODE_TYPES; ++i) {
+        EXPECT_EQ(rescannedCounts[i], expected->subtree.counts[i]) << i;
+    }
+
+    tree.clear();
+    fs::remove_all(tempDir);
+}
+
+TEST(FsScannerTest, LazyScanFillsPlaceholders) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_lazy";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "a" / "b" / "c");
+    fs::create_directories(tempDir / "x");
+    std::ofstream(tempDir / "top.txt") << "top";
+    std::ofstream(tempDir / "a" / "b" / "c" / "deep.bin") << std::string(2000, 'd');
+    std::ofstream(tempDir / "x" / "y.txt") << std::string(300, 'y');
+
+    // Only the root's entries are read; "a" and "x" are placeholders
+    FsScanner scanner;
+    scanner.options.maxDepth = 1;
+    FsTree& tree = FsTree::instance();
+    tree.setRoot(scanner.scan(tempDir.string()));
+    tree.setupTree();
+    FsNode* rootDir = tree.rootDir();
+    const FsNode* a = findChild(rootDir, "a");
+    ASSERT_NE(a, nullptr);
+    EXPECT_TRUE(a->flags & NODE_FLAG_UNSCANNED);
+    EXPECT_TRUE(a->children.empty());
+    EXPECT_NE(findChild(rootDir, "top.txt"), nullptr);
+
+    FsLoader loader;
+    loader.options.maxDepth = 1;
+    loader.start();
+    loader.request(a, true);
+
+    // Each job is depth-limited too: "a" arrives with "b" as a placeholder,
+    // which is then filled in as background work
+    bool sawNestedPlaceholder = false;
+    for (int i = 0; i < 200 && !loader.isIdle(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::vector<FsNode*> filled = loader.applyCompleted();
+        if (filled.empty()) continue;
+        tree.updateTree();
+        for (FsNode* dir : filled) {
+            EXPECT_FALSE(dir->flags & NODE_FLAG_UNSCANNED);
+            if (dir == a) {
+                const FsNode* b = findChild(a, "b");
+                ASSERT_NE(b, nullptr);
+                sawNestedPlaceholder = (b->flags & NODE_FLAG_UNSCANNED) != 0;
+            }
+        }
+    }
+    EXPECT_TRUE(sawNestedPlaceholder);
+    const FsNode* c = findChild(findChild(a, "b"), "c");
+    ASSERT_NE(c, nullptr);
+    ASSERT_NE(findChild(c, "deep.bin"), nullptr);
+    EXPECT_EQ(tree.nodeById(c->id), c);
+
+    // Background work covers the rest of the tree
+    loader.requestPlaceholders(rootDir);
+    for (int i = 0; i < 200 && !loader.isIdle(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (!loader.applyCompleted().empty()) {
+            tree.updateTree();
+        }
+    }
+    loader.stop();
+    int64_t lazySize = rootDir->subtree.size;
+    unsigned int lazyFiles = rootDir->subtree.counts[NODE_REGFILE];
+
+    FsScanner full;
+    tree.setRoot(full.scan(tempDir.string()));
+    tree.setupTree();
+    EXPECT_EQ(lazySize, tree.rootDir()->subtree.size);
+    EXPECT_EQ(lazyFiles, tree.rootDir()->subtree.counts[NODE_REGFILE]);
+
+    tree.clear();
+    fs::remove_all(tempDir);
+}
+
+TEST(FsScannerTest, ScanFilterMatchesRules) {
+    ScanFilter filter({ ".git", "*.o", "#*#", "/proc", "/home/*/.cache/" });
+    EXPECT_TRUE(filter.excludes("/src", ".git"));
+    EXPECT_FALSE(filter.excludes("/src", ".gitignore"));
+    EXPECT_TRUE(filter.excludes("/src", "main.o"));
+    EXPECT_FALSE(filter.excludes("/src", "main.c"));
+    EXPECT_TRUE(filter.excludes("/src", "#draft#"));
+    EXPECT_TRUE(filter.excludes("/", "proc"));
+    EXPECT_FALSE(filter.excludes("/srv", "proc"));
+    EXPECT_TRUE(filter.excludes("/home/ann", ".cache"));
+    EXPECT_FALSE(filter.excludes("/home/ann", ".config"));
+    EXPECT_TRUE(ScanFilter().empty());
+
+    // The combined automaton agrees with matching each glob on its own
+    std::vector<std::string> globs = { "*.o", "a*b?c", "*x*y*", "??", "test_*.cpp", "*~" };
+    ScanFilter combined(globs);
+    for (const char* name : { "a.o", "abbbxc", "ab", "xy", "zzxqqy", "test_.cpp",
+                              "test_a.cp", "notes~", "~x", "", "o", "aXbYc" }) {
+        bool expected = false;
+        for (const std::string& glob : globs) {
+            expected = expected || PlatformUtils::wildcardMatch(glob, name);
+        }
+        EXPECT_EQ(combined.excludes("/", name), expected) << name;
+    }
+}
+
+TEST(FsScannerTest, ExcludedEntriesArePruned) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_exclude";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / ".git" / "objects");
+    fs::create_directories(tempDir / "src" / "node_modules" / "pkg");
+    fs::create_directories(tempDir / "skipme");
+    std::ofstream(tempDir / ".git" / "objects" / "blob") << std::string(500, 'g');
+    std::ofstream(tempDir / "src" / "main.c") << "int main;";
+    std::ofstream(tempDir / "src" / "main.o") << std::string(100, 'o');
+    std::ofstream(tempDir / "skipme" / "big") << std::string(1000, 's');
+
+    for (unsigned int threads : { 1u, 2u }) {
+        FsScanner scanner;
+        scanner.options.threadCount = threads;
+        scanner.options.exclude = { ".git", "node_modules", "*.o",
+                                    fs::canonical(tempDir / "skipme").string() };
+        FsTree& tree = FsTree::instance();
+        tree.setRoot(scanner.scan(tempDir.string()));
+        tree.setupTree();
+
+        FsNode* rootDir = tree.rootDir();
+        EXPECT_EQ(findChild(rootDir, ".git"), nullptr);
+        EXPECT_EQ(findChild(rootDir, "skipme"), nullptr);
+        const FsNode* src = findChild(rootDir, "src");
+        ASSERT_NE(src, nullptr);
+        EXPECT_EQ(src->childCount(), 1u);
+        EXPECT_NE(findChild(src, "main.c"), nullptr);
+        EXPECT_EQ(rootDir->subtree.size, 9);
+    }
+
+    // A rescan applies rules added since, even to unchanged directories
+    FsScanner rescanner;
+    rescanner.options.exclude = { "main.c" };
+    FsTree& tree = FsTree::instance();
+    tree.setRoot(rescanner.scan(tempDir.string()));
+    tree.setupTree();
+    EXPECT_NE(findChild(tree.rootDir(), ".git"), nullptr);
+    rescanner.options.exclude = { "main.c", ".git" };
+    ASSERT_TRUE(rescanner.rescan(tree.root()));
+    tree.updateTree();
+    EXPECT_EQ(findChild(tree.rootDir(), ".git"), nullptr);
+    EXPECT_EQ(tree.rootDir()->subtree.size, 1100);
+
+    tree.clear();
+    fs::remove_all(tempDir);
+}
+
+TEST(FsScannerTest, SnapshotRoundTrip) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_snapshot";
+    auto snapPath = fs::temp_directory_path() / "fsvng_test_snapshot.fsvs";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "a" / "b");
+    fs::create_directories(tempDir / "empty");
+    std::ofstream(tempDir / "top.txt") << "top level";
+    std::ofstream(tempDir / "a" / "mid.dat") << std::string(300, 'm');
+    std::ofstream(tempDir / "a" / "b" / "leaf") << "x";
+
+    // Saved as the app does, once set up and numbered
+    FsScanner scanner;
+    FsTree& tree = FsTree::instance();
+    tree.setRoot(scanner.scan(tempDir.string()));
+    tree.setupTree();
+    const FsNode* scanned = tree.root();
+    ASSERT_NE(scanned, nullptr);
+
+    std::string error;
+    ASSERT_TRUE(FsSnapshot::save(scanned, snapPath.string(), &error)) << error;
+    EXPECT_TRUE(FsSnapshot::isSnapshot(snapPath.string()));
+    EXPECT_FALSE(FsSnapshot::isSnapshot((tempDir / "top.txt").string()));
+
+    auto loaded = FsSnapshot::load(snapPath.string(), &error);
+    ASSERT_NE(loaded, nullptr) << error;
+    expectSameTree(scanned, loaded.get());
+
+    // Parent links and full metadata survive the round trip
+    std::vector<std::pair<const FsNode*, const FsNode*>> stack{{scanned, loaded.get()}};
+    while (!stack.empty()) {
+        auto [a, b] = stack.back();
+        stack.pop_back();
+        EXPECT_EQ(a->sizeAlloc, b->sizeAlloc);
+        EXPECT_EQ(a->mtime, b->mtime);
+        EXPECT_EQ(a->perms, b->perms);
+        EXPECT_EQ(a->userId, b->userId);
+        if (!a->isMetanode()) {
+            EXPECT_EQ(a->absName(), b->absName());
+        }
+        for (size_t i = 0; i < a->childCount(); ++i) {
+            stack.push_back({a->children[i].get(), b->children[i].get()});
+        }
+    }
+
+    tree.clear();
+    fs::remove_all(tempDir);
+    fs::remove(snapPath);
+}
+
+TEST(FsScannerTest, SnapshotRejectsCorruptFiles) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_snapshot_bad";
+    auto snapPath = fs::temp_directory_path() / "fsvng_test_snapshot_bad.fsvs";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "sub");
+    std::ofstream(tempDir / "sub" / "file") << "data";
+
+    FsScanner scanner;
+    auto scanned = scanner.scan(tempDir.string());
+    ASSERT_TRUE(FsSnapshot::save(scanned.get(), snapPath.string()));
+    uintmax_t fullSize = fs::file_size(snapPath);
+
+    // Truncated in the middle of the records
+    fs::resize_file(snapPath, sizeof(FsSnapshot::SnapshotHeader) + 10);
+    std::string error;
+    EXPECT_EQ(FsSnapshot::load(snapPath.string(), &error), nullptr);
+    EXPECT_FALSE(error.empty());
+
+    // Child range pointing past the end of the record table
+    ASSERT_TRUE(FsSnapshot::save(scanned.get(), snapPath.string()));
+    ASSERT_EQ(fs::file_size(snapPath), fullSize);
+    {
+        std::fstream f(snapPath, std::ios::in | std::ios::out | std::ios::binary);
+        FsSnapshot::SnapshotRecord rec;
+        std::streamoff recOffset = sizeof(FsSnapshot::SnapshotHeader) + sizeof(rec);
+        f.seekg(recOffset);
+        f.read(reinterpret_cast<char*>(&rec), sizeof(rec));
+        rec.childCount = 1000;
+        f.seekp(recOffset);
+        f.write(reinterpret_cast<const char*>(&rec), sizeof(rec));
+    }
+    EXPECT_EQ(FsSnapshot::load(snapPath.string()), nullptr);
+
+    // Not a snapshot at all
+    EXPECT_EQ(FsSnapshot::load((tempDir / "sub" / "file").string()), nullptr);
+    EXPECT_EQ(FsSnapshot::load((tempDir / "missing").string()), nullptr);
+
+    fs::remove_all(tempDir);
+    fs::remove(snapPath);
+}
+
+#ifdef __linux__
+#include <sys/stat.h>
+
+TEST(FsScannerTest, GetdentsBackendMatchesPortable) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_getdents";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "a" / "b");
+    std::ofstream(tempDir / "one.txt") << "1";
+    std::ofstream(tempDir / "a" / "two.txt") << "22";
+    std::ofstream(tempDir / "a" / "b" / "three.txt") << "333";
+    fs::create_symlink("one.txt", tempDir / "link");
+
+    FsScanner portable;
+    portable.options.backend = ScanBackend::Portable;
+    auto portableRoot = portable.scan(tempDir.string());
+
+    FsScanner native;
+    native.options.backend = ScanBackend::Getdents;
+    auto nativeRoot = native.scan(tempDir.string());
+
+    ASSERT_NE(portableRoot, nullptr);
+    ASSERT_NE(nativeRoot, nullptr);
+    expectSameTree(portableRoot.get(), nativeRoot.get());
+
+    // The single statx also fills ownership and all three timestamps
+    struct stat st;
+    ASSERT_EQ(lstat((tempDir / "one.txt").c_str(), &st), 0);
+    for (auto& child : nativeRoot->children[0]->children) {
+        if (child->name == "one.txt") {
+            EXPECT_EQ(child->userId, st.st_uid);
+            EXPECT_EQ(child->groupId, st.st_gid);
+            EXPECT_EQ(child->atime, st.st_atime);
+            EXPECT_EQ(child->ctime, st.st_ctime);
+            EXPECT_EQ(child->sizeAlloc, static_cast<int64_t>(st.st_blocks) * 512);
+        }
+    }
+
+    fs::remove_all(tempDir);
+}
+
+TEST(FsScannerTest, SparseFileAllocatedSize) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_sparse";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir);
+    std::ofstream(tempDir / "sparse.img") << "x";
+    fs::resize_file(tempDir / "sparse.img", 64 * 1024 * 1024);
+
+    struct stat st;
+    ASSERT_EQ(lstat((tempDir / "sparse.img").c_str(), &st), 0);
+
+    for (ScanBackend backend : { ScanBackend::Portable, ScanBackend::Getdents }) {
+        FsScanner scanner;
+        scanner.options.backend = backend;
+        auto root = scanner.scan(tempDir.string());
+        ASSERT_NE(root, nullptr);
+        FsNode* file = root->children[0]->children[0].get();
+        EXPECT_EQ(file->size, 64 * 1024 * 1024);
+        EXPECT_EQ(file->sizeAlloc, static_cast<int64_t>(st.st_blocks) * 512);
+        EXPECT_EQ(file->atime, st.st_atime);
+        EXPECT_EQ(file->ctime, st.st_ctime);
+        EXPECT_EQ(file->userId, st.st_uid);
+    }
+
+    fs::remove_all(tempDir);
+}
+
+TEST(FsScannerTest, HardLinksCountedOnce) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_hardlinks";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "snap1");
+    fs::create_directories(tempDir / "snap2");
+    std::ofstream(tempDir / "snap1" / "data") << std::string(1000, 'x');
+    fs::create_hard_link(tempDir / "snap1" / "data", tempDir / "snap2" / "data");
+    fs::create_hard_link(tempDir / "snap1" / "data", tempDir / "copy");
+
+    struct stat st;
+    ASSERT_EQ(lstat(tempDir.c_str(), &st), 0);
+
+    for (ScanBackend backend : { ScanBackend::Portable, ScanBackend::Getdents }) {
+        FsScanner scanner;
+        scanner.options.backend = backend;
+        FsTree& tree = FsTree::instance();
+        tree.setRoot(scanner.scan(tempDir.string()));
+        tree.setupTree();
+
+        FsNode* root = tree.rootDir();
+        EXPECT_EQ(root->device, static_cast<uint64_t>(st.st_dev));
+        EXPECT_EQ(root->subtree.counts[NODE_REGFILE], 3u);
+        EXPECT_EQ(root->subtree.size, 1000);
+
+        // Exactly one link owns the bytes, and it stays the same one
+        int duplicates = 0;
+        for (const char* path : { "snap1/data", "snap2/data", "copy" }) {
+            FsNode* link = tree.nodeByPath((tempDir / path).string());
+            ASSERT_NE(link, nullptr) << path;
+            EXPECT_TRUE(link->flags & NODE_FLAG_MULTILINK);
+            duplicates += (link->flags & NODE_FLAG_DUPLICATE) ? 1 : 0;
+        }
+        EXPECT_EQ(duplicates, 2);
+        tree.updateTree();
+        EXPECT_EQ(root->subtree.size, 1000);
+    }
+
+    FsTree::instance().clear();
+    fs::remove_all(tempDir);
+}
+
+TEST(FsScannerTest, DuplicateFinderConfirmsInStages) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_duplicates";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "a");
+    fs::create_directories(tempDir / "b");
+    std::string big(20000, 'x');
+    std::ofstream(tempDir / "a" / "big") << big;
+    std::ofstream(tempDir / "b" / "big") << big;
+    big[10000] = 'y';  // same size and edges, differs in the middle
+    std::ofstream(tempDir / "b" / "big-edited") << big;
+    std::ofstream(tempDir / "a" / "hello") << "hello";
+    std::ofstream(tempDir / "b" / "hello") << "hello";
+    std::ofstream(tempDir / "b" / "world") << "world";
+    std::ofstream(tempDir / "unique") << "unique!";
+    std::ofstream(tempDir / "empty1");
+    std::ofstream(tempDir / "empty2");
+    fs::create_hard_link(tempDir / "a" / "big", tempDir / "a" / "big-link");
+
+    FsScanner scanner;
+    FsTree& tree = FsTree::instance();
+    tree.setRoot(scanner.scan(tempDir.string()));
+    tree.setupTree();
+    auto idOf = [&](const char* path) {
+        FsNode* node = tree.nodeByPath((tempDir / path).string());
+        return node ? node->id : 0u;
+    };
+
+    // Sizes shared by another file, hard links once, empty files skipped
+    std::vector<DuplicateCandidate> candidates = DuplicateFinder::collect(tree.root());
+    ASSERT_EQ(candidates.size(), 6u);
+    EXPECT_EQ(candidates[0].size, 20000);
+    EXPECT_EQ(tree.nodeByPath(candidates[0].path)->id, candidates[0].id);
+
+    DuplicateFinder::Progress progress;
+    DuplicateResult result = DuplicateFinder::find(candidates, 2, nullptr, &progress);
+    ASSERT_EQ(result.sets.size(), 2u);
+    EXPECT_EQ(result.sets[0].size, 20000);
+    std::vector<unsigned int> bigIds = {idOf("a/big"), idOf("b/big")};
+    if (tree.nodeById(bigIds[0])->flags & NODE_FLAG_DUPLICATE) {
+        bigIds[0] = idOf("a/big-link");
+    }
+    std::sort(bigIds.begin(), bigIds.end());
+    EXPECT_EQ(result.sets[0].ids, bigIds);
+    EXPECT_EQ(result.sets[1].size, 5);
+    EXPECT_EQ(result.wastedBytes, 20000 + 5);
+    EXPECT_EQ(result.duplicateFiles, 4u);
+    EXPECT_EQ(result.unreadableFiles, 0u);
+
+    // Only the three large files are read past their edges
+    EXPECT_EQ(progress.stage, DuplicateFinder::Stage::Done);
+    EXPECT_EQ(progress.bytesRead, 3u * 8192 + 3u * 5 + 3u * 20000);
+
+    DuplicateFinder finder;
+    finder.start(tree.root(), {});
+    while (finder.isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_NE(finder.result(), nullptr);
+    EXPECT_EQ(finder.result()->wastedBytes, result.wastedBytes);
+    finder.clear();
+    EXPECT_EQ(finder.result(), nullptr);
+
+    tree.clear();
+    fs::remove_all(tempDir);
+}
+
+TEST(FsScannerTest, IoUringBackendMatchesPortable) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_io_uring";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "sub");
+    // More entries than one ring submission holds
+    for (int i = 0; i < 300; ++i) {
+        std::ofstream(tempDir / "sub" / ("f" + std::to_string(i))) << std::string(i, 'x');
+    }
+
+    FsScanner portable;
+    portable.options.backend = ScanBackend::Portable;
+    auto portableRoot = portable.scan(tempDir.string());
+
+    // Falls back to synchronous statx where io_uring is unavailable
+    FsScanner uring;
+    uring.options.backend = ScanBackend::IoUring;
+    uring.options.threadCount = 2;
+    auto uringRoot = uring.scan(tempDir.string());
+
+    ASSERT_NE(portableRoot, nullptr);
+    ASSERT_NE(uringRoot, nullptr);
+    expectSameTree(portableRoot.get(), uringRoot.get());
+
+    fs::remove_all(tempDir);
+}
+
+TEST(FsScannerTest, WatcherPatchesTree) {
+    namespace fs = std::filesystem;
+    auto tempDir = fs::temp_directory_path() / "fsvng_test_watch";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "logs");
+    std::ofstream(tempDir / "logs" / "app.log") << "start\n";
+    std::ofstream(tempDir / "logs" / "old.log") << "old";
+    std::ofstream(tempDir / "stay.txt") << "stay";
+
+    FsScanner scanner;
+    FsTree& tree = FsTree::instance();
+    tree.setRoot(scanner.scan(tempDir.string()));
+    tree.setupTree();
+    FsNode* rootDir = tree.rootDir();
+    const FsNode* logs = findChild(rootDir, "logs");
+    const FsNode* appLog = findChild(logs, "app.log");
+    unsigned int maxId = tree.nodeCount() - 1;
+
+    FsWatcher watcher;
+    std::vector<const FsNode*> removed;
+    watcher.onRemove = [&](FsNode* node) { removed.push_back(node); };
+    ASSERT_TRUE(watcher.start(tree.root()));
+
+    // A log grows, one is rotated away, and a new directory appears
+    std::ofstream(tempDir / "logs" / "app.log", std::ios::app) << std::string(5000, 'x');
+    fs::remove(tempDir / "logs" / "old.log");
+    fs::create_directories(tempDir / "archive");
+    std::ofstream(tempDir / "archive" / "a.gz") << std::string(100, 'a');
+    fs::rename(tempDir / "stay.txt", tempDir / "moved.txt");
+
+    WatchBatch batch;
+    for (int i = 0; i < 100 && batch.changedDirs.size() < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (watcher.hasPendingBatch(0.05)) {
+            WatchBatch more = watcher.applyPending();
+            batch.changedDirs.insert(batch.changedDirs.end(), more.changedDirs.begin(),
+                                     more.changedDirs.end());
+            batch.rescanNeeded |= more.rescanNeeded;
+        }
+    }
+    watcher.stop();
+    EXPECT_FALSE(batch.rescanNeeded);
+    tree.updateTree();
+
+    // The grown file keeps its node; removed entries went through onRemove
+    EXPECT_EQ(findChild(logs, "app.log"), appLog);
+    EXPECT_EQ(appLog->size, 6 + 5000);
+    EXPECT_EQ(findChild(logs, "old.log"), nullptr);
+    EXPECT_EQ(removed.size(), 2u);
+    EXPECT_EQ(findChild(rootDir, "stay.txt"), nullptr);
+
+    // New entries are scanned in full and numbered past the old maximum
+    const FsNode* archive = findChild(rootDir, "archive");
+    ASSERT_NE(archive, nullptr);
+    ASSERT_NE(findChild(archive, "a.gz"), nullptr);
+    EXPECT_GT(archive->id, maxId);
+    ASSERT_NE(findChild(rootDir, "moved.txt"), nullptr);
+    EXPECT_EQ(tree.nodeById(archive->id), archive);
+
+    // Aggregates match a fresh scan
+    int64_t watchedSize = rootDir->subtree.size;
+    FsScanner fresh;
+    tree.setRoot(fresh.scan(tempDir.string()));
+    tree.setupTree();
+    EXPECT_EQ(watchedSize, tree.rootDir()->subtree.size);
+
+    tree.clear();
+    fs::remove_all(tempDir);
+}
+#endif
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "renderer/PackedVertex.h"
+
+#include <cmath>
+
+using namespace fsvng;
+
+namespace {
+
+// Sign-extend one 10-bit component of a packed normal
+int component(uint32_t packed, int index) {
+    int v = static_cast<int>((packed >> (index * 10)) & 0x3FFu);
+    return v >= 512 ? v - 1024 : v;
+}
+
+} // namespace
+
+TEST(PackedVertexTest, Snorm10Bounds) {
+    EXPECT_EQ(PackedVertex::packSnorm10(1.0f), 511u);
+    EXPECT_EQ(PackedVertex::packSnorm10(-1.0f), 0x3FFu & static_cast<uint32_t>(-511));
+    EXPECT_EQ(PackedVertex::packSnorm10(0.0f), 0u);
+    EXPECT_EQ(PackedVertex::packSnorm10(-0.0f), 0u);
+
+    // Out of range clamps rather than wrapping into the sign bit
+    EXPECT_EQ(PackedVertex::packSnorm10(2.0f), 511u);
+    EXPECT_EQ(PackedVertex::packSnorm10(-7.5f), PackedVertex::packSnorm10(-1.0f));
+}
+
+TEST(PackedVertexTest, NormalAxes) {
+    uint32_t x = PackedVertex::packNormal({1.0f, 0.0f, 0.0f});
+    EXPECT_EQ(component(x, 0), 511);
+    EXPECT_EQ(component(x, 1), 0);
+    EXPECT_EQ(component(x, 2), 0);
+
+    uint32_t negY = PackedVertex::packNormal({0.0f, -1.0f, 0.0f});
+    EXPECT_EQ(component(negY, 0), 0);
+    EXPECT_EQ(component(negY, 1), -511);
+    EXPECT_EQ(component(negY, 2), 0);
+
+    uint32_t z = PackedVertex::packNormal({0.0f, 0.0f, 1.0f});
+    EXPECT_EQ(component(z, 2), 511);
+
+    // The two spare bits stay clear
+    EXPECT_EQ(PackedVertex::packNormal({-1.0f, -1.0f, -1.0f}) >> 30, 0u);
+}
+
+TEST(PackedVertexTest, ZeroNormalStaysZero) {
+    EXPECT_EQ(PackedVertex::packNormal({0.0f, 0.0f, 0.0f}), 0u);
+}
+
+TEST(PackedVertexTest, UnnormalizedNormalKeepsDirection) {
+    // Layouts pass face normals scaled by edge lengths
+    EXPECT_EQ(PackedVertex::packNormal({0.0f, 250.0f, 0.0f}),
+              PackedVertex::packNormal({0.0f, 1.0f, 0.0f}));
+    EXPECT_EQ(PackedVertex::packNormal({-0.001f, 0.0f, 0.0f}),
+              PackedVertex::packNormal({-1.0f, 0.0f, 0.0f}));
+
+    uint32_t diag = PackedVertex::packNormal({3.0f, 4.0f, 0.0f});
+    EXPECT_EQ(component(diag, 0), static_cast<int>(std::lround(0.6f * 511.0f)));
+    EXPECT_EQ(component(diag, 1), static_cast<int>(std::lround(0.8f * 511.0f)));
+    EXPECT_EQ(component(diag, 2), 0);
+}
+
+TEST(PackedVertexTest, Unorm8Bounds) {
+    EXPECT_EQ(PackedVertex::packUnorm8(0.0f), 0);
+    EXPECT_EQ(PackedVertex::packUnorm8(1.0f), 255);
+    EXPECT_EQ(PackedVertex::packUnorm8(0.5f), 128);
+    EXPECT_EQ(PackedVertex::packUnorm8(-0.25f), 0);
+    EXPECT_EQ(PackedVertex::packUnorm8(1.75f), 255);
+}
+
+TEST(PackedVertexTest, ConstructorPacksColorOpaque) {
+    PackedVertex v({1.0f, 2.0f, 3.0f}, {0.0f, 0.0f, 2.0f}, {1.0f, 0.0f, 2.0f});
+    EXPECT_FLOAT_EQ(v.position.y, 2.0f);
+    EXPECT_EQ(component(v.normal, 2), 511);
+    EXPECT_EQ(v.color[0], 255);
+    EXPECT_EQ(v.color[1], 0);
+    EXPECT_EQ(v.color[2], 255);
+    EXPECT_EQ(v.color[3], 255);
+    EXPECT_EQ(sizeof(PackedVertex), 20u);
+}